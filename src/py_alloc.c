@@ -0,0 +1,157 @@
+/***********************************************************************************
+ * Describe : allocators of the table arrays, see py_alloc.h
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ **********************************************************************************/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <py_alloc.h>
+
+#define HUGE_ROUND(size) (((size)+PYALLOC_HUGE_PAGE-1) & ~(PYALLOC_HUGE_PAGE-1))
+
+
+static void* libc_alloc(size_t size, void* ctx)
+{
+	void* ptr = NULL;
+
+	if(posix_memalign(&ptr, 64, size>0 ? size : 1) != 0){
+		return NULL;
+	}
+	return ptr;
+}
+
+static void* libc_realloc(void* ptr, size_t old_size, size_t size, void* ctx)
+{
+	return realloc(ptr, size>0 ? size : 1);
+}
+
+static void libc_free(void* ptr, size_t size, void* ctx)
+{
+	free(ptr);
+}
+
+const py_alloc_t pyalloc_libc = {libc_alloc, libc_realloc, libc_free, NULL};
+
+/*
+ * func : map len bytes at a huge page boundary
+ *
+ * args : len, multiple of PYALLOC_HUGE_PAGE
+ *
+ * ret  : NULL, error
+ *      : else, the mapping
+ */
+static void* huge_map(size_t len)
+{
+	char*    addr = NULL;
+	size_t   head = 0;
+
+	addr = (char*)mmap(NULL, len, PROT_READ|PROT_WRITE,
+			MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+	if(addr!=MAP_FAILED){
+		return addr;
+	}
+
+	// no reserved huge pages, map one page more and cut it to the boundary
+	addr = (char*)mmap(NULL, len+PYALLOC_HUGE_PAGE, PROT_READ|PROT_WRITE,
+			MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if(addr==MAP_FAILED){
+		return NULL;
+	}
+	head = HUGE_ROUND((size_t)addr) - (size_t)addr;
+	if(head>0){
+		munmap(addr, head);
+	}
+	munmap(addr+head+len, PYALLOC_HUGE_PAGE-head);
+	addr += head;
+	madvise(addr, len, MADV_HUGEPAGE);
+
+	return addr;
+}
+
+static void* huge_alloc(size_t size, void* ctx)
+{
+	if(size<PYALLOC_HUGE_PAGE){
+		return libc_alloc(size, ctx);
+	}
+	return huge_map(HUGE_ROUND(size));
+}
+
+static void huge_free(void* ptr, size_t size, void* ctx)
+{
+	if(size<PYALLOC_HUGE_PAGE){
+		free(ptr);
+		return;
+	}
+	munmap(ptr, HUGE_ROUND(size));
+}
+
+static void* huge_realloc(void* ptr, size_t old_size, size_t size, void* ctx)
+{
+	size_t   old_len = HUGE_ROUND(old_size);
+	size_t   len     = HUGE_ROUND(size);
+	void*    addr    = NULL;
+
+	if(old_size<PYALLOC_HUGE_PAGE && size<PYALLOC_HUGE_PAGE){
+		return realloc(ptr, size>0 ? size : 1);
+	}
+	if(old_size>=PYALLOC_HUGE_PAGE && size>=PYALLOC_HUGE_PAGE){
+		if(len==old_len){
+			return ptr;
+		}
+		if(len<old_len){
+			munmap((char*)ptr+len, old_len-len);
+			return ptr;
+		}
+		// grow in place, or move the pages to a new aligned range
+		addr = mremap(ptr, old_len, len, 0);
+		if(addr!=MAP_FAILED){
+			madvise(addr, len, MADV_HUGEPAGE);
+			return addr;
+		}
+		if((addr = huge_map(len)) == NULL){
+			return NULL;
+		}
+		if(mremap(ptr, old_len, len, MREMAP_MAYMOVE|MREMAP_FIXED, addr) != MAP_FAILED){
+			madvise(addr, len, MADV_HUGEPAGE);
+			return addr;
+		}
+		memcpy(addr, ptr, old_size); // MAP_HUGETLB mappings may not move
+		munmap(ptr, old_len);
+		return addr;
+	}
+
+	// across the threshold, copy
+	if((addr = huge_alloc(size, ctx)) == NULL){
+		return NULL;
+	}
+	memcpy(addr, ptr, old_size<size ? old_size : size);
+	huge_free(ptr, old_size, ctx);
+	return addr;
+}
+
+const py_alloc_t pyalloc_huge = {huge_alloc, huge_realloc, huge_free, NULL};
+
+static py_alloc_t pyalloc_default = {libc_alloc, libc_realloc, libc_free, NULL};
+
+/*
+ * func : set the default allocator of new dicts
+ */
+void pyalloc_set(const py_alloc_t* alloc)
+{
+	pyalloc_default = alloc ? *alloc : pyalloc_libc;
+}
+
+/*
+ * func : get the default allocator of new dicts
+ */
+const py_alloc_t* pyalloc_get()
+{
+	return &pyalloc_default;
+}
@@ -0,0 +1,71 @@
+/********************************************************************************
+ * Describe : allocators of the table arrays of a dict, hashtab, node and key
+ *          : segments and the swiss arrays. a dict takes the default 
+ *          : allocator when it is created and frees its arrays with it, so
+ *          : an arena or a pool may be plugged in by pyalloc_set.
+ *
+ *          : pyalloc_huge backs arrays of 2MB or more with huge pages, a
+ *          : MAP_HUGETLB mapping if the system has reserved huge pages, else
+ *          : a 2MB aligned mapping with madvise(MADV_HUGEPAGE). such arrays
+ *          : grow by mremap, page tables are moved and the nodes are not
+ *          : copied. smaller arrays are left to malloc. a MAP_HUGETLB
+ *          : mapping takes its huge pages when it is made, not when they
+ *          : are first touched.
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ *******************************************************************************/
+#ifndef _PY_ALLOC_H
+#define _PY_ALLOC_H
+
+#include <stddef.h>
+
+#define PYALLOC_HUGE_PAGE   (2UL<<20)   // huge page size, x86_64
+
+// an allocator, sizes are passed back to realloc and free
+typedef struct _py_alloc{
+	void*   (*alloc)(size_t size, void* ctx);     // 64 bytes aligned
+	void*   (*realloc)(void* ptr, size_t old_size, size_t size, void* ctx);
+	void    (*free)(void* ptr, size_t size, void* ctx);
+	void*   ctx;
+}py_alloc_t;
+
+extern const py_alloc_t pyalloc_libc;   // posix_memalign, realloc, free
+extern const py_alloc_t pyalloc_huge;   // huge pages for large arrays
+
+/*
+ * func : set the default allocator of new dicts
+ *
+ * args : alloc, the allocator, it is copied. NULL for pyalloc_libc
+ *
+ * note : dicts keep the allocator they are created with, set it before
+ *      : creating, loading, mapping or building dicts.
+ */
+void                pyalloc_set(const py_alloc_t* alloc);
+
+/*
+ * func : get the default allocator of new dicts
+ */
+const py_alloc_t*   pyalloc_get();
+
+static inline void* pyalloc_alloc(const py_alloc_t* alloc, size_t size)
+{
+	return alloc->alloc(size, alloc->ctx);
+}
+
+static inline void* pyalloc_realloc(const py_alloc_t* alloc, void* ptr, size_t old_size, size_t size)
+{
+	return alloc->realloc(ptr, old_size, size, alloc->ctx);
+}
+
+static inline void pyalloc_free(const py_alloc_t* alloc, void* ptr, size_t size)
+{
+	if(ptr){
+		alloc->free(ptr, size, alloc->ctx);
+	}
+}
+
+#endif
@@ -0,0 +1,804 @@
+/***********************************************************************************
+ * Describe : parallel dict builder, see py_build.h
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ **********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <py_sign.h>
+#include <py_dict.h>
+#include <py_build.h>
+
+
+#define BUILD_MAX_THREAD 256
+#define BUILD_REC_STEP   65536   // records a thread allocates at first
+#define BUILD_SORT_MIN   16      // buckets with more records are sorted to drop duplicates
+
+// a parsed and signed line
+typedef struct _build_rec{
+	unsigned int  sign1;
+	unsigned int  sign2;
+	int           code;
+	int           value;
+	unsigned int  bucket;
+}build_rec_t;
+
+struct _build_ctx;
+
+// the work of one thread, a byte range of the file in the parse and
+// scatter phases, a bucket range of the hash table in the assemble phases
+typedef struct _build_part{
+	struct _build_ctx*  ctx;
+	int                 id;
+	int                 failed;
+
+	const char*         begin;      // byte range of the file
+	const char*         end;
+	build_rec_t*        recs;       // records in line order
+	unsigned int        rec_num;
+	unsigned int        rec_size;
+	unsigned int        line_num;
+	unsigned int        bad_num;
+	unsigned int        key_max;    // longest key
+
+	build_rec_t*        parted;     // records grouped by partition
+	unsigned int*       part_pos;   // offset of each partition in parted
+
+	unsigned int        lo;         // bucket range [lo, hi) of the partition
+	unsigned int        hi;
+	PNODE*              nodes;      // unique nodes, local positions
+	unsigned int        node_num;
+	unsigned int        node_base;  // position of nodes[0] in the block
+}build_part_t;
+
+typedef void (*build_func_t)(struct _build_part* part);
+
+typedef struct _build_ctx{
+	build_func_t        func;       // the phase being run
+	int                 thread_num;
+	int                 hash;       // signature function, the default of new dicts
+	unsigned int        hashsize;
+	unsigned int*       hashtab;
+	py_dict_t*          pydict;     // the nodes are placed in its segments
+	build_part_t        parts[BUILD_MAX_THREAD];
+}build_ctx_t;
+
+static void* build_thread(void* arg)
+{
+	build_part_t*  part = (build_part_t*)arg;
+
+	part->ctx->func(part);
+	return NULL;
+}
+
+/*
+ * func : run func on every part, one thread a part
+ *
+ * note : a part whose thread can not be created is run by the caller
+ */
+static void build_run(build_ctx_t* ctx, build_func_t func)
+{
+	pthread_t  threads[BUILD_MAX_THREAD];
+	int        started[BUILD_MAX_THREAD];
+	int        i = 0;
+
+	ctx->func = func;
+	for(i=0;i<ctx->thread_num;i++){
+		started[i] = (pthread_create(&threads[i], NULL, build_thread, &ctx->parts[i])==0);
+		if(!started[i]){
+			func(&ctx->parts[i]);
+		}
+	}
+	for(i=0;i<ctx->thread_num;i++){
+		if(started[i]){
+			pthread_join(threads[i], NULL);
+		}
+	}
+}
+
+/*
+ * func : parse an integer field, as atoi does, the field needs not end
+ *        with '\0'
+ */
+static int build_atoi(const char* str, const char* end)
+{
+	int   neg = 0;
+	int   val = 0;
+
+	if(str<end && (*str=='-' || *str=='+')){
+		neg = (*str=='-');
+		str++;
+	}
+	while(str<end && *str>='0' && *str<='9'){
+		val = val*10 + (*str-'0');
+		str++;
+	}
+	return neg ? -val : val;
+}
+
+/*
+ * func : append a batch of keys to the records of a part
+ */
+static int build_flush(build_part_t* part, const char* keys[], const int lens[],
+                       const int codes[], const int values[], const int num)
+{
+	unsigned int   sign1[SIGN_BATCH_STEP];
+	unsigned int   sign2[SIGN_BATCH_STEP];
+	build_rec_t*   recs = NULL;
+	build_rec_t*   rec  = NULL;
+	unsigned int   size = 0;
+	int            i    = 0;
+
+	if(part->rec_num+num > part->rec_size){
+		size = part->rec_size ? part->rec_size*2 : BUILD_REC_STEP;
+		recs = (build_rec_t*)realloc(part->recs, sizeof(build_rec_t)*size);
+		if(!recs){
+			return -1;
+		}
+		part->recs     = recs;
+		part->rec_size = size;
+	}
+
+	py_sign64_double_int_batch_hash(part->ctx->hash, keys, lens, num, sign1, sign2);
+	rec = part->recs + part->rec_num;
+	for(i=0;i<num;i++,rec++){
+		rec->sign1  = sign1[i];
+		rec->sign2  = sign2[i];
+		rec->code   = codes[i];
+		rec->value  = values[i];
+		rec->bucket = 0;
+		if((unsigned int)lens[i] > part->key_max){
+			part->key_max = lens[i];
+		}
+	}
+	part->rec_num += num;
+	return 0;
+}
+
+/*
+ * func : split a line into its first 3 fields
+ *
+ * args : line, end, the line and the end of the bytes
+ *      : fields, ends, the fields
+ *      : num, return the number of fields, -1 for an empty line
+ *
+ * ret  : the next line
+ *
+ * note : fields are split on runs of '\t' like split_c, a trailing '\r'
+ *        is dropped
+ */
+static const char* build_split(const char* line, const char* end, const char* fields[3],
+                               const char* ends[3], int* num)
+{
+	const char*   eol   = NULL;
+	const char*   p     = NULL;
+	int           field = 0;
+
+	eol = (const char*)memchr(line, '\n', end-line);
+	if(!eol){
+		eol = end;
+	}
+	p = eol;
+	if(p>line && p[-1]=='\r'){
+		p--;
+	}
+	if(p==line){ // empty line
+		*num = -1;
+		return eol+1;
+	}
+
+	while(field<3){
+		while(line<p && *line=='\t'){
+			line++;
+		}
+		if(line==p){
+			break;
+		}
+		fields[field] = line;
+		while(line<p && *line!='\t'){
+			line++;
+		}
+		ends[field++] = line;
+	}
+	*num = field;
+
+	return eol+1;
+}
+
+/*
+ * func : parse phase, split the lines of a byte range into key, code and
+ *        value and sign the keys a batch at a time
+ *
+ * note : empty lines are skipped, see build_split
+ */
+static void build_parse(build_part_t* part)
+{
+	const char*   keys[SIGN_BATCH_STEP];
+	int           lens[SIGN_BATCH_STEP];
+	int           codes[SIGN_BATCH_STEP];
+	int           values[SIGN_BATCH_STEP];
+	const char*   fields[3];
+	const char*   ends[3];
+	const char*   line  = part->begin;
+	int           field = 0;
+	int           num   = 0;
+
+	while(line<part->end){
+		line = build_split(line, part->end, fields, ends, &field);
+		if(field<0){
+			continue;
+		}
+		part->line_num++;
+		if(field<3){
+			part->bad_num++;
+			continue;
+		}
+
+		keys[num]   = fields[0];
+		lens[num]   = ends[0]-fields[0];
+		codes[num]  = build_atoi(fields[1], ends[1]);
+		values[num] = build_atoi(fields[2], ends[2]);
+		if(++num==SIGN_BATCH_STEP){
+			if(build_flush(part, keys, lens, codes, values, num) < 0){
+				part->failed = 1;
+				return;
+			}
+			num = 0;
+		}
+	}
+	if(num>0 && build_flush(part, keys, lens, codes, values, num) < 0){
+		part->failed = 1;
+	}
+}
+
+/*
+ * func : partition of a bucket, partition p holds buckets
+ *        [ceil(p*hashsize/thread_num), ceil((p+1)*hashsize/thread_num))
+ */
+static inline int build_part_of(build_ctx_t* ctx, unsigned int bucket)
+{
+	return (int)((unsigned long)bucket*ctx->thread_num/ctx->hashsize);
+}
+
+static inline unsigned int build_part_lo(build_ctx_t* ctx, int p)
+{
+	return (unsigned int)(((unsigned long)p*ctx->hashsize+ctx->thread_num-1)/ctx->thread_num);
+}
+
+/*
+ * func : scatter phase, group the records of a part by partition, keeping
+ *        the line order in each partition
+ */
+static void build_scatter(build_part_t* part)
+{
+	build_ctx_t*   ctx   = part->ctx;
+	build_rec_t*   rec   = NULL;
+	unsigned int*  pos   = NULL;
+	unsigned int   i     = 0;
+	int            p     = 0;
+	unsigned int   cur[BUILD_MAX_THREAD];
+
+	part->part_pos = (unsigned int*)calloc(ctx->thread_num+1, sizeof(unsigned int));
+	part->parted   = (build_rec_t*)malloc(sizeof(build_rec_t)*(part->rec_num+1));
+	if(!part->part_pos || !part->parted){
+		part->failed = 1;
+		return;
+	}
+	pos = part->part_pos;
+
+	for(i=0,rec=part->recs;i<part->rec_num;i++,rec++){
+		rec->bucket = (rec->sign1+rec->sign2) % ctx->hashsize;
+		pos[build_part_of(ctx, rec->bucket)+1]++;
+	}
+	for(p=0;p<ctx->thread_num;p++){
+		pos[p+1] += pos[p];
+		cur[p]    = pos[p];
+	}
+	for(i=0,rec=part->recs;i<part->rec_num;i++,rec++){
+		part->parted[cur[build_part_of(ctx, rec->bucket)]++] = *rec;
+	}
+
+	free(part->recs);
+	part->recs = NULL;
+}
+
+/*
+ * func : order records by signature, then by line, bucket holds the line 
+ *        order while a bucket is sorted
+ */
+static int build_rec_cmp(const void* a, const void* b)
+{
+	const build_rec_t*  ra = (const build_rec_t*)a;
+	const build_rec_t*  rb = (const build_rec_t*)b;
+
+	if(ra->sign1!=rb->sign1){
+		return ra->sign1<rb->sign1 ? -1 : 1;
+	}
+	if(ra->sign2!=rb->sign2){
+		return ra->sign2<rb->sign2 ? -1 : 1;
+	}
+	if(ra->bucket!=rb->bucket){
+		return ra->bucket<rb->bucket ? -1 : 1;
+	}
+	return 0;
+}
+
+/*
+ * func : assemble phase, sort the records of a partition by bucket, drop
+ *        duplicate keys and link the unique nodes of each bucket
+ *
+ * note : nodes and the partition's hash table range use local positions,
+ *        build_place moves them to the block
+ */
+static void build_assemble(build_part_t* part)
+{
+	build_ctx_t*   ctx    = part->ctx;
+	build_part_t*  src    = NULL;
+	build_rec_t*   sorted = NULL;
+	build_rec_t*   rec    = NULL;
+	unsigned int*  cnt    = NULL;
+	PNODE*         node   = NULL;
+	unsigned int   range  = 0;
+	unsigned int   total  = 0;
+	unsigned int   first  = 0;
+	unsigned int   b      = 0;
+	unsigned int   i      = 0;
+	unsigned int   j      = 0;
+	int            crowded = 0;
+	int            t      = 0;
+
+	part->lo = build_part_lo(ctx, part->id);
+	part->hi = build_part_lo(ctx, part->id+1);
+	range    = part->hi - part->lo;
+
+	for(t=0;t<ctx->thread_num;t++){
+		src    = &ctx->parts[t];
+		total += src->part_pos[part->id+1] - src->part_pos[part->id];
+	}
+
+	cnt        = (unsigned int*)calloc(range+1, sizeof(unsigned int));
+	sorted     = (build_rec_t*)malloc(sizeof(build_rec_t)*(total+1));
+	part->nodes = (PNODE*)malloc(sizeof(PNODE)*(total+1));
+	if(!cnt || !sorted || !part->nodes){
+		part->failed = 1;
+		goto out;
+	}
+
+	// stable counting sort by bucket, the lines of thread t come before
+	// those of thread t+1, so the line order is kept in a bucket
+	for(t=0;t<ctx->thread_num;t++){
+		src = &ctx->parts[t];
+		for(i=src->part_pos[part->id];i<src->part_pos[part->id+1];i++){
+			cnt[src->parted[i].bucket-part->lo+1]++;
+		}
+	}
+	for(b=0;b<range;b++){
+		cnt[b+1] += cnt[b];
+	}
+	for(t=0;t<ctx->thread_num;t++){
+		src = &ctx->parts[t];
+		for(i=src->part_pos[part->id];i<src->part_pos[part->id+1];i++){
+			rec = &src->parted[i];
+			sorted[cnt[rec->bucket-part->lo]++] = *rec;
+		}
+	}
+
+	// cnt[b] is now the end of bucket b, the later line of a key wins
+	for(b=0,i=0;b<range;b++){
+		first   = part->node_num;
+		crowded = (cnt[b]-i > BUILD_SORT_MIN);
+		if(crowded){ // sort by signature, then line, instead of scanning
+			for(j=i;j<cnt[b];j++){
+				sorted[j].bucket = j;
+			}
+			qsort(sorted+i, cnt[b]-i, sizeof(build_rec_t), build_rec_cmp);
+		}
+		for(;i<cnt[b];i++){
+			rec = &sorted[i];
+			j   = crowded && part->node_num>first ? part->node_num-1 : first;
+			for(;j<part->node_num;j++){
+				node = &part->nodes[j];
+				if(node->sign1==rec->sign1 && node->sign2==rec->sign2){
+					break;
+				}
+			}
+			node = &part->nodes[j];
+			if(j==part->node_num){
+				node->sign1 = rec->sign1;
+				node->sign2 = rec->sign2;
+				part->node_num++;
+			}
+			node->code  = rec->code;
+			node->value = rec->value;
+		}
+		for(j=first;j<part->node_num;j++){
+			part->nodes[j].next = (j+1<part->node_num) ? j+1 : COMMON_NULL;
+		}
+		ctx->hashtab[part->lo+b] = (first<part->node_num) ? first : COMMON_NULL;
+	}
+
+out:
+	if(cnt){
+		free(cnt);
+	}
+	if(sorted){
+		free(sorted);
+	}
+}
+
+/*
+ * func : place phase, copy the nodes of a partition to the block and
+ *        turn local positions into block positions
+ */
+static void build_place(build_part_t* part)
+{
+	build_ctx_t*   ctx   = part->ctx;
+	PNODE*         node  = NULL;
+	unsigned int   base  = part->node_base;
+	unsigned int   i     = 0;
+
+	for(i=0;i<part->node_num;i++){
+		node  = pydict_node(ctx->pydict, base+i);
+		*node = part->nodes[i];
+		if(node->next!=COMMON_NULL){
+			node->next += base;
+		}
+	}
+	for(i=part->lo;i<part->hi;i++){
+		if(ctx->hashtab[i]!=COMMON_NULL){
+			ctx->hashtab[i] += base;
+		}
+	}
+}
+
+/*
+ * func : free the buffers of all parts
+ */
+static void build_clear(build_ctx_t* ctx)
+{
+	build_part_t*  part = NULL;
+	int            i    = 0;
+
+	for(i=0;i<ctx->thread_num;i++){
+		part = &ctx->parts[i];
+		if(part->recs){
+			free(part->recs);
+			part->recs = NULL;
+		}
+		if(part->parted){
+			free(part->parted);
+			part->parted = NULL;
+		}
+		if(part->part_pos){
+			free(part->part_pos);
+			part->part_pos = NULL;
+		}
+		if(part->nodes){
+			free(part->nodes);
+			part->nodes = NULL;
+		}
+	}
+}
+
+/*
+ * func : check if any part failed
+ */
+static int build_failed(build_ctx_t* ctx)
+{
+	int   i = 0;
+
+	for(i=0;i<ctx->thread_num;i++){
+		if(ctx->parts[i].failed){
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * func : build a dict from a text file
+ *
+ * args : input, the text file, "key\tcode\tvalue" per line
+ *      : hashsize, hash table size, 0 for the number of lines
+ *      : thread_num, number of threads
+ *      : stat, statistics of the build, may be NULL
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_dict_t struct
+ */
+py_dict_t* pydict_build(const char* input, const unsigned int hashsize, const int thread_num,
+                        build_stat_t* stat)
+{
+	build_ctx_t*   ctx      = NULL;
+	build_part_t*  part     = NULL;
+	py_dict_t*     pydict   = NULL;
+	char*          addr     = NULL;
+	size_t         size     = 0;
+	unsigned int   line_num = 0;
+	unsigned int   bad_num  = 0;
+	unsigned int   rec_num  = 0;
+	unsigned int   node_num = 0;
+	int            fd       = -1;
+	int            i        = 0;
+	struct stat    st;
+
+	ctx = (build_ctx_t*)calloc(1, sizeof(build_ctx_t));
+	if(!ctx){
+		goto failed;
+	}
+	ctx->thread_num = thread_num;
+	ctx->hash       = py_sign_get_default();
+	if(ctx->thread_num<=0){
+		ctx->thread_num = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if(ctx->thread_num<=0){
+		ctx->thread_num = 1;
+	}
+	if(ctx->thread_num>BUILD_MAX_THREAD){
+		ctx->thread_num = BUILD_MAX_THREAD;
+	}
+
+	if((fd=open(input, O_RDONLY))<0){
+		goto failed;
+	}
+	if(fstat(fd, &st)<0){
+		goto failed;
+	}
+	size = (size_t)st.st_size;
+	if(size>0){
+		addr = (char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(addr==MAP_FAILED){
+			addr = NULL;
+			goto failed;
+		}
+		madvise(addr, size, MADV_SEQUENTIAL);
+	}
+
+	// byte ranges begin after a line end, a line belongs to the range
+	// its first byte is in
+	for(i=0;i<ctx->thread_num;i++){
+		part        = &ctx->parts[i];
+		part->ctx   = ctx;
+		part->id    = i;
+		part->begin = addr + size*i/ctx->thread_num;
+		if(i>0){
+			while(part->begin>addr && part->begin<addr+size && part->begin[-1]!='\n'){
+				part->begin++;
+			}
+		}
+	}
+	for(i=0;i<ctx->thread_num;i++){
+		ctx->parts[i].end = (i+1<ctx->thread_num) ? ctx->parts[i+1].begin : addr+size;
+	}
+
+	build_run(ctx, build_parse);
+	if(build_failed(ctx)){
+		goto failed;
+	}
+	for(i=0;i<ctx->thread_num;i++){
+		line_num += ctx->parts[i].line_num;
+		bad_num  += ctx->parts[i].bad_num;
+		rec_num  += ctx->parts[i].rec_num;
+	}
+
+	ctx->hashsize = hashsize ? hashsize : rec_num;
+	if(ctx->hashsize==0){
+		ctx->hashsize = 1;
+	}
+	build_run(ctx, build_scatter);
+	if(build_failed(ctx)){
+		goto failed;
+	}
+
+	// the table is handed over to an empty dict and the nodes are placed 
+	// in its segments, both are allocated by its allocator
+	if((pydict = pydict_create(1, 0)) == NULL){
+		goto failed;
+	}
+	pydict->hash = ctx->hash;
+	ctx->hashtab = (unsigned int*)pyalloc_alloc(&pydict->alloc, sizeof(unsigned int)*ctx->hashsize);
+	if(!ctx->hashtab){
+		goto failed;
+	}
+	build_run(ctx, build_assemble);
+	if(build_failed(ctx)){
+		goto failed;
+	}
+
+	for(i=0;i<ctx->thread_num;i++){
+		ctx->parts[i].node_base = node_num;
+		node_num += ctx->parts[i].node_num;
+	}
+	if(pydict_reserve(pydict, node_num+1) < 0){
+		goto failed;
+	}
+	ctx->pydict = pydict;
+	build_run(ctx, build_place);
+
+	// hand the table over
+	pyalloc_free(&pydict->alloc, pydict->hashtab, sizeof(unsigned int)*pydict->hashsize);
+	pydict->hashtab    = ctx->hashtab;
+	pydict->hashsize   = ctx->hashsize;
+	pydict->block_pos  = node_num;
+	pydict_live_rebuild(pydict);
+	for(i=0;i<ctx->thread_num;i++){
+		if(ctx->parts[i].key_max > pydict->key_max){
+			pydict->key_max = ctx->parts[i].key_max;
+		}
+	}
+
+	if(stat){
+		stat->line_num = line_num;
+		stat->bad_num  = bad_num;
+		stat->node_num = node_num;
+	}
+
+	build_clear(ctx);
+	free(ctx);
+	munmap(addr, size);
+	close(fd);
+	return pydict;
+
+failed:
+	if(ctx){
+		build_clear(ctx);
+		if(ctx->hashtab){
+			pyalloc_free(&pydict->alloc, ctx->hashtab, sizeof(unsigned int)*ctx->hashsize);
+		}
+		free(ctx);
+		ctx = NULL;
+	}
+	pydict_free(pydict);
+	if(addr){
+		munmap(addr, size);
+		addr = NULL;
+	}
+	if(fd>=0){
+		close(fd);
+		fd = -1;
+	}
+	return NULL;
+}
+
+/*
+ * func : build a dict from a text file and save it
+ *
+ * args : input, hashsize, thread_num, stat, see pydict_build
+ *      : path, file, the dict file to write
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+int pydict_build_file(const char* input, const unsigned int hashsize, const int thread_num,
+                      const char* path, const char* file, build_stat_t* stat)
+{
+	py_dict_t*   pydict = NULL;
+	int          ret    = 0;
+
+	if((pydict = pydict_build(input, hashsize, thread_num, stat)) == NULL){
+		return -1;
+	}
+	ret = pydict_save(pydict, path, file);
+	pydict_free(pydict);
+
+	return ret;
+}
+
+/*
+ * func : build a trie of the keys of a text file, the companion of the dict
+ *        pydict_build makes of the same file
+ *
+ * args : input, the text file, "key\tcode\tvalue" per line
+ *      : stat, statistics of the build, may be NULL, node_num is the
+ *      :       number of unique keys
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_trie_t struct
+ *
+ * note : lines are split as pydict_build does, the trie holds the same
+ *        keys with the same code and value
+ */
+py_trie_t* pytrie_build(const char* input, build_stat_t* stat)
+{
+	py_trie_t*     pytrie   = NULL;
+	const char**   keys     = NULL;
+	int*           lens     = NULL;
+	int*           codes    = NULL;
+	int*           values   = NULL;
+	void*          tmp      = NULL;
+	const char*    fields[3];
+	const char*    ends[3];
+	const char*    line     = NULL;
+	char*          addr     = NULL;
+	size_t         size     = 0;
+	unsigned int   line_num = 0;
+	unsigned int   bad_num  = 0;
+	int            key_num  = 0;
+	int            key_size = 0;
+	int            field    = 0;
+	int            fd       = -1;
+	struct stat    st;
+
+	if((fd=open(input, O_RDONLY))<0){
+		goto failed;
+	}
+	if(fstat(fd, &st)<0){
+		goto failed;
+	}
+	size = (size_t)st.st_size;
+	if(size>0){
+		addr = (char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(addr==MAP_FAILED){
+			addr = NULL;
+			goto failed;
+		}
+		madvise(addr, size, MADV_SEQUENTIAL);
+	}
+
+	line = addr;
+	while(line<addr+size){
+		line = build_split(line, addr+size, fields, ends, &field);
+		if(field<0){
+			continue;
+		}
+		line_num++;
+		if(field<3){
+			bad_num++;
+			continue;
+		}
+		if(key_num==key_size){
+			key_size = key_size ? key_size*2 : BUILD_REC_STEP;
+#define BUILD_GROW(ptr, type) \
+			do{ \
+				if((tmp = realloc(ptr, sizeof(type)*key_size)) == NULL){ \
+					goto failed; \
+				} \
+				ptr = (type*)tmp; \
+			}while(0)
+			BUILD_GROW(keys, const char*);
+			BUILD_GROW(lens, int);
+			BUILD_GROW(codes, int);
+			BUILD_GROW(values, int);
+#undef BUILD_GROW
+		}
+		keys[key_num]   = fields[0];
+		lens[key_num]   = (int)(ends[0]-fields[0]);
+		codes[key_num]  = build_atoi(fields[1], ends[1]);
+		values[key_num] = build_atoi(fields[2], ends[2]);
+		key_num++;
+	}
+
+	if((pytrie = pytrie_create(keys, lens, codes, values, key_num)) == NULL){
+		goto failed;
+	}
+	if(stat){
+		stat->line_num = line_num;
+		stat->bad_num  = bad_num;
+		stat->node_num = pytrie->head.key_num;
+	}
+
+failed:
+	free(keys);
+	free(lens);
+	free(codes);
+	free(values);
+	if(addr){
+		munmap(addr, size);
+		addr = NULL;
+	}
+	if(fd>=0){
+		close(fd);
+		fd = -1;
+	}
+	return pytrie;
+}
@@ -0,0 +1,70 @@
+/********************************************************************************
+ * Describe : build a dict from a text file on all cores. each line of the 
+ *          : file is "key\tcode\tvalue". the file is split into byte ranges
+ *          : parsed and signed in parallel, the results are partitioned by 
+ *          : bucket and each partition of the hash table and node block is 
+ *          : assembled by its own thread.
+ *
+ *          : later lines overwrite the code and value of earlier lines with 
+ *          : the same key, as pydict_add does. nodes are grouped by bucket.
+ * 
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ * 
+ * Create   : 2008-10-15
+ * 
+ * Modify   : 2008-10-15
+ *******************************************************************************/
+#ifndef _PY_BUILD_H
+#define _PY_BUILD_H
+
+#include <py_dict.h>
+#include <py_trie.h>
+
+// statistics of a build
+typedef struct _build_stat{
+	unsigned int      line_num;     // lines parsed
+	unsigned int      bad_num;      // lines without key, code and value
+	unsigned int      node_num;     // unique keys
+}build_stat_t;
+
+/*
+ * func : build a dict from a text file
+ *
+ * args : input, the text file, "key\tcode\tvalue" per line
+ *      : hashsize, hash table size, 0 for the number of lines
+ *      : thread_num, number of threads
+ *      : stat, statistics of the build, may be NULL
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_dict_t struct
+ */
+py_dict_t*  pydict_build(const char* input, const unsigned int hashsize, const int thread_num,
+                         build_stat_t* stat);
+
+/*
+ * func : build a dict from a text file and save it
+ *
+ * args : input, hashsize, thread_num, stat, see pydict_build
+ *      : path, file, the dict file to write
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+int         pydict_build_file(const char* input, const unsigned int hashsize, const int thread_num,
+                              const char* path, const char* file, build_stat_t* stat);
+
+/*
+ * func : build a trie of the keys of a text file, see py_trie.h
+ *
+ * args : input, the text file, "key\tcode\tvalue" per line
+ *      : stat, statistics of the build, may be NULL
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_trie_t struct
+ *
+ * note : it holds the keys, codes and values of the dict pydict_build
+ *        makes of the same file
+ */
+py_trie_t*  pytrie_build(const char* input, build_stat_t* stat);
+
+#endif
@@ -0,0 +1,521 @@
+/***********************************************************************************
+ * Describe : a concurrent sharded dict, see py_cdict.h
+ * 
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ * 
+ * Create   : 2008-10-15
+ * 
+ * Modify   : 2008-10-15
+ **********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <py_sign.h>
+#include <py_sign_inline.h>
+#include <py_utils.h>
+#include <py_dict.h>
+#include <py_cdict.h>
+
+
+#define LOAD_STEP 4096     // nodes read at a time by pycdict_load
+
+/*
+ * func : shard of a signature, the high bits of sign1, the low bits of 
+ *        sign1+sign2 choose the bucket in the shard
+ */
+static inline cdict_shard_t* pycdict_shard(py_cdict_t* pycdict, unsigned int sign1)
+{
+	if(pycdict->shard_bits==0){
+		return pycdict->shards;
+	}
+	return pycdict->shards + (sign1 >> (32-pycdict->shard_bits));
+}
+
+/*
+ * func : create a concurrent dict
+ *
+ * args : shard_num, number of shards, rounded up to a power of 2
+ *      : hashsize, nodesize, sizes of the whole dict, split among shards
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_cdict_t struct
+ */
+py_cdict_t* pycdict_create(const int shard_num, const int hashsize, const int nodesize)
+{
+	py_cdict_t*    pycdict  = NULL;
+	void*          shards   = NULL;
+	unsigned int   num      = 1;
+	unsigned int   bits     = 0;
+	unsigned int   i        = 0;
+
+	while(num < (unsigned int)shard_num && bits < 16){
+		num <<= 1;
+		bits++;
+	}
+
+	pycdict = (py_cdict_t*)calloc(1, sizeof(py_cdict_t));
+	if(!pycdict){
+		goto failed;
+	}
+	if(posix_memalign(&shards, 64, sizeof(cdict_shard_t)*num) != 0){
+		goto failed;
+	}
+	memset(shards, 0, sizeof(cdict_shard_t)*num);
+	pycdict->shards     = (cdict_shard_t*)shards;
+	pycdict->shard_num  = num;
+	pycdict->shard_bits = bits;
+	pycdict->hash       = py_sign_get_default();
+
+	for(i=0;i<num;i++){
+		pycdict->shards[i].pydict = pydict_create(hashsize/num+1, nodesize/num+1);
+		if(!pycdict->shards[i].pydict){
+			goto failed;
+		}
+		// readers share the lock, find must not move buckets
+		pycdict->shards[i].pydict->find_readonly = 1;
+		pthread_rwlock_init(&pycdict->shards[i].lock, NULL);
+	}
+
+	return pycdict;
+
+failed:
+	if(pycdict){
+		if(pycdict->shards){
+			for(i=0;i<num;i++){
+				if(pycdict->shards[i].pydict){
+					pydict_free(pycdict->shards[i].pydict);
+					pthread_rwlock_destroy(&pycdict->shards[i].lock);
+				}
+			}
+			free(pycdict->shards);
+		}
+		free(pycdict);
+		pycdict = NULL;
+	}
+	return NULL;
+}
+
+/*
+ * func : free a concurrent dict
+ */
+void pycdict_free(py_cdict_t* pycdict)
+{
+	unsigned int i = 0;
+
+	if(!pycdict){
+		return;
+	}
+	for(i=0;i<pycdict->shard_num;i++){
+		pydict_free(pycdict->shards[i].pydict);
+		pthread_rwlock_destroy(&pycdict->shards[i].lock);
+	}
+	free(pycdict->shards);
+	free(pycdict);
+	pycdict = NULL;
+}
+
+/*
+ * func : add a value pair, see pydict_add
+ *
+ * ret  : 1,  find a same key, value changed;
+ *      : 0,  find NO same key, new node added,
+ *      : -1, error;
+ */
+int pycdict_add(py_cdict_t* pycdict, const char* key, const int len, const int code, const int value)
+{
+	cdict_shard_t* shard = NULL;
+	unsigned long  sign  = 0;
+	int            ret   = 0;
+	PNODE          node;
+
+	sign       = py_sign64_inline(pycdict->hash, key, len);
+	node.sign1 = (unsigned int)(sign>>32);
+	node.sign2 = (unsigned int)sign;
+	node.code  = code;
+	node.value = value;
+	shard      = pycdict_shard(pycdict, node.sign1);
+
+	pthread_rwlock_wrlock(&shard->lock);
+	ret = pydict_add_node_len(shard->pydict, &node, len);
+	pthread_rwlock_unlock(&shard->lock);
+
+	return ret;
+}
+
+/*
+ * func : add a node, see pydict_add_node
+ */
+int pycdict_add_node(py_cdict_t* pycdict, PNODE* node)
+{
+	cdict_shard_t* shard = pycdict_shard(pycdict, node->sign1);
+	int            ret   = 0;
+
+	pthread_rwlock_wrlock(&shard->lock);
+	ret = pydict_add_node(shard->pydict, node);
+	pthread_rwlock_unlock(&shard->lock);
+
+	return ret;
+}
+
+/*
+ * func : delete a key, see pydict_del
+ *
+ * ret  : 0, NOT found; 1 founded.
+ */
+int pycdict_del(py_cdict_t* pycdict, const char* key, const int len)
+{
+	cdict_shard_t* shard = NULL;
+	SIGN64         sign;
+	int            ret   = 0;
+
+	sign.sign = py_sign64_inline(pycdict->hash, key, len);
+	shard     = pycdict_shard(pycdict, (unsigned int)(sign.sign>>32));
+
+	pthread_rwlock_wrlock(&shard->lock);
+	ret = pydict_del_node(shard->pydict, &sign);
+	pthread_rwlock_unlock(&shard->lock);
+
+	return ret;
+}
+
+/*
+ * func : find a key, see pydict_find
+ *
+ * ret  : 0, NOT found; 1, founded
+ */
+int pycdict_find(py_cdict_t* pycdict, const char* key, const int len, int* code, int* value)
+{
+	SIGN64  sign;
+	PNODE   node;
+
+	sign.sign = py_sign64_inline(pycdict->hash, key, len);
+	if(!pycdict_find_node(pycdict, &sign, &node)){
+		return 0;
+	}
+	*code  = node.code;
+	*value = node.value;
+	return 1;
+}
+
+/*
+ * func : find a node by signature, the node is copied out
+ *
+ * ret  : 0, NOT found; 1, founded
+ */
+int pycdict_find_node(py_cdict_t* pycdict, SIGN64* sign, PNODE* node)
+{
+	cdict_shard_t* shard = pycdict_shard(pycdict, (unsigned int)(sign->sign>>32));
+	PNODE*         pnode = NULL;
+
+	pthread_rwlock_rdlock(&shard->lock);
+	pnode = pydict_find_node(shard->pydict, sign);
+	if(pnode){
+		*node = *pnode;
+	}
+	pthread_rwlock_unlock(&shard->lock);
+
+	return pnode!=NULL;
+}
+
+/*
+ * func : get the node at or after a position
+ *
+ * args : shard_pos, node_pos, the position to start at
+ *      : node, pos, the node got and its position
+ *
+ * ret  : 0, reach the end
+ *      : 1, got a node
+ */
+static int pycdict_scan(py_cdict_t* pycdict, unsigned int shard_pos, int node_pos, 
+		PNODE* node, unsigned long* pos)
+{
+	cdict_shard_t* shard = NULL;
+	PNODE*         pnode = NULL;
+
+	for(;shard_pos<pycdict->shard_num;shard_pos++,node_pos=-1){
+		shard = pycdict->shards+shard_pos;
+
+		pthread_rwlock_rdlock(&shard->lock);
+		pnode = pydict_next(shard->pydict, &node_pos);
+		if(pnode){
+			*node = *pnode;
+		}
+		pthread_rwlock_unlock(&shard->lock);
+
+		if(pnode){
+			*pos = ((unsigned long)shard_pos<<32) | (unsigned int)node_pos;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * func : get the first node, see pydict_first
+ *
+ * args : node, the node is copied to it
+ *      : pos, return the position of the node
+ *
+ * ret  : 0, dict empty
+ *      : 1, got a node
+ */
+int pycdict_first(py_cdict_t* pycdict, PNODE* node, unsigned long* pos)
+{
+	return pycdict_scan(pycdict, 0, -1, node, pos);
+}
+
+/*
+ * func : get the node after pos, see pydict_next
+ *
+ * args : node, the node is copied to it
+ *      : pos, the start position, return the position of the node
+ *
+ * ret  : 0, reach the end
+ *      : 1, got a node
+ */
+int pycdict_next(py_cdict_t* pycdict, PNODE* node, unsigned long* pos)
+{
+	return pycdict_scan(pycdict, (unsigned int)(*pos>>32), (int)(unsigned int)*pos, node, pos);
+}
+
+/*
+ * func : total number of nodes
+ */
+unsigned int pycdict_size(py_cdict_t* pycdict)
+{
+	unsigned int  size = 0;
+	unsigned int  i    = 0;
+
+	for(i=0;i<pycdict->shard_num;i++){
+		pthread_rwlock_rdlock(&pycdict->shards[i].lock);
+		size += pycdict->shards[i].pydict->block_pos - pycdict->shards[i].pydict->free_num;
+		pthread_rwlock_unlock(&pycdict->shards[i].lock);
+	}
+
+	return size;
+}
+
+/*
+ * func : save a concurrent dict as a regular dict file
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+int pycdict_save(py_cdict_t* pycdict, const char* path, const char* file)
+{
+	FILE*          fp        = NULL;
+	unsigned int*  hashtab   = NULL;
+	unsigned int*  next      = NULL;
+	unsigned int   hashsize  = 0;
+	unsigned int   block_pos = 0;
+	unsigned int   base      = 0;
+	unsigned int   pos       = 0;
+	unsigned int   i         = 0;
+	unsigned int   j         = 0;
+	unsigned int   key_max   = 0;
+	int            known     = 1;
+	py_dict_t*     pydict    = NULL;
+	PNODE          node;
+	pydict_footer_t footer;
+	pydict_meta_t  meta;
+	char           fullpath[512];
+
+	for(i=0;i<pycdict->shard_num;i++){
+		pthread_rwlock_rdlock(&pycdict->shards[i].lock);
+		pydict     = pycdict->shards[i].pydict;
+		hashsize  += pydict->hashsize;
+		block_pos += pydict->block_pos;
+		known     &= pydict_key_max_known(pydict);
+		if(pydict->key_max > key_max){
+			key_max = pydict->key_max;
+		}
+	}
+
+	// link the nodes of all shards into one hash table, node positions
+	// are shard by shard
+	hashtab = (unsigned int*)malloc(sizeof(unsigned int)*hashsize);
+	next    = (unsigned int*)malloc(sizeof(unsigned int)*(block_pos+1));
+	if(!hashtab || !next){
+		goto failed;
+	}
+	for(i=0;i<hashsize;i++){
+		hashtab[i] = COMMON_NULL;
+	}
+	for(i=0,base=0;i<pycdict->shard_num;base+=pycdict->shards[i].pydict->block_pos,i++){
+		pydict = pycdict->shards[i].pydict;
+		for(j=0;j<pydict->block_pos;j++){
+			if(pydict_node(pydict, j)->code==-1){ // deleted
+				next[base+j] = COMMON_NULL;
+				continue;
+			}
+			pos          = (pydict_node(pydict, j)->sign1+pydict_node(pydict, j)->sign2) % hashsize;
+			next[base+j] = hashtab[pos];
+			hashtab[pos] = base+j;
+		}
+	}
+
+	if(cmps_path(fullpath, sizeof(fullpath), path, file) < 0){
+		goto failed;
+	}
+	if((fp=fopen(fullpath, "wb"))==NULL){
+		goto failed;
+	}
+	if(fwrite(&hashsize, sizeof(unsigned int), 1, fp)!=1){
+		goto failed;
+	}
+	if(fwrite(&block_pos, sizeof(unsigned int), 1, fp)!=1){
+		goto failed;
+	}
+	if(fwrite(hashtab, sizeof(unsigned int), hashsize, fp)!=hashsize){
+		goto failed;
+	}
+	for(i=0,base=0;i<pycdict->shard_num;base+=pycdict->shards[i].pydict->block_pos,i++){
+		pydict = pycdict->shards[i].pydict;
+		for(j=0;j<pydict->block_pos;j++){
+			node      = *pydict_node(pydict, j);
+			node.next = next[base+j];
+			if(fwrite(&node, sizeof(PNODE), 1, fp)!=1){
+				goto failed;
+			}
+		}
+	}
+	footer.magic = PYDICT_FILE_MAGIC;
+	footer.hash  = pycdict->hash;
+	if(fwrite(&footer, sizeof(footer), 1, fp)!=1){
+		goto failed;
+	}
+
+	// the longest key, unknown if a shard does not know it
+	if(known && key_max>0){
+		memset(&meta, 0, sizeof(meta));
+		meta.magic   = PYDICT_META_MAGIC;
+		meta.key_max = key_max;
+		if(fwrite(&meta, sizeof(meta), 1, fp)!=1){
+			goto failed;
+		}
+	}
+	if(fclose(fp)!=0){
+		fp = NULL;
+		goto failed;
+	}
+
+	for(i=0;i<pycdict->shard_num;i++){
+		pthread_rwlock_unlock(&pycdict->shards[i].lock);
+	}
+	free(hashtab);
+	free(next);
+
+	return 0;
+
+failed:
+	for(i=0;i<pycdict->shard_num;i++){
+		pthread_rwlock_unlock(&pycdict->shards[i].lock);
+	}
+	if(fp){
+		fclose(fp);
+		fp = NULL;
+	}
+	if(hashtab){
+		free(hashtab);
+		hashtab = NULL;
+	}
+	if(next){
+		free(next);
+		next = NULL;
+	}
+	return -1;
+}
+
+/*
+ * func : load a dict file into a concurrent dict
+ *
+ * args : path, file, a file saved by pydict_save or pycdict_save
+ *      : shard_num, number of shards
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_cdict_t struct
+ */
+py_cdict_t* pycdict_load(const char* path, const char* file, const int shard_num)
+{
+	FILE*          fp        = NULL;
+	py_cdict_t*    pycdict   = NULL;
+	unsigned int   hashsize  = 0;
+	unsigned int   block_pos = 0;
+	unsigned int   num       = 0;
+	unsigned int   i         = 0;
+	unsigned int   j         = 0;
+	PNODE          nodes[LOAD_STEP];
+	pydict_footer_t footer;
+	pydict_meta_t  meta;
+	char           fullpath[512];
+
+	memset(&meta, 0, sizeof(meta));
+	if(cmps_path(fullpath, sizeof(fullpath), path, file) < 0){
+		goto failed;
+	}
+	if((fp=fopen(fullpath, "rb"))==NULL){
+		goto failed;
+	}
+	if(fread(&hashsize, sizeof(unsigned int), 1, fp)!=1){
+		goto failed;
+	}
+	if(fread(&block_pos, sizeof(unsigned int), 1, fp)!=1){
+		goto failed;
+	}
+	if((pycdict = pycdict_create(shard_num, hashsize, block_pos)) == NULL){
+		goto failed;
+	}
+
+	// nodes are rehashed into shards, the hash table is not needed
+	if(fseeko(fp, (off_t)hashsize*sizeof(unsigned int), SEEK_CUR) < 0){
+		goto failed;
+	}
+	for(i=0;i<block_pos;i+=num){
+		num = block_pos-i < LOAD_STEP ? block_pos-i : LOAD_STEP;
+		if(fread(nodes, sizeof(PNODE), num, fp)!=num){
+			goto failed;
+		}
+		for(j=0;j<num;j++){
+			if(nodes[j].code==-1){ // deleted
+				continue;
+			}
+			if(pycdict_add_node(pycdict, nodes+j) < 0){
+				goto failed;
+			}
+		}
+	}
+
+	// keys are signed as in the file, murmur without a footer
+	pycdict->hash = PY_SIGN_MURMUR;
+	if(fread(&footer, sizeof(footer), 1, fp)==1 && footer.magic==PYDICT_FILE_MAGIC){
+		if(footer.hash>=PY_SIGN_NUM){
+			goto failed;
+		}
+		pycdict->hash = footer.hash;
+
+		// nodes are added by signature, the file knows the longest key
+		if(fread(&meta, sizeof(meta), 1, fp)!=1 || meta.magic!=PYDICT_META_MAGIC){
+			meta.key_max = 0;
+		}
+	}
+	for(i=0;i<pycdict->shard_num;i++){
+		pycdict->shards[i].pydict->hash    = pycdict->hash;
+		pycdict->shards[i].pydict->key_max = meta.key_max;
+	}
+
+	fclose(fp);
+	return pycdict;
+
+failed:
+	if(fp){
+		fclose(fp);
+		fp = NULL;
+	}
+	if(pycdict){
+		pycdict_free(pycdict);
+		pycdict = NULL;
+	}
+	return NULL;
+}
@@ -0,0 +1,140 @@
+/********************************************************************************
+ * Describe : a concurrent dict for many writer threads. keys are partitioned
+ *          : by the high bits of their signature into shards, each shard is 
+ *          : a py_dict_t with its own read-write lock, so writers of 
+ *          : different shards never wait for each other. 
+ *          : files are regular dict files, see pydict_save/pydict_load.
+ * 
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ * 
+ * Create   : 2008-10-15
+ * 
+ * Modify   : 2008-10-15
+ *******************************************************************************/
+#ifndef _PY_CDICT_H
+#define _PY_CDICT_H
+
+#include <pthread.h>
+#include <py_dict.h>
+
+// data structure define here
+//
+typedef struct _cdict_shard{
+	pthread_rwlock_t  lock;
+	py_dict_t*        pydict;
+}__attribute__((aligned(64))) cdict_shard_t;
+
+typedef struct _py_cdict{
+	cdict_shard_t*    shards;
+	unsigned int      shard_num;    // power of 2
+	unsigned int      shard_bits;
+	int               hash;         // signature function of all shards
+}py_cdict_t;
+
+
+// functions defined here
+//
+
+/*
+ * func : create a concurrent dict
+ *
+ * args : shard_num, number of shards, rounded up to a power of 2
+ *      : hashsize, nodesize, sizes of the whole dict, split among shards
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_cdict_t struct
+ */
+py_cdict_t*  pycdict_create(const int shard_num, const int hashsize, const int nodesize);
+
+/*
+ * func : free a concurrent dict
+ */
+void     pycdict_free(py_cdict_t* pycdict);
+
+/*
+ * func : load a dict file into a concurrent dict
+ *
+ * args : path, file, a file saved by pydict_save or pycdict_save
+ *      : shard_num, number of shards
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_cdict_t struct
+ */
+py_cdict_t*  pycdict_load(const char* path, const char* file, const int shard_num);
+
+/*
+ * func : save a concurrent dict as a regular dict file
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ *
+ * note : all shards are read locked while saving, so the file is a 
+ *      : snapshot of the dict.
+ */
+int      pycdict_save(py_cdict_t* pycdict, const char* path, const char* file);
+
+/*
+ * func : add a value pair, see pydict_add
+ *
+ * ret  : 1,  find a same key, value changed;
+ *      : 0,  find NO same key, new node added,
+ *      : -1, error;
+ */
+int      pycdict_add(py_cdict_t* pycdict, const char* key, const int len, const int code, const int value);
+
+/*
+ * func : add a node, see pydict_add_node
+ */
+int      pycdict_add_node(py_cdict_t* pycdict, PNODE* node);
+
+/*
+ * func : delete a key, see pydict_del
+ *
+ * ret  : 0, NOT found; 1 founded.
+ */
+int      pycdict_del(py_cdict_t* pycdict, const char* key, const int len);
+
+/*
+ * func : find a key, see pydict_find
+ *
+ * ret  : 0, NOT found; 1, founded
+ */
+int      pycdict_find(py_cdict_t* pycdict, const char* key, const int len, int* code, int* value);
+
+/*
+ * func : find a node by signature, the node is copied out
+ *
+ * ret  : 0, NOT found; 1, founded
+ */
+int      pycdict_find_node(py_cdict_t* pycdict, SIGN64* sign, PNODE* node);
+
+/*
+ * func : get the first node, see pydict_first
+ *
+ * args : node, the node is copied to it
+ *      : pos, return the position of the node
+ *
+ * ret  : 0, dict empty
+ *      : 1, got a node
+ */
+int      pycdict_first(py_cdict_t* pycdict, PNODE* node, unsigned long* pos);
+
+/*
+ * func : get the node after pos, see pydict_next
+ *
+ * args : node, the node is copied to it
+ *      : pos, the start position, return the position of the node
+ *
+ * ret  : 0, reach the end
+ *      : 1, got a node
+ *
+ * note : nodes added while iterating may be missed.
+ */
+int      pycdict_next(py_cdict_t* pycdict, PNODE* node, unsigned long* pos);
+
+/*
+ * func : total number of nodes
+ */
+unsigned int pycdict_size(py_cdict_t* pycdict);
+
+#endif
@@ -9,19 +9,625 @@
  **********************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
 #include <py_sign.h>
+#include <py_sign_inline.h>
 #include <py_utils.h>
 #include <py_dict.h>
+#include <py_swiss.h>
 
 
-#define BLOCK_STEP 50000
+#define REHASH_STEP 16      // buckets moved to the new table per add/find
+#define BATCH_STEP  16      // keys looked up together by the batch find
+#define NODE_MAX    0xFFFFFFF0u  // positions below COMMON_NULL
+#define ITER_STEP   65536   // nodes a thread of pydict_parallel_foreach takes at a time
+#define ITER_THREAD 64      // max threads of pydict_parallel_foreach
+#define BLOB_INIT   65536   // first size of the blob arena
+
+// words of the liveness bitmap of seg_num segments
+#define LIVE_WORDS(seg_num) ((size_t)(seg_num) << (PYDICT_SEG_SHIFT-6))
+
+
+/*
+ * func : get the key of a node by position, split layout
+ */
+static inline PKEY* pydict_key(py_dict_t* pydict, const unsigned int pos)
+{
+	return pydict->keys[pos>>PYDICT_SEG_SHIFT] + (pos&PYDICT_SEG_MASK);
+}
+
+/*
+ * func : mark a node live or not in the liveness bitmap
+ */
+static inline void pydict_set_live(py_dict_t* pydict, const unsigned int pos, const int live)
+{
+	if(!pydict->live){
+		return;
+	}
+	if(live){
+		pydict->live[pos>>6] |= 1UL<<(pos&63);
+	}
+	else{
+		pydict->live[pos>>6] &= ~(1UL<<(pos&63));
+	}
+}
+
+/*
+ * func : position of a node of the dict, segments are searched one by one
+ */
+static unsigned int pydict_node_pos(py_dict_t* pydict, const PNODE* pnode)
+{
+	unsigned int   i = 0;
+
+	for(i=0;i<pydict->seg_num;i++){
+		if(pnode>=pydict->segs[i] && pnode<pydict->segs[i]+PYDICT_SEG_SIZE){
+			return (i<<PYDICT_SEG_SHIFT) + (unsigned int)(pnode-pydict->segs[i]);
+		}
+	}
+	return COMMON_NULL;
+}
+
+/*
+ * func : walk a chain of the split layout, only keys are loaded
+ */
+static inline PNODE* pydict_walk_key(py_dict_t* pydict, unsigned int nodepos, 
+		unsigned int sign1, unsigned int sign2)
+{
+	PKEY* key = NULL;
+
+	while(nodepos!=COMMON_NULL){
+		key = pydict_key(pydict, nodepos);
+		if(key->sign1==sign1&&key->sign2==sign2){
+			return pydict_node(pydict, nodepos);
+		}
+		nodepos = key->next;
+	}
+
+	return NULL;
+}
+
+/*
+ * func : walk a chain for a signature
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : nodepos, head of the chain
+ *      : sign1, sign2, the signature
+ *
+ * ret  : NULL, not found
+ *      : else, pointer to the founded node
+ */
+static inline PNODE* pydict_walk(py_dict_t* pydict, unsigned int nodepos, 
+		unsigned int sign1, unsigned int sign2)
+{
+	PNODE* pnode = NULL;
+
+	if(pydict->keys){
+		return pydict_walk_key(pydict, nodepos, sign1, sign2);
+	}
+	while(nodepos!=COMMON_NULL){
+		pnode = pydict_node(pydict, nodepos);
+		if(pnode->sign1==sign1&&pnode->sign2==sign2){
+			return pnode;
+		}
+		nodepos = pnode->next;
+	}
+
+	return NULL;
+}
+
+/*
+ * func : find a node by signature, looking into the old table too
+ *        while rehashing
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : sign1, sign2, the signature
+ *
+ * ret  : NULL, not found
+ *      : else, pointer to the founded node
+ */
+static inline PNODE* pydict_lookup(py_dict_t* pydict, unsigned int sign1, unsigned int sign2)
+{
+	unsigned int   hashval    = sign1+sign2;
+	unsigned int   pos        = 0;
+	PNODE*         pnode      = NULL;
+
+	if(pydict->oldtab){ 
+		pos = hashval % pydict->oldsize;
+		if(pos >= pydict->rehash_pos){ // bucket not moved yet
+			pnode = pydict_walk(pydict, pydict->oldtab[pos], sign1, sign2);
+			if(pnode){
+				return pnode;
+			}
+		}
+	}
+
+	pos = hashval % pydict->hashsize;
+
+	return pydict_walk(pydict, pydict->hashtab[pos], sign1, sign2);
+}
+
+/*
+ * func : pydict_walk, add the nodes visited to probes
+ */
+static inline PNODE* pydict_walk_count(py_dict_t* pydict, unsigned int nodepos, 
+		unsigned int sign1, unsigned int sign2, unsigned int* probes)
+{
+	PNODE* pnode = NULL;
+	PKEY*  key   = NULL;
+
+	if(pydict->keys){
+		while(nodepos!=COMMON_NULL){
+			(*probes)++;
+			key = pydict_key(pydict, nodepos);
+			if(key->sign1==sign1&&key->sign2==sign2){
+				return pydict_node(pydict, nodepos);
+			}
+			nodepos = key->next;
+		}
+		return NULL;
+	}
+	while(nodepos!=COMMON_NULL){
+		(*probes)++;
+		pnode = pydict_node(pydict, nodepos);
+		if(pnode->sign1==sign1&&pnode->sign2==sign2){
+			return pnode;
+		}
+		nodepos = pnode->next;
+	}
+
+	return NULL;
+}
+
+/*
+ * func : pydict_lookup, add the nodes visited to probes
+ */
+static inline PNODE* pydict_lookup_count(py_dict_t* pydict, unsigned int sign1, unsigned int sign2,
+		unsigned int* probes)
+{
+	unsigned int   hashval    = sign1+sign2;
+	unsigned int   pos        = 0;
+	PNODE*         pnode      = NULL;
+
+	if(pydict->oldtab){ 
+		pos = hashval % pydict->oldsize;
+		if(pos >= pydict->rehash_pos){
+			pnode = pydict_walk_count(pydict, pydict->oldtab[pos], sign1, sign2, probes);
+			if(pnode){
+				return pnode;
+			}
+		}
+	}
+
+	pos = hashval % pydict->hashsize;
+
+	return pydict_walk_count(pydict, pydict->hashtab[pos], sign1, sign2, probes);
+}
+
+// counter slot of a thread, threads take slots in turn
+static int             pydict_thread_next = 0;
+static __thread int    pydict_thread_id   = -1;
+
+/*
+ * func : add find counts to the counter slot of the calling thread
+ */
+static inline void pydict_count(py_dict_t* pydict, unsigned int finds, unsigned int hits,
+		unsigned int probes)
+{
+	pydict_counter_t*  counter = NULL;
+
+	if(pydict_thread_id<0){
+		pydict_thread_id = __atomic_fetch_add(&pydict_thread_next, 1, __ATOMIC_RELAXED) & 0x7FFFFFFF;
+	}
+	counter = pydict->counters + pydict_thread_id % pydict->counter_num;
+
+	// the slot is owned by the thread, no locked add
+	__atomic_store_n(&counter->finds, __atomic_load_n(&counter->finds, __ATOMIC_RELAXED)+finds, 
+			__ATOMIC_RELAXED);
+	__atomic_store_n(&counter->hits, __atomic_load_n(&counter->hits, __ATOMIC_RELAXED)+hits, 
+			__ATOMIC_RELAXED);
+	__atomic_store_n(&counter->probes, __atomic_load_n(&counter->probes, __ATOMIC_RELAXED)+probes, 
+			__ATOMIC_RELAXED);
+}
+
+/*
+ * func : set next of a node, in keys too for the split layout
+ */
+static inline void pydict_set_next(py_dict_t* pydict, unsigned int nodepos, unsigned int next)
+{
+	pydict_node(pydict, nodepos)->next = next;
+	if(pydict->keys){
+		pydict_key(pydict, nodepos)->next = next;
+	}
+}
+
+/*
+ * func : start growing the hash table, the old table is kept and its 
+ *        buckets are moved to the new one by pydict_rehash_step
+ *
+ * ret  : 0, succeed
+ *      : -1, error, hash table can NOT grow
+ */
+static int pydict_rehash_start(py_dict_t* pydict)
+{
+	unsigned int*  hashtab  = NULL;
+	unsigned int   hashsize = 0;
+	unsigned int   i        = 0;
+
+	if(pydict->hashsize >= 0x7FFFFFFF){
+		return -1;
+	}
+	hashsize = pydict->hashsize*2+1;
+
+	hashtab = (unsigned int*)pyalloc_alloc(&pydict->alloc, sizeof(unsigned int)*hashsize);
+	if(!hashtab){
+		return -1;
+	}
+	for(i=0;i<hashsize;i++){
+		hashtab[i] = COMMON_NULL;
+	}
+
+	pydict->oldtab     = pydict->hashtab;
+	pydict->oldsize    = pydict->hashsize;
+	pydict->rehash_pos = 0;
+	pydict->hashtab    = hashtab;
+	pydict->hashsize   = hashsize;
+
+	return 0;
+}
+
+/*
+ * func : move some buckets of the old table to the new table
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : step, number of buckets to move
+ */
+static void pydict_rehash_step(py_dict_t* pydict, unsigned int step)
+{
+	unsigned int   empty    = 0;       // max empty buckets to visit
+	unsigned int   nodepos  = 0;
+	unsigned int   pos      = 0;
+	PNODE*         pnode    = NULL;
+
+	empty = step > 0xFFFFFFFF/10 ? 0xFFFFFFFF : step*10;
+	while(step>0 && pydict->rehash_pos<pydict->oldsize){
+		nodepos = pydict->oldtab[pydict->rehash_pos];
+		if(nodepos==COMMON_NULL){
+			pydict->rehash_pos++;
+			if(--empty==0){
+				break;
+			}
+			continue;
+		}
+		while(nodepos!=COMMON_NULL){
+			pnode   = pydict_node(pydict, nodepos);
+			pos     = (pnode->sign1+pnode->sign2) % pydict->hashsize;
+
+			unsigned int next = pnode->next;
+			pydict_set_next(pydict, nodepos, pydict->hashtab[pos]);
+			pydict->hashtab[pos] = nodepos;
+			nodepos = next;
+		}
+		pydict->oldtab[pydict->rehash_pos++] = COMMON_NULL;
+		step--;
+	}
+
+	if(pydict->rehash_pos>=pydict->oldsize){ // rehash finished
+		pyalloc_free(&pydict->alloc, pydict->oldtab, sizeof(unsigned int)*pydict->oldsize);
+		pydict->oldtab     = NULL;
+		pydict->oldsize    = 0;
+		pydict->rehash_pos = 0;
+	}
+}
+
+/*
+ * func : put a node to the free list, it is reused by the next add
+ */
+static inline void pydict_free_node(py_dict_t* pydict, unsigned int nodepos)
+{
+	PNODE* pnode = pydict_node(pydict, nodepos);
+
+	pnode->code  = -1;
+	pnode->value = 0;
+	pydict_set_live(pydict, nodepos, 0);
+	pydict_set_next(pydict, nodepos, pydict->free_head);
+	pydict->free_head = nodepos;
+	pydict->free_num++;
+}
+
+/*
+ * func : put the freed nodes of a loaded file to the free list, a freed
+ *        node has code -1 and is in no chain
+ *
+ * ret  : 0, succeed
+ *      : -1, error, out of memory or a chain is broken
+ */
+static int pydict_free_rebuild(py_dict_t* pydict)
+{
+	unsigned long*  linked  = NULL;
+	unsigned int    nodepos = 0;
+	unsigned int    i       = 0;
+
+	linked = (unsigned long*)calloc(pydict->block_pos/64+1, sizeof(unsigned long));
+	if(!linked){
+		return -1;
+	}
+	for(i=0;i<pydict->hashsize;i++){
+		nodepos = pydict->hashtab[i];
+		while(nodepos!=COMMON_NULL){
+			if(nodepos>=pydict->block_pos || (linked[nodepos>>6] & (1UL<<(nodepos&63)))){
+				free(linked);
+				return -1;
+			}
+			linked[nodepos>>6] |= 1UL<<(nodepos&63);
+			nodepos = pydict_node(pydict, nodepos)->next;
+		}
+	}
+
+	// pushed from the end, the lowest position is reused first
+	for(i=pydict->block_pos;i>0;i--){
+		if(!(linked[(i-1)>>6] & (1UL<<((i-1)&63))) && pydict_node(pydict, i-1)->code==-1){
+			pydict_free_node(pydict, i-1);
+		}
+	}
+	free(linked);
+	return 0;
+}
+
+/*
+ * func : unlink a node from a chain
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : link, head of the chain
+ *      : sign1, sign2, the signature
+ *
+ * ret  : COMMON_NULL, not found
+ *      : else, position of the unlinked node
+ */
+static unsigned int pydict_unlink(py_dict_t* pydict, unsigned int* link, 
+		unsigned int sign1, unsigned int sign2)
+{
+	unsigned int   nodepos = *link;
+	unsigned int   prev    = COMMON_NULL;
+	PNODE*         pnode   = NULL;
+
+	while(nodepos!=COMMON_NULL){
+		pnode   = pydict_node(pydict, nodepos);
+		if(pnode->sign1==sign1 && pnode->sign2==sign2){
+			if(prev==COMMON_NULL){
+				*link = pnode->next;
+			}
+			else{
+				pydict_set_next(pydict, prev, pnode->next);
+			}
+			return nodepos;
+		}
+		prev    = nodepos;
+		nodepos = pnode->next;
+	}
+
+	return COMMON_NULL;
+}
+
+/*
+ * func : link all nodes of block into chains of a hash table
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : hashtab, hashsize, the hash table and its size
+ *
+ * note : deleted nodes are not linked, their next keeps the free list.
+ */
+static void pydict_chain_link(py_dict_t* pydict, unsigned int* hashtab, unsigned int hashsize)
+{
+	unsigned int   pos     = 0;
+	unsigned int   i       = 0;
+	PNODE*         pnode   = NULL;
+
+	for(i=0;i<hashsize;i++){
+		hashtab[i] = COMMON_NULL;
+	}
+	for(i=0;i<pydict->block_pos;i++){
+		pnode        = pydict_node(pydict, i);
+		if(pnode->code==-1){
+			continue;
+		}
+		pos          = (pnode->sign1+pnode->sign2) % hashsize;
+		pydict_set_next(pydict, i, hashtab[pos]);  // front insert
+		hashtab[pos] = i;
+	}
+}
+
+/*
+ * func : link all nodes of block into chains of a new hash table
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : hashsize, the hash table size
+ *
+ * ret  : NULL, error
+ *      : else, the hash table, next of all nodes are changed
+ */
+static unsigned int* pydict_chain_build(py_dict_t* pydict, unsigned int hashsize)
+{
+	unsigned int*  hashtab = NULL;
+
+	hashtab = (unsigned int*)pyalloc_alloc(&pydict->alloc, sizeof(unsigned int)*hashsize);
+	if(!hashtab){
+		return NULL;
+	}
+	pydict_chain_link(pydict, hashtab, hashsize);
+
+	return hashtab;
+}
+
+/*
+ * func : hash table size for linking all nodes into chains
+ */
+static unsigned int pydict_chain_size(py_dict_t* pydict)
+{
+	unsigned int hashsize = pydict->hashsize;
+	unsigned int node_num = pydict->block_pos-pydict->free_num;
+
+	if(pydict->max_load>0 && node_num > hashsize*pydict->max_load){
+		hashsize = (unsigned int)(node_num/pydict->max_load)+1;
+	}
+	return hashsize > 0 ? hashsize : 1;
+}
+
+/*
+ * func : free the key segments of the split layout
+ */
+static void pydict_keys_free(py_dict_t* pydict)
+{
+	unsigned int i = 0;
+
+	if(!pydict->keys){
+		return;
+	}
+	for(i=0;i<pydict->seg_num;i++){
+		pyalloc_free(&pydict->alloc, pydict->keys[i], sizeof(PKEY)*PYDICT_SEG_SIZE);
+	}
+	free(pydict->keys);
+	pydict->keys = NULL;
+}
+
+/*
+ * func : nodes seg_num segments hold, the last segment is partly used,
+ *        positions stop at NODE_MAX
+ */
+static inline unsigned int pydict_segs_capacity(const unsigned int seg_num)
+{
+	unsigned long  size = (unsigned long)seg_num << PYDICT_SEG_SHIFT;
+
+	return size > NODE_MAX ? NODE_MAX : (unsigned int)size;
+}
+
+/*
+ * func : free node segments from segment seg_num on, the segments of a 
+ *        mapped dict are in the mapping and only the segment table is freed
+ */
+static void pydict_segs_trim(py_dict_t* pydict, unsigned int seg_num)
+{
+	unsigned long*  live = NULL;
+	unsigned int    i    = 0;
+
+	if(pydict->map_addr){
+		pydict_keys_free(pydict);
+		free(pydict->segs);
+		pydict->segs    = NULL;
+		pydict->seg_num = 0;
+		return;
+	}
+	if(seg_num>0 && seg_num>=pydict->seg_num){
+		return;
+	}
+	if(seg_num>0){ // keep all segments if the bitmap can not shrink
+		live = (unsigned long*)pyalloc_realloc(&pydict->alloc, pydict->live, 
+				sizeof(unsigned long)*LIVE_WORDS(pydict->seg_num), 
+				sizeof(unsigned long)*LIVE_WORDS(seg_num));
+		if(!live){
+			return;
+		}
+		pydict->live = live;
+	}
+	else{
+		pyalloc_free(&pydict->alloc, pydict->live, sizeof(unsigned long)*LIVE_WORDS(pydict->seg_num));
+		pydict->live = NULL;
+	}
+	for(i=seg_num;i<pydict->seg_num;i++){
+		pyalloc_free(&pydict->alloc, pydict->segs[i], sizeof(PNODE)*PYDICT_SEG_SIZE);
+		if(pydict->keys){
+			pyalloc_free(&pydict->alloc, pydict->keys[i], sizeof(PKEY)*PYDICT_SEG_SIZE);
+		}
+	}
+	pydict->seg_num    = seg_num;
+	pydict->block_size = pydict_segs_capacity(seg_num);
+	if(seg_num==0){
+		pydict_keys_free(pydict);
+		free(pydict->segs);
+		pydict->segs = NULL;
+	}
+}
+
+/*
+ * func : allocate node segments for node_num nodes
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : node_num, number of nodes
+ *
+ * ret  : 0, succeed
+ *      : -1, error, out of memory or the dict is mapped
+ */
+int pydict_reserve(py_dict_t* pydict, const unsigned int node_num)
+{
+	PNODE**        segs    = NULL;
+	PKEY**         keys    = NULL;
+	unsigned long* live    = NULL;
+	unsigned int   seg_num = 0;
+	unsigned int   i       = 0;
+
+	if(pydict->map_addr){
+		return -1;
+	}
+	seg_num = (unsigned int)(((unsigned long)node_num+PYDICT_SEG_MASK) >> PYDICT_SEG_SHIFT);
+
+	while(pydict->seg_num < seg_num){
+		i    = pydict->seg_num;
+		segs = (PNODE**)realloc(pydict->segs, sizeof(PNODE*)*(i+1));
+		if(!segs){
+			return -1;
+		}
+		pydict->segs = segs;
+		if(pydict->keys){
+			keys = (PKEY**)realloc(pydict->keys, sizeof(PKEY*)*(i+1));
+			if(!keys){
+				return -1;
+			}
+			pydict->keys = keys;
+		}
+
+		// a libc segment takes pages as nodes are added, a MAP_HUGETLB
+		// one of pyalloc_huge takes its huge pages now
+		segs[i] = (PNODE*)pyalloc_alloc(&pydict->alloc, sizeof(PNODE)*PYDICT_SEG_SIZE);
+		if(!segs[i]){
+			return -1;
+		}
+		if(pydict->keys){
+			keys[i] = (PKEY*)pyalloc_alloc(&pydict->alloc, sizeof(PKEY)*PYDICT_SEG_SIZE);
+			if(!keys[i]){
+				pyalloc_free(&pydict->alloc, segs[i], sizeof(PNODE)*PYDICT_SEG_SIZE);
+				return -1;
+			}
+		}
+		live = (unsigned long*)pyalloc_realloc(&pydict->alloc, pydict->live, 
+				sizeof(unsigned long)*LIVE_WORDS(i), sizeof(unsigned long)*LIVE_WORDS(i+1));
+		if(!live){
+			if(pydict->keys){
+				pyalloc_free(&pydict->alloc, keys[i], sizeof(PKEY)*PYDICT_SEG_SIZE);
+			}
+			pyalloc_free(&pydict->alloc, segs[i], sizeof(PNODE)*PYDICT_SEG_SIZE);
+			return -1;
+		}
+		memset(live+LIVE_WORDS(i), 0, sizeof(unsigned long)*LIVE_WORDS(1));
+		pydict->live = live;
+
+		pydict->seg_num++;
+		pydict->block_size = pydict_segs_capacity(pydict->seg_num);
+	}
+
+	return 0;
+}
 
 /*
  * func : create an py_dict_t struct
  *
  * args : hashsize, the hash table size
- *      : nodesize, the node array size
+ *      : nodesize, the nodes expected, segments are reserved for them if
+ *      :           they fill a segment, else the first add takes one
  *
  * ret  : NULL, error;
  *      : else, pointer the the py_dict_t struct
@@ -29,7 +635,6 @@
 py_dict_t*  pydict_create(const int hashsize, const int nodesize)
 {
 	py_dict_t*          pydict   = NULL;
-	PNODE*          block   = NULL;
 	unsigned int*   hashtab = NULL;
 	int             i       = 0;
 	
@@ -40,8 +645,11 @@ py_dict_t*  pydict_create(const int hashsize, const int nodesize)
 		goto failed;
 	}
 	
+	pydict->alloc = *pyalloc_get();
+	pydict->hash  = py_sign_get_default();
+	
 	// create hash table
-	hashtab = (unsigned int*)calloc(hashsize, sizeof(unsigned int));
+	hashtab = (unsigned int*)pyalloc_alloc(&pydict->alloc, sizeof(unsigned int)*hashsize);
 	if(!hashtab){
 		goto failed;
 	}
@@ -49,192 +657,563 @@ py_dict_t*  pydict_create(const int hashsize, const int nodesize)
 		hashtab[i] = COMMON_NULL;
 	}
 
-	block = (PNODE*)calloc(nodesize, sizeof(PNODE));
-	if(!block){
+	// a small dict maps no segment until it has nodes
+	if(nodesize>=(int)PYDICT_SEG_SIZE && pydict_reserve(pydict, nodesize) < 0){
 		goto failed;
 	}
-	for(i=0;i<nodesize;i++){
-		block[i].next = COMMON_NULL;
-	}
-
 	
 	pydict->hashtab      = hashtab;
 	pydict->hashsize     = hashsize;
-	pydict->block        = block;
-	pydict->block_size   = nodesize;
 	pydict->block_pos    = 0;
+	pydict->max_load     = PYDICT_MAX_LOAD;
+	pydict->free_head    = COMMON_NULL;
 
 	return pydict;
 
 failed:
+	if(hashtab){
+		pyalloc_free(&pydict->alloc, hashtab, sizeof(unsigned int)*hashsize);
+		hashtab = NULL;
+	}
 	if(pydict){
+		pydict_segs_trim(pydict, 0);
 		free(pydict);
 		pydict = NULL;
 	}
-	if(hashtab){
-		free(hashtab);
-		hashtab = NULL;
+	return NULL;
+}
+
+/*
+ * func : free a py_dict_t struct
+ */
+void pydict_free(py_dict_t* pydict)
+{
+	if(!pydict){
+		return;
+	}
+	if(pydict->map_addr){
+		pydict_unmap(pydict);
+		return;
+	}
+	if(pydict->hashtab){
+		pyalloc_free(&pydict->alloc, pydict->hashtab, sizeof(unsigned int)*pydict->hashsize);
+		pydict->hashtab=NULL;
+	}
+	if(pydict->oldtab){
+		pyalloc_free(&pydict->alloc, pydict->oldtab, sizeof(unsigned int)*pydict->oldsize);
+		pydict->oldtab=NULL;
+	}
+	pyswiss_free(pydict);
+	pydict_segs_trim(pydict, 0);
+	pyalloc_free(&pydict->alloc, pydict->blob, pydict->blob_cap);
+	if(pydict->counters){
+		free(pydict->counters);
+		pydict->counters = NULL;
+	}
+	free(pydict);
+	pydict = NULL;
+}
+
+/*
+ * func : add a value pair to the hash table;
+ * 
+ * args : pydict, the pointer to py_dict_t 
+ *      : key, value, the input pair
+ *
+ * ret  : 0,  find a same key, value changed;
+ *      : 1,  find NO same key, new node added,
+ *      : -1, error;
+ */
+int pydict_add(py_dict_t* pydict, const char* key, const int keylen, const int code, const int value)
+{
+	unsigned long  sign       = 0;
+	PNODE          node;
+
+	sign       = py_sign64_inline(pydict->hash, key, keylen);
+	node.sign1 = (unsigned int)(sign>>32);
+	node.sign2 = (unsigned int)sign;
+	node.code  = code;
+	node.value = value;
+
+	return pydict_add_node_len(pydict, &node, keylen);
+}
+
+/*
+ * func : append a record to the blob arena
+ *
+ * ret  : the record offset
+ *      : -1, error, out of memory or the arena is full
+ */
+static long pydict_blob_append(py_dict_t* pydict, const void* blob, const unsigned int blob_len)
+{
+	size_t   size   = 0;
+	size_t   cap    = 0;
+	size_t   offset = pydict->blob_size;
+	char*    arena  = NULL;
+
+	size = (sizeof(unsigned int)+(size_t)blob_len+1+PYDICT_BLOB_ALIGN-1) & ~(size_t)(PYDICT_BLOB_ALIGN-1);
+	if(offset+size > PYDICT_BLOB_MAX){
+		return -1;
+	}
+	if(offset+size > pydict->blob_cap){
+		cap = pydict->blob_cap>0 ? pydict->blob_cap : BLOB_INIT;
+		while(cap < offset+size){
+			cap *= 2;
+		}
+		if(pydict->blob){
+			arena = (char*)pyalloc_realloc(&pydict->alloc, pydict->blob, pydict->blob_cap, cap);
+		}
+		else{
+			arena = (char*)pyalloc_alloc(&pydict->alloc, cap);
+		}
+		if(!arena){
+			return -1;
+		}
+		pydict->blob     = arena;
+		pydict->blob_cap = cap;
+	}
+
+	memcpy(pydict->blob+offset, &blob_len, sizeof(unsigned int));
+	memcpy(pydict->blob+offset+sizeof(unsigned int), blob, blob_len);
+	memset(pydict->blob+offset+sizeof(unsigned int)+blob_len, 0, size-sizeof(unsigned int)-blob_len);
+	pydict->blob_size += size;
+
+	return (long)offset;
+}
+
+/*
+ * func : add a key with a variable length value, kept in the blob arena
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : key, keylen, the key
+ *      : code, the code of the node
+ *      : blob, blob_len, the value, copied into the arena
+ *
+ * ret  : 1,  find a same key, value changed;
+ *      : 0,  find NO same key, new node added,
+ *      : -1, error, out of memory, the arena is full or the dict is read only
+ */
+int pydict_add_blob(py_dict_t* pydict, const char* key, const int keylen, const int code,
+		const void* blob, const unsigned int blob_len)
+{
+	unsigned long  sign   = 0;
+	long           offset = 0;
+	PNODE          node;
+
+	if(pydict->map_addr || (blob==NULL && blob_len>0)){
+		return -1;
+	}
+	if((offset = pydict_blob_append(pydict, blob, blob_len)) < 0){
+		return -1;
+	}
+
+	sign       = py_sign64_inline(pydict->hash, key, keylen);
+	node.sign1 = (unsigned int)(sign>>32);
+	node.sign2 = (unsigned int)sign;
+	node.code  = code;
+	node.value = (int)(unsigned int)(offset/PYDICT_BLOB_ALIGN);
+
+	return pydict_add_node_len(pydict, &node, keylen);
+}
+
+/*
+ * func : add a node to the hash table;
+ * 
+ * args : pydict, pointer to py_dict_t 
+ *      : node , pointer to input node
+ *
+ * ret  : 0,  find a same key, value changed;
+ *      : 1,  find NO same key, new node added,
+ *      : -1, error;
+ *
+ * note : the key length is not known, a new node makes key_max 0
+ */
+int pydict_add_node(py_dict_t* pydict, PNODE* node) 
+{
+	unsigned int   pos        = 0;
+	unsigned int   hashval    = 0;
+	unsigned int   nodepos    = 0;
+	PNODE*         curnode    = NULL;
+
+	if(pydict->map_addr){ // mapped dict is read only
+		return -1;
+	}
+
+	if(pydict->engine==PYDICT_ENGINE_SWISS){
+		curnode = pyswiss_lookup(pydict, node->sign1, node->sign2);
+	}
+	else{
+		if(pydict->oldtab){
+			pydict_rehash_step(pydict, REHASH_STEP);
+		}
+		curnode = pydict_lookup(pydict, node->sign1, node->sign2);
+	}
+	if(curnode){ // find same key node
+		// a node of a file deleted with code -1 is live again, or the other way
+		if((curnode->code==-1) != (node->code==-1)){
+			pydict_set_live(pydict, pydict_node_pos(pydict, curnode), node->code!=-1);
+		}
+		curnode->code  = node->code;
+		curnode->value = node->value;
+		return 1;
+	}
+
+	// can not find same key node, add a new node, reuse a free node first
+	if(pydict->free_head!=COMMON_NULL){
+		nodepos = pydict->free_head;
+		pydict->free_head = pydict_node(pydict, nodepos)->next;
+		pydict->free_num--;
+	}
+	else{
+		nodepos = pydict->block_pos;
+		if(nodepos==pydict->block_size){ // all segments are full, add one, no node moves
+			if(nodepos>=NODE_MAX || pydict_reserve(pydict, nodepos+1) < 0){
+				return -1;
+			}
+		}
+		pydict->block_pos++;
+	}
+
+	curnode = pydict_node(pydict, nodepos);
+	curnode->sign1 = node->sign1;
+	curnode->sign2 = node->sign2;
+	curnode->code  = node->code;
+	curnode->value = node->value;
+	curnode->next  = COMMON_NULL;
+	pydict_set_live(pydict, nodepos, 1);
+	if(pydict->keys){
+		pydict_key(pydict, nodepos)->sign1 = node->sign1;
+		pydict_key(pydict, nodepos)->sign2 = node->sign2;
+	}
+
+	pydict->key_max = 0; // a key of unknown length, see pydict_key_max_known
+
+	if(pydict->engine==PYDICT_ENGINE_SWISS){
+		if(pyswiss_insert(pydict, nodepos) < 0){
+			pydict_free_node(pydict, nodepos);
+			return -1;
+		}
+		return 0;
+	}
+
+	// new node always goes to the new table
+	hashval = node->sign1+node->sign2;
+	pos     = hashval % pydict->hashsize;
+
+	pydict_set_next(pydict, nodepos, pydict->hashtab[pos]);  // front insert
+	pydict->hashtab[pos] = nodepos;
+
+	// grow the hash table when it is too crowded
+	if(!pydict->oldtab && pydict->max_load>0 && 
+	   pydict->block_pos-pydict->free_num > pydict->hashsize*pydict->max_load){
+		pydict_rehash_start(pydict);
+	}
+
+	return 0;
+}
+
+/*
+ * func : add a node of a key of keylen bytes, key_max counts the key
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : node, pointer to input node
+ *      : keylen, bytes of the key, -1 unknown as pydict_add_node
+ *
+ * ret  : see pydict_add_node
+ */
+int pydict_add_node_len(py_dict_t* pydict, PNODE* node, const int keylen)
+{
+	unsigned int   key_max = pydict->key_max;
+	int            known   = pydict_key_max_known(pydict);
+	int            ret     = 0;
+
+	ret = pydict_add_node(pydict, node);
+	if(ret>=0 && known && keylen>=0){
+		pydict->key_max = (unsigned int)keylen > key_max ? (unsigned int)keylen : key_max;
+	}
+	return ret;
+}
+
+/*
+ * func : set the signature function of an empty dict
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : hash, PY_SIGN_MURMUR, PY_SIGN_WYHASH or PY_SIGN_ROLL
+ *
+ * ret  : 0, succeed
+ *      : -1, error, the dict has nodes, is mapped or hash is unknown
+ */
+int pydict_set_hash(py_dict_t* pydict, const int hash)
+{
+	if(pydict->map_addr || pydict->block_pos>0 || hash<0 || hash>=PY_SIGN_NUM){
+		return -1;
+	}
+	pydict->hash = hash;
+
+	return 0;
+}
+
+/*
+ * func : switch the table engine of a dict, the table is rebuilt from the
+ *      : nodes, which are kept as they are
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : engine, PYDICT_ENGINE_CHAIN or PYDICT_ENGINE_SWISS
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+int pydict_set_engine(py_dict_t* pydict, const int engine)
+{
+	unsigned int*  hashtab  = NULL;
+	unsigned int   hashsize = 0;
+
+	if(pydict->map_addr){
+		return -1;
+	}
+	if(engine==pydict->engine){
+		return 0;
+	}
+
+	if(engine==PYDICT_ENGINE_SWISS){
+		if(pyswiss_build(pydict, 0) < 0){
+			return -1;
+		}
+		if(pydict->oldtab){
+			pyalloc_free(&pydict->alloc, pydict->oldtab, sizeof(unsigned int)*pydict->oldsize);
+			pydict->oldtab     = NULL;
+			pydict->oldsize    = 0;
+			pydict->rehash_pos = 0;
+		}
+		pyalloc_free(&pydict->alloc, pydict->hashtab, sizeof(unsigned int)*pydict->hashsize);
+		pydict->hashtab = NULL;
+		pydict->engine  = PYDICT_ENGINE_SWISS;
+		pydict_set_layout(pydict, PYDICT_LAYOUT_NODE);
+		return 0;
+	}
+	else if(engine==PYDICT_ENGINE_CHAIN){
+		hashsize = pydict_chain_size(pydict);
+		hashtab  = pydict_chain_build(pydict, hashsize);
+		if(!hashtab){
+			return -1;
+		}
+		pyswiss_free(pydict);
+		pydict->hashtab  = hashtab;
+		pydict->hashsize = hashsize;
+		pydict->engine   = PYDICT_ENGINE_CHAIN;
+		return 0;
+	}
+
+	return -1;
+}
+
+/*
+ * func : set the node layout of a chain engine dict
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : layout, PYDICT_LAYOUT_NODE or PYDICT_LAYOUT_SPLIT
+ *
+ * ret  : 0, succeed
+ *      : -1, error, swiss engine or out of memory
+ */
+int pydict_set_layout(py_dict_t* pydict, const int layout)
+{
+	PKEY*          key = NULL;
+	PNODE*         node = NULL;
+	unsigned int   k    = 0;
+	unsigned int   i    = 0;
+
+	if(layout==PYDICT_LAYOUT_NODE){
+		pydict_keys_free(pydict);
+		pydict->layout = PYDICT_LAYOUT_NODE;
+		return 0;
+	}
+	if(layout!=PYDICT_LAYOUT_SPLIT || pydict->engine!=PYDICT_ENGINE_CHAIN){
+		return -1;
+	}
+	if(pydict->keys){
+		return 0;
+	}
+
+	// one keys segment for each node segment, a mapped dict too
+	pydict->keys = (PKEY**)calloc(pydict->seg_num>0 ? pydict->seg_num : 1, sizeof(PKEY*));
+	if(!pydict->keys){
+		return -1;
+	}
+	for(k=0;k<pydict->seg_num;k++){
+		pydict->keys[k] = (PKEY*)pyalloc_alloc(&pydict->alloc, sizeof(PKEY)*PYDICT_SEG_SIZE);
+		if(!pydict->keys[k]){
+			pydict_keys_free(pydict);
+			return -1;
+		}
 	}
-	if(block){
-		free(block);
-		block = NULL;
+	for(i=0;i<pydict->block_pos;i++){
+		node = pydict_node(pydict, i);
+		key  = pydict_key(pydict, i);
+		key->sign1 = node->sign1;
+		key->sign2 = node->sign2;
+		key->next  = node->next;
 	}
-	return NULL;
+	pydict->layout = PYDICT_LAYOUT_SPLIT;
+
+	return 0;
 }
 
 /*
- * func : free a py_dict_t struct
+ * func : set the max load factor of the hash table
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : max_load, hash table grows when node number > hashsize*max_load,
+ *      :           0 means never grow.
  */
-void pydict_free(py_dict_t* pydict)
+void pydict_set_max_load(py_dict_t* pydict, const float max_load)
 {
-	if(!pydict){
+	if(pydict->map_addr){
 		return;
 	}
-	if(pydict->hashtab){
-		free(pydict->hashtab);
-		pydict->hashtab=NULL;
-	}
-	if(pydict->block){
-		free(pydict->block);
-		pydict->block = NULL;
+	pydict->max_load = max_load > 0 ? max_load : 0;
+}
+
+/*
+ * func : finish a pending rehash at once
+ */
+void pydict_rehash_finish(py_dict_t* pydict)
+{
+	while(pydict->oldtab){
+		pydict_rehash_step(pydict, pydict->oldsize);
 	}
-	free(pydict);
-	pydict = NULL;
 }
 
 /*
- * func : add a value pair to the hash table;
- * 
- * args : pydict, the pointer to py_dict_t 
- *      : key, value, the input pair
- *
- * ret  : 0,  find a same key, value changed;
- *      : 1,  find NO same key, new node added,
- *      : -1, error;
+ * func : reset the hash table;
  */
-int pydict_add(py_dict_t* pydict, const char* key, const int keylen, const int code, const int value)
+void pydict_reset(py_dict_t* pydict)
 {
-	unsigned int   sign1      = 0;
-	unsigned int   sign2      = 0;
-	PNODE          node;
+	unsigned int i = 0;
 
-	py_sign64_double_int(key, keylen, &sign1, &sign2);
-	node.sign1 = sign1;
-	node.sign2 = sign2;
-	node.code  = code;
-	node.value = value;
+	if(pydict->map_addr){
+		return;
+	}
 
-	return pydict_add_node(pydict, &node);
+	if(pydict->oldtab){ // drop the pending rehash
+		pyalloc_free(&pydict->alloc, pydict->oldtab, sizeof(unsigned int)*pydict->oldsize);
+		pydict->oldtab     = NULL;
+		pydict->oldsize    = 0;
+		pydict->rehash_pos = 0;
+	}
+
+	for(i=0;i<pydict->block_pos;i++){
+		pydict_set_next(pydict, i, COMMON_NULL);
+	}
+	if(pydict->live){
+		memset(pydict->live, 0, sizeof(unsigned long)*((pydict->block_pos+63)/64));
+	}
+	pydict->block_pos = 0;
+	pydict->free_head = COMMON_NULL;
+	pydict->free_num  = 0;
+	pydict->blob_size = 0;
+	pydict->key_max   = 0;
+
+	if(pydict->engine==PYDICT_ENGINE_SWISS){
+		pyswiss_reset(pydict);
+		return;
+	}
+	for(i=0;i<pydict->hashsize;i++){
+		pydict->hashtab[i] = COMMON_NULL;
+	}
 }
 
 /*
- * func : add a node to the hash table;
- * 
- * args : pydict, pointer to py_dict_t 
- *      : node , pointer to input node
+ * func : rebuild the liveness bitmap from the codes of the nodes
  *
- * ret  : 0,  find a same key, value changed;
- *      : 1,  find NO same key, new node added,
- *      : -1, error;
+ * note : for the node arrays filled in place, load, build and compact
  */
-int pydict_add_node(py_dict_t* pydict, PNODE* node) 
+void pydict_live_rebuild(py_dict_t* pydict)
 {
-	unsigned int   pos        = 0;
-	unsigned int   hashval    = 0;
-	unsigned int   hashsize   = 0;
-	unsigned int*  hashtab    = NULL;
-	PNODE*         curnode    = NULL;
+	unsigned int   i = 0;
 
-	hashval  = node->sign1+node->sign2;
-	hashtab  = pydict->hashtab;
-	hashsize = pydict->hashsize;
-	pos = hashval % hashsize;
-
-	if(hashtab[pos]==COMMON_NULL){ // can not find in hash table
-		unsigned int block_size = pydict->block_size;
-		unsigned int block_pos  = pydict->block_pos;
-		if(block_pos==block_size){ // if block array is full, realloc block array
-			PNODE* block = pydict->block;
-			block = (PNODE*)realloc(block, sizeof(PNODE)*(block_size+BLOCK_STEP));
-			if(!block){
-				assert(0);
-			}
-			block_size += BLOCK_STEP;
-			pydict->block = block;
-			pydict->block_size = block_size;
+	if(!pydict->live){
+		return;
+	}
+	memset(pydict->live, 0, sizeof(unsigned long)*LIVE_WORDS(pydict->seg_num));
+	for(i=0;i<pydict->block_pos;i++){
+		if(pydict_node(pydict, i)->code != -1){
+			pydict->live[i>>6] |= 1UL<<(i&63);
 		}
+	}
+}
 
-		curnode = pydict->block+block_pos;
-		curnode->sign1 = node->sign1;
-		curnode->sign2 = node->sign2;
-		curnode->code  = node->code;
-		curnode->value = node->value;
-		curnode->next  = COMMON_NULL;
-		hashtab[pos]   = block_pos; 
+/*
+ * func : find the first live node in [pos, end)
+ *
+ * ret  : end, no live node
+ *      : else, position of the node
+ *
+ * note : the bitmap skips 64 freed nodes a word, a mapped dict has no 
+ *      : bitmap and reads the code of every node
+ */
+static inline unsigned int pydict_live_next(py_dict_t* pydict, unsigned int pos, 
+		const unsigned int end)
+{
+	unsigned long   word = 0;
+	unsigned long   w    = 0;
 
-		block_pos++;
-		pydict->block_pos = block_pos;
-		return 0;
+	if(pos>=end){
+		return end;
 	}
-	else{
-		unsigned int nodepos = hashtab[pos];
-		PNODE*       pnode   = pydict->block+nodepos;
-		while((unsigned int)pnode->next!=COMMON_NULL){
-			if(pnode->sign1==node->sign1&&pnode->sign2==node->sign2) {
-				break;
+	if(!pydict->live){
+		for(;pos<end;pos++){
+			if(pydict_node(pydict, pos)->code != -1){
+				return pos;
 			}
-			pnode     = pydict->block+pnode->next;
-		}
-		if(pnode->sign1==node->sign1 && pnode->sign2==node->sign2){ // find same key node
-			pnode->code  = node->code;
-			pnode->value = node->value;
-			return 1;
 		}
+		return end;
+	}
 
-		// can not find same key node, add a new node
-		unsigned int block_size = pydict->block_size;
-		unsigned int block_pos = pydict->block_pos;
-		if(block_pos==block_size){
-			PNODE* block = pydict->block;
-			block = (PNODE*)realloc(block, sizeof(PNODE)*(block_size+BLOCK_STEP));
-			if(!block){
-				assert(0);
-			}
-			block_size += BLOCK_STEP;
-			pydict->block = block;
-			pydict->block_size = block_size;
+	w    = pos>>6;
+	word = pydict->live[w] & (~0UL<<(pos&63));
+	while(!word){
+		w++;
+		if((w<<6)>=end){
+			return end;
 		}
-		
-		PNODE* curnode = pydict->block+block_pos;
-		curnode->sign1 = node->sign1;
-		curnode->sign2 = node->sign2;
-		curnode->code  = node->code;
-		curnode->value = node->value;
-		curnode->next  = hashtab[pos];  // front insert
-		hashtab[pos] = block_pos;
-
-		block_pos++;
-		pydict->block_pos = block_pos;
-		return 0;
+		word = pydict->live[w];
 	}
+	pos = (unsigned int)((w<<6) + __builtin_ctzl(word));
 
+	return pos<end ? pos : end;
 }
 
 /*
- * func : reset the hash table;
+ * func : call func on the live nodes in [begin, end), see pydict_iter_range
+ *
+ * args : stop, set to 1 if func stopped the iteration, may be NULL
  */
-void pydict_reset(py_dict_t* pydict)
+static unsigned int pydict_iter_nodes(py_dict_t* pydict, unsigned int begin, unsigned int end, 
+		pydict_iter_func func, void* arg, int* stop)
 {
-	unsigned int i = 0;
+	PNODE*         pnode = NULL;
+	unsigned int   num   = 0;
+	unsigned int   pos   = 0;
 
-	for(i=0;i<pydict->block_pos;i++){
-		pydict->block[i].next = COMMON_NULL;
+	if(end>pydict->block_pos){
+		end = pydict->block_pos;
 	}
-	pydict->block_pos = 0;
-
-	for(i=0;i<pydict->hashsize;i++){
-		pydict->hashtab[i] = COMMON_NULL;
+	for(pos=pydict_live_next(pydict, begin, end);pos<end;pos=pydict_live_next(pydict, pos+1, end)){
+		pnode = pydict_node(pydict, pos);
+		if(pnode->code == -1){ // a delete kept by a merging log
+			continue;
+		}
+		num++;
+		if(func(pnode, pos, arg) != 0){
+			if(stop){
+				*stop = 1;
+			}
+			break;
+		}
 	}
+
+	return num;
 }
 
 /*
@@ -247,18 +1226,14 @@ void pydict_reset(py_dict_t* pydict)
  */
 PNODE* pydict_first(py_dict_t* pydict, unsigned int* pos)
 {
-	PNODE*        pnode = NULL;
-	unsigned int  i     = 0;
+	int   start = -1;
 
-	for(i=0;i<pydict->block_pos;i++){
-		pnode = pydict->block+i;
-		if(pnode->code != -1){
-			*pos = i;
-			return pnode;
-		}
+	if(pydict_next(pydict, &start) == NULL){
+		return NULL;
 	}
-	
-	return NULL;
+	*pos = (unsigned int)start;
+
+	return pydict_node(pydict, *pos);
 }
 
 /*
@@ -274,41 +1249,399 @@ PNODE* pydict_next(py_dict_t* pydict, int* pos)
 	PNODE*        pnode = NULL;
 	unsigned int  i     = 0;
 
-	for(i=*pos+1;i<pydict->block_pos;i++){
-		pnode = pydict->block+i;
+	for(i=pydict_live_next(pydict, (unsigned int)(*pos+1), pydict->block_pos);
+	    i<pydict->block_pos;
+	    i=pydict_live_next(pydict, i+1, pydict->block_pos)){
+		pnode = pydict_node(pydict, i);
 		if(pnode->code != -1){
 			*pos = i;
 			return pnode;
 		}
 	}
 
-	return NULL;
+	return NULL;
+}
+
+/*
+ * func : call func on the live nodes in a range of positions
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : begin, end, the range [begin, end) of node positions, end is 
+ *      :             cut to block_pos
+ *      : func, called with a node, its position and arg, returns 0 to go 
+ *      :       on, else the iteration stops
+ *      : arg, passed to func
+ *
+ * ret  : number of nodes passed to func
+ */
+unsigned int pydict_iter_range(py_dict_t* pydict, const unsigned int begin, const unsigned int end, 
+		pydict_iter_func func, void* arg)
+{
+	return pydict_iter_nodes(pydict, begin, end, func, arg, NULL);
+}
+
+typedef struct _iter_ctx{
+	py_dict_t*          pydict;
+	pydict_iter_func    func;
+	void*               arg;
+	unsigned long       next;       // first position not taken by a thread
+	unsigned long       num;        // nodes passed to func
+	int                 stop;
+}iter_ctx_t;
+
+/*
+ * func : a thread of pydict_parallel_foreach, takes ITER_STEP nodes at a time
+ */
+static void* pydict_iter_thread(void* arg)
+{
+	iter_ctx_t*     ctx   = (iter_ctx_t*)arg;
+	unsigned long   begin = 0;
+	unsigned long   end   = 0;
+	unsigned int    num   = 0;
+	int             stop  = 0;
+
+	while(!__atomic_load_n(&ctx->stop, __ATOMIC_RELAXED)){
+		begin = __atomic_fetch_add(&ctx->next, ITER_STEP, __ATOMIC_RELAXED);
+		if(begin>=ctx->pydict->block_pos){
+			break;
+		}
+		end = begin+ITER_STEP < ctx->pydict->block_pos ? begin+ITER_STEP : ctx->pydict->block_pos;
+		num = pydict_iter_nodes(ctx->pydict, (unsigned int)begin, (unsigned int)end, 
+				ctx->func, ctx->arg, &stop);
+		__atomic_fetch_add(&ctx->num, num, __ATOMIC_RELAXED);
+		if(stop){
+			__atomic_store_n(&ctx->stop, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * func : call func on all live nodes from several threads
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : thread_num, number of threads, <=0 for all cores
+ *      : func, arg, see pydict_iter_range, func is called concurrently
+ *
+ * ret  : number of nodes passed to func
+ *
+ * note : threads take ranges of ITER_STEP nodes until all are taken, the 
+ *      : caller is one of them. a thread that can not be created is not 
+ *      : waited for. the dict must not be changed while iterating. if func
+ *      : stops, the other threads stop after their current node.
+ */
+unsigned long pydict_parallel_foreach(py_dict_t* pydict, int thread_num, 
+		pydict_iter_func func, void* arg)
+{
+	pthread_t    threads[ITER_THREAD];
+	int          started[ITER_THREAD];
+	iter_ctx_t   ctx;
+	int          i = 0;
+
+	if(thread_num<=0){
+		thread_num = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if(thread_num<1){
+		thread_num = 1;
+	}
+	if(thread_num>ITER_THREAD){
+		thread_num = ITER_THREAD;
+	}
+	if((unsigned long)thread_num*ITER_STEP > pydict->block_pos){ // no thread idles
+		thread_num = pydict->block_pos/ITER_STEP + 1;
+	}
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.pydict = pydict;
+	ctx.func   = func;
+	ctx.arg    = arg;
+
+	for(i=1;i<thread_num;i++){
+		started[i] = (pthread_create(&threads[i], NULL, pydict_iter_thread, &ctx)==0);
+	}
+	pydict_iter_thread(&ctx);
+	for(i=1;i<thread_num;i++){
+		if(started[i]){
+			pthread_join(threads[i], NULL);
+		}
+	}
+
+	return ctx.num;
+}
+
+/*
+ * func : delete a node in the hash table
+ *
+ * args : pydict, pointer to hash table;
+ *      : key, the tobe delete node key
+ *
+ * ret  : 0, NOT found; 1 founded.
+ *      : -1, error, the dict is read only
+ *
+ * node : just mark delete, set pnode->code to -1 mean delete.
+ */
+int pydict_del(py_dict_t* pydict, const char* key, const int keylen)
+{
+	SIGN64         sign;
+
+	sign.sign = py_sign64_inline(pydict->hash, key, keylen);
+
+	return pydict_del_node(pydict, &sign);
+}
+
+/*
+ * func : delete a node by signature
+ *
+ * args : pydict, pointer to hash table;
+ *      : sign, 64 bit string signature
+ *
+ * ret  : 0, NOT found; 1 founded.
+ *      : -1, error, the dict is read only
+ */
+int pydict_del_node(py_dict_t* pydict, SIGN64* sign)
+{
+	unsigned int   sign1   = 0;
+	unsigned int   sign2   = 0;
+	unsigned int   hashval = 0;
+	unsigned int   pos     = 0;
+	unsigned int   nodepos = COMMON_NULL;
+
+	if(pydict->map_addr){
+		return -1;
+	}
+
+	sign1 = (unsigned int)(sign->sign>>32);
+	sign2 = (unsigned int)sign->sign;
+
+	if(pydict->engine==PYDICT_ENGINE_SWISS){
+		nodepos = pyswiss_erase(pydict, sign1, sign2);
+	}
+	else{
+		hashval = sign1+sign2;
+		if(pydict->oldtab){
+			pos = hashval % pydict->oldsize;
+			if(pos >= pydict->rehash_pos){ // bucket not moved yet
+				nodepos = pydict_unlink(pydict, pydict->oldtab+pos, sign1, sign2);
+			}
+		}
+		if(nodepos==COMMON_NULL){
+			pos     = hashval % pydict->hashsize;
+			nodepos = pydict_unlink(pydict, pydict->hashtab+pos, sign1, sign2);
+		}
+	}
+	if(nodepos==COMMON_NULL){
+		return 0;
+	}
+
+	pydict_free_node(pydict, nodepos);
+
+	return 1;
+}
+
+/*
+ * func : drop deleted nodes, move all nodes to the front of block and 
+ *        rebuild the hash table
+ *
+ * args : pydict, pointer to py_dict_t
+ *
+ * ret  : -1, error, the dict is read only or out of memory
+ *      : else, number of dropped nodes
+ */
+int pydict_compact(py_dict_t* pydict)
+{
+	unsigned int   seg_num  = 0;
+	unsigned int   pos      = 0;
+	unsigned int   i        = 0;
+	int            dropped  = 0;
+
+	if(pydict->map_addr){
+		return -1;
+	}
+
+	pydict_rehash_finish(pydict);
+
+	for(i=0;i<pydict->block_pos;i++){
+		if(pydict_node(pydict, i)->code==-1){
+			continue;
+		}
+		if(pos!=i){
+			*pydict_node(pydict, pos) = *pydict_node(pydict, i);
+			if(pydict->keys){
+				*pydict_key(pydict, pos) = *pydict_key(pydict, i);
+			}
+		}
+		pos++;
+	}
+	dropped = pydict->block_pos-pos;
+	pydict->block_pos = pos;
+	pydict->free_head = COMMON_NULL;
+	pydict->free_num  = 0;
+	pydict_live_rebuild(pydict);
+
+	// rebuild in place, fewer nodes always fit the table
+	if(pydict->engine==PYDICT_ENGINE_SWISS){
+		pyswiss_relink(pydict);
+	}
+	else{
+		pydict_chain_link(pydict, pydict->hashtab, pydict->hashsize);
+	}
+
+	// give back the segments of dropped nodes, keep one
+	seg_num = (unsigned int)(((unsigned long)pos+PYDICT_SEG_MASK) >> PYDICT_SEG_SHIFT);
+	pydict_segs_trim(pydict, seg_num > 0 ? seg_num : 1);
+
+	return dropped;
+}
+
+/*
+ * func : add a chain of length len to stats
+ */
+static void pydict_stats_chain(pydict_stats_t* stats, unsigned int len, double* walk)
+{
+	if(len==0){
+		return;
+	}
+	stats->used++;
+	stats->len_hist[len<PYDICT_STATS_LEN_MAX ? len : PYDICT_STATS_LEN_MAX]++;
+	if(len>stats->max_len){
+		stats->max_len = len;
+	}
+	*walk += (double)len*(len+1)/2; // the i-th node of a chain walks i nodes
+}
+
+/*
+ * func : get the health metrics of a dict
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : stats, the result
+ *
+ * ret  : 0, succeed
+ */
+int pydict_stats(py_dict_t* pydict, pydict_stats_t* stats)
+{
+	PNODE*         pnode   = NULL;
+	unsigned int   nodepos = 0;
+	unsigned int   len     = 0;
+	unsigned int   probes  = 0;
+	unsigned int   i       = 0;
+	double         walk    = 0;
+
+	memset(stats, 0, sizeof(pydict_stats_t));
+	stats->engine     = pydict->engine;
+	stats->hash       = pydict->hash;
+	stats->mapped     = pydict->map_addr!=NULL;
+	stats->rehashing  = pydict->oldtab!=NULL;
+	stats->block_pos  = pydict->block_pos;
+	stats->block_size = pydict->block_size;
+	stats->slack      = pydict->block_size - pydict->block_pos;
+	stats->free_num   = pydict->free_num;
+
+	for(i=0;i<pydict->block_pos;i++){
+		if(pydict_node(pydict, i)->code==-1){
+			stats->deleted_num++;
+		}
+	}
+	stats->node_num = pydict->block_pos - stats->deleted_num;
+
+	if(pydict->engine==PYDICT_ENGINE_SWISS){
+		stats->hashsize = pydict->capacity;
+		for(i=0;i<pydict->capacity;i++){
+			stats->used += pydict->ctrl[i] < SWISS_EMPTY;
+		}
+		for(i=0;i<pydict->block_pos;i++){
+			pnode = pydict_node(pydict, i);
+			if(pnode->code==-1){
+				continue;
+			}
+			probes = 0;
+			pyswiss_lookup_count(pydict, pnode->sign1, pnode->sign2, &probes);
+			stats->len_hist[probes<PYDICT_STATS_LEN_MAX ? probes : PYDICT_STATS_LEN_MAX]++;
+			if(probes>stats->max_len){
+				stats->max_len = probes;
+			}
+			walk += probes;
+		}
+		stats->bytes = (size_t)pydict->capacity*(1+sizeof(unsigned int));
+	}
+	else{
+		stats->hashsize = pydict->hashsize;
+		for(i=0;i<pydict->hashsize;i++){
+			len = 0;
+			for(nodepos=pydict->hashtab[i];nodepos!=COMMON_NULL;nodepos=pydict_node(pydict, nodepos)->next){
+				len++;
+			}
+			pydict_stats_chain(stats, len, &walk);
+		}
+		for(i=pydict->rehash_pos;pydict->oldtab && i<pydict->oldsize;i++){
+			len = 0;
+			for(nodepos=pydict->oldtab[i];nodepos!=COMMON_NULL;nodepos=pydict_node(pydict, nodepos)->next){
+				len++;
+			}
+			pydict_stats_chain(stats, len, &walk);
+		}
+		stats->bytes = (size_t)(pydict->hashsize+pydict->oldsize)*sizeof(unsigned int);
+	}
+
+	if(stats->node_num>0){
+		stats->avg_len = walk/stats->node_num;
+	}
+	if(stats->hashsize>0){
+		stats->load = (double)stats->node_num/stats->hashsize;
+	}
+	if(pydict->map_addr){
+		stats->bytes = pydict->map_size;
+	}
+	else{
+		stats->bytes += (size_t)pydict->seg_num*PYDICT_SEG_SIZE*sizeof(PNODE);
+	}
+	if(pydict->keys){
+		stats->bytes += (size_t)pydict->seg_num*PYDICT_SEG_SIZE*sizeof(PKEY);
+	}
+	if(pydict->live){
+		stats->bytes += LIVE_WORDS(pydict->seg_num)*sizeof(unsigned long);
+	}
+	stats->bytes += sizeof(py_dict_t) + (size_t)pydict->counter_num*sizeof(pydict_counter_t);
+	stats->bytes += pydict->blob_cap;
+	stats->blob_size = pydict->blob_size;
+	stats->key_max   = pydict->key_max;
+
+	for(i=0;i<pydict->counter_num;i++){
+		stats->finds  += __atomic_load_n(&pydict->counters[i].finds, __ATOMIC_RELAXED);
+		stats->hits   += __atomic_load_n(&pydict->counters[i].hits, __ATOMIC_RELAXED);
+		stats->probes += __atomic_load_n(&pydict->counters[i].probes, __ATOMIC_RELAXED);
+	}
+	stats->misses = stats->finds - stats->hits;
+
+	return 0;
 }
 
 /*
- * func : delete a node in the hash table
+ * func : count finds, hits and probes of a dict
  *
- * args : pydict, pointer to hash table;
- *      : key, the tobe delete node key
- *
- * ret  : 0, NOT found; 1 founded.
+ * args : pydict, pointer to py_dict_t
+ *      : slot_num, counter slots, 0 to stop counting
  *
- * node : just mark delete, set pnode->code to -1 mean delete.
+ * ret  : 0, succeed
+ *      : -1, error
  */
-int pydict_del(py_dict_t* pydict, const char* key, const int keylen)
+int pydict_counters_enable(py_dict_t* pydict, const int slot_num)
 {
-	PNODE* pnode = NULL;
+	void*   counters = NULL;
 
-	pnode = pydict_find_node_str(pydict, key, keylen);
-	if(!pnode){
-		return 0;
+	if(slot_num>0){
+		if(posix_memalign(&counters, 64, sizeof(pydict_counter_t)*slot_num) != 0){
+			return -1;
+		}
+		memset(counters, 0, sizeof(pydict_counter_t)*slot_num);
 	}
-	else{
-		pnode->code = -1;
-		return 1;
+	if(pydict->counters){
+		free(pydict->counters);
 	}
+	pydict->counters    = (pydict_counter_t*)counters;
+	pydict->counter_num = slot_num>0 ? slot_num : 0;
 
-	
+	return 0;
 }
 
 /*
@@ -334,6 +1667,60 @@ int pydict_find(py_dict_t* pydict, const char* key, const int keylen, int* code,
 	}
 }
 
+/*
+ * func : the blob of a node, when iterating a dict with blobs
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : pnode, a node added by pydict_add_blob
+ *      : blob_len, the blob length
+ *
+ * ret  : NULL, the value is not a blob
+ *      : else, the blob in the arena
+ */
+const char* pydict_blob(py_dict_t* pydict, PNODE* pnode, unsigned int* blob_len)
+{
+	size_t         offset = (size_t)(unsigned int)pnode->value*PYDICT_BLOB_ALIGN;
+	unsigned int   len    = 0;
+
+	if(offset+sizeof(unsigned int) >= pydict->blob_size){
+		return NULL;
+	}
+	memcpy(&len, pydict->blob+offset, sizeof(unsigned int));
+	if(len >= pydict->blob_size-offset-sizeof(unsigned int)){ // and the '\0'
+		return NULL;
+	}
+	*blob_len = len;
+
+	return pydict->blob+offset+sizeof(unsigned int);
+}
+
+/*
+ * func : find a key added by pydict_add_blob
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : key, keylen, the key
+ *      : code, blob, blob_len, the result
+ *
+ * ret  : 0, NOT found; 1, founded
+ *      : -1, the value of the node is not a blob
+ */
+int pydict_find_blob(py_dict_t* pydict, const char* key, const int keylen, int* code,
+		const char** blob, unsigned int* blob_len)
+{
+	PNODE* pnode = NULL;
+
+	pnode = pydict_find_node_str(pydict, key, keylen);
+	if(pnode==NULL){
+		return 0;
+	}
+	if((*blob = pydict_blob(pydict, pnode, blob_len)) == NULL){
+		return -1;
+	}
+	*code = pnode->code;
+
+	return 1;
+}
+
 /*
  * func : find int the hash table, return the founed node
  *
@@ -348,7 +1735,7 @@ PNODE* pydict_find_node_str(py_dict_t* pydict, const char* key, const int keylen
 	PNODE*         pnode      = NULL;
 	SIGN64         sign;
 
-	py_sign64_struct(key, keylen, &sign);
+	sign.sign = py_sign64_inline(pydict->hash, key, keylen);
 
 	pnode = pydict_find_node(pydict, &sign);
 
@@ -356,6 +1743,28 @@ PNODE* pydict_find_node_str(py_dict_t* pydict, const char* key, const int keylen
 		
 }
 
+/*
+ * func : pydict_find_node with counters
+ */
+static PNODE* pydict_find_count(py_dict_t* pydict, unsigned int sign1, unsigned int sign2)
+{
+	unsigned int   probes = 0;
+	PNODE*         pnode  = NULL;
+
+	if(pydict->engine==PYDICT_ENGINE_SWISS){
+		pnode = pyswiss_lookup_count(pydict, sign1, sign2, &probes);
+	}
+	else{
+		if(pydict->oldtab && !pydict->find_readonly){
+			pydict_rehash_step(pydict, REHASH_STEP);
+		}
+		pnode = pydict_lookup_count(pydict, sign1, sign2, &probes);
+	}
+	pydict_count(pydict, 1, pnode!=NULL, probes);
+
+	return pnode;
+}
+
 /*
  * func : find node in hash table by signature
  *
@@ -369,38 +1778,205 @@ PNODE* pydict_find_node(py_dict_t* pydict, SIGN64* sign)
 {
 	unsigned int   sign1      = 0;
 	unsigned int   sign2      = 0;
-	unsigned int   hashsize   = 0;
-	unsigned int   pos        = 0;
-	unsigned int   hashval    = 0;
-	unsigned int*  hashtab    = NULL;
+
+	sign1      = (unsigned int)(sign->sign>>32);
+	sign2      = (unsigned int)sign->sign;
+
+	if(pydict->counters){
+		return pydict_find_count(pydict, sign1, sign2);
+	}
+
+	if(pydict->engine==PYDICT_ENGINE_SWISS){
+		return pyswiss_lookup(pydict, sign1, sign2);
+	}
+
+	if(pydict->oldtab && !pydict->find_readonly){
+		pydict_rehash_step(pydict, REHASH_STEP);
+	}
+
+	return pydict_lookup(pydict, sign1, sign2);
+}
+
+/*
+ * func : find a group of signatures, memory accesses of all keys are 
+ *        prefetched and overlapped
+ *
+ * args : pydict, pointer to hash table
+ *      : sign1, sign2, signatures, n <= BATCH_STEP
+ *      : nodes, result nodes, NULL if not found
+ *
+ * ret  : number of founded nodes
+ */
+static int pydict_find_group(py_dict_t* pydict, unsigned int* sign1, unsigned int* sign2, 
+		const int n, PNODE** nodes)
+{
+	unsigned int   pos[BATCH_STEP];
+	unsigned int   nodepos[BATCH_STEP];
+	int            active[BATCH_STEP];
+	int            active_num = 0;
+	unsigned int   probes     = 0;
+	int            found      = 0;
+	int            i          = 0;
+	int            j          = 0;
+	int            hit        = 0;
+	unsigned int   next       = 0;
 	PNODE*         pnode      = NULL;
+	int            split      = pydict->keys!=NULL;
+	PKEY*          key        = NULL;
 
-	sign1      = sign->sign;
-	hashval    = sign1;
-	hashtab    = pydict->hashtab;
-	hashsize   = pydict->hashsize;
-	pos = hashval % hashsize;
+	if(pydict->engine==PYDICT_ENGINE_SWISS){
+		for(i=0;i<n;i++){
+			pyswiss_prefetch(pydict, sign1[i], sign2[i]);
+		}
+		for(i=0;i<n;i++){
+			nodes[i] = pyswiss_lookup_count(pydict, sign1[i], sign2[i], &probes);
+			found   += nodes[i]!=NULL;
+		}
+		goto out;
+	}
 
-	if(hashtab[pos]==COMMON_NULL){ // can not find in hash table
-		return NULL;
+	if(pydict->oldtab){ // two tables, no batching while rehashing
+		if(!pydict->find_readonly){
+			pydict_rehash_step(pydict, REHASH_STEP);
+		}
+		for(i=0;i<n;i++){
+			nodes[i] = pydict_lookup_count(pydict, sign1[i], sign2[i], &probes);
+			found   += nodes[i]!=NULL;
+		}
+		goto out;
 	}
-	else{
-		unsigned int nodepos = hashtab[pos];
-		pnode = pydict->block+nodepos;
-		while(pnode->next!=COMMON_NULL){
-			if(pnode->sign1==sign1&&pnode->sign2==sign2){
-				break;
+
+	// bucket slots
+	for(i=0;i<n;i++){
+		pos[i] = (sign1[i]+sign2[i]) % pydict->hashsize;
+		__builtin_prefetch(pydict->hashtab+pos[i]);
+	}
+
+	// chain heads
+	for(i=0;i<n;i++){
+		nodes[i]   = NULL;
+		nodepos[i] = pydict->hashtab[pos[i]];
+		if(nodepos[i]!=COMMON_NULL){
+			if(split){
+				__builtin_prefetch(pydict_key(pydict, nodepos[i]));
+			}
+			else{
+				__builtin_prefetch(pydict_node(pydict, nodepos[i]));
 			}
-			pnode = pydict->block + pnode->next;
+			active[active_num++] = i;
 		}
-		if(pnode->sign1==sign1&&pnode->sign2==sign2){ // find same key node
-			return pnode;
+	}
+
+	// walk all chains one node at a time
+	while(active_num>0){
+		probes += active_num;
+		for(j=0;j<active_num;){
+			i     = active[j];
+			if(split){ // split layout, the payload is not loaded
+				key  = pydict_key(pydict, nodepos[i]);
+				hit  = key->sign1==sign1[i] && key->sign2==sign2[i];
+				next = key->next;
+			}
+			else{
+				pnode = pydict_node(pydict, nodepos[i]);
+				hit   = pnode->sign1==sign1[i] && pnode->sign2==sign2[i];
+				next  = pnode->next;
+			}
+			if(hit){
+				nodes[i] = pydict_node(pydict, nodepos[i]);
+				found++;
+				active[j] = active[--active_num];
+				continue;
+			}
+			nodepos[i] = next;
+			if(nodepos[i]==COMMON_NULL){
+				active[j] = active[--active_num];
+				continue;
+			}
+			if(split){
+				__builtin_prefetch(pydict_key(pydict, nodepos[i]));
+			}
+			else{
+				__builtin_prefetch(pydict_node(pydict, nodepos[i]));
+			}
+			j++;
 		}
+	}
 
-		return NULL;
+out:
+	if(pydict->counters){
+		pydict_count(pydict, n, found, probes);
+	}
+	return found;
+}
+
+/*
+ * func : find nodes of a batch of signatures
+ *
+ * args : pydict, pointer to hash table
+ *      : signs, n, 64 bit signatures and their number
+ *      : nodes, result nodes, NULL if not found
+ *
+ * ret  : number of founded nodes
+ */
+int pydict_find_node_batch(py_dict_t* pydict, SIGN64* signs, const int n, PNODE** nodes)
+{
+	unsigned int   sign1[BATCH_STEP];
+	unsigned int   sign2[BATCH_STEP];
+	int            found = 0;
+	int            num   = 0;
+	int            i     = 0;
+	int            j     = 0;
 
+	for(i=0;i<n;i+=BATCH_STEP){
+		num = n-i < BATCH_STEP ? n-i : BATCH_STEP;
+		for(j=0;j<num;j++){
+			sign1[j] = (unsigned int)(signs[i+j].sign>>32);
+			sign2[j] = (unsigned int)signs[i+j].sign;
+		}
+		found += pydict_find_group(pydict, sign1, sign2, num, nodes+i);
 	}
-	
+
+	return found;
+}
+
+/*
+ * func : find a batch of keys in the hash table
+ *
+ * args : pydict, pointer to hash table
+ *      : keys, lens, n, the keys, their length and number
+ *      : codes, values, search results, set for founded keys only
+ *      : found, 1 for founded keys, 0 for others, may be NULL
+ *
+ * ret  : number of founded keys
+ */
+int pydict_find_batch(py_dict_t* pydict, const char* keys[], const int lens[], const int n,
+		int codes[], int values[], int found[])
+{
+	unsigned int   sign1[BATCH_STEP];
+	unsigned int   sign2[BATCH_STEP];
+	PNODE*         nodes[BATCH_STEP];
+	int            found_num = 0;
+	int            num       = 0;
+	int            i         = 0;
+	int            j         = 0;
+
+	for(i=0;i<n;i+=BATCH_STEP){
+		num = n-i < BATCH_STEP ? n-i : BATCH_STEP;
+		py_sign64_double_int_batch_hash(pydict->hash, keys+i, lens+i, num, sign1, sign2);
+		found_num += pydict_find_group(pydict, sign1, sign2, num, nodes);
+		for(j=0;j<num;j++){
+			if(nodes[j]){
+				codes[i+j]  = nodes[j]->code;
+				values[i+j] = nodes[j]->value;
+			}
+			if(found){
+				found[i+j] = nodes[j]!=NULL;
+			}
+		}
+	}
+
+	return found_num;
 }
 
 /*
@@ -417,10 +1993,27 @@ int pydict_save(py_dict_t* pydict, const char* path, const char* file)
 	FILE*  fp = NULL;
 	unsigned int hashsize   = 0;
 	unsigned int block_pos  = 0;
+	unsigned int* hashtab   = NULL;
+	unsigned int i          = 0;
+	unsigned int num        = 0;
+	pydict_footer_t footer;
+	pydict_meta_t meta;
+	pydict_blob_head_t blob_head;
 	char fullpath[256];
 
+	pydict_rehash_finish(pydict);
+
 	hashsize   = pydict->hashsize;
 	block_pos  = pydict->block_pos;
+	hashtab    = pydict->hashtab;
+
+	// files are in chain layout, link the nodes of a swiss table
+	if(pydict->engine==PYDICT_ENGINE_SWISS){
+		hashsize = pydict_chain_size(pydict);
+		if((hashtab = pydict_chain_build(pydict, hashsize))==NULL){
+			goto failed;
+		}
+	}
 
 	cmps_path(fullpath, sizeof(fullpath), path, file);
 	if((fp=fopen(fullpath, "wb"))==NULL){
@@ -436,16 +2029,55 @@ int pydict_save(py_dict_t* pydict, const char* path, const char* file)
 	}
 
 	// save hashtable
-	if(fwrite(pydict->hashtab, sizeof(unsigned int), hashsize, fp)!=hashsize){
+	if(fwrite(hashtab, sizeof(unsigned int), hashsize, fp)!=hashsize){
 		goto failed;
 	}
 	
-	// save blocks
-	if(fwrite(pydict->block, sizeof(PNODE), block_pos, fp)!=block_pos){
+	// save blocks, a segment at a time
+	for(i=0;i<block_pos;i+=num){
+		num = block_pos-i < PYDICT_SEG_SIZE ? block_pos-i : PYDICT_SEG_SIZE;
+		if(fwrite(pydict_node(pydict, i), sizeof(PNODE), num, fp)!=num){
+			goto failed;
+		}
+	}
+
+	// the signature function
+	footer.magic = PYDICT_FILE_MAGIC;
+	footer.hash  = pydict->hash;
+	if(fwrite(&footer, sizeof(footer), 1, fp)!=1){
 		goto failed;
 	}
 
-	fclose(fp);
+	// the longest key
+	if(pydict->key_max>0){
+		memset(&meta, 0, sizeof(meta));
+		meta.magic   = PYDICT_META_MAGIC;
+		meta.key_max = pydict->key_max;
+		if(fwrite(&meta, sizeof(meta), 1, fp)!=1){
+			goto failed;
+		}
+	}
+
+	// the blob arena, mapped with the nodes
+	if(pydict->blob_size>0){
+		memset(&blob_head, 0, sizeof(blob_head));
+		blob_head.magic = PYDICT_BLOB_MAGIC;
+		blob_head.size  = pydict->blob_size;
+		if(fwrite(&blob_head, sizeof(blob_head), 1, fp)!=1){
+			goto failed;
+		}
+		if(fwrite(pydict->blob, 1, pydict->blob_size, fp)!=pydict->blob_size){
+			goto failed;
+		}
+	}
+
+	if(fclose(fp)!=0){
+		fp = NULL;
+		goto failed;
+	}
+	if(hashtab!=pydict->hashtab){
+		pyalloc_free(&pydict->alloc, hashtab, sizeof(unsigned int)*hashsize);
+	}
 
 	return 0;
 failed:
@@ -453,6 +2085,10 @@ failed:
 		fclose(fp);
 		fp = NULL;
 	}
+	if(hashtab && hashtab!=pydict->hashtab){
+		pyalloc_free(&pydict->alloc, hashtab, sizeof(unsigned int)*hashsize);
+		hashtab = NULL;
+	}
 	return -1;
 }
 
@@ -488,8 +2124,13 @@ py_dict_t*   pydict_load_fullpath(const char* full_path)
 {
 	unsigned int hashsize   = 0;
 	unsigned int block_pos  = 0;
+	unsigned int i          = 0;
+	unsigned int num        = 0;
 	FILE*        fp         = NULL;
 	py_dict_t*       pydict      = NULL;
+	pydict_footer_t  footer;
+	pydict_meta_t    meta;
+	pydict_blob_head_t blob_head;
 
 	// open dict file
 	if ((fp = fopen(full_path, "rb")) == NULL)
@@ -502,12 +2143,19 @@ py_dict_t*   pydict_load_fullpath(const char* full_path)
 		goto failed;
 	}
 	
+	if (hashsize == PYDICT_FILE_MAGIC128){
+		goto failed;
+	}
+	
 	if (fread(&block_pos, sizeof(unsigned int), 1, fp) != 1){
 		goto failed;
 	}
 	
 	// create py_dict_t struct
-	if ((pydict = pydict_create(hashsize, block_pos+BLOCK_STEP)) == NULL){
+	if ((pydict = pydict_create(hashsize, block_pos)) == NULL){
+		goto failed;
+	}
+	if (pydict_reserve(pydict, block_pos) < 0){
 		goto failed;
 	}
 	
@@ -516,13 +2164,58 @@ py_dict_t*   pydict_load_fullpath(const char* full_path)
 		goto failed;
 	}
 
-	// load blocks
-	if (fread(pydict->block, sizeof(PNODE), block_pos, fp) != block_pos){
-		goto failed;
+	// load blocks, a segment at a time
+	for (i = 0; i < block_pos; i += num){
+		num = block_pos-i < PYDICT_SEG_SIZE ? block_pos-i : PYDICT_SEG_SIZE;
+		if (fread(pydict_node(pydict, i), sizeof(PNODE), num, fp) != num){
+			goto failed;
+		}
+	}
+
+	// files without a footer are murmur signed
+	pydict->hash = PY_SIGN_MURMUR;
+	if (fread(&footer, sizeof(footer), 1, fp) == 1 && footer.magic == PYDICT_FILE_MAGIC){
+		if (footer.hash >= PY_SIGN_NUM){
+			goto failed;
+		}
+		pydict->hash = footer.hash;
+
+		// the meta and blob sections have heads of the same size
+		memset(&blob_head, 0, sizeof(blob_head));
+		if (fread(&meta, sizeof(meta), 1, fp) == 1){
+			if (meta.magic == PYDICT_META_MAGIC){
+				pydict->key_max = meta.key_max;
+				if (fread(&blob_head, sizeof(blob_head), 1, fp) != 1){
+					blob_head.magic = 0;
+				}
+			}
+			else{
+				memcpy(&blob_head, &meta, sizeof(blob_head));
+			}
+		}
+
+		// the blob arena
+		if (blob_head.magic == PYDICT_BLOB_MAGIC){
+			if (blob_head.size > PYDICT_BLOB_MAX || blob_head.size % PYDICT_BLOB_ALIGN != 0){
+				goto failed;
+			}
+			if ((pydict->blob = (char*)pyalloc_alloc(&pydict->alloc, blob_head.size)) == NULL){
+				goto failed;
+			}
+			pydict->blob_cap = blob_head.size;
+			if (fread(pydict->blob, 1, blob_head.size, fp) != blob_head.size){
+				goto failed;
+			}
+			pydict->blob_size = blob_head.size;
+		}
 	}
 
 	pydict->block_pos  = block_pos;
 	pydict->hashsize   = hashsize;
+	pydict_live_rebuild(pydict);
+	if (pydict_free_rebuild(pydict) < 0){
+		goto failed;
+	}
 
 	fclose(fp);
 	return pydict;
@@ -541,3 +2234,195 @@ failed:
 	
 }
 
+
+
+/*
+ * func : map a dict file into memory, read only
+ *
+ * args : path, file, the dict file
+ *      : flags, PYDICT_MAP_POPULATE | PYDICT_MAP_WILLNEED | PYDICT_MAP_LOCK
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_dict_t struct
+ */
+py_dict_t* pydict_map(const char* path, const char* file, int flags)
+{
+	char  fullpath[512] = {0};
+
+	if(cmps_path(fullpath, sizeof(fullpath), path, file) < 0){
+		return NULL;
+	}
+
+	return pydict_map_fullpath(fullpath, flags);
+}
+
+/*
+ * func : map a dict file into memory, read only
+ *
+ * args : full_path, the dict file
+ *      : flags, see pydict_map
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_dict_t struct
+ */
+py_dict_t* pydict_map_fullpath(const char* full_path, int flags)
+{
+	int            fd         = -1;
+	int            mmap_flags = MAP_SHARED;
+	unsigned int   hashsize   = 0;
+	unsigned int   block_pos  = 0;
+	unsigned int*  head       = NULL;
+	void*          addr       = MAP_FAILED;
+	size_t         size       = 0;
+	size_t         nodes_end  = 0;
+	unsigned int   i          = 0;
+	int            hash       = PY_SIGN_MURMUR;
+	py_dict_t*     pydict     = NULL;
+	char*          blob       = NULL;
+	size_t         blob_size  = 0;
+	size_t         sect       = 0;
+	unsigned int   key_max    = 0;
+	pydict_footer_t footer;
+	pydict_meta_t  meta;
+	pydict_blob_head_t blob_head;
+	struct stat    st;
+
+	if((fd = open(full_path, O_RDONLY)) < 0){
+		goto failed;
+	}
+	if(fstat(fd, &st) < 0 || st.st_size < 2*sizeof(unsigned int)){
+		goto failed;
+	}
+	size = st.st_size;
+
+	if(flags & PYDICT_MAP_POPULATE){
+		mmap_flags |= MAP_POPULATE;
+	}
+	addr = mmap(NULL, size, PROT_READ, mmap_flags, fd, 0);
+	if(addr == MAP_FAILED){
+		goto failed;
+	}
+	close(fd);
+	fd = -1;
+
+	// check the file is complete
+	head      = (unsigned int*)addr;
+	hashsize  = head[0];
+	block_pos = head[1];
+	nodes_end = 2*sizeof(unsigned int) + (size_t)hashsize*sizeof(unsigned int) 
+	          + (size_t)block_pos*sizeof(PNODE);
+	if(hashsize == 0 || hashsize == PYDICT_FILE_MAGIC128 || nodes_end > size){
+		goto failed;
+	}
+
+	// files without a footer are murmur signed
+	if(nodes_end + sizeof(footer) <= size){
+		memcpy(&footer, (char*)addr + nodes_end, sizeof(footer));
+		if(footer.magic == PYDICT_FILE_MAGIC){
+			if(footer.hash >= PY_SIGN_NUM){
+				goto failed;
+			}
+			hash = footer.hash;
+
+			// the longest key
+			sect = nodes_end + sizeof(footer);
+			if(sect + sizeof(meta) <= size){
+				memcpy(&meta, (char*)addr + sect, sizeof(meta));
+				if(meta.magic == PYDICT_META_MAGIC){
+					key_max = meta.key_max;
+					sect   += sizeof(meta);
+				}
+			}
+
+			// the blob arena stays in the mapping
+			if(sect + sizeof(blob_head) <= size){
+				memcpy(&blob_head, (char*)addr + sect, sizeof(blob_head));
+				if(blob_head.magic == PYDICT_BLOB_MAGIC){
+					if(blob_head.size > size - sect - sizeof(blob_head)){
+						goto failed;
+					}
+					blob      = (char*)addr + sect + sizeof(blob_head);
+					blob_size = blob_head.size;
+				}
+			}
+		}
+	}
+
+	if(flags & PYDICT_MAP_WILLNEED){
+		madvise(addr, size, MADV_WILLNEED);
+	}
+	if(flags & PYDICT_MAP_LOCK){
+		if(mlock(addr, size) < 0){
+			goto failed;
+		}
+	}
+
+	pydict = (py_dict_t*)calloc(1, sizeof(py_dict_t));
+	if(!pydict){
+		goto failed;
+	}
+	pydict->alloc      = *pyalloc_get();
+	pydict->hash       = hash;
+	pydict->hashtab    = head + 2;
+	pydict->hashsize   = hashsize;
+	pydict->block_pos  = block_pos;
+	pydict->block_size = block_pos;
+	pydict->map_addr   = addr;
+	pydict->map_size   = size;
+	pydict->map_flags  = flags;
+	pydict->free_head  = COMMON_NULL;
+	pydict->blob       = blob;
+	pydict->blob_size  = blob_size;
+	pydict->key_max    = key_max;
+
+	// segments point into the mapping, nodes are not copied
+	pydict->seg_num = (unsigned int)(((unsigned long)block_pos+PYDICT_SEG_MASK) >> PYDICT_SEG_SHIFT);
+	pydict->segs    = (PNODE**)malloc(sizeof(PNODE*)*(pydict->seg_num>0 ? pydict->seg_num : 1));
+	if(!pydict->segs){
+		goto failed;
+	}
+	for(i=0;i<pydict->seg_num;i++){
+		pydict->segs[i] = (PNODE*)(head + 2 + hashsize) + ((size_t)i<<PYDICT_SEG_SHIFT);
+	}
+
+	return pydict;
+
+failed:
+	if(pydict){
+		free(pydict);
+		pydict = NULL;
+	}
+	if(fd >= 0){
+		close(fd);
+		fd = -1;
+	}
+	if(addr != MAP_FAILED){
+		munmap(addr, size);
+		addr = MAP_FAILED;
+	}
+	return NULL;
+}
+
+/*
+ * func : unmap a dict created by pydict_map
+ */
+void pydict_unmap(py_dict_t* pydict)
+{
+	if(!pydict){
+		return;
+	}
+	pydict_segs_trim(pydict, 0);
+	if(pydict->map_addr){
+		if(pydict->map_flags & PYDICT_MAP_LOCK){
+			munlock(pydict->map_addr, pydict->map_size);
+		}
+		munmap(pydict->map_addr, pydict->map_size);
+		pydict->map_addr = NULL;
+	}
+	if(pydict->counters){
+		free(pydict->counters);
+		pydict->counters = NULL;
+	}
+	free(pydict);
+	pydict = NULL;
+}
@@ -14,13 +14,60 @@
 #ifndef _py_dict_t_H
 #define _py_dict_t_H
 
+#include <stddef.h>
 #include <py_sign.h>
+#include <py_alloc.h>
 
 
 // macros defined here
 //
 #define COMMON_NULL 0xFFFFFFFE
 
+// table engines, see pydict_set_engine
+#define PYDICT_ENGINE_CHAIN  0       // hashtab buckets, chained nodes
+#define PYDICT_ENGINE_SWISS  1       // open addressing, SIMD probed control bytes
+
+// node layouts of the chain engine, see pydict_set_layout
+#define PYDICT_LAYOUT_NODE   0       // chains are walked in the nodes
+#define PYDICT_LAYOUT_SPLIT  1       // chains are walked in keys, payload read on a hit
+
+// nodes are kept in segments of PYDICT_SEG_SIZE nodes, a segment is 10MB, 
+// five 2MB huge pages. a libc segment takes its pages as nodes are added,
+// pyalloc_huge takes reserved huge pages when it maps the segment
+#define PYDICT_SEG_SHIFT     19
+#define PYDICT_SEG_SIZE      (1u<<PYDICT_SEG_SHIFT)
+#define PYDICT_SEG_MASK      (PYDICT_SEG_SIZE-1)
+
+// default max load factor, hashtab grows when block_pos > hashsize*max_load
+#define PYDICT_MAX_LOAD      1.0f
+
+// flags for pydict_map
+#define PYDICT_MAP_POPULATE  0x01    // prefault the whole file with MAP_POPULATE
+#define PYDICT_MAP_WILLNEED  0x02    // madvise(MADV_WILLNEED), async read ahead
+#define PYDICT_MAP_LOCK      0x04    // mlock the mapping, keep it in memory
+
+// chains this long or longer share the last slot of pydict_stats_t.len_hist
+#define PYDICT_STATS_LEN_MAX 16
+
+// a dict file is [hashsize][block_pos][hashtab][nodes][pydict_footer_t],
+// files without the footer are signed with PY_SIGN_MURMUR
+#define PYDICT_FILE_MAGIC    0x31445950   // "PYD1"
+
+// a dict file of 128 bit signatures starts with this magic, see py_dict128.h,
+// pydict_load and pydict_map refuse it
+#define PYDICT_FILE_MAGIC128 0x32445950   // "PYD2"
+
+// blob values, see pydict_add_blob. the arena is a section after the footer,
+// [pydict_blob_head_t][records], a record is [length][bytes]['\0'] padded to
+// PYDICT_BLOB_ALIGN, the value of its node is the record offset / ALIGN
+#define PYDICT_BLOB_MAGIC    0x42445950   // "PYDB"
+#define PYDICT_BLOB_ALIGN    4
+#define PYDICT_BLOB_MAX      ((size_t)PYDICT_BLOB_ALIGN<<32)  // arena bytes
+
+// the longest key of a dict, see py_dict_t.key_max. a section after the
+// footer, before the blob section, written when key_max is known
+#define PYDICT_META_MAGIC    0x4d445950   // "PYDM"
+
 
 // data structure define here
 //
@@ -32,15 +79,119 @@ typedef struct _pnode{
 	unsigned int next;
 }PNODE;
 
+// signatures and next of a node, the keys array of the split layout
+typedef struct _pkey{
+	unsigned int sign1;
+	unsigned int sign2;
+	unsigned int next;
+}PKEY;
+
+// find counters of a thread, one cache line, see pydict_counters_enable
+typedef struct _pydict_counter{
+	unsigned long    finds;
+	unsigned long    hits;
+	unsigned long    probes;        // chain nodes or swiss groups visited
+	unsigned long    pad[5];
+}pydict_counter_t;
+
 
 typedef struct _int_dict{
 	unsigned int*     hashtab;
 	unsigned int      hashsize;
 
-	PNODE*            block;
+	PNODE**           segs;         // node segments, a node never moves, see pydict_node
+	unsigned int      seg_num;
+	unsigned int      block_pos;    // nodes used
+	unsigned int      block_size;   // nodes allocated, block_pos if mapped
+	unsigned int      free_head;    // free list of deleted nodes, linked by next
+	unsigned int      free_num;
+	unsigned long*    live;         // a bit a node, clear if freed, NULL if mapped
+
+	float             max_load;     // 0, hashtab never grows
+	unsigned int*     oldtab;       // not NULL while rehashing into hashtab
+	unsigned int      oldsize;
+	unsigned int      rehash_pos;   // buckets of oldtab before it are moved
+	int               find_readonly;// 1, find never moves buckets, only add does
+
+	int               engine;       // PYDICT_ENGINE_CHAIN or PYDICT_ENGINE_SWISS
+	unsigned char*    ctrl;         // swiss: 7 bits signature tag per slot
+	unsigned int*     slots;        // swiss: node position per slot
+	unsigned int      capacity;     // swiss: slot number, power of 2
+	unsigned int      growth_left;  // swiss: empty slots usable before growing
+
+	int               layout;       // PYDICT_LAYOUT_NODE or PYDICT_LAYOUT_SPLIT
+	PKEY**            keys;         // split: segments of signatures and next, same index
+
+	void*             map_addr;     // not NULL, read-only dict mapped by pydict_map
+	size_t            map_size;
+	int               map_flags;
+
+	pydict_counter_t* counters;     // NULL, find is not counted
+	unsigned int      counter_num;
+
+	py_alloc_t        alloc;        // allocator of the arrays, see pyalloc_set
+	int               hash;         // signature function of keys, see pydict_set_hash
+
+	char*             blob;         // arena of blob values, see pydict_add_blob
+	size_t            blob_size;    // bytes used
+	size_t            blob_cap;     // bytes allocated, 0 if mapped
+
+	unsigned int      key_max;      // longest key added by its string, 0 unknown,
+	                                // it is not lowered by delete, see py_seg.h
+	                                // and pydict_key_max_known
+}py_dict_t;
+
+// footer of a dict file, after the nodes
+typedef struct _pydict_footer{
+	unsigned int      magic;        // PYDICT_FILE_MAGIC
+	unsigned int      hash;         // signature function, PY_SIGN_MURMUR ...
+}pydict_footer_t;
+
+// the meta section of a dict file, after the footer
+typedef struct _pydict_meta{
+	unsigned int      magic;        // PYDICT_META_MAGIC
+	unsigned int      key_max;
+	unsigned long     reserved;
+}pydict_meta_t;
+
+// head of the blob section of a dict file, after the footer and meta
+typedef struct _pydict_blob_head{
+	unsigned int      magic;        // PYDICT_BLOB_MAGIC
+	unsigned int      reserved;
+	unsigned long     size;         // bytes of the records
+}pydict_blob_head_t;
+
+// callback of pydict_iter_range and pydict_parallel_foreach, 0 to go on
+typedef int (*pydict_iter_func)(PNODE* node, unsigned int pos, void* arg);
+
+// health of a dict, see pydict_stats
+typedef struct _pydict_stats{
+	int               engine;
+	int               hash;         // signature function, PY_SIGN_MURMUR ...
+	int               mapped;
+	int               rehashing;    // an incremental rehash is pending
+	unsigned int      hashsize;     // buckets, or swiss slots
+	unsigned int      used;         // buckets with a chain, or used swiss slots
+	unsigned int      node_num;     // live nodes
+	unsigned int      deleted_num;  // nodes with code -1, free or in old files' chains
+	unsigned int      free_num;     // nodes on the free list
 	unsigned int      block_pos;
 	unsigned int      block_size;
-}py_dict_t;
+	unsigned int      slack;        // block_size - block_pos
+	unsigned int      max_len;      // longest chain, or most swiss groups probed
+	double            avg_len;      // nodes a found key walks on average
+	double            load;         // node_num / hashsize
+	unsigned int      len_hist[PYDICT_STATS_LEN_MAX+1]; // buckets by chain length, 
+	                                // or keys by swiss groups probed
+	size_t            bytes;        // memory used, or mapped size
+	size_t            blob_size;    // bytes of the blob arena
+	unsigned int      key_max;      // longest key, 0 unknown
+
+	unsigned long     finds;        // counters, 0 when not enabled
+	unsigned long     hits;
+	unsigned long     misses;
+	unsigned long     probes;
+}pydict_stats_t;
 
 
 // functions defined here
@@ -50,7 +201,8 @@ typedef struct _int_dict{
  * func : create an py_dict_t struct
  *
  * args : hashsize, the hash table size
- *      : nodesize, the node array size
+ *      : nodesize, the nodes expected, segments are reserved for them if
+ *      :           they fill a segment, else the first add takes one
  *
  * ret  : NULL, error;
  *      : else, pointer the the py_dict_t struct
@@ -58,6 +210,44 @@ typedef struct _int_dict{
 py_dict_t*   pydict_create(const int hashsize, const int nodesize);
 
 
+/*
+ * func : get a node by position
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : pos, position of the node, < block_pos
+ *
+ * ret  : pointer to the node, it stays valid while the dict grows
+ */
+static inline PNODE* pydict_node(py_dict_t* pydict, const unsigned int pos)
+{
+	return pydict->segs[pos>>PYDICT_SEG_SHIFT] + (pos&PYDICT_SEG_MASK);
+}
+
+/*
+ * func : key_max is the longest key, a key added by its signature only
+ *        leaves key_max 0 until the dict has no nodes again
+ *
+ * ret  : 1, known; 0, unknown
+ */
+static inline int pydict_key_max_known(const py_dict_t* pydict)
+{
+	return pydict->key_max>0 || pydict->block_pos==pydict->free_num;
+}
+
+/*
+ * func : allocate node segments for node_num nodes
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : node_num, number of nodes
+ *
+ * ret  : 0, succeed
+ *      : -1, error, out of memory or the dict is mapped
+ *
+ * note : adding grows the dict a segment at a time, nodes already added 
+ *      : are never moved or copied.
+ */
+int          pydict_reserve(py_dict_t* pydict, const unsigned int node_num);
+
 /*
  * func : load py_dict_t from disk file
  *
@@ -82,11 +272,116 @@ py_dict_t*   pydict_load_fullpath(const char* full_path);
 
 
 
+/*
+ * func : map a dict file into memory, read only
+ *
+ * args : path, file, the dict file
+ *      : flags, PYDICT_MAP_POPULATE | PYDICT_MAP_WILLNEED | PYDICT_MAP_LOCK
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_dict_t struct
+ *
+ * note : hashtab and nodes point into the mapping, nothing is copied, so 
+ *      : the page cache is shared by all processes mapping the same file.
+ *      : add/del/reset on a mapped dict fail.
+ */
+py_dict_t*   pydict_map(const char* path, const char* file, int flags);
+
+/*
+ * func : map a dict file into memory, read only
+ *
+ * args : full_path, the dict file
+ *      : flags, see pydict_map
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_dict_t struct
+ */
+py_dict_t*   pydict_map_fullpath(const char* full_path, int flags);
+
+/*
+ * func : unmap a dict created by pydict_map
+ */
+void     pydict_unmap(py_dict_t* pydict);
+
 /*
  * func : free a py_dict_t struct
+ *
+ * note : a mapped dict is unmapped.
  */
 void     pydict_free(py_dict_t* pydict);
 
+/*
+ * func : set the signature function of an empty dict
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : hash, PY_SIGN_MURMUR, PY_SIGN_WYHASH or PY_SIGN_ROLL
+ *
+ * ret  : 0, succeed
+ *      : -1, error, the dict has nodes, is mapped or hash is unknown
+ *
+ * note : new dicts take py_sign_get_default(), the function is saved in 
+ *      : the file and a loaded or mapped dict signs keys with it. nodes 
+ *      : found by pydict_find_node must be signed with it too.
+ */
+int      pydict_set_hash(py_dict_t* pydict, const int hash);
+
+/*
+ * func : switch the table engine of a dict, the table is rebuilt from the
+ *      : nodes, which are kept as they are
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : engine, PYDICT_ENGINE_CHAIN or PYDICT_ENGINE_SWISS
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ *
+ * note : dict files are always saved in chain layout, load a dict and set
+ *      : its engine to use the swiss engine.
+ */
+int      pydict_set_engine(py_dict_t* pydict, const int engine);
+
+/*
+ * func : set the node layout of a chain engine dict
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : layout, PYDICT_LAYOUT_NODE or PYDICT_LAYOUT_SPLIT
+ *
+ * ret  : 0, succeed
+ *      : -1, error, swiss engine or out of memory
+ *
+ * note : a chain walk of the node layout loads 20 bytes nodes, the payload
+ *      : of every node visited shares their cache lines. the split layout 
+ *      : keeps a parallel keys array of signatures and next, 12 bytes a 
+ *      : node, chain walks stay in it and code and value are read only 
+ *      : on a hit. a miss or a long chain touches 40% less memory, a hit
+ *      : may touch one more line. the nodes are kept whole, PNODE pointers,
+ *      : save and iteration do not change, the keys array costs 12 bytes 
+ *      : a node more. a mapped dict may be split too, the keys array is 
+ *      : allocated. switching to the swiss engine drops the split layout.
+ */
+int      pydict_set_layout(py_dict_t* pydict, const int layout);
+
+/*
+ * func : set the max load factor of the hash table
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : max_load, hash table grows when node number > hashsize*max_load,
+ *      :           0 means never grow.
+ *
+ * note : the hash table doubles and its buckets are moved incrementally,
+ *      : a few buckets per add/find, so there is no long pause. while a 
+ *      : rehash is pending, find also changes the dict, unless 
+ *      : find_readonly is set.
+ *      : the swiss engine keeps its own load factor of 7/8.
+ */
+void     pydict_set_max_load(py_dict_t* pydict, const float max_load);
+
+/*
+ * func : finish a pending rehash at once, call it before sharing the dict 
+ *      : among reader threads
+ */
+void     pydict_rehash_finish(py_dict_t* pydict);
+
 /*
  * func : reset the hash table;
  */
@@ -123,10 +418,23 @@ int      pydict_add(py_dict_t* pydict, const char* key, const int len, const int
  *
  * ret  : 1,  find a same key, value changed;
  *      : 0,  find NO same key, new node added,
- *      : -1, error;
+ *      : -1, error, or the dict is read only;
+ *
+ * note : the key length is not known, a new node makes key_max 0
  */
 int      pydict_add_node(py_dict_t* pydict, PNODE* node);
 
+/*
+ * func : add a node of a key of keylen bytes, key_max counts the key
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : node, pointer to input node
+ *      : keylen, bytes of the key, -1 unknown as pydict_add_node
+ *
+ * ret  : see pydict_add_node
+ */
+int      pydict_add_node_len(py_dict_t* pydict, PNODE* node, const int keylen);
+
 /*
  * func : delete a node in the hash table
  *
@@ -134,11 +442,39 @@ int      pydict_add_node(py_dict_t* pydict, PNODE* node);
  *      : key, the tobe delete node key
  *
  * ret  : 0, NOT found; 1 founded.
+ *      : -1, error, the dict is read only
  *
- * node : just mark delete, set pnode->code to -1 mean delete.
+ * node : the node is unlinked, its code is set to -1 and it is put to a 
+ *      : free list, the next add reuses it.
  */
 int      pydict_del(py_dict_t* pydict, const char* key, const int len);
 
+/*
+ * func : delete a node by signature, see pydict_del
+ *
+ * args : pydict, pointer to hash table;
+ *      : sign, 64 bit string signature
+ *
+ * ret  : 0, NOT found; 1 founded.
+ *      : -1, error, the dict is read only
+ */
+int      pydict_del_node(py_dict_t* pydict, SIGN64* sign);
+
+/*
+ * func : drop deleted nodes, move all nodes to the front of block and 
+ *      : rebuild the hash table
+ *
+ * args : pydict, pointer to py_dict_t
+ *
+ * ret  : -1, error, the dict is read only
+ *      : else, number of dropped nodes
+ *
+ * note : node positions change. files written before deleted nodes were
+ *      : reclaimed keep them in their chains with code -1, compact the 
+ *      : loaded dict to drop them.
+ */
+int      pydict_compact(py_dict_t* pydict);
+
 /*
  * func : find in the hash table
  *
@@ -150,6 +486,55 @@ int      pydict_del(py_dict_t* pydict, const char* key, const int len);
  */
 int      pydict_find(py_dict_t* pydict, const char* key, const int len, int* code, int* value);
 
+/*
+ * func : add a key with a variable length value, kept in the blob arena
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : key, len, the key
+ *      : code, the code of the node
+ *      : blob, blob_len, the value, copied into the arena
+ *
+ * ret  : 1,  find a same key, value changed;
+ *      : 0,  find NO same key, new node added,
+ *      : -1, error, out of memory, the arena is full or the dict is read only
+ *
+ * note : the value of the node is its blob reference, keys of a dict with 
+ *      : blobs are added by this function. a changed key gets a new record,
+ *      : the old one stays in the arena. the arena is saved in the same file
+ *      : and mapped with it.
+ */
+int      pydict_add_blob(py_dict_t* pydict, const char* key, const int len, const int code,
+                         const void* blob, const unsigned int blob_len);
+
+/*
+ * func : find a key added by pydict_add_blob
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : key, len, the key
+ *      : code, blob, blob_len, the result, blob points into the arena and 
+ *      :       is followed by a '\0'
+ *
+ * ret  : 0, NOT found; 1, founded
+ *      : -1, the value of the node is not a blob
+ *
+ * note : blob is valid until the next pydict_add_blob, which may move the
+ *      : arena, and as long as a loaded or mapped dict is not changed.
+ */
+int      pydict_find_blob(py_dict_t* pydict, const char* key, const int len, int* code,
+                          const char** blob, unsigned int* blob_len);
+
+/*
+ * func : the blob of a node, when iterating a dict with blobs
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : pnode, a node added by pydict_add_blob
+ *      : blob_len, the blob length
+ *
+ * ret  : NULL, the value is not a blob
+ *      : else, the blob in the arena
+ */
+const char* pydict_blob(py_dict_t* pydict, PNODE* pnode, unsigned int* blob_len);
+
 /*
  * func : find node in hash table by signature
  *
@@ -172,6 +557,63 @@ PNODE*   pydict_find_node(py_dict_t* pydict, SIGN64* sign);
  */
 PNODE*   pydict_find_node_str(py_dict_t* pydict, const char* key, const int len);
 
+/*
+ * func : find a batch of keys in the hash table
+ *
+ * args : pydict, pointer to hash table
+ *      : keys, lens, n, the keys, their length and number
+ *      : codes, values, search results, set for founded keys only
+ *      : found, 1 for founded keys, 0 for others, may be NULL
+ *
+ * ret  : number of founded keys
+ *
+ * note : keys are hashed first, then bucket slots and chain heads are 
+ *      : prefetched and the chains are walked together, so the memory 
+ *      : latency of the keys overlaps.
+ */
+int      pydict_find_batch(py_dict_t* pydict, const char* keys[], const int lens[], const int n,
+                           int codes[], int values[], int found[]);
+
+/*
+ * func : find nodes of a batch of signatures, see pydict_find_batch
+ *
+ * args : pydict, pointer to hash table
+ *      : signs, n, 64 bit signatures and their number
+ *      : nodes, result nodes, NULL if not found
+ *
+ * ret  : number of founded nodes
+ */
+int      pydict_find_node_batch(py_dict_t* pydict, SIGN64* signs, const int n, PNODE** nodes);
+
+/*
+ * func : get the health metrics of a dict
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : stats, the result
+ *
+ * ret  : 0, succeed
+ *
+ * note : walks the whole table and block, do not call it on a hot path.
+ */
+int      pydict_stats(py_dict_t* pydict, pydict_stats_t* stats);
+
+/*
+ * func : count finds, hits and probes of a dict
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : slot_num, counter slots, threads take slots in turn, 0 to stop 
+ *      :           counting
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ *
+ * note : counters are reset. a slot is one cache line and is written by 
+ *      : the threads using it without locking, give at least one slot to
+ *      : each finding thread, counts of threads sharing a slot may be lost.
+ *      : do not call it while other threads find.
+ */
+int      pydict_counters_enable(py_dict_t* pydict, const int slot_num);
+
 /*
  * func : get the first node in hash table
  *
@@ -192,4 +634,46 @@ PNODE*   pydict_first(py_dict_t* pydict, unsigned int* pos);
  */
 PNODE*   pydict_next(py_dict_t* pydict, int* pos);
 
+/*
+ * func : call func on the live nodes in a range of positions
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : begin, end, the range [begin, end) of node positions, end is 
+ *      :             cut to block_pos
+ *      : func, called with a node, its position and arg, returns 0 to go 
+ *      :       on, else the iteration stops
+ *      : arg, passed to func
+ *
+ * ret  : number of nodes passed to func
+ *
+ * note : deleted nodes are skipped 64 at a time by the liveness bitmap.
+ *      : disjoint ranges may be iterated by different threads.
+ */
+unsigned int  pydict_iter_range(py_dict_t* pydict, const unsigned int begin, const unsigned int end, 
+		pydict_iter_func func, void* arg);
+
+/*
+ * func : call func on all live nodes from several threads
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : thread_num, number of threads, <=0 for all cores
+ *      : func, arg, see pydict_iter_range, func is called concurrently
+ *
+ * ret  : number of nodes passed to func
+ *
+ * note : threads take ranges of 64K nodes until all are taken, the caller
+ *      : is one of them. the order of nodes is not kept. the dict must not
+ *      : be changed while iterating. if func stops, the other threads stop
+ *      : after their current node.
+ */
+unsigned long pydict_parallel_foreach(py_dict_t* pydict, int thread_num, 
+		pydict_iter_func func, void* arg);
+
+/*
+ * func : rebuild the liveness bitmap from the codes of the nodes
+ *
+ * note : for nodes written in place, by load, build and compact
+ */
+void     pydict_live_rebuild(py_dict_t* pydict);
+
 #endif
@@ -0,0 +1,654 @@
+/********************************************************************************
+ * Describe : C++ front-end of the dict, pydict::dict<Value, SignBits>, for
+ *          : values other than the two ints of PNODE. keys are signed as in
+ *          : py_dict_t, by the dict's function and inline for short keys,
+ *          : nodes are chained from a hashtab and kept in segments of
+ *          : PYDICT_SEG_SIZE nodes. a node never moves, a value may be
+ *          : pointed to until its key is deleted.
+ *
+ *          : Value is any trivially copyable type, stored inline. the layout
+ *          : is chosen at compile time: a value of 8 bytes or less is kept in
+ *          : the node, fields ordered by alignment so only the end is padded;
+ *          : a larger value goes to a values array of the same index and a
+ *          : chain walk reads signatures only, as PYDICT_LAYOUT_SPLIT.
+ *          : SignBits is 64, the signature of py_dict_t, or 32, a node is 4
+ *          : bytes smaller and signatures collide from about 64K keys on.
+ *
+ *          : a dict owns its arrays and is move-only. errors are returned as
+ *          : in the C API, nothing throws. a file records SignBits and the
+ *          : value size, a dict of another instantiation does not load it.
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ *******************************************************************************/
+#ifndef PY_DICT_HPP
+#define PY_DICT_HPP
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+
+extern "C" {
+#include <py_dict.h>
+#include <py_utils.h>
+#include <py_sign_inline.h>
+}
+
+#define PYDICT_TPL_MAGIC     0x31545950   // "PYT1"
+
+namespace pydict {
+
+namespace detail {
+
+static const unsigned int NODE_MAX = 0xFFFFFFF0u;   // positions below COMMON_NULL
+
+// node of the inline layout, the field of the larger alignment first
+template<int SignNum, typename Value, bool ValueFirst> struct node_inline{
+	unsigned int   sign[SignNum];
+	unsigned int   next;
+	Value          value;
+};
+
+template<int SignNum, typename Value> struct node_inline<SignNum, Value, true>{
+	Value          value;
+	unsigned int   sign[SignNum];
+	unsigned int   next;
+};
+
+// node of the split layout, the value is in the values array
+template<int SignNum> struct node_key{
+	unsigned int   sign[SignNum];
+	unsigned int   next;
+};
+
+// the node type of a layout and where its value is
+template<int SignNum, typename Value, bool Split> struct layout{
+	typedef node_inline<SignNum, Value, (alignof(Value) > alignof(unsigned int))> node_t;
+
+	static Value* value(node_t* node, Value** vals, unsigned int pos)
+	{
+		return &node->value;
+	}
+};
+
+template<int SignNum, typename Value> struct layout<SignNum, Value, true>{
+	typedef node_key<SignNum> node_t;
+
+	static Value* value(node_t* node, Value** vals, unsigned int pos)
+	{
+		return vals[pos>>PYDICT_SEG_SHIFT] + (pos&PYDICT_SEG_MASK);
+	}
+};
+
+// head of a file, node_num records of the signature and the value follow
+struct file_head{
+	unsigned int   magic;        // PYDICT_TPL_MAGIC
+	unsigned int   sign_bits;
+	unsigned int   value_size;
+	unsigned int   hash;         // signature function, PY_SIGN_MURMUR ...
+	unsigned int   hashsize;
+	unsigned int   node_num;
+};
+
+} // namespace detail
+
+template<typename Value, int SignBits = 64>
+class dict{
+	static_assert(std::is_trivially_copyable<Value>::value, "values are copied as bytes");
+	static_assert(alignof(Value) <= 64, "segments are 64 bytes aligned");
+	static_assert(SignBits==32 || SignBits==64, "signatures are 32 or 64 bits");
+
+public:
+	static const int   SIGN_NUM = SignBits/32;
+	static const bool  SPLIT    = sizeof(Value) > 8;
+
+	typedef detail::layout<SIGN_NUM, Value, SPLIT>   layout_t;
+	typedef typename layout_t::node_t                node_t;
+
+	// live nodes in position order
+	template<bool Const> class iter{
+	public:
+		typedef typename std::conditional<Const, const dict, dict>::type    dict_type;
+		typedef typename std::conditional<Const, const Value, Value>::type  value_type;
+
+		iter(dict_type* pydict, unsigned int pos) : pydict_(pydict), pos_(pos) {}
+
+		value_type&    operator*() const  { return *pydict_->value_at(pos_); }
+		value_type*    operator->() const { return pydict_->value_at(pos_); }
+		unsigned int   pos() const        { return pos_; }
+		unsigned long  sign() const       { return pydict_->sign_at(pos_); }
+
+		iter& operator++()
+		{
+			pos_ = pydict_->live_next(pos_+1);
+			return *this;
+		}
+		bool operator==(const iter& other) const { return pos_==other.pos_; }
+		bool operator!=(const iter& other) const { return pos_!=other.pos_; }
+
+	private:
+		dict_type*     pydict_;
+		unsigned int   pos_;
+	};
+	typedef iter<false>  iterator;
+	typedef iter<true>   const_iterator;
+
+	/*
+	 * func : an empty dict, the hash table is allocated by the first add
+	 *
+	 * args : hashsize, the hash table size, it grows with the nodes
+	 */
+	explicit dict(const unsigned int hashsize = 1024)
+	{
+		init(hashsize);
+	}
+
+	~dict()
+	{
+		release();
+	}
+
+	dict(dict&& other)
+	{
+		steal(other);
+	}
+
+	dict& operator=(dict&& other)
+	{
+		if(this!=&other){
+			release();
+			steal(other);
+		}
+		return *this;
+	}
+
+	dict(const dict&) = delete;
+	dict& operator=(const dict&) = delete;
+
+	/*
+	 * func : add a key and its value
+	 *
+	 * ret  : 1,  find a same key, value changed;
+	 *      : 0,  find NO same key, new node added,
+	 *      : -1, error, out of memory
+	 */
+	int add(const char* key, const int keylen, const Value& value)
+	{
+		unsigned int sign[SIGN_NUM];
+
+		make_sign(py_sign64_inline(hash_, key, keylen), sign);
+		return add_sign(sign, value);
+	}
+
+	/*
+	 * func : find a key
+	 *
+	 * ret  : NULL, NOT found
+	 *      : else, pointer to the value, valid until the key is deleted
+	 */
+	Value* find(const char* key, const int keylen)
+	{
+		unsigned int sign[SIGN_NUM];
+
+		make_sign(py_sign64_inline(hash_, key, keylen), sign);
+		return lookup(sign);
+	}
+
+	const Value* find(const char* key, const int keylen) const
+	{
+		return const_cast<dict*>(this)->find(key, keylen);
+	}
+
+	/*
+	 * func : find a node by the signature an iterator gives
+	 */
+	Value* find_sign(const unsigned long sign)
+	{
+		unsigned int s[SIGN_NUM];
+
+		s[0] = (unsigned int)(sign>>32*(SIGN_NUM-1));
+		s[SIGN_NUM-1] = (unsigned int)sign;
+		return lookup(s);
+	}
+
+	/*
+	 * func : delete a key
+	 *
+	 * ret  : 0, NOT found; 1, founded.
+	 */
+	int del(const char* key, const int keylen)
+	{
+		unsigned int    sign[SIGN_NUM];
+		unsigned int*   link = NULL;
+		unsigned int    pos  = 0;
+		node_t*         node = NULL;
+
+		if(!hashtab_){
+			return 0;
+		}
+		make_sign(py_sign64_inline(hash_, key, keylen), sign);
+		for(link=&hashtab_[bucket(sign, hashsize_)];*link!=COMMON_NULL;link=&node->next){
+			node = node_at(*link);
+			if(same(node->sign, sign)){
+				pos        = *link;
+				*link      = node->next;
+				node->next = free_head_;
+				free_head_ = pos;
+				live_[pos>>6] &= ~(1UL<<(pos&63));
+				node_num_--;
+				return 1;
+			}
+		}
+		return 0;
+	}
+
+	/*
+	 * func : delete all keys, arrays are kept
+	 */
+	void clear()
+	{
+		unsigned int i = 0;
+
+		for(i=0;hashtab_ && i<hashsize_;i++){
+			hashtab_[i] = COMMON_NULL;
+		}
+		if(live_){
+			memset(live_, 0, live_bytes(seg_num_));
+		}
+		block_pos_ = 0;
+		free_head_ = COMMON_NULL;
+		node_num_  = 0;
+	}
+
+	/*
+	 * func : set the signature function, see pydict_set_hash
+	 *
+	 * ret  : 0, succeed
+	 *      : -1, error, the dict has nodes or hash is not valid
+	 */
+	int set_hash(const int hash)
+	{
+		if(block_pos_>0 || hash<0 || hash>=PY_SIGN_NUM){
+			return -1;
+		}
+		hash_ = hash;
+		return 0;
+	}
+
+	/*
+	 * func : hash table grows when node number > hashsize*max_load, 0 never
+	 */
+	void set_max_load(const float max_load)
+	{
+		max_load_ = max_load > 0 ? max_load : 0;
+	}
+
+	unsigned int size() const     { return node_num_; }
+	unsigned int hashsize() const { return hashsize_; }
+	int          hash() const     { return hash_; }
+
+	iterator begin()              { return iterator(this, live_next(0)); }
+	iterator end()                { return iterator(this, block_pos_); }
+	const_iterator begin() const  { return const_iterator(this, live_next(0)); }
+	const_iterator end() const    { return const_iterator(this, block_pos_); }
+
+	/*
+	 * func : save the dict to a file, the live nodes are written in order
+	 *
+	 * ret  : 0, succeed
+	 *      : -1, error
+	 */
+	int save(const char* path, const char* file) const
+	{
+		FILE*               fp   = NULL;
+		detail::file_head   head;
+		const_iterator      it   = end();
+		node_t*             node = NULL;
+		char                fullpath[512];
+
+		memset(&head, 0, sizeof(head));
+		head.magic      = PYDICT_TPL_MAGIC;
+		head.sign_bits  = SignBits;
+		head.value_size = sizeof(Value);
+		head.hash       = hash_;
+		head.hashsize   = hashsize_;
+		head.node_num   = node_num_;
+
+		if(cmps_path(fullpath, sizeof(fullpath), path, file) < 0){
+			goto failed;
+		}
+		if((fp=fopen(fullpath, "wb"))==NULL){
+			goto failed;
+		}
+		if(fwrite(&head, sizeof(head), 1, fp)!=1){
+			goto failed;
+		}
+		for(it=begin();it!=end();++it){
+			node = node_at(it.pos());
+			if(fwrite(node->sign, sizeof(node->sign), 1, fp)!=1){
+				goto failed;
+			}
+			if(fwrite(&*it, sizeof(Value), 1, fp)!=1){
+				goto failed;
+			}
+		}
+		if(fclose(fp)!=0){
+			fp = NULL;
+			goto failed;
+		}
+		return 0;
+
+	failed:
+		if(fp){
+			fclose(fp);
+		}
+		return -1;
+	}
+
+	/*
+	 * func : load a file saved by the same instantiation, the dict is
+	 *        replaced by it
+	 *
+	 * ret  : 0, succeed
+	 *      : -1, error, the dict is not changed
+	 */
+	int load(const char* path, const char* file)
+	{
+		FILE*               fp     = NULL;
+		detail::file_head   head;
+		unsigned int        sign[SIGN_NUM];
+		unsigned int        i      = 0;
+		char                fullpath[512];
+
+		// Value needs no default constructor
+		typename std::aligned_storage<sizeof(Value), alignof(Value)>::type  value;
+
+		if(cmps_path(fullpath, sizeof(fullpath), path, file) < 0){
+			return -1;
+		}
+		if((fp=fopen(fullpath, "rb"))==NULL){
+			return -1;
+		}
+		if(fread(&head, sizeof(head), 1, fp)!=1 || head.magic!=PYDICT_TPL_MAGIC ||
+		   head.sign_bits!=SignBits || head.value_size!=sizeof(Value) || head.hash>=PY_SIGN_NUM){
+			fclose(fp);
+			return -1;
+		}
+
+		dict loaded(head.hashsize);
+
+		loaded.hash_ = head.hash;
+		for(i=0;i<head.node_num;i++){
+			if(fread(sign, sizeof(sign), 1, fp)!=1 || fread(&value, sizeof(Value), 1, fp)!=1){
+				fclose(fp);
+				return -1;
+			}
+			if(loaded.add_sign(sign, *(Value*)&value)<0){
+				fclose(fp);
+				return -1;
+			}
+		}
+		fclose(fp);
+		*this = std::move(loaded);
+
+		return 0;
+	}
+
+private:
+	unsigned int*     hashtab_;
+	unsigned int      hashsize_;
+	node_t**          segs_;        // node segments, a node never moves
+	Value**           vals_;        // split: value segments, same index
+	unsigned int      seg_num_;
+	unsigned int      block_pos_;   // nodes used
+	unsigned int      free_head_;   // free list of deleted nodes, linked by next
+	unsigned int      node_num_;
+	unsigned long*    live_;        // a bit a node, clear if freed
+	float             max_load_;
+	int               hash_;        // signature function of keys
+	py_alloc_t        alloc_;       // allocator of the arrays, see pyalloc_set
+
+	void init(const unsigned int hashsize)
+	{
+		hashtab_   = NULL;
+		hashsize_  = hashsize > 0 ? hashsize : 1;
+		segs_      = NULL;
+		vals_      = NULL;
+		seg_num_   = 0;
+		block_pos_ = 0;
+		free_head_ = COMMON_NULL;
+		node_num_  = 0;
+		live_      = NULL;
+		max_load_  = PYDICT_MAX_LOAD;
+		hash_      = py_sign_get_default();
+		alloc_     = *pyalloc_get();
+	}
+
+	void steal(dict& other)
+	{
+		memcpy((void*)this, (const void*)&other, sizeof(dict));
+		other.init(1);
+	}
+
+	void release()
+	{
+		unsigned int i = 0;
+
+		for(i=0;i<seg_num_;i++){
+			pyalloc_free(&alloc_, segs_[i], sizeof(node_t)*PYDICT_SEG_SIZE);
+			if(SPLIT){
+				pyalloc_free(&alloc_, vals_[i], sizeof(Value)*PYDICT_SEG_SIZE);
+			}
+		}
+		pyalloc_free(&alloc_, hashtab_, sizeof(unsigned int)*hashsize_);
+		pyalloc_free(&alloc_, live_, live_bytes(seg_num_));
+		free(segs_);
+		free(vals_);
+		init(hashsize_);
+	}
+
+	static size_t live_bytes(const unsigned int seg_num)
+	{
+		return sizeof(unsigned long)*((size_t)seg_num << (PYDICT_SEG_SHIFT-6));
+	}
+
+	// 64 bit signature as sign1, sign2 of PNODE, or folded to 32 bits
+	static void make_sign(const unsigned long sign64, unsigned int* sign)
+	{
+		if(SIGN_NUM==2){
+			sign[0]          = (unsigned int)(sign64>>32);
+			sign[SIGN_NUM-1] = (unsigned int)sign64;
+		}
+		else{
+			sign[0] = (unsigned int)(sign64>>32) ^ (unsigned int)sign64;
+		}
+	}
+
+	static bool same(const unsigned int* a, const unsigned int* b)
+	{
+		return a[0]==b[0] && (SIGN_NUM==1 || a[SIGN_NUM-1]==b[SIGN_NUM-1]);
+	}
+
+	static unsigned int bucket(const unsigned int* sign, const unsigned int hashsize)
+	{
+		return (SIGN_NUM==1 ? sign[0] : sign[0]+sign[SIGN_NUM-1]) % hashsize;
+	}
+
+	node_t* node_at(const unsigned int pos) const
+	{
+		return segs_[pos>>PYDICT_SEG_SHIFT] + (pos&PYDICT_SEG_MASK);
+	}
+
+	Value* value_at(const unsigned int pos) const
+	{
+		return layout_t::value(node_at(pos), vals_, pos);
+	}
+
+	unsigned long sign_at(const unsigned int pos) const
+	{
+		node_t* node = node_at(pos);
+
+		return SIGN_NUM==1 ? node->sign[0] : ((unsigned long)node->sign[0]<<32) | node->sign[SIGN_NUM-1];
+	}
+
+	// the first live position >= pos, block_pos_ if none
+	unsigned int live_next(unsigned int pos) const
+	{
+		unsigned long word = 0;
+
+		if(pos>=block_pos_){
+			return block_pos_;
+		}
+		word = live_[pos>>6] & (~0UL << (pos&63));
+		while(word==0){
+			pos = (pos|63)+1;
+			if(pos>=block_pos_){
+				return block_pos_;
+			}
+			word = live_[pos>>6];
+		}
+		pos = (pos&~63u) + __builtin_ctzl(word);
+
+		return pos<block_pos_ ? pos : block_pos_;
+	}
+
+	Value* lookup(const unsigned int* sign)
+	{
+		unsigned int   pos  = 0;
+		node_t*        node = NULL;
+
+		if(!hashtab_){
+			return NULL;
+		}
+		for(pos=hashtab_[bucket(sign, hashsize_)];pos!=COMMON_NULL;pos=node->next){
+			node = node_at(pos);
+			if(same(node->sign, sign)){
+				return layout_t::value(node, vals_, pos);
+			}
+		}
+		return NULL;
+	}
+
+	// one more segment of nodes, values and live bits
+	int grow_segs()
+	{
+		node_t**         segs = NULL;
+		Value**          vals = NULL;
+		unsigned long*   live = NULL;
+		unsigned int     i    = seg_num_;
+
+		if((segs = (node_t**)realloc(segs_, sizeof(node_t*)*(i+1))) == NULL){
+			return -1;
+		}
+		segs_ = segs;
+		if(SPLIT){
+			if((vals = (Value**)realloc(vals_, sizeof(Value*)*(i+1))) == NULL){
+				return -1;
+			}
+			vals_ = vals;
+		}
+		if((segs[i] = (node_t*)pyalloc_alloc(&alloc_, sizeof(node_t)*PYDICT_SEG_SIZE)) == NULL){
+			return -1;
+		}
+		if(SPLIT && (vals[i] = (Value*)pyalloc_alloc(&alloc_, sizeof(Value)*PYDICT_SEG_SIZE)) == NULL){
+			pyalloc_free(&alloc_, segs[i], sizeof(node_t)*PYDICT_SEG_SIZE);
+			return -1;
+		}
+		if((live = (unsigned long*)pyalloc_realloc(&alloc_, live_, live_bytes(i), live_bytes(i+1))) == NULL){
+			if(SPLIT){
+				pyalloc_free(&alloc_, vals[i], sizeof(Value)*PYDICT_SEG_SIZE);
+			}
+			pyalloc_free(&alloc_, segs[i], sizeof(node_t)*PYDICT_SEG_SIZE);
+			return -1;
+		}
+		memset((char*)live+live_bytes(i), 0, live_bytes(1));
+		live_ = live;
+		seg_num_++;
+
+		return 0;
+	}
+
+	// a hash table of hashsize buckets, live nodes are linked again
+	int rehash(const unsigned int hashsize)
+	{
+		unsigned int*   hashtab = NULL;
+		unsigned int    pos     = 0;
+		unsigned int    b       = 0;
+		node_t*         node    = NULL;
+
+		hashtab = (unsigned int*)pyalloc_alloc(&alloc_, sizeof(unsigned int)*hashsize);
+		if(!hashtab){
+			return -1;
+		}
+		for(b=0;b<hashsize;b++){
+			hashtab[b] = COMMON_NULL;
+		}
+		for(pos=live_next(0);pos<block_pos_;pos=live_next(pos+1)){
+			node          = node_at(pos);
+			b             = bucket(node->sign, hashsize);
+			node->next    = hashtab[b];
+			hashtab[b]    = pos;
+		}
+		pyalloc_free(&alloc_, hashtab_, sizeof(unsigned int)*hashsize_);
+		hashtab_  = hashtab;
+		hashsize_ = hashsize;
+
+		return 0;
+	}
+
+	int add_sign(const unsigned int* sign, const Value& value)
+	{
+		unsigned int   pos  = 0;
+		unsigned int   b    = 0;
+		node_t*        node = NULL;
+
+		if(!hashtab_ && rehash(hashsize_)<0){
+			return -1;
+		}
+		for(pos=hashtab_[bucket(sign, hashsize_)];pos!=COMMON_NULL;pos=node->next){
+			node = node_at(pos);
+			if(same(node->sign, sign)){
+				*layout_t::value(node, vals_, pos) = value;
+				return 1;
+			}
+		}
+
+		// a larger table, or longer chains if it can not be allocated
+		if(max_load_>0 && node_num_+1 > hashsize_*max_load_ && hashsize_ < detail::NODE_MAX/2){
+			rehash(hashsize_*2);
+		}
+
+		if(free_head_!=COMMON_NULL){
+			pos        = free_head_;
+			free_head_ = node_at(pos)->next;
+		}
+		else{
+			if(block_pos_>=detail::NODE_MAX){
+				return -1;
+			}
+			if(block_pos_ >= (seg_num_<<PYDICT_SEG_SHIFT) && grow_segs()<0){
+				return -1;
+			}
+			pos = block_pos_++;
+		}
+		node = node_at(pos);
+		memcpy(node->sign, sign, sizeof(node->sign));
+		*layout_t::value(node, vals_, pos) = value;
+		b             = bucket(sign, hashsize_);
+		node->next    = hashtab_[b];
+		hashtab_[b]   = pos;
+		live_[pos>>6] |= 1UL<<(pos&63);
+		node_num_++;
+
+		return 0;
+	}
+};
+
+} // namespace pydict
+
+#endif
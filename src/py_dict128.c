@@ -0,0 +1,754 @@
+/***********************************************************************************
+ * Describe : a hash table keyed on 128 bit signatures, see py_dict128.h
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ **********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <py_sign.h>
+#include <py_utils.h>
+#include <py_dict.h>
+#include <py_dict128.h>
+
+
+#define BATCH_STEP  16           // keys looked up together by the batch find
+#define NODE_MAX    0xFFFFFFF0u  // positions below COMMON_NULL
+#define HASH_MAX    0x80000000u  // largest power of 2 hash table
+
+/*
+ * func : round a hash table size up to a power of 2
+ */
+static unsigned int pydict128_hashsize(unsigned int hashsize)
+{
+	unsigned int size = PYDICT128_HASH_MIN;
+
+	while(size < hashsize && size < HASH_MAX){
+		size <<= 1;
+	}
+	return size;
+}
+
+/*
+ * func : walk a chain, sign1 is compared first, the nodes of a chain share
+ *        the low bits of sign2
+ */
+static inline PNODE128* pydict128_lookup(py_dict128_t* pydict, unsigned long sign1,
+		unsigned long sign2)
+{
+	PNODE128*      pnode   = NULL;
+	unsigned int   nodepos = pydict->hashtab[sign2 & pydict->hashmask];
+
+	while(nodepos!=COMMON_NULL){
+		pnode = pydict128_node(pydict, nodepos);
+		if(pnode->sign1==sign1 && pnode->sign2==sign2){
+			return pnode;
+		}
+		nodepos = pnode->next;
+	}
+
+	return NULL;
+}
+
+/*
+ * func : nodes seg_num segments hold, the last segment is partly used,
+ *        positions stop at NODE_MAX
+ */
+static inline unsigned int pydict128_segs_capacity(const unsigned int seg_num)
+{
+	unsigned long  size = (unsigned long)seg_num << PYDICT128_SEG_SHIFT;
+
+	return size > NODE_MAX ? NODE_MAX : (unsigned int)size;
+}
+
+/*
+ * func : allocate node segments for node_num nodes
+ *
+ * ret  : 0, succeed
+ *      : -1, error, out of memory
+ */
+static int pydict128_reserve(py_dict128_t* pydict, const unsigned int node_num)
+{
+	PNODE128**     segs    = NULL;
+	unsigned int   seg_num = 0;
+	unsigned int   i       = 0;
+
+	seg_num = (unsigned int)(((unsigned long)node_num+PYDICT128_SEG_MASK) >> PYDICT128_SEG_SHIFT);
+
+	while(pydict->seg_num < seg_num){
+		i    = pydict->seg_num;
+		segs = (PNODE128**)realloc(pydict->segs, sizeof(PNODE128*)*(i+1));
+		if(!segs){
+			return -1;
+		}
+		pydict->segs = segs;
+
+		// 64 bytes aligned, one of pyalloc_huge takes its huge pages now
+		segs[i] = (PNODE128*)pyalloc_alloc(&pydict->alloc, sizeof(PNODE128)*PYDICT128_SEG_SIZE);
+		if(!segs[i]){
+			return -1;
+		}
+		pydict->seg_num++;
+		pydict->block_size = pydict128_segs_capacity(pydict->seg_num);
+	}
+
+	return 0;
+}
+
+/*
+ * func : double the hash table and relink all live nodes
+ *
+ * ret  : 0, succeed
+ *      : -1, error, out of memory, the dict is not changed
+ */
+static int pydict128_grow(py_dict128_t* pydict)
+{
+	unsigned int*  hashtab  = NULL;
+	unsigned int   hashsize = pydict->hashsize<<1;
+	unsigned int   i        = 0;
+	PNODE128*      pnode    = NULL;
+
+	if(pydict->hashsize >= HASH_MAX){
+		return 0;
+	}
+	hashtab = (unsigned int*)pyalloc_alloc(&pydict->alloc, sizeof(unsigned int)*hashsize);
+	if(!hashtab){
+		return -1;
+	}
+	for(i=0;i<hashsize;i++){
+		hashtab[i] = COMMON_NULL;
+	}
+	for(i=0;i<pydict->block_pos;i++){
+		pnode = pydict128_node(pydict, i);
+		if(pnode->live){
+			pnode->next = hashtab[pnode->sign2 & (hashsize-1)];
+			hashtab[pnode->sign2 & (hashsize-1)] = i;
+		}
+	}
+
+	pyalloc_free(&pydict->alloc, pydict->hashtab, sizeof(unsigned int)*pydict->hashsize);
+	pydict->hashtab  = hashtab;
+	pydict->hashsize = hashsize;
+	pydict->hashmask = hashsize-1;
+
+	return 0;
+}
+
+/*
+ * func : create a 128 bit dict
+ *
+ * args : hashsize, the hash table size, rounded up to a power of 2
+ *      : nodesize, nodes allocated at first
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_dict128_t struct
+ */
+py_dict128_t* pydict128_create(const unsigned int hashsize, const unsigned int nodesize)
+{
+	py_dict128_t*  pydict = NULL;
+	unsigned int   i      = 0;
+
+	pydict = (py_dict128_t*)calloc(1, sizeof(py_dict128_t));
+	if(!pydict){
+		goto failed;
+	}
+	pydict->alloc     = *pyalloc_get();
+	pydict->hashsize  = pydict128_hashsize(hashsize);
+	pydict->hashmask  = pydict->hashsize-1;
+	pydict->max_load  = PYDICT_MAX_LOAD;
+	pydict->free_head = COMMON_NULL;
+
+	pydict->hashtab = (unsigned int*)pyalloc_alloc(&pydict->alloc, sizeof(unsigned int)*pydict->hashsize);
+	if(!pydict->hashtab){
+		goto failed;
+	}
+	for(i=0;i<pydict->hashsize;i++){
+		pydict->hashtab[i] = COMMON_NULL;
+	}
+	if(nodesize>0 && pydict128_reserve(pydict, nodesize) < 0){
+		goto failed;
+	}
+
+	return pydict;
+
+failed:
+	pydict128_free(pydict);
+	return NULL;
+}
+
+/*
+ * func : free a 128 bit dict, created, loaded or mapped
+ */
+void pydict128_free(py_dict128_t* pydict)
+{
+	unsigned int i = 0;
+
+	if(!pydict){
+		return;
+	}
+	if(pydict->map_addr){
+		if(pydict->map_flags & PYDICT_MAP_LOCK){
+			munlock(pydict->map_addr, pydict->map_size);
+		}
+		munmap(pydict->map_addr, pydict->map_size);
+		pydict->map_addr = NULL;
+	}
+	else{
+		for(i=0;i<pydict->seg_num;i++){
+			pyalloc_free(&pydict->alloc, pydict->segs[i], sizeof(PNODE128)*PYDICT128_SEG_SIZE);
+		}
+		pyalloc_free(&pydict->alloc, pydict->hashtab, sizeof(unsigned int)*pydict->hashsize);
+	}
+	free(pydict->segs);
+	free(pydict);
+}
+
+/*
+ * func : set the max load factor
+ */
+void pydict128_set_max_load(py_dict128_t* pydict, const float max_load)
+{
+	pydict->max_load = max_load>0 ? max_load : 0;
+}
+
+/*
+ * func : add a value pair
+ *
+ * ret  : 1,  find a same key, value changed
+ *      : 0,  find NO same key, new node added
+ *      : -1, error
+ */
+int pydict128_add(py_dict128_t* pydict, const char* key, const int keylen,
+		const int code, const int value)
+{
+	SIGN128 sign;
+
+	py_sign128_hash(key, keylen, &sign);
+
+	return pydict128_add_node(pydict, &sign, code, value);
+}
+
+/*
+ * func : add a node by its signature
+ *
+ * ret  : see pydict128_add
+ */
+int pydict128_add_node(py_dict128_t* pydict, const SIGN128* sign, const int code,
+		const int value)
+{
+	PNODE128*      pnode   = NULL;
+	unsigned int   nodepos = 0;
+	unsigned int   bucket  = 0;
+
+	if(pydict->map_addr){
+		return -1;
+	}
+
+	pnode = pydict128_lookup(pydict, sign->sign1, sign->sign2);
+	if(pnode){
+		pnode->code  = code;
+		pnode->value = value;
+		return 1;
+	}
+
+	// a failed grow leaves longer chains, the node is still added
+	if(pydict->max_load>0 && pydict->node_num+1 > pydict->hashsize*pydict->max_load){
+		pydict128_grow(pydict);
+	}
+
+	if(pydict->free_head!=COMMON_NULL){
+		nodepos           = pydict->free_head;
+		pydict->free_head = pydict128_node(pydict, nodepos)->next;
+	}
+	else{
+		nodepos = pydict->block_pos;
+		if(nodepos>=pydict->block_size){
+			if(nodepos>=NODE_MAX || pydict128_reserve(pydict, nodepos+1) < 0){
+				return -1;
+			}
+		}
+		pydict->block_pos++;
+	}
+
+	bucket       = (unsigned int)(sign->sign2 & pydict->hashmask);
+	pnode        = pydict128_node(pydict, nodepos);
+	pnode->sign1 = sign->sign1;
+	pnode->sign2 = sign->sign2;
+	pnode->code  = code;
+	pnode->value = value;
+	pnode->live  = 1;
+	pnode->next  = pydict->hashtab[bucket];
+	pydict->hashtab[bucket] = nodepos;
+	pydict->node_num++;
+
+	return 0;
+}
+
+/*
+ * func : delete a key
+ *
+ * ret  : 1, founded and deleted; 0, NOT found; -1, error
+ */
+int pydict128_del(py_dict128_t* pydict, const char* key, const int keylen)
+{
+	SIGN128 sign;
+
+	py_sign128_hash(key, keylen, &sign);
+
+	return pydict128_del_node(pydict, &sign);
+}
+
+/*
+ * func : delete a node by its signature, the node goes to the free list
+ *
+ * ret  : see pydict128_del
+ */
+int pydict128_del_node(py_dict128_t* pydict, const SIGN128* sign)
+{
+	unsigned int*  link    = NULL;
+	unsigned int   nodepos = 0;
+	PNODE128*      pnode   = NULL;
+
+	if(pydict->map_addr){
+		return -1;
+	}
+
+	link = pydict->hashtab + (sign->sign2 & pydict->hashmask);
+	for(nodepos=*link;nodepos!=COMMON_NULL;nodepos=*link){
+		pnode = pydict128_node(pydict, nodepos);
+		if(pnode->sign1==sign->sign1 && pnode->sign2==sign->sign2){
+			*link             = pnode->next;
+			pnode->code       = -1;
+			pnode->value      = 0;
+			pnode->live       = 0;
+			pnode->next       = pydict->free_head;
+			pydict->free_head = nodepos;
+			pydict->node_num--;
+			return 1;
+		}
+		link = &pnode->next;
+	}
+
+	return 0;
+}
+
+/*
+ * func : find a key
+ *
+ * ret  : 0, NOT found; 1, founded
+ */
+int pydict128_find(py_dict128_t* pydict, const char* key, const int keylen,
+		int* code, int* value)
+{
+	PNODE128*  pnode = NULL;
+	SIGN128    sign;
+
+	py_sign128_hash(key, keylen, &sign);
+	pnode = pydict128_lookup(pydict, sign.sign1, sign.sign2);
+	if(pnode==NULL){
+		return 0;
+	}
+	*code  = pnode->code;
+	*value = pnode->value;
+
+	return 1;
+}
+
+/*
+ * func : find a node by its signature
+ *
+ * ret  : NULL, NOT found
+ *      : else, pointer to the node
+ */
+PNODE128* pydict128_find_node(py_dict128_t* pydict, const SIGN128* sign)
+{
+	return pydict128_lookup(pydict, sign->sign1, sign->sign2);
+}
+
+/*
+ * func : find a group of signatures, memory accesses of all keys are
+ *        prefetched and overlapped, see pydict_find_group
+ *
+ * args : signs, n <= BATCH_STEP
+ *      : nodes, result nodes, NULL if not found
+ *
+ * ret  : number of founded nodes
+ */
+static int pydict128_find_group(py_dict128_t* pydict, SIGN128* signs, const int n,
+		PNODE128** nodes)
+{
+	unsigned int   pos[BATCH_STEP];
+	unsigned int   nodepos[BATCH_STEP];
+	int            active[BATCH_STEP];
+	int            active_num = 0;
+	int            found      = 0;
+	int            i          = 0;
+	int            j          = 0;
+	PNODE128*      pnode      = NULL;
+
+	// bucket slots
+	for(i=0;i<n;i++){
+		pos[i] = (unsigned int)(signs[i].sign2 & pydict->hashmask);
+		__builtin_prefetch(pydict->hashtab+pos[i]);
+	}
+
+	// chain heads, a node is one line
+	for(i=0;i<n;i++){
+		nodes[i]   = NULL;
+		nodepos[i] = pydict->hashtab[pos[i]];
+		if(nodepos[i]!=COMMON_NULL){
+			__builtin_prefetch(pydict128_node(pydict, nodepos[i]));
+			active[active_num++] = i;
+		}
+	}
+
+	// walk all chains one node at a time
+	while(active_num>0){
+		for(j=0;j<active_num;){
+			i     = active[j];
+			pnode = pydict128_node(pydict, nodepos[i]);
+			if(pnode->sign1==signs[i].sign1 && pnode->sign2==signs[i].sign2){
+				nodes[i] = pnode;
+				found++;
+				active[j] = active[--active_num];
+				continue;
+			}
+			nodepos[i] = pnode->next;
+			if(nodepos[i]==COMMON_NULL){
+				active[j] = active[--active_num];
+				continue;
+			}
+			__builtin_prefetch(pydict128_node(pydict, nodepos[i]));
+			j++;
+		}
+	}
+
+	return found;
+}
+
+/*
+ * func : find a batch of keys
+ *
+ * ret  : number of founded keys
+ */
+int pydict128_find_batch(py_dict128_t* pydict, const char* keys[], const int lens[],
+		const int n, int* codes, int* values, char* found)
+{
+	SIGN128        signs[BATCH_STEP];
+	PNODE128*      nodes[BATCH_STEP];
+	int            num   = 0;
+	int            total = 0;
+	int            i     = 0;
+	int            j     = 0;
+
+	for(i=0;i<n;i+=BATCH_STEP){
+		num = n-i < BATCH_STEP ? n-i : BATCH_STEP;
+		for(j=0;j<num;j++){
+			py_sign128_hash(keys[i+j], lens[i+j], signs+j);
+		}
+		total += pydict128_find_group(pydict, signs, num, nodes);
+		for(j=0;j<num;j++){
+			if(nodes[j]){
+				codes[i+j]  = nodes[j]->code;
+				values[i+j] = nodes[j]->value;
+			}
+			if(found){
+				found[i+j] = nodes[j]!=NULL;
+			}
+		}
+	}
+
+	return total;
+}
+
+/*
+ * func : get the first live node
+ *
+ * ret  : NULL, dict empty
+ *      : else, pointer to the node
+ */
+PNODE128* pydict128_first(py_dict128_t* pydict, unsigned int* pos)
+{
+	*pos = COMMON_NULL;
+
+	return pydict128_next(pydict, pos);
+}
+
+/*
+ * func : get the live node after pos, COMMON_NULL for the first
+ *
+ * ret  : NULL, reach the end
+ *      : else, pointer to the node
+ */
+PNODE128* pydict128_next(py_dict128_t* pydict, unsigned int* pos)
+{
+	PNODE128*      pnode = NULL;
+	unsigned int   i     = 0;
+
+	for(i=(*pos==COMMON_NULL ? 0 : *pos+1);i<pydict->block_pos;i++){
+		pnode = pydict128_node(pydict, i);
+		if(pnode->live){
+			*pos = i;
+			return pnode;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * func : number of live nodes
+ */
+unsigned int pydict128_size(py_dict128_t* pydict)
+{
+	return pydict->node_num;
+}
+
+/*
+ * func : save a 128 bit dict to disk
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+int pydict128_save(py_dict128_t* pydict, const char* path, const char* file)
+{
+	FILE*              fp   = NULL;
+	unsigned int       i    = 0;
+	unsigned int       num  = 0;
+	pydict128_head_t   head;
+	char               fullpath[512];
+
+	memset(&head, 0, sizeof(head));
+	head.magic     = PYDICT_FILE_MAGIC128;
+	head.version   = PYDICT128_VERSION;
+	head.node_size = sizeof(PNODE128);
+	head.hashsize  = pydict->hashsize;
+	head.block_pos = pydict->block_pos;
+	head.free_head = pydict->free_head;
+	head.node_num  = pydict->node_num;
+
+	if(cmps_path(fullpath, sizeof(fullpath), path, file) < 0){
+		goto failed;
+	}
+	if((fp=fopen(fullpath, "wb"))==NULL){
+		goto failed;
+	}
+	if(fwrite(&head, sizeof(head), 1, fp)!=1){
+		goto failed;
+	}
+	if(fwrite(pydict->hashtab, sizeof(unsigned int), head.hashsize, fp)!=head.hashsize){
+		goto failed;
+	}
+
+	// a segment at a time
+	for(i=0;i<head.block_pos;i+=num){
+		num = head.block_pos-i < PYDICT128_SEG_SIZE ? head.block_pos-i : PYDICT128_SEG_SIZE;
+		if(fwrite(pydict128_node(pydict, i), sizeof(PNODE128), num, fp)!=num){
+			goto failed;
+		}
+	}
+
+	if(fclose(fp)!=0){
+		fp = NULL;
+		goto failed;
+	}
+
+	return 0;
+failed:
+	if(fp){
+		fclose(fp);
+		fp = NULL;
+	}
+	return -1;
+}
+
+/*
+ * func : check the head of a 128 bit dict file
+ *
+ * args : head, the head
+ *      : size, file size
+ *
+ * ret  : 0, a complete file
+ *      : -1, not a 128 bit dict file, or cut
+ */
+static int pydict128_check(pydict128_head_t* head, size_t size)
+{
+	if(head->magic!=PYDICT_FILE_MAGIC128 || head->version!=PYDICT128_VERSION ||
+	   head->node_size!=sizeof(PNODE128)){
+		return -1;
+	}
+	if(head->hashsize<PYDICT128_HASH_MIN || (head->hashsize&(head->hashsize-1))!=0 ||
+	   head->block_pos>=NODE_MAX || head->node_num>head->block_pos){
+		return -1;
+	}
+	if(sizeof(*head) + (size_t)head->hashsize*sizeof(unsigned int)
+	   + (size_t)head->block_pos*sizeof(PNODE128) > size){
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * func : load a 128 bit dict from disk
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_dict128_t struct
+ */
+py_dict128_t* pydict128_load(const char* path, const char* file)
+{
+	FILE*              fp     = NULL;
+	py_dict128_t*      pydict = NULL;
+	unsigned int       i      = 0;
+	unsigned int       num    = 0;
+	pydict128_head_t   head;
+	struct stat        st;
+	char               fullpath[512];
+
+	if(cmps_path(fullpath, sizeof(fullpath), path, file) < 0){
+		goto failed;
+	}
+	if((fp=fopen(fullpath, "rb"))==NULL){
+		goto failed;
+	}
+	if(fstat(fileno(fp), &st)<0 || fread(&head, sizeof(head), 1, fp)!=1){
+		goto failed;
+	}
+	if(pydict128_check(&head, st.st_size)<0){
+		goto failed;
+	}
+	if((pydict = pydict128_create(head.hashsize, head.block_pos))==NULL){
+		goto failed;
+	}
+	if(fread(pydict->hashtab, sizeof(unsigned int), head.hashsize, fp)!=head.hashsize){
+		goto failed;
+	}
+	for(i=0;i<head.block_pos;i+=num){
+		num = head.block_pos-i < PYDICT128_SEG_SIZE ? head.block_pos-i : PYDICT128_SEG_SIZE;
+		if(fread(pydict128_node(pydict, i), sizeof(PNODE128), num, fp)!=num){
+			goto failed;
+		}
+	}
+	pydict->block_pos = head.block_pos;
+	pydict->free_head = head.free_head;
+	pydict->node_num  = head.node_num;
+
+	fclose(fp);
+	return pydict;
+
+failed:
+	if(fp){
+		fclose(fp);
+		fp = NULL;
+	}
+	pydict128_free(pydict);
+	return NULL;
+}
+
+/*
+ * func : map a 128 bit dict file into memory, read only
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_dict128_t struct
+ */
+py_dict128_t* pydict128_map(const char* path, const char* file, int flags)
+{
+	int                fd         = -1;
+	int                mmap_flags = MAP_SHARED;
+	void*              addr       = MAP_FAILED;
+	size_t             size       = 0;
+	unsigned int       i          = 0;
+	py_dict128_t*      pydict     = NULL;
+	PNODE128*          nodes      = NULL;
+	pydict128_head_t   head;
+	struct stat        st;
+	char               fullpath[512];
+
+	if(cmps_path(fullpath, sizeof(fullpath), path, file) < 0){
+		goto failed;
+	}
+	if((fd = open(fullpath, O_RDONLY)) < 0){
+		goto failed;
+	}
+	if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(head)){
+		goto failed;
+	}
+	size = st.st_size;
+
+	if(flags & PYDICT_MAP_POPULATE){
+		mmap_flags |= MAP_POPULATE;
+	}
+	addr = mmap(NULL, size, PROT_READ, mmap_flags, fd, 0);
+	if(addr == MAP_FAILED){
+		goto failed;
+	}
+	close(fd);
+	fd = -1;
+
+	memcpy(&head, addr, sizeof(head));
+	if(pydict128_check(&head, size) < 0){
+		goto failed;
+	}
+	if(flags & PYDICT_MAP_WILLNEED){
+		madvise(addr, size, MADV_WILLNEED);
+	}
+	if(flags & PYDICT_MAP_LOCK){
+		if(mlock(addr, size) < 0){
+			goto failed;
+		}
+	}
+
+	pydict = (py_dict128_t*)calloc(1, sizeof(py_dict128_t));
+	if(!pydict){
+		goto failed;
+	}
+	pydict->alloc      = *pyalloc_get();
+	pydict->hashtab    = (unsigned int*)((char*)addr + sizeof(head));
+	pydict->hashsize   = head.hashsize;
+	pydict->hashmask   = head.hashsize-1;
+	pydict->block_pos  = head.block_pos;
+	pydict->block_size = head.block_pos;
+	pydict->free_head  = head.free_head;
+	pydict->node_num   = head.node_num;
+	pydict->map_addr   = addr;
+	pydict->map_size   = size;
+	pydict->map_flags  = flags;
+
+	// segments point into the mapping, nodes are not copied
+	nodes = (PNODE128*)(pydict->hashtab + head.hashsize);
+	pydict->seg_num = (unsigned int)(((unsigned long)head.block_pos+PYDICT128_SEG_MASK) >> PYDICT128_SEG_SHIFT);
+	pydict->segs    = (PNODE128**)malloc(sizeof(PNODE128*)*(pydict->seg_num>0 ? pydict->seg_num : 1));
+	if(!pydict->segs){
+		goto failed;
+	}
+	for(i=0;i<pydict->seg_num;i++){
+		pydict->segs[i] = nodes + ((size_t)i<<PYDICT128_SEG_SHIFT);
+	}
+
+	return pydict;
+
+failed:
+	if(pydict){
+		pydict128_free(pydict);
+		addr = MAP_FAILED;
+	}
+	if(fd >= 0){
+		close(fd);
+		fd = -1;
+	}
+	if(addr != MAP_FAILED){
+		if(flags & PYDICT_MAP_LOCK){
+			munlock(addr, size);
+		}
+		munmap(addr, size);
+		addr = MAP_FAILED;
+	}
+	return NULL;
+}
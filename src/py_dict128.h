@@ -0,0 +1,245 @@
+/********************************************************************************
+ * Describe : a string hash table keyed on 128 bit signatures, for dicts of
+ *          : billions of keys where two 64 bit signatures may collide. keys
+ *          : are signed once by py_sign128_hash.
+ *
+ *          : a node is 32 bytes aligned to 32, it never spans two cache
+ *          : lines, so a chain walk reads one line a node as a py_dict_t
+ *          : does (its 20 bytes nodes span two lines one time in four). the
+ *          : hash table is a power of 2, the bucket is the low bits of sign2
+ *          : and a walk compares sign1 first, the node is rejected on its
+ *          : first word.
+ *
+ *          : file layout, [pydict128_head_t][hashtab hashsize*4][nodes], the
+ *          : head is 64 bytes and hashsize a power of 2 of 16 or more, so the
+ *          : nodes of a mapped file are aligned too.
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ *******************************************************************************/
+#ifndef _PY_DICT128_H
+#define _PY_DICT128_H
+
+#include <stddef.h>
+#include <py_sign.h>
+#include <py_alloc.h>
+#include <py_dict.h>
+
+#define PYDICT128_VERSION    1
+#define PYDICT128_HASH_MIN   16
+
+// nodes are kept in segments of 8MB, four 2MB huge pages
+#define PYDICT128_SEG_SHIFT  18
+#define PYDICT128_SEG_SIZE   (1u<<PYDICT128_SEG_SHIFT)
+#define PYDICT128_SEG_MASK   (PYDICT128_SEG_SIZE-1)
+
+
+// data structure define here
+//
+typedef struct _pnode128{
+	unsigned long sign1;
+	unsigned long sign2;        // its low bits are the bucket
+	int           code;
+	int           value;
+	unsigned int  next;
+	unsigned int  live;         // 0, on the free list
+}__attribute__((aligned(32))) PNODE128;
+
+typedef struct _py_dict128{
+	unsigned int*     hashtab;
+	unsigned int      hashsize;     // power of 2
+	unsigned int      hashmask;
+
+	PNODE128**        segs;         // node segments, a node never moves
+	unsigned int      seg_num;
+	unsigned int      block_pos;    // nodes used
+	unsigned int      block_size;   // nodes allocated, block_pos if mapped
+	unsigned int      free_head;    // free list of deleted nodes, linked by next
+	unsigned int      node_num;     // live nodes
+
+	float             max_load;     // 0, hashtab never grows
+
+	void*             map_addr;     // not NULL, read-only dict mapped by pydict128_map
+	size_t            map_size;
+	int               map_flags;
+
+	py_alloc_t        alloc;        // allocator of the arrays, see pyalloc_set
+}py_dict128_t;
+
+// head of a 128 bit dict file, 64 bytes
+typedef struct _pydict128_head{
+	unsigned int      magic;        // PYDICT_FILE_MAGIC128
+	unsigned int      version;
+	unsigned int      node_size;    // sizeof(PNODE128)
+	unsigned int      hashsize;
+	unsigned int      block_pos;
+	unsigned int      free_head;
+	unsigned int      node_num;
+	unsigned int      reserved;
+	unsigned long     reserved2[4];
+}pydict128_head_t;
+
+
+// functions defined here
+//
+
+/*
+ * func : create a 128 bit dict
+ *
+ * args : hashsize, the hash table size, rounded up to a power of 2
+ *      : nodesize, nodes allocated at first
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_dict128_t struct
+ */
+py_dict128_t*  pydict128_create(const unsigned int hashsize, const unsigned int nodesize);
+
+/*
+ * func : free a 128 bit dict, created, loaded or mapped
+ */
+void      pydict128_free(py_dict128_t* pydict);
+
+/*
+ * func : get a node by position
+ *
+ * args : pydict, pos, position of the node, < block_pos
+ *
+ * ret  : pointer to the node, it stays valid while the dict grows
+ */
+static inline PNODE128* pydict128_node(py_dict128_t* pydict, const unsigned int pos)
+{
+	return pydict->segs[pos>>PYDICT128_SEG_SHIFT] + (pos&PYDICT128_SEG_MASK);
+}
+
+/*
+ * func : set the max load factor, see pydict_set_max_load
+ *
+ * note : the hash table is doubled and all nodes relinked at once when
+ *      : node_num passes hashsize*max_load
+ */
+void      pydict128_set_max_load(py_dict128_t* pydict, const float max_load);
+
+/*
+ * func : add a value pair
+ *
+ * args : pydict, key, keylen, code, value
+ *
+ * ret  : 1,  find a same key, value changed
+ *      : 0,  find NO same key, new node added
+ *      : -1, error, out of memory or the dict is mapped
+ */
+int       pydict128_add(py_dict128_t* pydict, const char* key, const int keylen,
+                        const int code, const int value);
+
+/*
+ * func : add a node by its signature, the code and value are copied
+ *
+ * ret  : see pydict128_add
+ */
+int       pydict128_add_node(py_dict128_t* pydict, const SIGN128* sign, const int code,
+                             const int value);
+
+/*
+ * func : delete a key
+ *
+ * ret  : 1, founded and deleted
+ *      : 0, NOT found
+ *      : -1, error, the dict is mapped
+ */
+int       pydict128_del(py_dict128_t* pydict, const char* key, const int keylen);
+
+/*
+ * func : delete a node by its signature
+ *
+ * ret  : see pydict128_del
+ */
+int       pydict128_del_node(py_dict128_t* pydict, const SIGN128* sign);
+
+/*
+ * func : find a key
+ *
+ * args : pydict, key, keylen
+ *      : code, value, the result
+ *
+ * ret  : 0, NOT found; 1, founded
+ */
+int       pydict128_find(py_dict128_t* pydict, const char* key, const int keylen,
+                         int* code, int* value);
+
+/*
+ * func : find a node by its signature
+ *
+ * ret  : NULL, NOT found
+ *      : else, pointer to the node
+ */
+PNODE128* pydict128_find_node(py_dict128_t* pydict, const SIGN128* sign);
+
+/*
+ * func : find a batch of keys, the buckets and nodes of a group of keys
+ *        are prefetched and the chains walked together
+ *
+ * args : pydict, keys, lens, n
+ *      : codes, values, the result of found keys
+ *      : found, 1 or 0 for each key, may be NULL
+ *
+ * ret  : number of founded keys
+ */
+int       pydict128_find_batch(py_dict128_t* pydict, const char* keys[], const int lens[],
+                               const int n, int* codes, int* values, char* found);
+
+/*
+ * func : get the first live node
+ *
+ * args : pos, return the position of the node
+ *
+ * ret  : NULL, dict empty
+ *      : else, pointer to the node
+ */
+PNODE128* pydict128_first(py_dict128_t* pydict, unsigned int* pos);
+
+/*
+ * func : get the live node after pos
+ *
+ * args : pos, the start position, return the position of the node
+ *
+ * ret  : NULL, reach the end
+ *      : else, pointer to the node
+ */
+PNODE128* pydict128_next(py_dict128_t* pydict, unsigned int* pos);
+
+/*
+ * func : number of live nodes
+ */
+unsigned int pydict128_size(py_dict128_t* pydict);
+
+/*
+ * func : save a 128 bit dict to disk
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+int       pydict128_save(py_dict128_t* pydict, const char* path, const char* file);
+
+/*
+ * func : load a 128 bit dict from disk
+ *
+ * ret  : NULL, error, or not a 128 bit dict file
+ *      : else, pointer to py_dict128_t struct
+ */
+py_dict128_t*  pydict128_load(const char* path, const char* file);
+
+/*
+ * func : map a 128 bit dict file into memory, read only
+ *
+ * args : path, file
+ *      : flags, PYDICT_MAP_* flags, see pydict_map
+ *
+ * ret  : NULL, error, or not a 128 bit dict file
+ *      : else, pointer to py_dict128_t struct
+ */
+py_dict128_t*  pydict128_map(const char* path, const char* file, int flags);
+
+#endif
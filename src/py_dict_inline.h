@@ -0,0 +1,76 @@
+/********************************************************************************
+ * Describe : inline find of a dict, include it instead of calling pydict_find
+ *          : in a hot loop. short keys are signed inline, see py_sign_inline.h,
+ *          : and the chain of a chain engine dict in the node layout is walked
+ *          : in the caller. a swiss or split dict, a rehashing dict or a dict
+ *          : with counters goes to pydict_find_node.
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ *******************************************************************************/
+#ifndef PY_DICT_INLINE_H
+#define PY_DICT_INLINE_H
+
+#include <py_dict.h>
+#include <py_sign_inline.h>
+
+/*
+ * func : find a node, same as pydict_find_node_str
+ *
+ * args : pydict, pointer to the hash table
+ *      : key, keylen, the key to be searched
+ *
+ * ret  : NULL, NOT found
+ *      : else, pointer to the founded node
+ */
+static inline PNODE* pydict_find_node_inline(py_dict_t* pydict, const char* key, const int keylen)
+{
+	SIGN64         sign;
+	PNODE*         pnode   = NULL;
+	unsigned int   sign1   = 0;
+	unsigned int   sign2   = 0;
+	unsigned int   nodepos = 0;
+
+	sign.sign = py_sign64_inline(pydict->hash, key, keylen);
+	if(pydict->engine!=PYDICT_ENGINE_CHAIN || pydict->keys || pydict->oldtab || pydict->counters){
+		return pydict_find_node(pydict, &sign);
+	}
+
+	sign1   = (unsigned int)(sign.sign>>32);
+	sign2   = (unsigned int)sign.sign;
+	nodepos = pydict->hashtab[(sign1+sign2) % pydict->hashsize];
+	while(nodepos!=COMMON_NULL){
+		pnode = pydict_node(pydict, nodepos);
+		if(pnode->sign1==sign1&&pnode->sign2==sign2){
+			return pnode;
+		}
+		nodepos = pnode->next;
+	}
+
+	return NULL;
+}
+
+/*
+ * func : find a key, same as pydict_find
+ *
+ * ret  : 0, NOT found; 1, founded
+ */
+static inline int pydict_find_inline(py_dict_t* pydict, const char* key, const int keylen,
+		int* code, int* value)
+{
+	PNODE* pnode = NULL;
+
+	pnode = pydict_find_node_inline(pydict, key, keylen);
+	if(pnode==NULL){
+		return 0;
+	}
+	*code  = pnode->code;
+	*value = pnode->value;
+
+	return 1;
+}
+
+#endif
@@ -0,0 +1,614 @@
+/***********************************************************************************
+ * Describe : frozen minimal perfect hash dict, see py_frozen.h
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ **********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <py_sign.h>
+#include <py_sign_inline.h>
+#include <py_utils.h>
+#include <py_dict.h>
+#include <py_frozen.h>
+
+
+#define FROZEN_BUCKET_KEYS 4      // keys a bucket holds on average
+#define FROZEN_SLACK       50     // one more slot for every 50 keys
+#define FROZEN_MAX_PILOT   65536
+#define FROZEN_MAX_TRY     16     // seeds tried before giving up
+
+static inline unsigned long frozen_mix(unsigned long h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdUL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53UL;
+	h ^= h >> 33;
+	return h;
+}
+
+// map a 64 bit hash to [0, n)
+static inline unsigned long frozen_range(unsigned long h, unsigned long n)
+{
+	return (unsigned long)(((unsigned __int128)h*n) >> 64);
+}
+
+static inline unsigned long frozen_sign(unsigned int sign1, unsigned int sign2)
+{
+	return ((unsigned long)sign1 << 32) | sign2;
+}
+
+/*
+ * func : slot of a key hash for a pilot, may be past key_num
+ */
+static inline unsigned long frozen_pos(frozen_head_t* head, unsigned long h, unsigned int pilot)
+{
+	return frozen_range(frozen_mix(h ^ ((pilot+1)*0x9e3779b97f4a7c15UL)), head->slot_num);
+}
+
+/*
+ * func : slot of a signature, the signature in the slot must still be
+ *        checked
+ *
+ * ret  : the slot
+ *      : key_num, empty dict
+ */
+static inline unsigned long frozen_index(py_frozen_t* pyfrozen, unsigned long sign)
+{
+	frozen_head_t*  head = &pyfrozen->head;
+	unsigned long   h    = 0;
+	unsigned long   pos  = 0;
+
+	if(head->key_num==0){
+		return 0;
+	}
+	h   = frozen_mix(sign ^ head->seed);
+	pos = frozen_pos(head, h, pyfrozen->pilots[frozen_range(h, head->bucket_num)]);
+	if(pos>=head->key_num){
+		pos = pyfrozen->remap[pos-head->key_num];
+	}
+	return pos;
+}
+
+/*
+ * func : set the section pointers from the head
+ *
+ * args : pyfrozen, the head is set
+ *      : base, first byte of the sections, NULL only to get the size
+ *
+ * ret  : size of the sections
+ */
+static size_t frozen_layout(py_frozen_t* pyfrozen, char* base)
+{
+	frozen_head_t*  head = &pyfrozen->head;
+	size_t          size = 0;
+
+#define FROZEN_SECTION(ptr, type, num) \
+	do{ \
+		if(base){ \
+			pyfrozen->ptr = (type*)(base+size); \
+		} \
+		size += ((size_t)(num)*sizeof(type) + 63) & ~(size_t)63; \
+	}while(0)
+
+	FROZEN_SECTION(pilots, unsigned short, head->bucket_num);
+	FROZEN_SECTION(remap, unsigned int, head->slot_num-head->key_num);
+	FROZEN_SECTION(nodes, frozen_node_t, head->key_num);
+
+#undef FROZEN_SECTION
+
+	return size;
+}
+
+/*
+ * func : find a pilot for every bucket with a seed
+ *
+ * args : head, the sizes and the seed are set
+ *      : keys, hashes of the keys
+ *      : pilots, the result
+ *      : taken, slot_num bits, the slots used
+ *
+ * ret  : 0, succeed
+ *      : -1, a bucket has no pilot, try another seed
+ *      : -2, error
+ *
+ * note : buckets are placed from the largest, while the table is empty
+ */
+static int frozen_search(frozen_head_t* head, unsigned long* keys,
+                         unsigned short* pilots, unsigned long* taken)
+{
+	unsigned long*  sorted = NULL;
+	unsigned int*   start  = NULL;
+	unsigned int*   order  = NULL;
+	unsigned int*   size_pos = NULL;
+	unsigned long   pos[FROZEN_BUCKET_KEYS*16];
+	unsigned long   b      = 0;
+	unsigned int    max    = 0;
+	unsigned int    size   = 0;
+	unsigned int    pilot  = 0;
+	unsigned int    i      = 0;
+	unsigned int    j      = 0;
+	unsigned int    k      = 0;
+	int             ret    = -2;
+
+	sorted   = (unsigned long*)malloc(sizeof(unsigned long)*(head->key_num+1));
+	start    = (unsigned int*)calloc(head->bucket_num+1, sizeof(unsigned int));
+	order    = (unsigned int*)malloc(sizeof(unsigned int)*head->bucket_num);
+	size_pos = (unsigned int*)calloc(FROZEN_BUCKET_KEYS*16+2, sizeof(unsigned int));
+	if(!sorted || !start || !order || !size_pos){
+		goto out;
+	}
+
+	// keys grouped by bucket
+	for(i=0;i<head->key_num;i++){
+		start[frozen_range(keys[i], head->bucket_num)+1]++;
+	}
+	for(b=0;b<head->bucket_num;b++){
+		size = start[b+1];
+		if(size>=FROZEN_BUCKET_KEYS*16){ // a seed crowding a bucket this much is bad
+			ret = -1;
+			goto out;
+		}
+		size_pos[size]++;
+		start[b+1] += start[b];
+		if(size>max){
+			max = size;
+		}
+	}
+	for(i=0;i<head->key_num;i++){
+		b = frozen_range(keys[i], head->bucket_num);
+		sorted[start[b]++] = keys[i];
+	}
+	for(b=head->bucket_num;b>0;b--){ // start[b] is the end of bucket b
+		start[b] = start[b-1];
+	}
+	start[0] = 0;
+
+	// buckets by size, the largest first
+	for(i=0,j=0;i<=max;i++){
+		k = size_pos[max-i];
+		size_pos[max-i] = j;
+		j += k;
+	}
+	for(b=0;b<head->bucket_num;b++){
+		order[size_pos[start[b+1]-start[b]]++] = b;
+	}
+
+	for(i=0;i<head->bucket_num;i++){
+		b    = order[i];
+		size = start[b+1]-start[b];
+		if(size==0){
+			pilots[b] = 0;
+			continue;
+		}
+		for(pilot=0;pilot<FROZEN_MAX_PILOT;pilot++){
+			for(j=0;j<size;j++){
+				pos[j] = frozen_pos(head, sorted[start[b]+j], pilot);
+				if(taken[pos[j]>>6] & (1UL<<(pos[j]&63))){
+					break;
+				}
+				for(k=0;k<j && pos[k]!=pos[j];k++);
+				if(k<j){
+					break;
+				}
+			}
+			if(j==size){
+				break;
+			}
+		}
+		if(pilot==FROZEN_MAX_PILOT){
+			ret = -1;
+			goto out;
+		}
+		pilots[b] = pilot;
+		for(j=0;j<size;j++){
+			taken[pos[j]>>6] |= 1UL<<(pos[j]&63);
+		}
+	}
+	ret = 0;
+
+out:
+	if(sorted){
+		free(sorted);
+	}
+	if(start){
+		free(start);
+	}
+	if(order){
+		free(order);
+	}
+	if(size_pos){
+		free(size_pos);
+	}
+	return ret;
+}
+
+/*
+ * func : freeze the live nodes of a dict
+ *
+ * args : pydict, the dict, not changed
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_frozen_t struct
+ */
+py_frozen_t* pyfrozen_freeze(py_dict_t* pydict)
+{
+	py_frozen_t*    pyfrozen  = NULL;
+	frozen_head_t*  head      = NULL;
+	unsigned long*  signs     = NULL;
+	unsigned long*  keys      = NULL;
+	unsigned long*  taken     = NULL;
+	unsigned long   words     = 0;
+	unsigned long   pos       = 0;
+	unsigned long   sign      = 0;
+	unsigned int    num       = 0;
+	unsigned int    free_pos  = 0;
+	unsigned int    i         = 0;
+	int             retry     = 0;
+	int             ret       = -1;
+	void*           data      = NULL;
+	PNODE*          node      = NULL;
+
+	pyfrozen = (py_frozen_t*)calloc(1, sizeof(py_frozen_t));
+	if(!pyfrozen){
+		goto failed;
+	}
+	head = &pyfrozen->head;
+	head->magic   = FROZEN_MAGIC;
+	head->version = FROZEN_VERSION;
+	head->hash    = pydict->hash;
+
+	signs = (unsigned long*)malloc(sizeof(unsigned long)*(pydict->block_pos+1));
+	keys  = (unsigned long*)malloc(sizeof(unsigned long)*(pydict->block_pos+1));
+	if(!signs || !keys){
+		goto failed;
+	}
+	for(i=0;i<pydict->block_pos;i++){
+		node = pydict_node(pydict, i);
+		if(node->code!=-1){ // deleted or free node
+			signs[num++] = frozen_sign(node->sign1, node->sign2);
+		}
+	}
+	head->key_num    = num;
+	head->slot_num   = num + num/FROZEN_SLACK;
+	head->bucket_num = num/FROZEN_BUCKET_KEYS + 1;
+
+	pyfrozen->data_size = frozen_layout(pyfrozen, NULL);
+	if(posix_memalign(&data, 64, pyfrozen->data_size+1) != 0){
+		goto failed;
+	}
+	pyfrozen->data = data;
+	frozen_layout(pyfrozen, (char*)data);
+
+	words = (head->slot_num+63) >> 6;
+	taken = (unsigned long*)malloc(sizeof(unsigned long)*(words+1));
+	if(!taken){
+		goto failed;
+	}
+	for(retry=0;retry<FROZEN_MAX_TRY;retry++){
+		head->seed = frozen_mix(retry+1);
+		for(i=0;i<num;i++){
+			keys[i] = frozen_mix(signs[i] ^ head->seed);
+		}
+		memset(taken, 0, sizeof(unsigned long)*(words+1));
+		if((ret = frozen_search(head, keys, pyfrozen->pilots, taken)) != -1){
+			break;
+		}
+	}
+	if(ret<0){
+		goto failed;
+	}
+
+	// slots past the keys go to the free slots below, in order
+	for(pos=num;pos<head->slot_num;pos++){
+		pyfrozen->remap[pos-num] = 0;
+		if(!(taken[pos>>6] & (1UL<<(pos&63)))){
+			continue;
+		}
+		while(taken[free_pos>>6] & (1UL<<(free_pos&63))){
+			free_pos++;
+		}
+		pyfrozen->remap[pos-num] = free_pos++;
+	}
+
+	for(i=0;i<pydict->block_pos;i++){
+		node = pydict_node(pydict, i);
+		if(node->code==-1){
+			continue;
+		}
+		sign = frozen_sign(node->sign1, node->sign2);
+		pos  = frozen_index(pyfrozen, sign);
+		pyfrozen->nodes[pos].sign  = sign;
+		pyfrozen->nodes[pos].code  = node->code;
+		pyfrozen->nodes[pos].value = node->value;
+	}
+
+	free(signs);
+	free(keys);
+	free(taken);
+	return pyfrozen;
+
+failed:
+	if(signs){
+		free(signs);
+	}
+	if(keys){
+		free(keys);
+	}
+	if(taken){
+		free(taken);
+	}
+	pyfrozen_free(pyfrozen);
+	return NULL;
+}
+
+/*
+ * func : free a frozen dict, built, loaded or mapped
+ */
+void pyfrozen_free(py_frozen_t* pyfrozen)
+{
+	if(!pyfrozen){
+		return;
+	}
+	if(pyfrozen->map_addr){
+		if(pyfrozen->map_flags & PYDICT_MAP_LOCK){
+			munlock(pyfrozen->map_addr, pyfrozen->map_size);
+		}
+		munmap(pyfrozen->map_addr, pyfrozen->map_size);
+		pyfrozen->map_addr = NULL;
+	}
+	else if(pyfrozen->data){
+		free(pyfrozen->data);
+		pyfrozen->data = NULL;
+	}
+	free(pyfrozen);
+}
+
+/*
+ * func : save a frozen dict to disk
+ *
+ * args : pyfrozen, path, file
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+int pyfrozen_save(py_frozen_t* pyfrozen, const char* path, const char* file)
+{
+	FILE*  fp = NULL;
+	char   fullpath[512];
+
+	if(cmps_path(fullpath, sizeof(fullpath), path, file) < 0){
+		goto failed;
+	}
+	if((fp=fopen(fullpath, "wb"))==NULL){
+		goto failed;
+	}
+	if(fwrite(&pyfrozen->head, sizeof(frozen_head_t), 1, fp)!=1){
+		goto failed;
+	}
+	if(fwrite(pyfrozen->data, 1, pyfrozen->data_size, fp)!=pyfrozen->data_size){
+		goto failed;
+	}
+	if(fclose(fp)!=0){
+		fp = NULL;
+		goto failed;
+	}
+	return 0;
+
+failed:
+	if(fp){
+		fclose(fp);
+		fp = NULL;
+	}
+	return -1;
+}
+
+/*
+ * func : check a file head and set the section sizes
+ *
+ * ret  : 0, the head is good and the file holds size bytes of sections
+ *      : -1, error
+ */
+static int frozen_check(py_frozen_t* pyfrozen, size_t size)
+{
+	frozen_head_t*  head = &pyfrozen->head;
+
+	if(head->magic!=FROZEN_MAGIC || head->version!=FROZEN_VERSION ||
+	   head->slot_num<head->key_num || head->bucket_num==0 || head->hash>=PY_SIGN_NUM){
+		return -1;
+	}
+	pyfrozen->data_size = frozen_layout(pyfrozen, NULL);
+	if(pyfrozen->data_size!=size){
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * func : load a frozen dict from disk
+ *
+ * args : path, file
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_frozen_t struct
+ */
+py_frozen_t* pyfrozen_load(const char* path, const char* file)
+{
+	FILE*          fp       = NULL;
+	py_frozen_t*   pyfrozen = NULL;
+	void*          data     = NULL;
+	struct stat    st;
+	char           fullpath[512];
+
+	if(cmps_path(fullpath, sizeof(fullpath), path, file) < 0){
+		goto failed;
+	}
+	if((fp=fopen(fullpath, "rb"))==NULL){
+		goto failed;
+	}
+	if(fstat(fileno(fp), &st)<0 || st.st_size<(off_t)sizeof(frozen_head_t)){
+		goto failed;
+	}
+	pyfrozen = (py_frozen_t*)calloc(1, sizeof(py_frozen_t));
+	if(!pyfrozen){
+		goto failed;
+	}
+	if(fread(&pyfrozen->head, sizeof(frozen_head_t), 1, fp)!=1){
+		goto failed;
+	}
+	if(frozen_check(pyfrozen, st.st_size-sizeof(frozen_head_t)) < 0){
+		goto failed;
+	}
+	if(posix_memalign(&data, 64, pyfrozen->data_size+1) != 0){
+		goto failed;
+	}
+	pyfrozen->data = data;
+	if(fread(data, 1, pyfrozen->data_size, fp)!=pyfrozen->data_size){
+		goto failed;
+	}
+	frozen_layout(pyfrozen, (char*)data);
+
+	fclose(fp);
+	return pyfrozen;
+
+failed:
+	if(fp){
+		fclose(fp);
+		fp = NULL;
+	}
+	pyfrozen_free(pyfrozen);
+	return NULL;
+}
+
+/*
+ * func : map a frozen dict file into memory
+ *
+ * args : path, file
+ *      : flags, PYDICT_MAP_* flags, see pydict_map
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_frozen_t struct
+ */
+py_frozen_t* pyfrozen_map(const char* path, const char* file, int flags)
+{
+	int            fd         = -1;
+	int            mmap_flags = MAP_SHARED;
+	void*          addr       = MAP_FAILED;
+	size_t         size       = 0;
+	py_frozen_t*   pyfrozen   = NULL;
+	struct stat    st;
+	char           fullpath[512];
+
+	if(cmps_path(fullpath, sizeof(fullpath), path, file) < 0){
+		goto failed;
+	}
+	if((fd = open(fullpath, O_RDONLY)) < 0){
+		goto failed;
+	}
+	if(fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(frozen_head_t)){
+		goto failed;
+	}
+	size = st.st_size;
+
+	if(flags & PYDICT_MAP_POPULATE){
+		mmap_flags |= MAP_POPULATE;
+	}
+	addr = mmap(NULL, size, PROT_READ, mmap_flags, fd, 0);
+	if(addr == MAP_FAILED){
+		goto failed;
+	}
+	close(fd);
+	fd = -1;
+
+	pyfrozen = (py_frozen_t*)calloc(1, sizeof(py_frozen_t));
+	if(!pyfrozen){
+		goto failed;
+	}
+	memcpy(&pyfrozen->head, addr, sizeof(frozen_head_t));
+	if(frozen_check(pyfrozen, size-sizeof(frozen_head_t)) < 0){
+		goto failed;
+	}
+
+	if(flags & PYDICT_MAP_WILLNEED){
+		madvise(addr, size, MADV_WILLNEED);
+	}
+	if(flags & PYDICT_MAP_LOCK){
+		if(mlock(addr, size) < 0){
+			goto failed;
+		}
+	}
+
+	pyfrozen->data      = (char*)addr + sizeof(frozen_head_t);
+	pyfrozen->map_addr  = addr;
+	pyfrozen->map_size  = size;
+	pyfrozen->map_flags = flags;
+	frozen_layout(pyfrozen, (char*)pyfrozen->data);
+
+	return pyfrozen;
+
+failed:
+	if(pyfrozen){
+		free(pyfrozen);
+		pyfrozen = NULL;
+	}
+	if(fd >= 0){
+		close(fd);
+		fd = -1;
+	}
+	if(addr != MAP_FAILED){
+		munmap(addr, size);
+		addr = MAP_FAILED;
+	}
+	return NULL;
+}
+
+/*
+ * func : find a key by its signature, see py_sign64_double_int
+ *
+ * args : pyfrozen, sign1, sign2
+ *      : code, value, the result
+ *
+ * ret  : 1, found
+ *      : 0, not found
+ */
+int pyfrozen_find_sign(py_frozen_t* pyfrozen, const unsigned int sign1,
+                       const unsigned int sign2, int* code, int* value)
+{
+	unsigned long  sign = frozen_sign(sign1, sign2);
+	unsigned long  idx  = frozen_index(pyfrozen, sign);
+
+	if(pyfrozen->head.key_num==0 || pyfrozen->nodes[idx].sign!=sign){
+		return 0;
+	}
+	*code  = pyfrozen->nodes[idx].code;
+	*value = pyfrozen->nodes[idx].value;
+	return 1;
+}
+
+/*
+ * func : find a key
+ *
+ * args : pyfrozen, key, keylen
+ *      : code, value, the result
+ *
+ * ret  : 1, found
+ *      : 0, not found
+ */
+int pyfrozen_find(py_frozen_t* pyfrozen, const char* key, const int keylen,
+                  int* code, int* value)
+{
+	unsigned long  sign = 0;
+
+	sign = py_sign64_inline(pyfrozen->head.hash, key, keylen);
+
+	return pyfrozen_find_sign(pyfrozen, (unsigned int)(sign>>32), (unsigned int)sign, code, value);
+}
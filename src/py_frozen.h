@@ -0,0 +1,137 @@
+/********************************************************************************
+ * Describe : a frozen, read only dict. the keys of a py_dict_t are placed by a
+ *          : minimal perfect hash (PTHash style). keys are hashed into small
+ *          : buckets, every bucket has a pilot which sends its keys to free
+ *          : slots of the table, the signatures, codes and values are packed
+ *          : in a node array indexed by the slot. a lookup is one key
+ *          : signature, one pilot load and one node check, there is no hash
+ *          : table and no chain.
+ *
+ *          : the table has a few more slots than keys, slots past the last
+ *          : key are sent to the free slots below it by a remap array.
+ *
+ *          : a frozen dict costs about 16.6 bytes a key, a py_dict_t costs
+ *          : 20 bytes a node and 4 bytes a bucket.
+ *
+ *          : file layout, every section is 64 bytes aligned
+ *          : [frozen_head_t][pilots bucket_num*2][remap (slot_num-key_num)*4]
+ *          : [nodes key_num*16]
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ *******************************************************************************/
+#ifndef _PY_FROZEN_H
+#define _PY_FROZEN_H
+
+#include <stddef.h>
+#include <py_dict.h>
+
+#define FROZEN_MAGIC      0x5a465950   // "PYFZ"
+#define FROZEN_VERSION    1
+
+// a key of a frozen dict, signature, code and value share a cache line
+typedef struct _frozen_node{
+	unsigned long   sign;         // sign1<<32 | sign2
+	int             code;
+	int             value;
+}frozen_node_t;
+
+// file head of a frozen dict, 64 bytes
+typedef struct _frozen_head{
+	unsigned int    magic;
+	unsigned int    version;
+	unsigned int    key_num;
+	unsigned int    slot_num;     // slots of the table, a few more than keys
+	unsigned int    bucket_num;
+	unsigned int    hash;         // signature function of the dict, 0 in old files
+	unsigned long   seed;         // seed of the key hash
+	unsigned long   reserved2[4];
+}frozen_head_t;
+
+typedef struct _py_frozen{
+	frozen_head_t     head;
+	unsigned short*   pilots;     // pilot of each bucket
+	unsigned int*     remap;      // slot below key_num of each slot past it
+	frozen_node_t*    nodes;      // the key in each slot
+
+	void*             data;       // sections, allocated or mapped
+	size_t            data_size;
+	void*             map_addr;   // not NULL for a mapped frozen dict
+	size_t            map_size;
+	int               map_flags;
+}py_frozen_t;
+
+/*
+ * func : freeze the live nodes of a dict
+ *
+ * args : pydict, the dict, not changed
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_frozen_t struct
+ */
+py_frozen_t*  pyfrozen_freeze(py_dict_t* pydict);
+
+/*
+ * func : free a frozen dict, built, loaded or mapped
+ */
+void          pyfrozen_free(py_frozen_t* pyfrozen);
+
+/*
+ * func : save a frozen dict to disk
+ *
+ * args : pyfrozen, path, file
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+int           pyfrozen_save(py_frozen_t* pyfrozen, const char* path, const char* file);
+
+/*
+ * func : load a frozen dict from disk
+ *
+ * args : path, file
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_frozen_t struct
+ */
+py_frozen_t*  pyfrozen_load(const char* path, const char* file);
+
+/*
+ * func : map a frozen dict file into memory
+ *
+ * args : path, file
+ *      : flags, PYDICT_MAP_* flags, see pydict_map
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_frozen_t struct
+ */
+py_frozen_t*  pyfrozen_map(const char* path, const char* file, int flags);
+
+/*
+ * func : find a key
+ *
+ * args : pyfrozen, key, keylen
+ *      : code, value, the result
+ *
+ * ret  : 1, found
+ *      : 0, not found
+ */
+int           pyfrozen_find(py_frozen_t* pyfrozen, const char* key, const int keylen,
+                            int* code, int* value);
+
+/*
+ * func : find a key by its signature, see py_sign64_double_int
+ *
+ * args : pyfrozen, sign1, sign2
+ *      : code, value, the result
+ *
+ * ret  : 1, found
+ *      : 0, not found
+ */
+int           pyfrozen_find_sign(py_frozen_t* pyfrozen, const unsigned int sign1,
+                                 const unsigned int sign2, int* code, int* value);
+
+#endif
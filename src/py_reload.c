@@ -0,0 +1,279 @@
+/***********************************************************************************
+ * Describe : dict handle with background reload, see py_reload.h
+ * 
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ * 
+ * Create   : 2008-10-15
+ * 
+ * Modify   : 2008-10-15
+ **********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sched.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <py_utils.h>
+#include <py_dict.h>
+#include <py_reload.h>
+
+
+/*
+ * func : load the dict file
+ *
+ * args : reload, the handle
+ *
+ * ret  : NULL, error
+ *      : else, the loaded dict
+ */
+static py_dict_t* pyreload_load(py_reload_t* reload)
+{
+	if(reload->flags & PYRELOAD_MAP){
+		return pydict_map_fullpath(reload->path, reload->flags & ~PYRELOAD_MAP);
+	}
+	return pydict_load_fullpath(reload->path);
+}
+
+/*
+ * func : wait until no reader is in an epoch before the given one
+ */
+static void pyreload_sync(py_reload_t* reload, unsigned long epoch)
+{
+	unsigned long  reader_epoch = 0;
+	int            i            = 0;
+
+	for(i=0;i<reload->slot_num;i++){
+		while(1){
+			reader_epoch = __atomic_load_n(&reload->slots[i].epoch, __ATOMIC_SEQ_CST);
+			if(reader_epoch==0 || reader_epoch>=epoch){
+				break;
+			}
+			sched_yield();
+		}
+	}
+}
+
+/*
+ * func : watching thread
+ */
+static void* pyreload_thread(void* arg)
+{
+	py_reload_t*     reload = (py_reload_t*)arg;
+	struct timeval   now;
+	struct timespec  deadline;
+
+	pthread_mutex_lock(&reload->mutex);
+	while(!reload->stop){
+		gettimeofday(&now, NULL);
+		deadline.tv_sec  = now.tv_sec + reload->interval;
+		deadline.tv_nsec = now.tv_usec * 1000;
+		pthread_cond_timedwait(&reload->cond, &reload->mutex, &deadline);
+		if(reload->stop){
+			break;
+		}
+		pthread_mutex_unlock(&reload->mutex);
+		pyreload_check(reload);
+		pthread_mutex_lock(&reload->mutex);
+	}
+	pthread_mutex_unlock(&reload->mutex);
+
+	return NULL;
+}
+
+/*
+ * func : create a reload handle, load the dict and start watching its file
+ *
+ * args : path, file, the dict file
+ *      : interval, seconds between two checks of the file, 0 for no 
+ *      :           background thread, call pyreload_check instead
+ *      : reader_num, max number of reader threads
+ *      : flags, 0 for pydict_load, or PYRELOAD_MAP|PYDICT_MAP_* for pydict_map
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_reload_t struct
+ */
+py_reload_t* pyreload_create(const char* path, const char* file, const int interval,
+		const int reader_num, const int flags)
+{
+	py_reload_t*   reload = NULL;
+	struct stat    st;
+
+	assert(reader_num > 0);
+
+	reload = (py_reload_t*)calloc(1, sizeof(py_reload_t));
+	if(!reload){
+		goto failed;
+	}
+	if(cmps_path(reload->path, sizeof(reload->path), path, file) < 0){
+		goto failed;
+	}
+	reload->flags    = flags;
+	reload->interval = interval;
+	reload->epoch    = 1;
+
+	if(posix_memalign((void**)&reload->slots, 64, sizeof(reload_slot_t)*reader_num) != 0){
+		reload->slots = NULL;
+		goto failed;
+	}
+	memset(reload->slots, 0, sizeof(reload_slot_t)*reader_num);
+	reload->slot_num = reader_num;
+
+	pthread_mutex_init(&reload->mutex, NULL);
+	pthread_mutex_init(&reload->load_mutex, NULL);
+	pthread_cond_init(&reload->cond, NULL);
+
+	// first version
+	if(stat(reload->path, &st) < 0){
+		goto failed;
+	}
+	if((reload->current = pyreload_load(reload)) == NULL){
+		goto failed;
+	}
+	reload->mtime   = st.st_mtime;
+	reload->size    = st.st_size;
+	reload->ino     = st.st_ino;
+	reload->version = 1;
+
+	if(interval > 0){
+		if(pthread_create(&reload->thread, NULL, pyreload_thread, reload) != 0){
+			goto failed;
+		}
+		reload->running = 1;
+	}
+
+	return reload;
+
+failed:
+	if(reload){
+		if(reload->slots){
+			pthread_mutex_destroy(&reload->mutex);
+			pthread_mutex_destroy(&reload->load_mutex);
+			pthread_cond_destroy(&reload->cond);
+			free(reload->slots);
+		}
+		pydict_free(reload->current);
+		free(reload);
+		reload = NULL;
+	}
+	return NULL;
+}
+
+/*
+ * func : stop watching and free the handle and the current dict
+ *
+ * note : all readers must have left.
+ */
+void pyreload_free(py_reload_t* reload)
+{
+	if(!reload){
+		return;
+	}
+
+	if(reload->running){
+		pthread_mutex_lock(&reload->mutex);
+		reload->stop = 1;
+		pthread_cond_signal(&reload->cond);
+		pthread_mutex_unlock(&reload->mutex);
+		pthread_join(reload->thread, NULL);
+		reload->running = 0;
+	}
+
+	pydict_free(reload->current);
+	reload->current = NULL;
+
+	pthread_mutex_destroy(&reload->mutex);
+	pthread_mutex_destroy(&reload->load_mutex);
+	pthread_cond_destroy(&reload->cond);
+	free(reload->slots);
+	free(reload);
+	reload = NULL;
+}
+
+/*
+ * func : check the dict file and reload it if it changed
+ *
+ * ret  : 1, a new dict is published
+ *      : 0, file not changed
+ *      : -1, error, the current dict is kept
+ */
+int pyreload_check(py_reload_t* reload)
+{
+	py_dict_t*     pydict = NULL;
+	py_dict_t*     old    = NULL;
+	unsigned long  epoch  = 0;
+	struct stat    st;
+
+	// one loader at a time
+	pthread_mutex_lock(&reload->load_mutex);
+
+	if(stat(reload->path, &st) < 0){
+		goto failed;
+	}
+	if(st.st_mtime==reload->mtime && st.st_size==reload->size && st.st_ino==reload->ino){
+		pthread_mutex_unlock(&reload->load_mutex);
+		return 0;
+	}
+	if((pydict = pyreload_load(reload)) == NULL){
+		goto failed;
+	}
+
+	// publish, then wait for the readers of the old dict
+	old   = __atomic_exchange_n(&reload->current, pydict, __ATOMIC_SEQ_CST);
+	epoch = __atomic_add_fetch(&reload->epoch, 1, __ATOMIC_SEQ_CST);
+	pyreload_sync(reload, epoch);
+	pydict_free(old);
+
+	reload->mtime = st.st_mtime;
+	reload->size  = st.st_size;
+	reload->ino   = st.st_ino;
+	__atomic_add_fetch(&reload->version, 1, __ATOMIC_RELEASE);
+
+	pthread_mutex_unlock(&reload->load_mutex);
+	return 1;
+
+failed:
+	pthread_mutex_unlock(&reload->load_mutex);
+	return -1;
+}
+
+/*
+ * func : register a reader thread
+ *
+ * ret  : -1, error, too many readers
+ *      : else, reader id
+ */
+int pyreload_reader(py_reload_t* reload)
+{
+	int reader = -1;
+
+	pthread_mutex_lock(&reload->mutex);
+	if(reload->slot_used < reload->slot_num){
+		reader = reload->slot_used++;
+	}
+	pthread_mutex_unlock(&reload->mutex);
+
+	return reader;
+}
+
+/*
+ * func : find in the current dict
+ *
+ * args : reload, the handle
+ *      : reader, reader id of the calling thread
+ *      : key, len, code, value, see pydict_find
+ *
+ * ret  : 0, NOT found; 1, founded
+ */
+int pyreload_find(py_reload_t* reload, const int reader, const char* key, const int len,
+		int* code, int* value)
+{
+	py_dict_t*  pydict = NULL;
+	int         ret    = 0;
+
+	pydict = pyreload_enter(reload, reader);
+	ret    = pydict_find(pydict, key, len, code, value);
+	pyreload_leave(reload, reader);
+
+	return ret;
+}
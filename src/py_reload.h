@@ -0,0 +1,144 @@
+/********************************************************************************
+ * Describe : a dict handle which watches a dict file and reloads it in the 
+ *          : background. a new version is published by an atomic pointer 
+ *          : swap, the old one is freed after all readers have left it 
+ *          : (epoch based reclamation), so lookups never see a freed dict.
+ *
+ *          : write a new dict file to a temp file and rename it to the 
+ *          : watched path, so a half written file is never loaded.
+ * 
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ * 
+ * Create   : 2008-10-15
+ * 
+ * Modify   : 2008-10-15
+ *******************************************************************************/
+#ifndef _PY_RELOAD_H
+#define _PY_RELOAD_H
+
+#include <pthread.h>
+#include <sys/types.h>
+#include <py_dict.h>
+
+// macros defined here
+//
+#define PYRELOAD_MAP    0x100   // load by pydict_map, may be ORed with PYDICT_MAP_*
+
+// data structure define here
+//
+typedef struct _reload_slot{
+	unsigned long     epoch;        // epoch when the reader entered, 0 outside
+	char              pad[56];      // one slot per cache line
+}reload_slot_t;
+
+typedef struct _py_reload{
+	char              path[512];    // full path of the dict file
+	int               flags;        // PYRELOAD_MAP and PYDICT_MAP_* flags
+	int               interval;     // seconds between two checks of the file
+
+	py_dict_t*        current;      // published dict
+	unsigned long     epoch;        // increased on every publish
+	unsigned int      version;      // number of loaded dicts, read it atomically
+
+	// stat of the loaded file
+	time_t            mtime;
+	off_t             size;
+	ino_t             ino;
+
+	reload_slot_t*    slots;        // one per reader
+	int               slot_num;
+	int               slot_used;
+
+	pthread_t         thread;
+	pthread_mutex_t   load_mutex;   // one loader at a time
+	pthread_mutex_t   mutex;
+	pthread_cond_t    cond;
+	int               running;
+	int               stop;
+}py_reload_t;
+
+
+// functions defined here
+//
+
+/*
+ * func : create a reload handle, load the dict and start watching its file
+ *
+ * args : path, file, the dict file
+ *      : interval, seconds between two checks of the file, 0 for no 
+ *      :           background thread, call pyreload_check instead
+ *      : reader_num, max number of reader threads
+ *      : flags, 0 for pydict_load, or PYRELOAD_MAP|PYDICT_MAP_* for pydict_map
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_reload_t struct
+ */
+py_reload_t*  pyreload_create(const char* path, const char* file, const int interval,
+                              const int reader_num, const int flags);
+
+/*
+ * func : stop watching and free the handle and the current dict
+ *
+ * note : all readers must have left.
+ */
+void          pyreload_free(py_reload_t* reload);
+
+/*
+ * func : check the dict file and reload it if it changed
+ *
+ * ret  : 1, a new dict is published
+ *      : 0, file not changed
+ *      : -1, error, the current dict is kept
+ */
+int           pyreload_check(py_reload_t* reload);
+
+/*
+ * func : register a reader thread
+ *
+ * ret  : -1, error, too many readers
+ *      : else, reader id
+ */
+int           pyreload_reader(py_reload_t* reload);
+
+/*
+ * func : enter the read side, get the current dict
+ *
+ * args : reload, the handle
+ *      : reader, reader id of the calling thread
+ *
+ * ret  : the current dict, valid until pyreload_leave
+ */
+static inline py_dict_t* pyreload_enter(py_reload_t* reload, const int reader)
+{
+	// acquire, a reader that sees a new epoch sees the dict published
+	// before it, never the old one retired at that epoch
+	unsigned long epoch = __atomic_load_n(&reload->epoch, __ATOMIC_ACQUIRE);
+
+	// the slot must be visible before the dict pointer is read
+	__atomic_store_n(&reload->slots[reader].epoch, epoch, __ATOMIC_SEQ_CST);
+
+	return __atomic_load_n(&reload->current, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * func : leave the read side, the dict got by pyreload_enter can NOT be 
+ *      : used anymore
+ */
+static inline void pyreload_leave(py_reload_t* reload, const int reader)
+{
+	__atomic_store_n(&reload->slots[reader].epoch, 0, __ATOMIC_RELEASE);
+}
+
+/*
+ * func : find in the current dict
+ *
+ * args : reload, the handle
+ *      : reader, reader id of the calling thread
+ *      : key, len, code, value, see pydict_find
+ *
+ * ret  : 0, NOT found; 1, founded
+ */
+int           pyreload_find(py_reload_t* reload, const int reader, const char* key, const int len,
+                            int* code, int* value);
+
+#endif
@@ -0,0 +1,252 @@
+/***********************************************************************************
+ * Describe : dictionary segmentation with rolling signatures, see py_seg.h
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ **********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <py_sign.h>
+#include <py_sign_inline.h>
+#include <py_dict.h>
+#include <py_seg.h>
+
+
+#define SEG_STACK 256    // character starts of a text this long are on the stack
+
+/*
+ * func : bytes of the character at p, 2 for a GBK double byte character
+ */
+static inline int pyseg_char(const unsigned char* p, const unsigned char* end)
+{
+	if(p+1<end && p[0]>=0x81 && p[0]<=0xFE && p[1]>=0x40 && p[1]<=0xFE && p[1]!=0x7F){
+		return 2;
+	}
+	return 1;
+}
+
+/*
+ * func : longest candidate in bytes
+ */
+static inline int pyseg_max(py_dict_t* pydict)
+{
+	return pydict->key_max>0 ? (int)pydict->key_max : PYSEG_LEN_DEFAULT;
+}
+
+static inline PNODE* pyseg_find(py_dict_t* pydict, const unsigned long sign)
+{
+	SIGN64 sign64;
+
+	sign64.sign = sign;
+	return pydict_find_node(pydict, &sign64);
+}
+
+/*
+ * func : signature of a candidate one character longer
+ *
+ * args : word, n, the candidate, h is its rolling state
+ *      : c, bytes of the next character
+ *
+ * ret  : the signature of the n+c bytes, h is rolled over the character
+ */
+static inline unsigned long pyseg_sign(py_dict_t* pydict, const unsigned char* word,
+		const int n, const int c, unsigned long* h)
+{
+	int i = 0;
+
+	if(pydict->hash!=PY_SIGN_ROLL){
+		return py_sign64_inline(pydict->hash, (const char*)word, n+c);
+	}
+	for(i=n;i<n+c;i++){
+		*h = py_roll_step(*h, word[i]);
+	}
+	return py_roll_final(*h, n+c);
+}
+
+static inline int pyseg_put(pyseg_token_t* tokens, const int token_size, int* num,
+		const int offset, const int len, PNODE* node)
+{
+	if(*num>=token_size){
+		return -1;
+	}
+	tokens[*num].offset = offset;
+	tokens[*num].len    = len;
+	tokens[*num].node   = node;
+	(*num)++;
+
+	return 0;
+}
+
+/*
+ * func : forward maximum match
+ *
+ * ret  : -1, error, tokens is full
+ *      : else, number of tokens
+ */
+int pyseg_forward(py_dict_t* pydict, const char* text, const int len,
+		pyseg_token_t* tokens, const int token_size)
+{
+	const unsigned char* p     = (const unsigned char*)text;
+	const unsigned char* end   = p+len;
+	unsigned long        h     = 0;
+	unsigned long        sign  = 0;
+	PNODE*               pnode = NULL;
+	PNODE*               word  = NULL;
+	int                  max   = pyseg_max(pydict);
+	int                  pos   = 0;
+	int                  best  = 0;
+	int                  num   = 0;
+	int                  n     = 0;
+	int                  c     = 0;
+
+	while(pos<len){
+		h    = 0;
+		n    = 0;
+		best = pyseg_char(p+pos, end);
+		word = NULL;
+		while(pos+n<len){
+			c = pyseg_char(p+pos+n, end);
+			if(n+c>max){
+				break;
+			}
+			sign = pyseg_sign(pydict, p+pos, n, c, &h);
+			n   += c;
+			if((pnode = pyseg_find(pydict, sign)) != NULL){
+				best = n;
+				word = pnode;
+			}
+		}
+		if(pyseg_put(tokens, token_size, &num, pos, best, word) < 0){
+			return -1;
+		}
+		pos += best;
+	}
+
+	return num;
+}
+
+/*
+ * func : backward maximum match, candidates grow to the left, the state 
+ *        of a candidate is rolled from the one a character shorter by 
+ *        prepending its bytes
+ *
+ * ret  : -1, error, tokens is full or out of memory
+ *      : else, number of tokens
+ */
+int pyseg_backward(py_dict_t* pydict, const char* text, const int len,
+		pyseg_token_t* tokens, const int token_size)
+{
+	const unsigned char* p      = (const unsigned char*)text;
+	int                  stack[SEG_STACK+1];
+	int*                 starts = stack;
+	pyseg_token_t        token;
+	unsigned long        h      = 0;
+	unsigned long        pw     = 0;
+	unsigned long        sign   = 0;
+	PNODE*               pnode  = NULL;
+	PNODE*               word   = NULL;
+	int                  roll   = pydict->hash==PY_SIGN_ROLL;
+	int                  max    = pyseg_max(pydict);
+	int                  start_num = 0;
+	int                  best   = 0;
+	int                  num    = 0;
+	int                  k      = 0;
+	int                  i      = 0;
+	int                  b      = 0;
+
+	// character starts, then the text end
+	if(len>SEG_STACK){
+		starts = (int*)malloc(sizeof(int)*(len+1));
+		if(!starts){
+			return -1;
+		}
+	}
+	for(i=0;i<len;i+=pyseg_char(p+i, p+len)){
+		starts[start_num++] = i;
+	}
+	starts[start_num] = len;
+
+	for(k=start_num;k>0;k=best){
+		h    = 0;
+		pw   = 1;
+		best = k-1;
+		word = NULL;
+		for(i=k-1;i>=0 && starts[k]-starts[i]<=max;i--){
+			if(roll){
+				for(b=starts[i+1]-1;b>=starts[i];b--){
+					h  = py_roll_prepend(h, pw, p[b]);
+					pw = py_roll_pow(pw);
+				}
+				sign = py_roll_final(h, starts[k]-starts[i]);
+			}
+			else{
+				sign = py_sign64_inline(pydict->hash, text+starts[i], starts[k]-starts[i]);
+			}
+			if((pnode = pyseg_find(pydict, sign)) != NULL){
+				best = i;
+				word = pnode;
+			}
+		}
+		if(pyseg_put(tokens, token_size, &num, starts[best], starts[k]-starts[best], word) < 0){
+			num = -1;
+			break;
+		}
+	}
+	if(starts!=stack){
+		free(starts);
+	}
+
+	// tokens were taken from the end
+	for(i=0;i<num/2;i++){
+		token           = tokens[i];
+		tokens[i]       = tokens[num-1-i];
+		tokens[num-1-i] = token;
+	}
+
+	return num;
+}
+
+/*
+ * func : all the words of a text
+ *
+ * ret  : -1, error, tokens is full
+ *      : else, number of words
+ */
+int pyseg_all(py_dict_t* pydict, const char* text, const int len,
+		pyseg_token_t* tokens, const int token_size)
+{
+	const unsigned char* p     = (const unsigned char*)text;
+	const unsigned char* end   = p+len;
+	unsigned long        h     = 0;
+	unsigned long        sign  = 0;
+	PNODE*               pnode = NULL;
+	int                  max   = pyseg_max(pydict);
+	int                  pos   = 0;
+	int                  num   = 0;
+	int                  n     = 0;
+	int                  c     = 0;
+
+	for(pos=0;pos<len;pos+=pyseg_char(p+pos, end)){
+		h = 0;
+		n = 0;
+		while(pos+n<len){
+			c = pyseg_char(p+pos+n, end);
+			if(n+c>max){
+				break;
+			}
+			sign = pyseg_sign(pydict, p+pos, n, c, &h);
+			n   += c;
+			if((pnode = pyseg_find(pydict, sign)) != NULL){
+				if(pyseg_put(tokens, token_size, &num, pos, n, pnode) < 0){
+					return -1;
+				}
+			}
+		}
+	}
+
+	return num;
+}
@@ -0,0 +1,77 @@
+/********************************************************************************
+ * Describe : dictionary segmentation of GBK text, forward and backward
+ *          : maximum match and all the words of a text. words are the keys
+ *          : of a py_dict_t, candidates are the runs of whole characters up
+ *          : to the dict key_max bytes, PYSEG_LEN_DEFAULT if it is unknown.
+ *
+ *          : a dict signed with PY_SIGN_ROLL is walked with rolling
+ *          : signatures, a candidate one character longer (backward, one
+ *          : character earlier) is signed from the one before it in O(1), a
+ *          : position costs a signature step for each byte of its longest
+ *          : candidate instead of a hash of every candidate. a dict of
+ *          : another signature function is segmented the same, each
+ *          : candidate is signed whole.
+ *
+ *          : a character is two bytes if its lead byte is 0x81-0xFE and its
+ *          : trail byte 0x40-0xFE but 0x7F, the hanzi of is_gbk_hz and the
+ *          : GBK symbols, else one byte.
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ *******************************************************************************/
+#ifndef _PY_SEG_H
+#define _PY_SEG_H
+
+#include <py_dict.h>
+
+#define PYSEG_LEN_DEFAULT 32     // longest word in bytes of a dict with key_max 0
+
+// a token of a text
+typedef struct _pyseg_token{
+	int           offset;        // first byte in the text
+	int           len;           // bytes
+	PNODE*        node;          // the word, NULL for a character not in the dict
+}pyseg_token_t;
+
+/*
+ * func : forward maximum match, from the text start the longest word at
+ *        each position is taken, a character of no word is a token alone
+ *
+ * args : pydict, the words
+ *      : text, len, the text and its length in bytes
+ *      : tokens, token_size, the result and its size
+ *
+ * ret  : -1, error, tokens is full
+ *      : else, number of tokens, in text order
+ */
+int  pyseg_forward(py_dict_t* pydict, const char* text, const int len,
+                   pyseg_token_t* tokens, const int token_size);
+
+/*
+ * func : backward maximum match, from the text end the longest word that
+ *        ends at each position is taken
+ *
+ * args : see pyseg_forward
+ *
+ * ret  : -1, error, tokens is full or out of memory
+ *      : else, number of tokens, in text order
+ */
+int  pyseg_backward(py_dict_t* pydict, const char* text, const int len,
+                    pyseg_token_t* tokens, const int token_size);
+
+/*
+ * func : all the words of a text, every word at every position, shorter
+ *        first at a position
+ *
+ * args : see pyseg_forward, tokens are only words
+ *
+ * ret  : -1, error, tokens is full
+ *      : else, number of words
+ */
+int  pyseg_all(py_dict_t* pydict, const char* text, const int len,
+               pyseg_token_t* tokens, const int token_size);
+
+#endif
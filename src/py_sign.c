@@ -1,8 +1,20 @@
 #include <py_sign.h>
+#include <py_sign_inline.h>
 #include <assert.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PY_SIGN_X86
+#endif
 
 static inline unsigned long murmur_hash_64 ( const void * key, int len, unsigned int seed );
 static inline unsigned int murmur_hash_32 ( const void * key, int len, unsigned int seed );
+static inline unsigned long wy_hash_64(const void* key, int len);
+static inline void murmur3_hash_128(const void* key, int len, SIGN128* sign);
+
+static int py_sign_default = PY_SIGN_MURMUR;  // of new dicts
+
+static void murmur_hash_64_batch(const char** strs, const int* lens, int n, unsigned long* out);
 /*
  * func : make a 64 bit string signature
  *
@@ -63,6 +75,45 @@ void py_sign64(const char* str, int len, unsigned long* sign)
 
 }
 
+/*
+ * func : make 64 bit signatures of a batch of strings
+ *
+ * args : strs, lens, n, input strings, their length and number
+ *      : signs, the result signatures, same as py_sign64
+ *
+ * ret  :
+ */
+void py_sign64_batch(const char** strs, const int* lens, const int n, unsigned long* signs)
+{
+	murmur_hash_64_batch(strs, lens, n, signs);
+}
+
+/*
+ * func : make 64 bit signatures of a batch of strings
+ *
+ * args : strs, lens, n, input strings, their length and number
+ *      : sign1, sign2, the result signatures, same as py_sign64_double_int
+ *
+ * ret  :
+ */
+void py_sign64_double_int_batch(const char** strs, const int* lens, const int n, 
+		unsigned int* sign1, unsigned int* sign2)
+{
+	unsigned long signs[SIGN_BATCH_STEP];
+	int           num = 0;
+	int           i   = 0;
+	int           j   = 0;
+
+	for(i=0;i<n;i+=SIGN_BATCH_STEP){
+		num = n-i < SIGN_BATCH_STEP ? n-i : SIGN_BATCH_STEP;
+		murmur_hash_64_batch(strs+i, lens+i, num, signs);
+		for(j=0;j<num;j++){
+			sign1[i+j] = (unsigned int)(signs[j]>>32);
+			sign2[i+j] = (unsigned int)signs[j];
+		}
+	}
+}
+
 /*
  * func : make a 128 bit signature
  *
@@ -86,6 +137,19 @@ void py_sign128(const char* str, const int len, SIGN128* sign)
 	}
 }
 
+/*
+ * func : make a 128 bit signature in one pass, MurmurHash3_x64_128
+ *
+ * args : str, len, input string and its length
+ *      : sign, pointer to a SIGN128 struct, sign1 is h1, sign2 is h2
+ *
+ * ret  :
+ */
+void py_sign128_hash(const char* str, const int len, SIGN128* sign)
+{
+	murmur3_hash_128(str, len, sign);
+}
+
 
 /*
  * func : make a 32 bit string signature
@@ -103,6 +167,89 @@ void py_sign32(const char* str, const int len, unsigned int* sign)
 }
 
 
+/*
+ * func : make a 64 bit string signature with a given function
+ *
+ * args : hash, PY_SIGN_MURMUR, PY_SIGN_WYHASH or PY_SIGN_ROLL
+ *      : str, len, input string and its length
+ *      : sign, the result signature
+ *
+ * ret  :
+ */
+void py_sign64_hash(const int hash, const char* str, const int len, unsigned long* sign)
+{
+	if(hash==PY_SIGN_ROLL){
+		*sign = py_roll64(str, len);
+	}
+	else if(len<=PY_SIGN_SHORT){
+		*sign = hash==PY_SIGN_WYHASH ? py_wyhash64_short(str, len) : py_murmur64_short(str, len);
+	}
+	else if(hash==PY_SIGN_WYHASH){
+		*sign = wy_hash_64(str, len);
+	}
+	else{
+		*sign = murmur_hash_64(str, len, 0);
+	}
+}
+
+/*
+ * func : make a 64 bit string signature with a given function, split into
+ *        two integers as py_sign64_double_int
+ */
+void py_sign64_double_int_hash(const int hash, const char* str, const int len, 
+		unsigned int* sign1, unsigned int* sign2)
+{
+	unsigned long val64 = 0;
+
+	py_sign64_hash(hash, str, len, &val64);
+	*sign1 = (unsigned int)(val64>>32);
+	*sign2 = (unsigned int)val64;
+}
+
+/*
+ * func : make 64 bit signatures of a batch of strings with a given function
+ *
+ * note : murmur keys go to the SIMD lanes, wyhash and rolling keys one by
+ *        one, their 64x64 bit multiply has no vector form
+ */
+void py_sign64_double_int_batch_hash(const int hash, const char** strs, const int* lens, 
+		const int n, unsigned int* sign1, unsigned int* sign2)
+{
+	unsigned long val64 = 0;
+	int           i     = 0;
+
+	if(hash==PY_SIGN_MURMUR){
+		py_sign64_double_int_batch(strs, lens, n, sign1, sign2);
+		return;
+	}
+	for(i=0;i<n;i++){
+		py_sign64_hash(hash, strs[i], lens[i], &val64);
+		sign1[i] = (unsigned int)(val64>>32);
+		sign2[i] = (unsigned int)val64;
+	}
+}
+
+/*
+ * func : set the signature function of new dicts
+ */
+int py_sign_set_default(const int hash)
+{
+	if(hash<0 || hash>=PY_SIGN_NUM){
+		return -1;
+	}
+	py_sign_default = hash;
+	return 0;
+}
+
+/*
+ * func : get the signature function of new dicts
+ */
+int py_sign_get_default()
+{
+	return py_sign_default;
+}
+
+
 unsigned long murmur_hash_64 ( const void * key, int len, unsigned int seed )
 {
 	const unsigned int m = 0x5bd1e995;
@@ -205,3 +352,408 @@ unsigned int murmur_hash_32 ( const void * key, int len, unsigned int seed )
 	return h;
 }
 
+
+/*
+ * wyhash final 4 by Wang Yi, public domain, with seed 0 and its default 
+ * secret. keys up to 16 bytes take two overlapping reads and one multiply,
+ * see py_wyhash64_short, longer keys 16 or 48 bytes a step, no byte loop 
+ * for the tail.
+ */
+static inline unsigned long wy_r8(const unsigned char* p)
+{
+	unsigned long v = 0;
+
+	memcpy(&v, p, 8);
+	return v;
+}
+
+static inline unsigned long wy_hash_64(const void* key, int len)
+{
+	const unsigned char* p    = (const unsigned char*)key;
+	unsigned long        seed = py_wy_mix(PY_WY_P0, PY_WY_P1);
+	unsigned long        see1 = 0;
+	unsigned long        see2 = 0;
+	unsigned long        a    = 0;
+	unsigned long        b    = 0;
+	int                  i    = len;
+
+	if(len<=PY_SIGN_SHORT){
+		return py_wyhash64_short((const char*)key, len);
+	}
+	if(i>=48){
+		see1 = seed;
+		see2 = seed;
+		do{
+			seed = py_wy_mix(wy_r8(p)^PY_WY_P1, wy_r8(p+8)^seed);
+			see1 = py_wy_mix(wy_r8(p+16)^PY_WY_P2, wy_r8(p+24)^see1);
+			see2 = py_wy_mix(wy_r8(p+32)^PY_WY_P3, wy_r8(p+40)^see2);
+			p += 48;
+			i -= 48;
+		}while(i>=48);
+		seed ^= see1^see2;
+	}
+	while(i>16){
+		seed = py_wy_mix(wy_r8(p)^PY_WY_P1, wy_r8(p+8)^seed);
+		p += 16;
+		i -= 16;
+	}
+	a = wy_r8(p+i-16)^PY_WY_P1;
+	b = wy_r8(p+i-8)^seed;
+	py_wy_mum(&a, &b);
+
+	return py_wy_mix(a^PY_WY_P0^(unsigned long)len, b^PY_WY_P1);
+}
+
+/*
+ * MurmurHash3_x64_128 by Austin Appleby, public domain, with seed 0. two 64
+ * bit lanes take 16 bytes a round, the tail is read at most twice 8 bytes
+ * at once, no byte loop. little endian only, as the rest of this file.
+ */
+#define M3_C1 0x87c37b91114253d5ull
+#define M3_C2 0x4cf5ad432745937full
+
+static inline unsigned long m3_rotl(unsigned long x, int r)
+{
+	return (x << r) | (x >> (64-r));
+}
+
+static inline unsigned long m3_fmix(unsigned long k)
+{
+	k ^= k >> 33;
+	k *= 0xff51afd7ed558ccdull;
+	k ^= k >> 33;
+	k *= 0xc4ceb9fe1a85ec53ull;
+	k ^= k >> 33;
+	return k;
+}
+
+// the n (1 to 8) bytes at p, little endian, without reading past them
+static inline unsigned long m3_tail(const unsigned char* p, int n)
+{
+	unsigned long v = 0;
+
+	if(n>=4){
+		v = (unsigned long)py_sign_r4(p) | ((unsigned long)py_sign_r4(p+n-4) << ((n-4)*8));
+	}
+	else{
+		v = p[0] | (n>1 ? p[1]<<8 : 0) | (n>2 ? p[2]<<16 : 0);
+	}
+	return v;
+}
+
+static inline void murmur3_hash_128(const void* key, int len, SIGN128* sign)
+{
+	const unsigned char* p    = (const unsigned char*)key;
+	unsigned long        h1   = 0;
+	unsigned long        h2   = 0;
+	unsigned long        k1   = 0;
+	unsigned long        k2   = 0;
+	int                  i    = len;
+	int                  rest = len&15;
+
+	for(;i>=16;i-=16,p+=16){
+		k1 = wy_r8(p);
+		k2 = wy_r8(p+8);
+
+		k1 *= M3_C1; k1 = m3_rotl(k1, 31); k1 *= M3_C2; h1 ^= k1;
+		h1 = m3_rotl(h1, 27); h1 += h2; h1 = h1*5+0x52dce729;
+
+		k2 *= M3_C2; k2 = m3_rotl(k2, 33); k2 *= M3_C1; h2 ^= k2;
+		h2 = m3_rotl(h2, 31); h2 += h1; h2 = h2*5+0x38495ab5;
+	}
+
+	if(rest>8){
+		k2  = m3_tail(p+8, rest-8);
+		k2 *= M3_C2; k2 = m3_rotl(k2, 33); k2 *= M3_C1; h2 ^= k2;
+	}
+	if(rest>0){
+		k1  = rest>=8 ? wy_r8(p) : m3_tail(p, rest);
+		k1 *= M3_C1; k1 = m3_rotl(k1, 31); k1 *= M3_C2; h1 ^= k1;
+	}
+
+	h1 ^= (unsigned long)len;
+	h2 ^= (unsigned long)len;
+	h1 += h2;
+	h2 += h1;
+	h1  = m3_fmix(h1);
+	h2  = m3_fmix(h2);
+	h1 += h2;
+	h2 += h1;
+
+	sign->sign1 = h1;
+	sign->sign2 = h2;
+}
+
+/*
+ * murmur_hash_64 of many keys in parallel lanes. lanes run the 8 bytes 
+ * rounds together with masked gathers, a lane whose key is used up keeps
+ * its state. the bytes left after the rounds (the last word and the tail
+ * bytes) are fetched per lane, then all lanes are mixed and finalized 
+ * together.
+ */
+/*
+ * func : fetch the bytes of a key after its 8 bytes rounds, little endian
+ *
+ * args : str, len, the key
+ *
+ * ret  : the len%8 bytes after the rounds, the last word in the low 32 bits 
+ *        if len%8 >= 4, followed by the tail bytes
+ */
+static inline unsigned long murmur_rest(const char* str, int len)
+{
+	const unsigned char* data = (const unsigned char*)str;
+	unsigned long        val  = 0;
+	unsigned int         rest = len & 7;
+	unsigned int         w32  = 0;
+	unsigned short       w16  = 0;
+	unsigned int         off  = 0;
+
+	if(rest == 0){
+		return 0;
+	}
+	if(len >= 8){ // the 8 bytes ending at the key end
+		memcpy(&val, data+len-8, 8);
+		return val >> (64-rest*8);
+	}
+	if(rest & 4){
+		memcpy(&w32, data, 4);
+		val = w32;
+		off = 4;
+	}
+	if(rest & 2){
+		memcpy(&w16, data+off, 2);
+		val |= (unsigned long)w16 << (off*8);
+		off += 2;
+	}
+	if(rest & 1){
+		val |= (unsigned long)data[off] << (off*8);
+	}
+	return val;
+}
+
+#ifdef PY_SIGN_X86
+
+#define AVX2_LANES   8
+#define AVX512_LANES 16
+
+__attribute__((target("avx2")))
+static inline __m256i murmur_mix_avx2(__m256i k)
+{
+	const __m256i m = _mm256_set1_epi32(PY_MURMUR_M);
+
+	k = _mm256_mullo_epi32(k, m);
+	k = _mm256_xor_si256(k, _mm256_srli_epi32(k, 24));
+	return _mm256_mullo_epi32(k, m);
+}
+
+/*
+ * func : split 8 64 bit values in two vectors into their low and high words
+ */
+__attribute__((target("avx2")))
+static inline void murmur_split_avx2(__m256i a, __m256i b, __m256i* lo, __m256i* hi)
+{
+	const __m256i idx = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+	a   = _mm256_permutevar8x32_epi32(a, idx);
+	b   = _mm256_permutevar8x32_epi32(b, idx);
+	*lo = _mm256_permute2x128_si256(a, b, 0x20);
+	*hi = _mm256_permute2x128_si256(a, b, 0x31);
+}
+
+/*
+ * func : murmur_hash_64 of 8 keys with seed 0
+ */
+__attribute__((target("avx2")))
+static void murmur_hash_64_avx2(const char** strs, const int* lens, unsigned long* out)
+{
+	const __m256i m      = _mm256_set1_epi32(PY_MURMUR_M);
+	const __m256i zero   = _mm256_setzero_si256();
+	unsigned long rest[AVX2_LANES] __attribute__((aligned(32)));
+	unsigned int  r1[AVX2_LANES] __attribute__((aligned(32)));
+	unsigned int  r2[AVX2_LANES] __attribute__((aligned(32)));
+	int           max    = 0;
+	int           round  = 0;
+	int           i      = 0;
+	__m256i       h1, h2, k1, k2, len, rounds, live, live_a, live_b, ptr_a, ptr_b;
+
+	len    = _mm256_loadu_si256((const __m256i*)lens);
+	rounds = _mm256_srli_epi32(len, 3);
+	h1     = len;  // seed ^ len
+	h2     = zero;
+	ptr_a  = _mm256_loadu_si256((const __m256i*)strs);
+	ptr_b  = _mm256_loadu_si256((const __m256i*)(strs+4));
+	for(i=0;i<AVX2_LANES;i++){
+		if(lens[i] > max){
+			max = lens[i];
+		}
+	}
+
+	// 8 bytes rounds
+	for(round=0;round<max/8;round++){
+		live   = _mm256_cmpgt_epi32(rounds, _mm256_set1_epi32(round));
+		live_a = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(live));
+		live_b = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(live, 1));
+		k1     = _mm256_mask_i64gather_epi64(zero, NULL, ptr_a, live_a, 1);
+		k2     = _mm256_mask_i64gather_epi64(zero, NULL, ptr_b, live_b, 1);
+		murmur_split_avx2(k1, k2, &k1, &k2);
+
+		k1 = murmur_mix_avx2(k1);
+		h1 = _mm256_blendv_epi8(h1, _mm256_xor_si256(_mm256_mullo_epi32(h1, m), k1), live);
+		k2 = murmur_mix_avx2(k2);
+		h2 = _mm256_blendv_epi8(h2, _mm256_xor_si256(_mm256_mullo_epi32(h2, m), k2), live);
+
+		ptr_a = _mm256_add_epi64(ptr_a, _mm256_set1_epi64x(8));
+		ptr_b = _mm256_add_epi64(ptr_b, _mm256_set1_epi64x(8));
+	}
+
+	// last word and tail bytes
+	for(i=0;i<AVX2_LANES;i++){
+		rest[i] = murmur_rest(strs[i], lens[i]);
+	}
+	murmur_split_avx2(_mm256_load_si256((const __m256i*)rest), 
+			_mm256_load_si256((const __m256i*)(rest+4)), &k1, &k2);
+
+	len  = _mm256_and_si256(len, _mm256_set1_epi32(7));
+	live = _mm256_cmpgt_epi32(len, _mm256_set1_epi32(3));   // has last word
+	h1   = _mm256_blendv_epi8(h1, _mm256_xor_si256(_mm256_mullo_epi32(h1, m), murmur_mix_avx2(k1)), live);
+	k2   = _mm256_blendv_epi8(k1, k2, live);                // tail bytes
+	len  = _mm256_and_si256(len, _mm256_set1_epi32(3));
+	live = _mm256_cmpgt_epi32(len, zero);                   // has tail bytes
+	h2   = _mm256_blendv_epi8(h2, _mm256_mullo_epi32(_mm256_xor_si256(h2, k2), m), live);
+
+	// finalize
+	h1 = _mm256_mullo_epi32(_mm256_xor_si256(h1, _mm256_srli_epi32(h2, 18)), m);
+	h2 = _mm256_mullo_epi32(_mm256_xor_si256(h2, _mm256_srli_epi32(h1, 22)), m);
+	h1 = _mm256_mullo_epi32(_mm256_xor_si256(h1, _mm256_srli_epi32(h2, 17)), m);
+	h2 = _mm256_mullo_epi32(_mm256_xor_si256(h2, _mm256_srli_epi32(h1, 19)), m);
+
+	_mm256_store_si256((__m256i*)r1, h1);
+	_mm256_store_si256((__m256i*)r2, h2);
+	for(i=0;i<AVX2_LANES;i++){
+		out[i] = ((unsigned long)r1[i]<<32) | r2[i];
+	}
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i murmur_mix_avx512(__m512i k)
+{
+	const __m512i m = _mm512_set1_epi32(PY_MURMUR_M);
+
+	k = _mm512_mullo_epi32(k, m);
+	k = _mm512_xor_si512(k, _mm512_srli_epi32(k, 24));
+	return _mm512_mullo_epi32(k, m);
+}
+
+/*
+ * func : split 16 64 bit values in two vectors into their low and high words
+ */
+__attribute__((target("avx512f")))
+static inline void murmur_split_avx512(__m512i a, __m512i b, __m512i* lo, __m512i* hi)
+{
+	const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 
+			16, 18, 20, 22, 24, 26, 28, 30);
+	const __m512i odd  = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 
+			17, 19, 21, 23, 25, 27, 29, 31);
+
+	*lo = _mm512_permutex2var_epi32(a, even, b);
+	*hi = _mm512_permutex2var_epi32(a, odd, b);
+}
+
+/*
+ * func : murmur_hash_64 of 16 keys with seed 0
+ */
+__attribute__((target("avx512f")))
+static void murmur_hash_64_avx512(const char** strs, const int* lens, unsigned long* out)
+{
+	const __m512i m      = _mm512_set1_epi32(PY_MURMUR_M);
+	const __m512i zero   = _mm512_setzero_si512();
+	unsigned long rest[AVX512_LANES] __attribute__((aligned(64)));
+	int           max    = 0;
+	int           round  = 0;
+	int           i      = 0;
+	__mmask16     live   = 0;
+	__m512i       h1, h2, k1, k2, len, rounds, ptr_a, ptr_b;
+
+	len    = _mm512_loadu_si512(lens);
+	rounds = _mm512_srli_epi32(len, 3);
+	h1     = len;  // seed ^ len
+	h2     = zero;
+	ptr_a  = _mm512_loadu_si512(strs);
+	ptr_b  = _mm512_loadu_si512(strs+8);
+	max    = _mm512_reduce_max_epi32(len);
+
+	// 8 bytes rounds
+	for(round=0;round<max/8;round++){
+		live = _mm512_cmpgt_epi32_mask(rounds, _mm512_set1_epi32(round));
+		k1   = _mm512_mask_i64gather_epi64(zero, (__mmask8)live, ptr_a, NULL, 1);
+		k2   = _mm512_mask_i64gather_epi64(zero, (__mmask8)(live>>8), ptr_b, NULL, 1);
+		murmur_split_avx512(k1, k2, &k1, &k2);
+
+		h1 = _mm512_mask_xor_epi32(h1, live, _mm512_mullo_epi32(h1, m), murmur_mix_avx512(k1));
+		h2 = _mm512_mask_xor_epi32(h2, live, _mm512_mullo_epi32(h2, m), murmur_mix_avx512(k2));
+
+		ptr_a = _mm512_add_epi64(ptr_a, _mm512_set1_epi64(8));
+		ptr_b = _mm512_add_epi64(ptr_b, _mm512_set1_epi64(8));
+	}
+
+	// last word and tail bytes
+	for(i=0;i<AVX512_LANES;i++){
+		rest[i] = murmur_rest(strs[i], lens[i]);
+	}
+	murmur_split_avx512(_mm512_load_si512(rest), _mm512_load_si512(rest+8), &k1, &k2);
+
+	len  = _mm512_and_si512(len, _mm512_set1_epi32(7));
+	live = _mm512_cmpgt_epi32_mask(len, _mm512_set1_epi32(3));  // has last word
+	h1   = _mm512_mask_xor_epi32(h1, live, _mm512_mullo_epi32(h1, m), murmur_mix_avx512(k1));
+	k2   = _mm512_mask_mov_epi32(k1, live, k2);                 // tail bytes
+	len  = _mm512_and_si512(len, _mm512_set1_epi32(3));
+	live = _mm512_cmpgt_epi32_mask(len, zero);                  // has tail bytes
+	h2   = _mm512_mask_mov_epi32(h2, live, _mm512_mullo_epi32(_mm512_xor_si512(h2, k2), m));
+
+	// finalize
+	h1 = _mm512_mullo_epi32(_mm512_xor_si512(h1, _mm512_srli_epi32(h2, 18)), m);
+	h2 = _mm512_mullo_epi32(_mm512_xor_si512(h2, _mm512_srli_epi32(h1, 22)), m);
+	h1 = _mm512_mullo_epi32(_mm512_xor_si512(h1, _mm512_srli_epi32(h2, 17)), m);
+	h2 = _mm512_mullo_epi32(_mm512_xor_si512(h2, _mm512_srli_epi32(h1, 19)), m);
+
+	// interleave back to 64 bit signatures, h1 high, h2 low
+	_mm512_storeu_si512(out, _mm512_permutex2var_epi32(h2, 
+			_mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23), h1));
+	_mm512_storeu_si512(out+8, _mm512_permutex2var_epi32(h2, 
+			_mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31), h1));
+}
+
+#endif
+
+/*
+ * func : murmur_hash_64 with seed 0 of many keys, uses the widest lanes 
+ *        the cpu supports
+ */
+static void murmur_hash_64_batch(const char** strs, const int* lens, int n, unsigned long* out)
+{
+	int i = 0;
+
+#ifdef PY_SIGN_X86
+	static int level = -1;  // 0, scalar; 1, avx2; 2, avx512
+
+	if(level < 0){
+		__builtin_cpu_init();
+		level = __builtin_cpu_supports("avx512f") ? 2 : 
+			(__builtin_cpu_supports("avx2") ? 1 : 0);
+	}
+	if(level == 2){
+		for(;i+AVX512_LANES<=n;i+=AVX512_LANES){
+			murmur_hash_64_avx512(strs+i, lens+i, out+i);
+		}
+	}
+	if(level >= 1){
+		for(;i+AVX2_LANES<=n;i+=AVX2_LANES){
+			murmur_hash_64_avx2(strs+i, lens+i, out+i);
+		}
+	}
+#endif
+
+	for(;i<n;i++){
+		out[i] = murmur_hash_64(strs[i], lens[i], 0);
+	}
+}
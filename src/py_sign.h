@@ -10,6 +10,14 @@
 #ifndef PY_SIGN_H
 #define PY_SIGN_H
 
+#define SIGN_BATCH_STEP 64   // keys signed together by py_sign64_double_int_batch
+
+// 64 bit signature functions, the id is kept in dict files
+#define PY_SIGN_MURMUR  0    // murmur2 64 bit, py_sign64 and files without an id
+#define PY_SIGN_WYHASH  1    // wyhash, 8 or 16 bytes a step, faster on long keys
+#define PY_SIGN_ROLL    2    // rolling polynomial, a key grows by a byte in O(1), see py_seg.h
+#define PY_SIGN_NUM     3
+
 typedef struct _sign64{
 	unsigned long sign;
 }SIGN64;
@@ -61,6 +69,78 @@ void py_sign64(const char* str, const int len, unsigned long* sign);
 
 
 
+/*
+ * func : make 64 bit signatures of a batch of strings
+ *
+ * args : strs, lens, n, input strings, their length and number
+ *      : signs, the result signatures, same as py_sign64
+ *
+ * ret  :
+ *
+ * note : keys are hashed 8 or 16 at a time with AVX2 or AVX-512 when the
+ *      : cpu supports it.
+ */
+void py_sign64_batch(const char** strs, const int* lens, const int n, unsigned long* signs);
+
+/*
+ * func : make 64 bit signatures of a batch of strings
+ *
+ * args : strs, lens, n, input strings, their length and number
+ *      : sign1, sign2, the result signatures, same as py_sign64_double_int
+ *
+ * ret  :
+ */
+void py_sign64_double_int_batch(const char** strs, const int* lens, const int n, 
+                                unsigned int* sign1, unsigned int* sign2);
+
+/*
+ * func : make a 64 bit string signature with a given function
+ *
+ * args : hash, PY_SIGN_MURMUR, PY_SIGN_WYHASH or PY_SIGN_ROLL
+ *      : str, len, input string and its length
+ *      : sign, the result signature
+ *
+ * ret  :
+ *
+ * note : the functions above are PY_SIGN_MURMUR
+ */
+void py_sign64_hash(const int hash, const char* str, const int len, unsigned long* sign);
+
+/*
+ * func : make a 64 bit string signature with a given function, split into
+ *        two integers as py_sign64_double_int
+ */
+void py_sign64_double_int_hash(const int hash, const char* str, const int len, 
+                               unsigned int* sign1, unsigned int* sign2);
+
+/*
+ * func : make 64 bit signatures of a batch of strings with a given function
+ *
+ * args : hash, strs, lens, n, sign1, sign2, see py_sign64_double_int_hash
+ *
+ * ret  :
+ */
+void py_sign64_double_int_batch_hash(const int hash, const char** strs, const int* lens, 
+                                     const int n, unsigned int* sign1, unsigned int* sign2);
+
+/*
+ * func : set the signature function of new dicts
+ *
+ * args : hash, PY_SIGN_MURMUR, the default, PY_SIGN_WYHASH or PY_SIGN_ROLL
+ *
+ * ret  : 0, succeed
+ *      : -1, error, unknown function
+ *
+ * note : a dict keeps the function it is created with, a loaded or mapped
+ *      : dict takes the one in its file.
+ */
+int  py_sign_set_default(const int hash);
+
+/*
+ * func : get the signature function of new dicts
+ */
+int  py_sign_get_default();
+
 /*
  * func : make a 128 bit signature
  *
@@ -68,7 +148,20 @@ void py_sign64(const char* str, const int len, unsigned long* sign);
  *      : sign, pointer to a SIGN128 struct
  * 
  * ret  :
+ *
+ * note : two murmur_hash_64 passes, py_sign128_hash takes one
  */
 void py_sign128(const char* str, const int len, SIGN128* sign);
 
+/*
+ * func : make a 128 bit signature in one pass, MurmurHash3_x64_128 with
+ *        seed 0, the signature of py_dict128_t keys
+ *
+ * args : str, len, input string and its length
+ *      : sign, pointer to a SIGN128 struct
+ *
+ * ret  :
+ */
+void py_sign128_hash(const char* str, const int len, SIGN128* sign);
+
 #endif
@@ -0,0 +1,241 @@
+/********************************************************************************
+ * Describe : inline signatures of short keys. keys up to 16 bytes are signed
+ *          : without a call, murmur by word count with no round loop and the
+ *          : tail bytes read at once, wyhash by two overlapping reads. longer
+ *          : keys go to py_sign64_hash. signatures are the same as py_sign.h.
+ *
+ *          : the rolling signature of any length is here too, its state is
+ *          : extended a byte at a time by py_roll_step, see py_seg.h.
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ *******************************************************************************/
+#ifndef PY_SIGN_INLINE_H
+#define PY_SIGN_INLINE_H
+
+#include <string.h>
+#include <py_sign.h>
+
+#define PY_SIGN_SHORT   16   // longest key signed inline
+
+#define PY_MURMUR_M     0x5bd1e995
+
+// wyhash final 4 default secret
+#define PY_WY_P0        0x2d358dccaa6c78a5ull
+#define PY_WY_P1        0x8bb84b93962eacc9ull
+#define PY_WY_P2        0x4b33a62ed433d4a3ull
+#define PY_WY_P3        0x4d5a2da51de1aa47ull
+
+// rolling signature, a polynomial of the bytes modulo the prime 2^61-1
+#define PY_ROLL_MOD     0x1fffffffffffffffull
+#define PY_ROLL_BASE    0x1c6a5c9e1ad1f3b5ull   // < PY_ROLL_MOD
+
+static inline unsigned int py_sign_r4(const unsigned char* p)
+{
+	unsigned int v = 0;
+
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static inline void py_wy_mum(unsigned long* a, unsigned long* b)
+{
+	__uint128_t r = (__uint128_t)*a * *b;
+
+	*a = (unsigned long)r;
+	*b = (unsigned long)(r>>64);
+}
+
+static inline unsigned long py_wy_mix(unsigned long a, unsigned long b)
+{
+	py_wy_mum(&a, &b);
+	return a^b;
+}
+
+/*
+ * func : one word of a murmur round into h
+ */
+static inline unsigned int py_murmur_word(unsigned int h, unsigned int k)
+{
+	k *= PY_MURMUR_M; k ^= k >> 24; k *= PY_MURMUR_M;
+	h *= PY_MURMUR_M; h ^= k;
+	return h;
+}
+
+/*
+ * func : murmur_hash_64 with seed 0 of a key up to 16 bytes
+ *
+ * note : the rounds give the words to h1 and h2 in turn, a last odd word
+ *        to h1, so word i goes to h1 if i is even. the 1 to 3 tail bytes
+ *        are the top bytes of the last 4, little endian.
+ */
+static inline unsigned long py_murmur64_short(const char* str, const int len)
+{
+	const unsigned char* p    = (const unsigned char*)str;
+	unsigned int         h1   = len;
+	unsigned int         h2   = 0;
+	unsigned int         tail = 0;
+	int                  rest = len&3;
+
+	if(len>=4){
+		h1 = py_murmur_word(h1, py_sign_r4(p));
+		if(len>=8){
+			h2 = py_murmur_word(h2, py_sign_r4(p+4));
+			if(len>=12){
+				h1 = py_murmur_word(h1, py_sign_r4(p+8));
+				if(len>=16){
+					h2 = py_murmur_word(h2, py_sign_r4(p+12));
+				}
+			}
+		}
+		if(rest){
+			tail = py_sign_r4(p+len-4) >> (32-rest*8);
+		}
+	}
+	else if(rest){
+		tail = p[0] | (rest>1 ? p[1]<<8 : 0) | (rest>2 ? p[2]<<16 : 0);
+	}
+	if(rest){
+		h2 ^= tail;
+		h2 *= PY_MURMUR_M;
+	}
+
+	h1 ^= h2 >> 18; h1 *= PY_MURMUR_M;
+	h2 ^= h1 >> 22; h2 *= PY_MURMUR_M;
+	h1 ^= h2 >> 17; h1 *= PY_MURMUR_M;
+	h2 ^= h1 >> 19; h2 *= PY_MURMUR_M;
+
+	return ((unsigned long)h1 << 32) | h2;
+}
+
+/*
+ * func : wyhash with seed 0 of a key up to 16 bytes
+ */
+static inline unsigned long py_wyhash64_short(const char* str, const int len)
+{
+	const unsigned char* p    = (const unsigned char*)str;
+	unsigned long        a    = 0;
+	unsigned long        b    = 0;
+	int                  step = (len>>3)<<2;
+
+	if(len>=4){
+		a = ((unsigned long)py_sign_r4(p)<<32) | py_sign_r4(p+step);
+		b = ((unsigned long)py_sign_r4(p+len-4)<<32) | py_sign_r4(p+len-4-step);
+	}
+	else if(len>0){
+		a = ((unsigned long)p[0]<<16) | ((unsigned long)p[len>>1]<<8) | p[len-1];
+	}
+	a ^= PY_WY_P1;
+	b ^= py_wy_mix(PY_WY_P0, PY_WY_P1);
+	py_wy_mum(&a, &b);
+
+	return py_wy_mix(a^PY_WY_P0^(unsigned long)len, b^PY_WY_P1);
+}
+
+/*
+ * func : reduce a product modulo PY_ROLL_MOD
+ */
+static inline unsigned long py_roll_mod(__uint128_t r)
+{
+	unsigned long v = (unsigned long)(r & PY_ROLL_MOD) + (unsigned long)(r >> 61);
+
+	v = (v & PY_ROLL_MOD) + (v >> 61);
+	return v >= PY_ROLL_MOD ? v - PY_ROLL_MOD : v;
+}
+
+/*
+ * func : append a byte to the rolling state of a key
+ *
+ * args : h, the state of the key, 0 for the empty key
+ *      : c, the byte
+ *
+ * ret  : the state of the key and c
+ */
+static inline unsigned long py_roll_step(const unsigned long h, const unsigned char c)
+{
+	return py_roll_mod((__uint128_t)h*PY_ROLL_BASE + c + 1);
+}
+
+/*
+ * func : prepend a byte to the rolling state of a key
+ *
+ * args : h, the state of the key
+ *      : pw, PY_ROLL_BASE to the power of the key length, see py_roll_pow
+ *      : c, the byte
+ *
+ * ret  : the state of c and the key
+ */
+static inline unsigned long py_roll_prepend(const unsigned long h, const unsigned long pw,
+		const unsigned char c)
+{
+	return py_roll_mod((__uint128_t)pw*(c+1) + h);
+}
+
+/*
+ * func : the power of the next length, pw*PY_ROLL_BASE
+ */
+static inline unsigned long py_roll_pow(const unsigned long pw)
+{
+	return py_roll_mod((__uint128_t)pw*PY_ROLL_BASE);
+}
+
+/*
+ * func : the signature of a rolling state, the state is mixed with the
+ *        length so the high bits are spread as murmur ones are
+ */
+static inline unsigned long py_roll_final(unsigned long h, const int len)
+{
+	h += (unsigned long)len * 0x9e3779b97f4a7c15ull;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+/*
+ * func : rolling signature of a key, the state rolled over all its bytes
+ */
+static inline unsigned long py_roll64(const char* str, const int len)
+{
+	const unsigned char* p = (const unsigned char*)str;
+	unsigned long        h = 0;
+	int                  i = 0;
+
+	for(i=0;i<len;i++){
+		h = py_roll_step(h, p[i]);
+	}
+	return py_roll_final(h, len);
+}
+
+/*
+ * func : make a 64 bit string signature, inline for short keys
+ *
+ * args : hash, PY_SIGN_MURMUR, PY_SIGN_WYHASH or PY_SIGN_ROLL
+ *      : str, len, input string and its length
+ *
+ * ret  : the signature, same as py_sign64_hash
+ */
+static inline unsigned long py_sign64_inline(const int hash, const char* str, const int len)
+{
+	unsigned long sign = 0;
+
+	if(hash==PY_SIGN_ROLL){
+		return py_roll64(str, len);
+	}
+	if(len<=PY_SIGN_SHORT){
+		if(hash==PY_SIGN_WYHASH){
+			return py_wyhash64_short(str, len);
+		}
+		return py_murmur64_short(str, len);
+	}
+	py_sign64_hash(hash, str, len, &sign);
+
+	return sign;
+}
+
+#endif
@@ -0,0 +1,364 @@
+/***********************************************************************************
+ * Describe : open addressing table engine of py_dict_t, see py_swiss.h
+ * 
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ * 
+ * Create   : 2008-10-15
+ * 
+ * Modify   : 2008-10-15
+ **********************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <py_dict.h>
+#include <py_swiss.h>
+
+
+#define SWISS_MIN_CAPACITY 16
+
+
+/*
+ * func : match the control bytes of a group
+ *
+ * args : ctrl, the group, SWISS_GROUP bytes
+ *      : tag, byte to match
+ *
+ * ret  : bit mask, bit i set if ctrl[i]==tag
+ */
+static inline unsigned int swiss_match(const unsigned char* ctrl, unsigned char tag)
+{
+#ifdef __SSE2__
+	__m128i group = _mm_load_si128((const __m128i*)ctrl);
+
+	return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)));
+#else
+	unsigned int mask = 0;
+	int          i    = 0;
+
+	for(i=0;i<SWISS_GROUP;i++){
+		if(ctrl[i]==tag){
+			mask |= 1u<<i;
+		}
+	}
+	return mask;
+#endif
+}
+
+/*
+ * func : match the free (empty or deleted) control bytes of a group
+ */
+static inline unsigned int swiss_match_free(const unsigned char* ctrl)
+{
+#ifdef __SSE2__
+	__m128i group = _mm_load_si128((const __m128i*)ctrl);
+
+	// full slots hold 0-127, free slots have the high bit set
+	return (unsigned int)_mm_movemask_epi8(group);
+#else
+	unsigned int mask = 0;
+	int          i    = 0;
+
+	for(i=0;i<SWISS_GROUP;i++){
+		if(ctrl[i]&0x80){
+			mask |= 1u<<i;
+		}
+	}
+	return mask;
+#endif
+}
+
+/*
+ * func : allocate control bytes and slots of a capacity
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+static int swiss_alloc(py_dict_t* pydict, unsigned int capacity, unsigned char** pctrl, 
+		unsigned int** pslots)
+{
+	void*          ctrl  = NULL;
+	unsigned int*  slots = NULL;
+
+	// aligned so that a group never crosses a cache line
+	if((ctrl = pyalloc_alloc(&pydict->alloc, capacity)) == NULL){
+		return -1;
+	}
+	slots = (unsigned int*)pyalloc_alloc(&pydict->alloc, sizeof(unsigned int)*capacity);
+	if(!slots){
+		pyalloc_free(&pydict->alloc, ctrl, capacity);
+		return -1;
+	}
+	memset(ctrl, SWISS_EMPTY, capacity);
+
+	*pctrl  = (unsigned char*)ctrl;
+	*pslots = slots;
+	return 0;
+}
+
+/*
+ * func : put a node into the first free slot of its probe sequence
+ *
+ * ret  : 1, an empty slot used
+ *      : 0, a deleted slot reused
+ */
+static int swiss_put(unsigned char* ctrl, unsigned int* slots, unsigned int capacity, 
+		PNODE* pnode, unsigned int nodepos)
+{
+	unsigned int   mask   = capacity-1;
+	unsigned int   group  = 0;
+	unsigned int   step   = 0;
+	unsigned int   match  = 0;
+	unsigned int   pos    = 0;
+	int            empty  = 0;
+
+	group = (unsigned int)SWISS_H1(pnode->sign1, pnode->sign2) & mask & ~(SWISS_GROUP-1);
+	while(1){
+		match = swiss_match_free(ctrl+group);
+		if(match){
+			pos   = group + __builtin_ctz(match);
+			empty = ctrl[pos]==SWISS_EMPTY;
+			ctrl[pos]  = SWISS_H2(pnode->sign1, pnode->sign2);
+			slots[pos] = nodepos;
+			return empty;
+		}
+		step  += SWISS_GROUP;
+		group  = (group+step) & mask;
+	}
+}
+
+/*
+ * func : build the swiss table of a dict from the nodes in its block
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : capacity, min slot number, 0 for fitting block_pos
+ *
+ * ret  : 0, succeed
+ *      : -1, error, the dict is not changed
+ */
+int pyswiss_build(py_dict_t* pydict, unsigned int capacity)
+{
+	unsigned char* ctrl   = NULL;
+	unsigned int*  slots  = NULL;
+	unsigned int   want   = 0;
+	unsigned int   used   = 0;
+	unsigned int   i      = 0;
+
+	// keep load factor under 7/8
+	want = pydict->block_pos-pydict->free_num;
+	want = want + want/7 + 1;
+	if(capacity < want){
+		capacity = want;
+	}
+	if(capacity > 0x80000000u){
+		return -1;
+	}
+	want = SWISS_MIN_CAPACITY;
+	while(want < capacity){
+		want <<= 1;
+	}
+	capacity = want;
+
+	if(swiss_alloc(pydict, capacity, &ctrl, &slots) < 0){
+		return -1;
+	}
+	for(i=0;i<pydict->block_pos;i++){
+		if(pydict_node(pydict, i)->code==-1){ // deleted
+			continue;
+		}
+		used += swiss_put(ctrl, slots, capacity, pydict_node(pydict, i), i);
+	}
+
+	pyswiss_free(pydict);
+	pydict->ctrl        = ctrl;
+	pydict->slots       = slots;
+	pydict->capacity    = capacity;
+	pydict->growth_left = capacity/8*7 - used;
+
+	return 0;
+}
+
+/*
+ * func : rebuild the swiss table of a dict in place, the nodes must fit
+ *        the current capacity
+ */
+void pyswiss_relink(py_dict_t* pydict)
+{
+	unsigned int i = 0;
+
+	pyswiss_reset(pydict);
+	for(i=0;i<pydict->block_pos;i++){
+		if(pydict_node(pydict, i)->code==-1){
+			continue;
+		}
+		pydict->growth_left -= swiss_put(pydict->ctrl, pydict->slots, pydict->capacity,
+				pydict_node(pydict, i), i);
+	}
+}
+
+/*
+ * func : free the swiss table of a dict
+ */
+void pyswiss_free(py_dict_t* pydict)
+{
+	if(pydict->ctrl){
+		pyalloc_free(&pydict->alloc, pydict->ctrl, pydict->capacity);
+		pydict->ctrl = NULL;
+	}
+	if(pydict->slots){
+		pyalloc_free(&pydict->alloc, pydict->slots, sizeof(unsigned int)*pydict->capacity);
+		pydict->slots = NULL;
+	}
+	pydict->capacity    = 0;
+	pydict->growth_left = 0;
+}
+
+/*
+ * func : clear all slots
+ */
+void pyswiss_reset(py_dict_t* pydict)
+{
+	if(pydict->ctrl){
+		memset(pydict->ctrl, SWISS_EMPTY, pydict->capacity);
+		pydict->growth_left = pydict->capacity/8*7;
+	}
+}
+
+/*
+ * func : find a node by signature, count the groups probed
+ */
+static inline PNODE* swiss_find(py_dict_t* pydict, unsigned int sign1, unsigned int sign2,
+		unsigned int* groups)
+{
+	unsigned char* ctrl   = pydict->ctrl;
+	unsigned int   mask   = pydict->capacity-1;
+	unsigned char  tag    = SWISS_H2(sign1, sign2);
+	unsigned int   group  = 0;
+	unsigned int   step   = 0;
+	unsigned int   match  = 0;
+	PNODE*         pnode  = NULL;
+
+	group = (unsigned int)SWISS_H1(sign1, sign2) & mask & ~(SWISS_GROUP-1);
+	while(1){
+		(*groups)++;
+		match = swiss_match(ctrl+group, tag);
+		while(match){
+			pnode = pydict_node(pydict, pydict->slots[group+__builtin_ctz(match)]);
+			if(pnode->sign1==sign1 && pnode->sign2==sign2){
+				return pnode;
+			}
+			match &= match-1;
+		}
+		if(swiss_match(ctrl+group, SWISS_EMPTY)){ // end of probe sequence
+			return NULL;
+		}
+		step  += SWISS_GROUP;
+		group  = (group+step) & mask;
+	}
+}
+
+/*
+ * func : find a node by signature
+ *
+ * ret  : NULL, not found
+ *      : else, pointer to the founded node
+ */
+PNODE* pyswiss_lookup(py_dict_t* pydict, unsigned int sign1, unsigned int sign2)
+{
+	unsigned int   groups = 0;
+
+	return swiss_find(pydict, sign1, sign2, &groups);
+}
+
+/*
+ * func : find a node by signature, add the groups probed to groups
+ *
+ * ret  : NULL, not found
+ *      : else, pointer to the founded node
+ */
+PNODE* pyswiss_lookup_count(py_dict_t* pydict, unsigned int sign1, unsigned int sign2,
+		unsigned int* groups)
+{
+	return swiss_find(pydict, sign1, sign2, groups);
+}
+
+/*
+ * func : insert a node which is NOT in the table yet
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : nodepos, node position in pydict->block
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+int pyswiss_insert(py_dict_t* pydict, unsigned int nodepos)
+{
+	PNODE* pnode = pydict_node(pydict, nodepos);
+
+	if(pydict->growth_left==0){ // grow, deleted slots are dropped too
+		if(pyswiss_build(pydict, pydict->capacity*2) < 0){
+			return -1;
+		}
+		// the node is in block already, the rebuild may have inserted it
+		if(pyswiss_lookup(pydict, pnode->sign1, pnode->sign2)){
+			return 0;
+		}
+	}
+
+	pydict->growth_left -= swiss_put(pydict->ctrl, pydict->slots, pydict->capacity,
+			pydict_node(pydict, nodepos), nodepos);
+
+	return 0;
+}
+
+/*
+ * func : remove a node from the table
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : sign1, sign2, the signature
+ *
+ * ret  : COMMON_NULL, not found
+ *      : else, position of the removed node in pydict->block
+ */
+unsigned int pyswiss_erase(py_dict_t* pydict, unsigned int sign1, unsigned int sign2)
+{
+	unsigned char* ctrl    = pydict->ctrl;
+	unsigned int   mask    = pydict->capacity-1;
+	unsigned char  tag     = SWISS_H2(sign1, sign2);
+	unsigned int   group   = 0;
+	unsigned int   step    = 0;
+	unsigned int   match   = 0;
+	unsigned int   pos     = 0;
+	unsigned int   nodepos = 0;
+	PNODE*         pnode   = NULL;
+
+	group = (unsigned int)SWISS_H1(sign1, sign2) & mask & ~(SWISS_GROUP-1);
+	while(1){
+		match = swiss_match(ctrl+group, tag);
+		while(match){
+			pos     = group+__builtin_ctz(match);
+			nodepos = pydict->slots[pos];
+			pnode   = pydict_node(pydict, nodepos);
+			if(pnode->sign1==sign1 && pnode->sign2==sign2){
+				// a group with an empty slot was never full, no probe 
+				// sequence goes on past it, so the slot can be empty again
+				if(swiss_match(ctrl+group, SWISS_EMPTY)){
+					ctrl[pos] = SWISS_EMPTY;
+					pydict->growth_left++;
+				}
+				else{
+					ctrl[pos] = SWISS_DELETED;
+				}
+				return nodepos;
+			}
+			match &= match-1;
+		}
+		if(swiss_match(ctrl+group, SWISS_EMPTY)){
+			return COMMON_NULL;
+		}
+		step  += SWISS_GROUP;
+		group  = (group+step) & mask;
+	}
+}
@@ -0,0 +1,108 @@
+/********************************************************************************
+ * Describe : open addressing table engine of py_dict_t, in the style of swiss
+ *          : tables. each slot has a control byte holding 7 bits of the node
+ *          : signature, control bytes are probed 16 at a time with SSE2, so 
+ *          : most misses are answered by one group of control bytes without
+ *          : touching the nodes. slots hold indexes into pydict->block, the 
+ *          : nodes themselves are the same as the chain engine.
+ *
+ *          : used by py_dict.c only, see pydict_set_engine.
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ *******************************************************************************/
+#ifndef _PY_SWISS_H
+#define _PY_SWISS_H
+
+#include <py_dict.h>
+
+#define SWISS_GROUP   16      // control bytes probed at once
+#define SWISS_EMPTY   0x80
+#define SWISS_DELETED 0xFE
+
+// slot position bits and 7 bits tag of a signature
+#define SWISS_H1(sign1, sign2) ((((unsigned long)(sign1)<<32)|(sign2))>>7)
+#define SWISS_H2(sign1, sign2) ((unsigned char)((sign2)&0x7F))
+
+/*
+ * func : prefetch the first group probed for a signature
+ */
+static inline void pyswiss_prefetch(py_dict_t* pydict, unsigned int sign1, unsigned int sign2)
+{
+	unsigned int group = (unsigned int)SWISS_H1(sign1, sign2) 
+		& (pydict->capacity-1) & ~(SWISS_GROUP-1);
+
+	__builtin_prefetch(pydict->ctrl+group);
+	__builtin_prefetch(pydict->slots+group);
+}
+
+/*
+ * func : build the swiss table of a dict from the nodes in its block
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : capacity, min slot number, 0 for fitting block_pos
+ *
+ * ret  : 0, succeed
+ *      : -1, error, the dict is not changed
+ */
+int      pyswiss_build(py_dict_t* pydict, unsigned int capacity);
+
+/*
+ * func : rebuild the swiss table of a dict in place, the nodes must fit
+ *        the current capacity
+ */
+void     pyswiss_relink(py_dict_t* pydict);
+
+/*
+ * func : free the swiss table of a dict
+ */
+void     pyswiss_free(py_dict_t* pydict);
+
+/*
+ * func : clear all slots
+ */
+void     pyswiss_reset(py_dict_t* pydict);
+
+/*
+ * func : find a node by signature
+ *
+ * ret  : NULL, not found
+ *      : else, pointer to the founded node
+ */
+PNODE*   pyswiss_lookup(py_dict_t* pydict, unsigned int sign1, unsigned int sign2);
+
+/*
+ * func : find a node by signature, add the groups probed to groups
+ *
+ * ret  : NULL, not found
+ *      : else, pointer to the founded node
+ */
+PNODE*   pyswiss_lookup_count(py_dict_t* pydict, unsigned int sign1, unsigned int sign2,
+                              unsigned int* groups);
+
+/*
+ * func : insert a node which is NOT in the table yet
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : nodepos, node position in pydict->block
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+int      pyswiss_insert(py_dict_t* pydict, unsigned int nodepos);
+
+/*
+ * func : remove a node from the table
+ *
+ * args : pydict, pointer to py_dict_t
+ *      : sign1, sign2, the signature
+ *
+ * ret  : COMMON_NULL, not found
+ *      : else, position of the removed node in pydict->block
+ */
+unsigned int pyswiss_erase(py_dict_t* pydict, unsigned int sign1, unsigned int sign2);
+
+#endif
@@ -0,0 +1,811 @@
+/***********************************************************************************
+ * Describe : double-array trie of dict keys, see py_trie.h
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ **********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <py_utils.h>
+#include <py_dict.h>
+#include <py_trie.h>
+
+
+#define TRIE_UNIT_MIN    1024
+#define TRIE_LABEL_NUM   257      // the end of a key and 256 bytes
+#define TRIE_GROUP_LOCAL 8        // groups of a node kept on the stack
+#define TRIE_ROOT_CHECK  -2       // the root is used and has no parent
+
+// a key of the input, sorted by bytes
+typedef struct _trie_key{
+	const char*     key;
+	int             len;
+	int             idx;          // position in the input
+}trie_key_t;
+
+// state of a build
+typedef struct _trie_build{
+	trie_key_t*     keys;         // unique keys in byte order
+	trie_unit_t*    units;
+	unsigned int    unit_size;    // units allocated
+	unsigned int    unit_num;     // highest unit used + 1
+	unsigned int    free_pos;     // units below are all used
+}trie_build_t;
+
+/*
+ * func : set the section pointers of a trie
+ *
+ * args : pytrie, the head is set
+ *      : base, start of the sections, NULL to get the size only
+ *
+ * ret  : bytes of the sections
+ */
+static size_t trie_layout(py_trie_t* pytrie, char* base)
+{
+	trie_head_t*  head = &pytrie->head;
+	size_t        size = 0;
+
+#define TRIE_SECTION(ptr, type, num) \
+	do{ \
+		if(base){ \
+			pytrie->ptr = (type*)(base+size); \
+		} \
+		size += ((size_t)(num)*sizeof(type) + 63) & ~(size_t)63; \
+	}while(0)
+
+	TRIE_SECTION(units, trie_unit_t, head->unit_num);
+	TRIE_SECTION(payloads, trie_payload_t, head->key_num);
+
+#undef TRIE_SECTION
+
+	return size;
+}
+
+// keys by bytes, a shorter key first, equal keys by input position
+static int trie_key_cmp(const void* a, const void* b)
+{
+	const trie_key_t*  ka  = (const trie_key_t*)a;
+	const trie_key_t*  kb  = (const trie_key_t*)b;
+	int                len = ka->len < kb->len ? ka->len : kb->len;
+	int                ret = 0;
+
+	ret = memcmp(ka->key, kb->key, len);
+	if(ret != 0){
+		return ret;
+	}
+	if(ka->len != kb->len){
+		return ka->len < kb->len ? -1 : 1;
+	}
+	return ka->idx < kb->idx ? -1 : (ka->idx > kb->idx);
+}
+
+// the label of a key at depth, 0 for its end, else byte+1
+static inline int trie_label(const trie_key_t* key, const int depth)
+{
+	return key->len > depth ? (unsigned char)key->key[depth] + 1 : 0;
+}
+
+/*
+ * func : make room for units [0, size)
+ *
+ * ret  : 0, succeed
+ *      : -1, error, out of memory
+ */
+static int trie_reserve(trie_build_t* tb, const unsigned int size)
+{
+	trie_unit_t*  units = NULL;
+	unsigned int  num   = tb->unit_size;
+	unsigned int  i     = 0;
+
+	if(size <= tb->unit_size){
+		return 0;
+	}
+	while(num < size){
+		if(num >= 0x40000000){
+			return -1;
+		}
+		num *= 2;
+	}
+	units = (trie_unit_t*)realloc(tb->units, sizeof(trie_unit_t)*num);
+	if(!units){
+		return -1;
+	}
+	for(i=tb->unit_size;i<num;i++){
+		units[i].base  = 0;
+		units[i].check = -1;
+	}
+	tb->units     = units;
+	tb->unit_size = num;
+	return 0;
+}
+
+/*
+ * func : find a base that puts every label of a node on a free unit
+ *
+ * args : tb, labels, num, the labels of the node, ascending
+ *
+ * ret  : -1, error, out of memory
+ *      : else, the base, 1 or more
+ */
+static int trie_find_base(trie_build_t* tb, const int* labels, const int num)
+{
+	unsigned int  pos  = 0;
+	unsigned int  base = 0;
+	int           i    = 0;
+
+	while(tb->free_pos < tb->unit_size && tb->units[tb->free_pos].check != -1){
+		tb->free_pos++;
+	}
+	pos = tb->free_pos > (unsigned int)labels[0] ? tb->free_pos : (unsigned int)labels[0]+1;
+	for(;;pos++){
+		if(trie_reserve(tb, pos+TRIE_LABEL_NUM+1) < 0){
+			return -1;
+		}
+		if(tb->units[pos].check != -1){
+			continue;
+		}
+		base = pos - labels[0];
+		for(i=1;i<num;i++){
+			if(tb->units[base+labels[i]].check != -1){
+				break;
+			}
+		}
+		if(i == num){
+			if(base > 0x7fffff00){
+				return -1;
+			}
+			return (int)base;
+		}
+	}
+}
+
+/*
+ * func : place the children of a node, the keys [lo, hi) share their first
+ *        depth bytes, the path to unit s
+ *
+ * ret  : 0, succeed
+ *      : -1, error, out of memory
+ */
+static int trie_insert(trie_build_t* tb, const unsigned int s, const int depth,
+                       const unsigned int lo, const unsigned int hi)
+{
+	int            labels_local[TRIE_GROUP_LOCAL];
+	unsigned int   starts_local[TRIE_GROUP_LOCAL+1];
+	int*           labels = labels_local;
+	unsigned int*  starts = starts_local;
+	unsigned int   unit   = 0;
+	unsigned int   i      = 0;
+	int            num    = 0;
+	int            label  = 0;
+	int            last   = -1;
+	int            base   = 0;
+	int            ret    = -1;
+
+	// no keys, no children to place
+	if(lo >= hi){
+		return 0;
+	}
+
+	// keys are sorted, the keys of a label are a run
+	for(i=lo;i<hi;i++){
+		label = trie_label(&tb->keys[i], depth);
+		if(label != last){
+			num++;
+			last = label;
+		}
+	}
+	if(num > TRIE_GROUP_LOCAL){
+		labels = (int*)malloc(sizeof(int)*num);
+		starts = (unsigned int*)malloc(sizeof(unsigned int)*(num+1));
+		if(!labels || !starts){
+			goto done;
+		}
+	}
+	num  = 0;
+	last = -1;
+	for(i=lo;i<hi;i++){
+		label = trie_label(&tb->keys[i], depth);
+		if(label != last){
+			labels[num] = label;
+			starts[num] = i;
+			num++;
+			last = label;
+		}
+	}
+	starts[num] = hi;
+
+	base = trie_find_base(tb, labels, num);
+	if(base < 0){
+		goto done;
+	}
+	tb->units[s].base = base;
+	for(i=0;i<(unsigned int)num;i++){
+		unit = base + labels[i];
+		tb->units[unit].check = s;
+		if(unit >= tb->unit_num){
+			tb->unit_num = unit+1;
+		}
+	}
+	for(i=0;i<(unsigned int)num;i++){
+		unit = base + labels[i];
+		if(labels[i] == 0){
+			// keys are unique, one key ends here
+			tb->units[unit].base = -(int)starts[i]-1;
+		}
+		else if(trie_insert(tb, unit, depth+1, starts[i], starts[i+1]) < 0){
+			goto done;
+		}
+	}
+	ret = 0;
+
+done:
+	if(labels != labels_local){
+		free(labels);
+	}
+	if(starts != starts_local){
+		free(starts);
+	}
+	return ret;
+}
+
+/*
+ * func : build a trie of a key set
+ *
+ * args : keys, lens, codes, values, n, the keys and their payloads, in
+ *      :        any order. a later key overwrites the payload of an
+ *      :        earlier one, as pydict_add does
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_trie_t struct
+ *
+ * note : a node takes the lowest base its labels fit, the units are filled
+ *      : from the front and a free_pos pointer skips the full ones
+ */
+py_trie_t* pytrie_create(const char* keys[], const int lens[], const int codes[],
+                         const int values[], const int n)
+{
+	py_trie_t*     pytrie = NULL;
+	trie_key_t*    sorted = NULL;
+	trie_build_t   tb;
+	void*          data   = NULL;
+	unsigned int   num    = 0;
+	unsigned int   key_max= 0;
+	int            i      = 0;
+
+	memset(&tb, 0, sizeof(tb));
+	if(n < 0){
+		goto failed;
+	}
+	sorted = (trie_key_t*)malloc(sizeof(trie_key_t)*(n+1));
+	if(!sorted){
+		goto failed;
+	}
+	for(i=0;i<n;i++){
+		if(lens[i] < 0){
+			goto failed;
+		}
+		sorted[i].key = keys[i];
+		sorted[i].len = lens[i];
+		sorted[i].idx = i;
+	}
+	qsort(sorted, n, sizeof(trie_key_t), trie_key_cmp);
+
+	// the last of equal keys is kept
+	for(i=0;i<n;i++){
+		if(i+1<n && sorted[i].len==sorted[i+1].len &&
+		   memcmp(sorted[i].key, sorted[i+1].key, sorted[i].len)==0){
+			continue;
+		}
+		sorted[num++] = sorted[i];
+		if((unsigned int)sorted[i].len > key_max){
+			key_max = sorted[i].len;
+		}
+	}
+
+	tb.keys      = sorted;
+	tb.unit_size = TRIE_UNIT_MIN;
+	tb.units     = (trie_unit_t*)malloc(sizeof(trie_unit_t)*tb.unit_size);
+	if(!tb.units){
+		goto failed;
+	}
+	for(i=0;i<(int)tb.unit_size;i++){
+		tb.units[i].base  = 0;
+		tb.units[i].check = -1;
+	}
+	tb.units[0].base  = 1;
+	tb.units[0].check = TRIE_ROOT_CHECK;
+	tb.unit_num       = 1;
+	if(num>0 && trie_insert(&tb, 0, 0, 0, num) < 0){
+		goto failed;
+	}
+
+	pytrie = (py_trie_t*)calloc(1, sizeof(py_trie_t));
+	if(!pytrie){
+		goto failed;
+	}
+	pytrie->head.magic    = TRIE_MAGIC;
+	pytrie->head.version  = TRIE_VERSION;
+	pytrie->head.unit_num = tb.unit_num;
+	pytrie->head.key_num  = num;
+	pytrie->head.key_max  = key_max;
+
+	pytrie->data_size = trie_layout(pytrie, NULL);
+	if(posix_memalign(&data, 64, pytrie->data_size+1) != 0){
+		goto failed;
+	}
+	memset(data, 0, pytrie->data_size);
+	pytrie->data = data;
+	trie_layout(pytrie, (char*)data);
+
+	memcpy(pytrie->units, tb.units, sizeof(trie_unit_t)*tb.unit_num);
+	for(i=0;i<(int)num;i++){
+		pytrie->payloads[i].code  = codes[sorted[i].idx];
+		pytrie->payloads[i].value = values[sorted[i].idx];
+	}
+
+	free(tb.units);
+	free(sorted);
+	return pytrie;
+
+failed:
+	if(tb.units){
+		free(tb.units);
+		tb.units = NULL;
+	}
+	if(sorted){
+		free(sorted);
+		sorted = NULL;
+	}
+	pytrie_free(pytrie);
+	return NULL;
+}
+
+/*
+ * func : free a trie, built, loaded or mapped
+ */
+void pytrie_free(py_trie_t* pytrie)
+{
+	if(!pytrie){
+		return;
+	}
+	if(pytrie->map_addr){
+		if(pytrie->map_flags & PYDICT_MAP_LOCK){
+			munlock(pytrie->map_addr, pytrie->map_size);
+		}
+		munmap(pytrie->map_addr, pytrie->map_size);
+		pytrie->map_addr = NULL;
+	}
+	else if(pytrie->data){
+		free(pytrie->data);
+		pytrie->data = NULL;
+	}
+	free(pytrie);
+}
+
+/*
+ * func : save a trie to disk
+ *
+ * args : pytrie, path, file
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+int pytrie_save(py_trie_t* pytrie, const char* path, const char* file)
+{
+	FILE*  fp = NULL;
+	char   fullpath[512];
+
+	if(cmps_path(fullpath, sizeof(fullpath), path, file) < 0){
+		goto failed;
+	}
+	if((fp=fopen(fullpath, "wb"))==NULL){
+		goto failed;
+	}
+	if(fwrite(&pytrie->head, sizeof(trie_head_t), 1, fp)!=1){
+		goto failed;
+	}
+	if(fwrite(pytrie->data, 1, pytrie->data_size, fp)!=pytrie->data_size){
+		goto failed;
+	}
+	if(fclose(fp)!=0){
+		fp = NULL;
+		goto failed;
+	}
+	return 0;
+
+failed:
+	if(fp){
+		fclose(fp);
+		fp = NULL;
+	}
+	return -1;
+}
+
+/*
+ * func : check a file head and set the section sizes
+ *
+ * ret  : 0, the head is good and the file holds size bytes of sections
+ *      : -1, error
+ */
+static int trie_check(py_trie_t* pytrie, size_t size)
+{
+	trie_head_t*  head = &pytrie->head;
+
+	if(head->magic!=TRIE_MAGIC || head->version!=TRIE_VERSION || head->unit_num==0){
+		return -1;
+	}
+	pytrie->data_size = trie_layout(pytrie, NULL);
+	if(pytrie->data_size!=size){
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * func : load a trie from disk
+ *
+ * args : path, file
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_trie_t struct
+ */
+py_trie_t* pytrie_load(const char* path, const char* file)
+{
+	FILE*        fp     = NULL;
+	py_trie_t*   pytrie = NULL;
+	void*        data   = NULL;
+	struct stat  st;
+	char         fullpath[512];
+
+	if(cmps_path(fullpath, sizeof(fullpath), path, file) < 0){
+		goto failed;
+	}
+	if((fp=fopen(fullpath, "rb"))==NULL){
+		goto failed;
+	}
+	if(fstat(fileno(fp), &st)<0 || st.st_size<(off_t)sizeof(trie_head_t)){
+		goto failed;
+	}
+	pytrie = (py_trie_t*)calloc(1, sizeof(py_trie_t));
+	if(!pytrie){
+		goto failed;
+	}
+	if(fread(&pytrie->head, sizeof(trie_head_t), 1, fp)!=1){
+		goto failed;
+	}
+	if(trie_check(pytrie, st.st_size-sizeof(trie_head_t)) < 0){
+		goto failed;
+	}
+	if(posix_memalign(&data, 64, pytrie->data_size+1) != 0){
+		goto failed;
+	}
+	pytrie->data = data;
+	if(fread(data, 1, pytrie->data_size, fp)!=pytrie->data_size){
+		goto failed;
+	}
+	trie_layout(pytrie, (char*)data);
+
+	fclose(fp);
+	return pytrie;
+
+failed:
+	if(fp){
+		fclose(fp);
+		fp = NULL;
+	}
+	pytrie_free(pytrie);
+	return NULL;
+}
+
+/*
+ * func : map a trie file into memory
+ *
+ * args : path, file
+ *      : flags, PYDICT_MAP_* flags, see pydict_map
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_trie_t struct
+ */
+py_trie_t* pytrie_map(const char* path, const char* file, int flags)
+{
+	int          fd         = -1;
+	int          mmap_flags = MAP_SHARED;
+	void*        addr       = MAP_FAILED;
+	size_t       size       = 0;
+	py_trie_t*   pytrie     = NULL;
+	struct stat  st;
+	char         fullpath[512];
+
+	if(cmps_path(fullpath, sizeof(fullpath), path, file) < 0){
+		goto failed;
+	}
+	if((fd = open(fullpath, O_RDONLY)) < 0){
+		goto failed;
+	}
+	if(fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(trie_head_t)){
+		goto failed;
+	}
+	size = st.st_size;
+
+	if(flags & PYDICT_MAP_POPULATE){
+		mmap_flags |= MAP_POPULATE;
+	}
+	addr = mmap(NULL, size, PROT_READ, mmap_flags, fd, 0);
+	if(addr == MAP_FAILED){
+		goto failed;
+	}
+	close(fd);
+	fd = -1;
+
+	pytrie = (py_trie_t*)calloc(1, sizeof(py_trie_t));
+	if(!pytrie){
+		goto failed;
+	}
+	memcpy(&pytrie->head, addr, sizeof(trie_head_t));
+	if(trie_check(pytrie, size-sizeof(trie_head_t)) < 0){
+		goto failed;
+	}
+
+	if(flags & PYDICT_MAP_WILLNEED){
+		madvise(addr, size, MADV_WILLNEED);
+	}
+	if(flags & PYDICT_MAP_LOCK){
+		if(mlock(addr, size) < 0){
+			goto failed;
+		}
+	}
+
+	pytrie->data      = (char*)addr + sizeof(trie_head_t);
+	pytrie->map_addr  = addr;
+	pytrie->map_size  = size;
+	pytrie->map_flags = flags;
+	trie_layout(pytrie, (char*)pytrie->data);
+
+	return pytrie;
+
+failed:
+	if(pytrie){
+		free(pytrie);
+		pytrie = NULL;
+	}
+	if(fd >= 0){
+		close(fd);
+		fd = -1;
+	}
+	if(addr != MAP_FAILED){
+		munmap(addr, size);
+		addr = MAP_FAILED;
+	}
+	return NULL;
+}
+
+/*
+ * func : the child of a unit by a label
+ *
+ * ret  : -1, no such child
+ *      : else, the unit of the child
+ */
+static inline int trie_child(py_trie_t* pytrie, const unsigned int s, const int label)
+{
+	unsigned int  unit = (unsigned int)pytrie->units[s].base + label;
+
+	if(unit >= pytrie->head.unit_num || pytrie->units[unit].check != (int)s){
+		return -1;
+	}
+	return (int)unit;
+}
+
+/*
+ * func : the payload of the key that ends at a unit
+ *
+ * ret  : NULL, no key ends here
+ *      : else, the payload
+ */
+static inline trie_payload_t* trie_payload(py_trie_t* pytrie, const unsigned int s)
+{
+	int           end = trie_child(pytrie, s, 0);
+	unsigned int  idx = 0;
+
+	if(end < 0 || pytrie->units[end].base >= 0){
+		return NULL;
+	}
+	idx = (unsigned int)(-pytrie->units[end].base-1);
+	return idx < pytrie->head.key_num ? &pytrie->payloads[idx] : NULL;
+}
+
+/*
+ * func : walk from the root by a string
+ *
+ * ret  : -1, the string is no prefix of a key
+ *      : else, the unit of the string
+ */
+static int trie_walk(py_trie_t* pytrie, const char* str, const int len)
+{
+	int  s = 0;
+	int  i = 0;
+
+	for(i=0;i<len && s>=0;i++){
+		s = trie_child(pytrie, s, (unsigned char)str[i]+1);
+	}
+	return s;
+}
+
+/*
+ * func : find a key
+ *
+ * args : pytrie, key, len
+ *      : code, value, the result
+ *
+ * ret  : 0, NOT found; 1, founded
+ */
+int pytrie_find(py_trie_t* pytrie, const char* key, const int len, int* code, int* value)
+{
+	trie_payload_t*  payload = NULL;
+	int              s       = 0;
+
+	s = trie_walk(pytrie, key, len);
+	if(s < 0 || (payload = trie_payload(pytrie, s)) == NULL){
+		return 0;
+	}
+	*code  = payload->code;
+	*value = payload->value;
+	return 1;
+}
+
+/*
+ * func : common prefix search, the keys that are prefixes of a string
+ *
+ * args : pytrie, str, len, the string
+ *      : matches, match_size, the result, shorter keys first
+ *
+ * ret  : number of keys found, more than match_size if matches is full,
+ *      : the first match_size are kept
+ */
+int pytrie_prefix(py_trie_t* pytrie, const char* str, const int len,
+                  pytrie_match_t* matches, const int match_size)
+{
+	trie_payload_t*  payload = NULL;
+	int              s       = 0;
+	int              i       = 0;
+	int              num     = 0;
+
+	for(i=0;;i++){
+		payload = trie_payload(pytrie, s);
+		if(payload){
+			if(num < match_size){
+				matches[num].len   = i;
+				matches[num].code  = payload->code;
+				matches[num].value = payload->value;
+			}
+			num++;
+		}
+		if(i == len){
+			break;
+		}
+		s = trie_child(pytrie, s, (unsigned char)str[i]+1);
+		if(s < 0){
+			break;
+		}
+	}
+	return num;
+}
+
+/*
+ * func : the longest key that is a prefix of a string
+ *
+ * args : pytrie, str, len, the string
+ *      : match, the result
+ *
+ * ret  : 0, NOT found; 1, founded
+ */
+int pytrie_longest(py_trie_t* pytrie, const char* str, const int len,
+                   pytrie_match_t* match)
+{
+	trie_payload_t*  payload = NULL;
+	int              s       = 0;
+	int              i       = 0;
+	int              found   = 0;
+
+	for(i=0;;i++){
+		payload = trie_payload(pytrie, s);
+		if(payload){
+			match->len   = i;
+			match->code  = payload->code;
+			match->value = payload->value;
+			found        = 1;
+		}
+		if(i == len){
+			break;
+		}
+		s = trie_child(pytrie, s, (unsigned char)str[i]+1);
+		if(s < 0){
+			break;
+		}
+	}
+	return found;
+}
+
+/*
+ * func : visit the keys under a unit in byte order
+ *
+ * args : key, depth, the path to unit s, key has key_max+1 bytes
+ *      : num, keys visited
+ *
+ * ret  : 1, func stops the search
+ *      : 0, go on
+ */
+static int trie_visit(py_trie_t* pytrie, const unsigned int s, char* key, const int depth,
+                      pytrie_func func, void* arg, int* num)
+{
+	trie_payload_t*  payload = NULL;
+	int              label   = 0;
+	int              child   = 0;
+
+	for(label=0;label<TRIE_LABEL_NUM;label++){
+		child = trie_child(pytrie, s, label);
+		if(child < 0){
+			continue;
+		}
+		if(label == 0){
+			payload = trie_payload(pytrie, s);
+			if(!payload){
+				continue;
+			}
+			(*num)++;
+			key[depth] = '\0';
+			if(func && func(key, depth, payload->code, payload->value, arg) != 0){
+				return 1;
+			}
+		}
+		else if(depth < (int)pytrie->head.key_max){
+			key[depth] = (char)(label-1);
+			if(trie_visit(pytrie, child, key, depth+1, func, arg, num)){
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/*
+ * func : predictive search, call func on the keys that begin with a prefix,
+ *        in byte order
+ *
+ * args : pytrie, prefix, len, the prefix, len 0 for all keys
+ *      : func, arg, the callback, it returns 0 to go on, else the search
+ *      :            stops
+ *
+ * ret  : -1, error, out of memory
+ *      : else, number of keys visited
+ *
+ * note : the key given to func is NUL terminated and lives until func
+ *      : returns
+ */
+int pytrie_predict(py_trie_t* pytrie, const char* prefix, const int len,
+                   pytrie_func func, void* arg)
+{
+	char*  key = NULL;
+	int    s   = 0;
+	int    num = 0;
+
+	s = trie_walk(pytrie, prefix, len);
+	if(s < 0){
+		return 0;
+	}
+	key = (char*)malloc(pytrie->head.key_max+1);
+	if(!key){
+		return -1;
+	}
+	memcpy(key, prefix, len);
+	trie_visit(pytrie, s, key, len, func, arg, &num);
+	free(key);
+	return num;
+}
@@ -0,0 +1,167 @@
+/********************************************************************************
+ * Describe : a double-array trie of the keys of a dict, a companion index for
+ *          : the queries a hash table can not answer, the keys that prefix a
+ *          : string and the keys a prefix begins. it holds the same code and
+ *          : value of each key as the dict, see pytrie_build.
+ *
+ *          : the trie is on bytes, a GBK character is two steps. a unit is
+ *          : a base and a check, the child of unit s by byte c is unit
+ *          : base[s]+c+1 if its check is s, the end of a key is the child
+ *          : base[s]+0 whose base is -(payload index+1). a common prefix
+ *          : search is one left to right pass over the string.
+ *
+ *          : file layout, every section is 64 bytes aligned
+ *          : [trie_head_t][units unit_num*8][payloads key_num*8]
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ *******************************************************************************/
+#ifndef _PY_TRIE_H
+#define _PY_TRIE_H
+
+#include <stddef.h>
+
+#define TRIE_MAGIC      0x54445950   // "PYDT"
+#define TRIE_VERSION    1
+
+// a unit of the double array, a check of -1 is a free unit
+typedef struct _trie_unit{
+	int             base;
+	int             check;
+}trie_unit_t;
+
+// the code and value of a key, keys in byte order
+typedef struct _trie_payload{
+	int             code;
+	int             value;
+}trie_payload_t;
+
+// file head of a trie, 64 bytes
+typedef struct _trie_head{
+	unsigned int    magic;
+	unsigned int    version;
+	unsigned int    unit_num;
+	unsigned int    key_num;
+	unsigned int    key_max;      // longest key in bytes
+	unsigned int    reserved;
+	unsigned long   reserved2[5];
+}trie_head_t;
+
+typedef struct _py_trie{
+	trie_head_t       head;
+	trie_unit_t*      units;
+	trie_payload_t*   payloads;
+
+	void*             data;       // sections, allocated or mapped
+	size_t            data_size;
+	void*             map_addr;   // not NULL for a mapped trie
+	size_t            map_size;
+	int               map_flags;
+}py_trie_t;
+
+// a key found by pytrie_prefix
+typedef struct _pytrie_match{
+	int             len;          // bytes of the key, a prefix of the string
+	int             code;
+	int             value;
+}pytrie_match_t;
+
+// callback of pytrie_predict, 0 to go on
+typedef int (*pytrie_func)(const char* key, int len, int code, int value, void* arg);
+
+/*
+ * func : build a trie of a key set
+ *
+ * args : keys, lens, codes, values, n, the keys and their payloads, in
+ *      :        any order. a later key overwrites the payload of an
+ *      :        earlier one, as pydict_add does
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_trie_t struct
+ */
+py_trie_t*  pytrie_create(const char* keys[], const int lens[], const int codes[],
+                          const int values[], const int n);
+
+/*
+ * func : free a trie, built, loaded or mapped
+ */
+void        pytrie_free(py_trie_t* pytrie);
+
+/*
+ * func : save a trie to disk, next to its dict file
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+int         pytrie_save(py_trie_t* pytrie, const char* path, const char* file);
+
+/*
+ * func : load a trie from disk
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_trie_t struct
+ */
+py_trie_t*  pytrie_load(const char* path, const char* file);
+
+/*
+ * func : map a trie file into memory, read only
+ *
+ * args : path, file
+ *      : flags, PYDICT_MAP_* flags, see pydict_map
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_trie_t struct
+ */
+py_trie_t*  pytrie_map(const char* path, const char* file, int flags);
+
+/*
+ * func : find a key
+ *
+ * args : pytrie, key, len
+ *      : code, value, the result
+ *
+ * ret  : 0, NOT found; 1, founded
+ */
+int         pytrie_find(py_trie_t* pytrie, const char* key, const int len, int* code, int* value);
+
+/*
+ * func : common prefix search, the keys that are prefixes of a string
+ *
+ * args : pytrie, str, len, the string
+ *      : matches, match_size, the result, shorter keys first
+ *
+ * ret  : number of keys found, more than match_size if matches is full,
+ *      : the first match_size are kept
+ */
+int         pytrie_prefix(py_trie_t* pytrie, const char* str, const int len,
+                          pytrie_match_t* matches, const int match_size);
+
+/*
+ * func : the longest key that is a prefix of a string
+ *
+ * args : pytrie, str, len, the string
+ *      : match, the result
+ *
+ * ret  : 0, NOT found; 1, founded
+ */
+int         pytrie_longest(py_trie_t* pytrie, const char* str, const int len,
+                           pytrie_match_t* match);
+
+/*
+ * func : predictive search, call func on the keys that begin with a prefix,
+ *        in byte order
+ *
+ * args : pytrie, prefix, len, the prefix, len 0 for all keys
+ *      : func, arg, the callback, it returns 0 to go on, else the search
+ *      :            stops
+ *
+ * ret  : -1, error, out of memory
+ *      : else, number of keys visited
+ */
+int         pytrie_predict(py_trie_t* pytrie, const char* prefix, const int len,
+                           pytrie_func func, void* arg);
+
+#endif
@@ -2,6 +2,10 @@
 #include <sys/time.h>
 #include <string.h>
 #include <assert.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PY_UTILS_X86
+#endif
 #include <py_utils.h>
 
 /*
@@ -286,3 +290,266 @@ int split_all(const char* src, char* strbuf, const int strbuf_size,
 
 }
 
+#ifdef PY_UTILS_X86
+
+/*
+ * func : delimiter bits of 64 bytes, 16 bytes a compare
+ */
+#ifdef __SSE2__
+static unsigned long split_mask_sse2(const char* p, const split_delim_t* sd)
+{
+	unsigned long  mask = 0;
+	__m128i        v    = _mm_setzero_si128();
+	__m128i        eq   = _mm_setzero_si128();
+	int            i    = 0;
+	int            j    = 0;
+
+	for(i=0;i<4;i++){
+		v  = _mm_loadu_si128((const __m128i*)(p+i*16));
+		eq = _mm_setzero_si128();
+		for(j=0;j<sd->num;j++){
+			eq = _mm_or_si128(eq, _mm_cmpeq_epi8(v, _mm_set1_epi8(sd->chars[j])));
+		}
+		mask |= (unsigned long)(unsigned int)_mm_movemask_epi8(eq) << (i*16);
+	}
+	return mask;
+}
+#endif
+
+/*
+ * func : delimiter bits of 64 bytes, 32 bytes a compare
+ */
+__attribute__((target("avx2")))
+static unsigned long split_mask_avx2(const char* p, const split_delim_t* sd)
+{
+	__m256i        lo  = _mm256_loadu_si256((const __m256i*)p);
+	__m256i        hi  = _mm256_loadu_si256((const __m256i*)(p+32));
+	__m256i        elo = _mm256_setzero_si256();
+	__m256i        ehi = _mm256_setzero_si256();
+	__m256i        d   = _mm256_setzero_si256();
+	int            j   = 0;
+
+	for(j=0;j<sd->num;j++){
+		d   = _mm256_set1_epi8(sd->chars[j]);
+		elo = _mm256_or_si256(elo, _mm256_cmpeq_epi8(lo, d));
+		ehi = _mm256_or_si256(ehi, _mm256_cmpeq_epi8(hi, d));
+	}
+	return (unsigned long)(unsigned int)_mm256_movemask_epi8(elo) |
+	       (unsigned long)(unsigned int)_mm256_movemask_epi8(ehi) << 32;
+}
+
+#endif
+
+/*
+ * func : prepare a delimiter set, the widest vectors the cpu supports are
+ *        used if it has SPLIT_VEC_MAX delimiters or less
+ *
+ * args : sd, the result
+ *      : delim, the delimiters
+ */
+void split_delim_init(split_delim_t* sd, const char* delim)
+{
+	const unsigned char* p = (const unsigned char*)delim;
+
+	assert(sd && delim);
+
+	memset(sd, 0, sizeof(split_delim_t));
+	for(;*p;p++){
+		if(sd->table[*p]){
+			continue;
+		}
+		sd->table[*p] = 1;
+		if(sd->num < SPLIT_VEC_MAX){
+			sd->chars[sd->num] = (char)*p;
+		}
+		sd->num++;
+	}
+
+	sd->simd = 0;
+#ifdef PY_UTILS_X86
+	if(sd->num <= SPLIT_VEC_MAX){
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx2")){
+			sd->simd = 2;
+		}
+#ifdef __SSE2__
+		else{
+			sd->simd = 1;
+		}
+#endif
+	}
+#endif
+}
+
+// a string scanned 64 bytes at a time, mask holds the delimiter bits of
+// the block at base
+typedef struct _split_scan{
+	const char*           str;
+	int                   len;
+	const split_delim_t*  sd;
+	int                   base;
+	unsigned long         mask;
+}split_scan_t;
+
+/*
+ * func : delimiter bits of the block at base, bytes past the string end
+ *        are not delimiters
+ */
+static inline unsigned long split_mask(split_scan_t* sc, const int base)
+{
+	const unsigned char*  p    = (const unsigned char*)sc->str + base;
+	unsigned long         mask = 0;
+	int                   n    = sc->len - base;
+	int                   i    = 0;
+
+#ifdef PY_UTILS_X86
+	if(n >= 64){
+		if(sc->sd->simd == 2){
+			return split_mask_avx2((const char*)p, sc->sd);
+		}
+#ifdef __SSE2__
+		if(sc->sd->simd == 1){
+			return split_mask_sse2((const char*)p, sc->sd);
+		}
+#endif
+	}
+#endif
+	if(n > 64){
+		n = 64;
+	}
+	for(i=0;i<n;i++){
+		mask |= (unsigned long)sc->sd->table[p[i]] << i;
+	}
+	return mask;
+}
+
+/*
+ * func : find the first delimiter (or the first other byte) from pos
+ *
+ * args : sc, the string
+ *      : pos, the start position
+ *      : delim, 1 to find a delimiter, 0 to find a byte of a word
+ *
+ * ret  : its position, len if none
+ */
+static inline int split_find(split_scan_t* sc, int pos, const int delim)
+{
+	unsigned long   bits = 0;
+
+	while(pos < sc->len){
+		if(pos - sc->base >= 64){
+			sc->base = pos & ~63;
+			sc->mask = split_mask(sc, sc->base);
+		}
+		bits = delim ? sc->mask : ~sc->mask;
+		bits &= ~0UL << (pos - sc->base);
+		if(bits){
+			pos = sc->base + __builtin_ctzl(bits);
+			return pos < sc->len ? pos : sc->len;
+		}
+		pos = sc->base + 64;
+	}
+	return sc->len;
+}
+
+/*
+ * func : split a string into words, the spans of split_c
+ *
+ * args : str, len, the string, no '\0' in its len bytes
+ *      : sd, the delimiters, see split_delim_init
+ *      : spans, span_size, result word spans and its size
+ *
+ * ret  : -1, failed, spans is full
+ *      : else, number of words
+ *
+ * note : a step of split_c is kept, a word or the delimiters at the string
+ *        end take a check of the spans size
+ */
+int split_span(const char* str, const int len, const split_delim_t* sd,
+               split_span_t* spans, const int span_size)
+{
+	split_scan_t  sc;
+	int           begin = 0;
+	int           end   = 0;
+	int           pos   = 0;
+	int           cnt   = 0;
+
+	assert(str && sd && spans);
+
+	sc.str  = str;
+	sc.len  = len;
+	sc.sd   = sd;
+	sc.base = -64;
+	sc.mask = 0;
+
+	while(pos < len){
+		begin = split_find(&sc, pos, 0);
+		end   = split_find(&sc, begin, 1);
+
+		if(cnt+1 == span_size){
+			return -1;
+		}
+		if(end - begin > 0){
+			spans[cnt].offset = begin;
+			spans[cnt].len    = end - begin;
+			cnt++;
+		}
+		if(end == len){
+			break;
+		}
+		pos = end+1;
+	}
+	return cnt;
+}
+
+/*
+ * func : split a string into tokens, each delimiter is a token, the spans
+ *        of split_all
+ *
+ * args : see split_span
+ *
+ * ret  : <0, error, spans is full
+ *      : else, token number
+ */
+int split_all_span(const char* str, const int len, const split_delim_t* sd,
+                   split_span_t* spans, const int span_size)
+{
+	split_scan_t  sc;
+	int           token_num = 0;
+	int           cur       = 0;
+	int           end       = 0;
+
+	assert(str && sd && spans && span_size>0);
+
+	sc.str  = str;
+	sc.len  = len;
+	sc.sd   = sd;
+	sc.base = -64;
+	sc.mask = 0;
+
+	while(cur < len){
+		// every delimiter is a token
+		end = split_find(&sc, cur, 0);
+		for(;cur<end;cur++){
+			if(token_num+1 == span_size){
+				return -1;
+			}
+			spans[token_num].offset = cur;
+			spans[token_num].len    = 1;
+			token_num++;
+		}
+
+		// a word
+		end = split_find(&sc, cur, 1);
+		if(end - cur > 0){
+			if(token_num+1 == span_size){
+				return -1;
+			}
+			spans[token_num].offset = cur;
+			spans[token_num].len    = end - cur;
+			token_num++;
+			cur = end;
+		}
+	}
+	return token_num;
+}
@@ -84,5 +84,61 @@ void pthr_sleep(int sec);
 int split_all(const char* src, char* strbuf, const int strbuf_size, 
 		             char** tokens, int token_size, const char *delim);
 
+#define SPLIT_VEC_MAX 8      // delimiters compared in vectors, more take the table
+
+// a delimiter set prepared for split_span and split_all_span
+typedef struct _split_delim{
+	unsigned char  table[256];              // 1, a delimiter
+	char           chars[SPLIT_VEC_MAX];    // distinct delimiters if num <= SPLIT_VEC_MAX
+	int            num;                     // distinct delimiters
+	int            simd;                    // 0, table; 1, sse2; 2, avx2
+}split_delim_t;
+
+// a token of a string, no copy
+typedef struct _split_span{
+	int            offset;
+	int            len;
+}split_span_t;
+
+/*
+ * func : prepare a delimiter set, the widest vectors the cpu supports are
+ *        used if it has SPLIT_VEC_MAX delimiters or less
+ *
+ * args : sd, the result
+ *      : delim, the delimiters
+ */
+void split_delim_init(split_delim_t* sd, const char* delim);
+
+/*
+ * func : split a string into words, the spans of split_c
+ *
+ * args : str, len, the string, no '\0' in its len bytes
+ *      : sd, the delimiters, see split_delim_init
+ *      : spans, span_size, result word spans and its size
+ *
+ * ret  : -1, failed, spans is full
+ *      : else, number of words
+ *
+ * note : the words and the failures are those of split_c on the same
+ *        string, str is NOT changed. 64 bytes are scanned at a time into
+ *        a bit mask of their delimiters
+ */
+int split_span(const char* str, const int len, const split_delim_t* sd,
+               split_span_t* spans, const int span_size);
+
+/*
+ * func : split a string into tokens, each delimiter is a token, the spans
+ *        of split_all
+ *
+ * args : see split_span
+ *
+ * ret  : <0, error, spans is full
+ *      : else, token number
+ *
+ * note : the tokens are those of split_all with a strbuf large enough
+ */
+int split_all_span(const char* str, const int len, const split_delim_t* sd,
+                   split_span_t* spans, const int span_size);
+
 
 #endif
@@ -0,0 +1,745 @@
+/***********************************************************************************
+ * Describe : dict with a write ahead log, see py_wal.h
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ **********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libgen.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <py_sign.h>
+#include <py_utils.h>
+#include <py_dict.h>
+#include <py_wal.h>
+
+
+#define WAL_READ_STEP   4096      // records read at a time
+#define WAL_WRITE_BUF   (1<<20)   // stdio buffer of the merged snapshot
+#define WAL_HEAD_V1     8         // magic and version, the head of version 1
+#define WAL_REC_V2      24        // a record up to check, versions 1 and 2
+
+// what a replay found in a log
+typedef struct _wal_scan{
+	size_t         good_size;       // size of the good part of the log
+	unsigned int   version;         // 0, no head
+	int            key_max;         // longest key of the adds, -1 unknown
+}wal_scan_t;
+
+/*
+ * func : checksum of a record of a log version
+ */
+static unsigned int wal_check(wal_rec_t* rec, const unsigned int version)
+{
+	unsigned long   h = 0x9e3779b97f4a7c15UL;
+
+	h = (h ^ rec->op)                 * 0xff51afd7ed558ccdUL;
+	h = (h ^ rec->sign1)              * 0xff51afd7ed558ccdUL;
+	h = (h ^ rec->sign2)              * 0xff51afd7ed558ccdUL;
+	h = (h ^ (unsigned int)rec->code) * 0xff51afd7ed558ccdUL;
+	h = (h ^ (unsigned int)rec->value)* 0xc4ceb9fe1a85ec53UL;
+	if(version>=3){
+		h = (h ^ (unsigned int)rec->keylen) * 0xc4ceb9fe1a85ec53UL;
+	}
+
+	return (unsigned int)(h ^ (h >> 32));
+}
+
+/*
+ * func : apply a record to a dict, an add counts its key in key_max
+ *
+ * args : merge, 1, a del is kept as a node with code -1, see pywal_merge
+ */
+static int wal_apply(py_dict_t* pydict, wal_rec_t* rec, const int merge)
+{
+	PNODE    node;
+	SIGN64   sign;
+
+	if(rec->op==PYWAL_OP_DEL && !merge){
+		sign.sign = ((unsigned long)rec->sign1 << 32) | rec->sign2;
+		return pydict_del_node(pydict, &sign);
+	}
+	node.sign1 = rec->sign1;
+	node.sign2 = rec->sign2;
+	node.code  = rec->op==PYWAL_OP_DEL ? -1 : rec->code;
+	node.value = rec->value;
+	node.next  = COMMON_NULL;
+	if(merge){ // the scan keeps the longest key, see wal_replay
+		return pydict_add_node(pydict, &node);
+	}
+	return pydict_add_node_len(pydict, &node, rec->op==PYWAL_OP_ADD ? rec->keylen : -1);
+}
+
+/*
+ * func : replay a log into a dict
+ *
+ * args : pydict, the dict
+ *      : log, the log file, may not exist
+ *      : merge, see wal_apply
+ *      : scan, what the replay found, see wal_scan_t
+ *
+ * ret  : number of records replayed
+ *      : -1, error, not a log
+ *
+ * note : the log ends at the first short or bad record
+ */
+static int wal_replay(py_dict_t* pydict, const char* log, const int merge, wal_scan_t* scan)
+{
+	FILE*        fp   = NULL;
+	wal_head_t   head;
+	wal_rec_t    recs[WAL_READ_STEP];
+	wal_rec_t    rec;
+	size_t       rec_size = sizeof(wal_rec_t);
+	size_t       num  = 0;
+	size_t       i    = 0;
+	size_t       size = 0;
+	int          count = 0;
+
+	memset(scan, 0, sizeof(wal_scan_t));
+	if((fp=fopen(log, "rb"))==NULL){
+		return errno==ENOENT ? 0 : -1;
+	}
+	if(fread(&head, WAL_HEAD_V1, 1, fp)!=1){ // empty or torn head
+		fclose(fp);
+		return 0;
+	}
+	if(head.magic!=PYWAL_MAGIC || head.version<1 || head.version>PYWAL_VERSION){
+		fclose(fp);
+		return -1;
+	}
+	head.hash = PY_SIGN_MURMUR;
+	size      = WAL_HEAD_V1;
+	if(head.version>=2){
+		if(fread((char*)&head+WAL_HEAD_V1, sizeof(wal_head_t)-WAL_HEAD_V1, 1, fp)!=1){
+			fclose(fp);
+			return 0;
+		}
+		size = sizeof(wal_head_t);
+	}
+	if(head.version<3){
+		rec_size = WAL_REC_V2;
+	}
+	scan->version = head.version;
+
+	// an empty dict takes the function of the log
+	if(head.hash!=(unsigned int)pydict->hash && pydict_set_hash(pydict, head.hash)<0){
+		fclose(fp);
+		return -1;
+	}
+
+	while((num=fread(recs, rec_size, WAL_READ_STEP, fp))>0){
+		for(i=0;i<num;i++){
+			rec.keylen = -1;
+			memcpy(&rec, (char*)recs+i*rec_size, rec_size);
+			if(rec.check!=wal_check(&rec, head.version) ||
+			   (rec.op!=PYWAL_OP_ADD && rec.op!=PYWAL_OP_DEL)){
+				goto out;
+			}
+			if(wal_apply(pydict, &rec, merge) < 0){
+				goto out;
+			}
+			if(rec.op==PYWAL_OP_ADD && scan->key_max>=0){
+				scan->key_max = rec.keylen<0 || rec.keylen>scan->key_max ? rec.keylen : scan->key_max;
+			}
+			size += rec_size;
+			count++;
+		}
+		if(num<WAL_READ_STEP){
+			break;
+		}
+	}
+
+out:
+	fclose(fp);
+	scan->good_size = size;
+	return count;
+}
+
+/*
+ * func : fsync the directory of a file, so a rename in it is durable
+ */
+static void wal_sync_dir(const char* path)
+{
+	char   dir[600];
+	int    fd = -1;
+
+	snprintf(dir, sizeof(dir), "%s", path);
+	if((fd=open(dirname(dir), O_RDONLY))>=0){
+		fsync(fd);
+		close(fd);
+	}
+}
+
+/*
+ * func : open the log for appending, cut a torn tail and write the head
+ *        of a new log
+ */
+static int wal_open_log(py_wal_t* pywal, const size_t good_size)
+{
+	char         log[600];
+	wal_head_t   head;
+
+	snprintf(log, sizeof(log), "%s.wal", pywal->path);
+	if((pywal->fd=open(log, O_WRONLY|O_CREAT, 0644))<0){
+		return -1;
+	}
+	if(good_size<sizeof(wal_head_t)){
+		memset(&head, 0, sizeof(head));
+		head.magic   = PYWAL_MAGIC;
+		head.version = PYWAL_VERSION;
+		head.hash    = pywal->pydict->hash;
+		if(ftruncate(pywal->fd, 0)<0 ||
+		   pwrite(pywal->fd, &head, sizeof(head), 0)!=sizeof(head)){
+			return -1;
+		}
+		pywal->log_size = sizeof(head);
+	}
+	else{
+		if(ftruncate(pywal->fd, good_size)<0){
+			return -1;
+		}
+		pywal->log_size = good_size;
+	}
+	if(lseek(pywal->fd, pywal->log_size, SEEK_SET)<0 || fdatasync(pywal->fd)<0){
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * func : merge a log into a dict file, used by the compaction
+ *
+ * args : path, the dict file, may not exist
+ *      : log, the log file
+ *      : hashsize, hash table size when there is no dict file
+ *
+ * ret  : 0, succeed
+ *      : -1, error, the dict file is not changed
+ *
+ * note : the nodes of the dict file are streamed from a mapping, nodes
+ *      : changed by the log are replaced or dropped, then the new nodes of
+ *      : the log are appended. only the new hash table is in memory. the
+ *      : blob arena of the dict file is copied after the footer.
+ */
+int pywal_merge(const char* path, const char* log, const int hashsize)
+{
+	py_dict_t*      snap     = NULL;
+	py_dict_t*      logged   = NULL;
+	FILE*           fp       = NULL;
+	char*           buf      = NULL;
+	unsigned int*   hashtab  = NULL;
+	unsigned int    size     = 0;
+	unsigned int    snap_num = 0;
+	unsigned int    node_num = 0;
+	unsigned int    pos      = 0;
+	unsigned int    i        = 0;
+	PNODE*          lnode    = NULL;
+	PNODE           node;
+	SIGN64          sign;
+	wal_scan_t      scan;
+	pydict_footer_t footer;
+	pydict_meta_t   meta;
+	pydict_blob_head_t blob_head;
+	char            tmp[600];
+
+	// the logged changes, a deleted key keeps a node with code -1
+	if((logged = pydict_create(1024, 1024)) == NULL){
+		goto failed;
+	}
+	if(wal_replay(logged, log, 1, &scan) < 0){
+		goto failed;
+	}
+
+	if(access(path, F_OK)==0){
+		if((snap = pydict_map_fullpath(path, 0)) == NULL){
+			goto failed;
+		}
+		madvise(snap->map_addr, snap->map_size, MADV_SEQUENTIAL);
+		snap_num = snap->block_pos;
+		size     = snap->hashsize;
+
+		// records and snapshot nodes must be signed alike
+		if(logged->block_pos>0 && logged->hash!=snap->hash){
+			goto failed;
+		}
+	}
+	footer.magic = PYDICT_FILE_MAGIC;
+	footer.hash  = snap && logged->block_pos==0 ? snap->hash : logged->hash;
+
+	// the longest key, unknown if the snapshot or the log does not know it
+	memset(&meta, 0, sizeof(meta));
+	meta.magic = PYDICT_META_MAGIC;
+	if(scan.key_max>=0 && (!snap || pydict_key_max_known(snap))){
+		meta.key_max = snap && snap->key_max>(unsigned int)scan.key_max ? snap->key_max : scan.key_max;
+	}
+	if(size==0){
+		size = hashsize>0 ? hashsize : 1;
+	}
+	while((unsigned long)snap_num+logged->block_pos > (unsigned long)size*PYDICT_MAX_LOAD
+	      && size < 0x7FFFFFFF){
+		size = size*2+1;
+	}
+
+	hashtab = (unsigned int*)malloc(sizeof(unsigned int)*size);
+	buf     = (char*)malloc(WAL_WRITE_BUF);
+	if(!hashtab || !buf){
+		goto failed;
+	}
+	for(i=0;i<size;i++){
+		hashtab[i] = COMMON_NULL;
+	}
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	if((fp=fopen(tmp, "wb"))==NULL){
+		goto failed;
+	}
+	setvbuf(fp, buf, _IOFBF, WAL_WRITE_BUF);
+
+	// nodes go after the hash table, the head and the table are written last
+	if(fseeko(fp, (off_t)(2+size)*sizeof(unsigned int), SEEK_SET) < 0){
+		goto failed;
+	}
+	for(i=0;i<snap_num+logged->block_pos;i++){
+		if(i<snap_num){
+			node = *pydict_node(snap, i);
+			if(node.code==-1){
+				continue;
+			}
+			sign.sign = ((unsigned long)node.sign1 << 32) | node.sign2;
+			if((lnode = pydict_find_node(logged, &sign)) != NULL){
+				node.code  = lnode->code;
+				node.value = lnode->value;
+				lnode->code = -1; // consumed, keys of the snapshot are unique
+			}
+		}
+		else{
+			node = *pydict_node(logged, i-snap_num);
+		}
+		if(node.code==-1){
+			continue;
+		}
+		pos       = (node.sign1+node.sign2) % size;
+		node.next = hashtab[pos];
+		hashtab[pos] = node_num++;
+		if(fwrite(&node, sizeof(PNODE), 1, fp)!=1){
+			goto failed;
+		}
+	}
+	if(fwrite(&footer, sizeof(footer), 1, fp)!=1){
+		goto failed;
+	}
+	if(meta.key_max>0 && fwrite(&meta, sizeof(meta), 1, fp)!=1){
+		goto failed;
+	}
+
+	// the blob arena of the snapshot, the nodes keep their offsets
+	if(snap && snap->blob_size>0){
+		memset(&blob_head, 0, sizeof(blob_head));
+		blob_head.magic = PYDICT_BLOB_MAGIC;
+		blob_head.size  = snap->blob_size;
+		if(fwrite(&blob_head, sizeof(blob_head), 1, fp)!=1 ||
+		   fwrite(snap->blob, 1, snap->blob_size, fp)!=snap->blob_size){
+			goto failed;
+		}
+	}
+
+	if(fseeko(fp, 0, SEEK_SET) < 0){
+		goto failed;
+	}
+	if(fwrite(&size, sizeof(unsigned int), 1, fp)!=1 ||
+	   fwrite(&node_num, sizeof(unsigned int), 1, fp)!=1 ||
+	   fwrite(hashtab, sizeof(unsigned int), size, fp)!=size){
+		goto failed;
+	}
+	if(fflush(fp)!=0 || fsync(fileno(fp))<0){
+		goto failed;
+	}
+	if(fclose(fp)!=0){
+		fp = NULL;
+		goto failed;
+	}
+	fp = NULL;
+
+	if(rename(tmp, path)<0){
+		goto failed;
+	}
+	wal_sync_dir(path);
+
+	pydict_free(snap);
+	pydict_free(logged);
+	free(hashtab);
+	free(buf);
+	return 0;
+
+failed:
+	if(fp){
+		fclose(fp);
+		unlink(tmp);
+	}
+	pydict_free(snap);
+	pydict_free(logged);
+	if(hashtab){
+		free(hashtab);
+	}
+	if(buf){
+		free(buf);
+	}
+	return -1;
+}
+
+/*
+ * func : compaction thread, merge file.wal.old into the snapshot and
+ *        remove it
+ */
+static void* wal_thread(void* arg)
+{
+	py_wal_t*   pywal  = (py_wal_t*)arg;
+	char        old[600];
+	int         failed = 0;
+
+	snprintf(old, sizeof(old), "%s.wal.old", pywal->path);
+	if(pywal_merge(pywal->path, old, pywal->hashsize) < 0){
+		failed = 1;
+	}
+	else{
+		unlink(old);
+		wal_sync_dir(old);
+	}
+
+	__atomic_store_n(&pywal->failed, failed, __ATOMIC_RELAXED);
+	__atomic_store_n(&pywal->done, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+/*
+ * func : join a finished compaction thread
+ *
+ * args : wait, 1 to wait for a running one
+ *
+ * ret  : 1, no compaction is running now
+ *      : 0, a compaction is running
+ */
+static int wal_join(py_wal_t* pywal, const int wait)
+{
+	if(!pywal->running){
+		return 1;
+	}
+	if(!wait && !__atomic_load_n(&pywal->done, __ATOMIC_ACQUIRE)){
+		return 0;
+	}
+	pthread_join(pywal->thread, NULL);
+	pywal->running = 0;
+	return 1;
+}
+
+/*
+ * func : start a compaction thread, the log is renamed to file.wal.old
+ *        first, unless an old log is still there from a failed compaction
+ *
+ * ret  : 0, started
+ *      : -1, error
+ */
+static int wal_compact(py_wal_t* pywal)
+{
+	char   log[600];
+	char   old[600];
+
+	if(!wal_join(pywal, 0)){
+		return 0;
+	}
+
+	snprintf(log, sizeof(log), "%s.wal", pywal->path);
+	snprintf(old, sizeof(old), "%s.wal.old", pywal->path);
+	if(access(old, F_OK)<0){
+		if(fdatasync(pywal->fd)<0){
+			return -1;
+		}
+		if(rename(log, old)<0){
+			return -1;
+		}
+		close(pywal->fd);
+		pywal->fd = -1;
+		if(wal_open_log(pywal, 0)<0){
+			return -1;
+		}
+		wal_sync_dir(log);
+	}
+
+	pywal->done            = 0;
+	pywal->hashsize = pywal->pydict->hashsize;
+	if(pthread_create(&pywal->thread, NULL, wal_thread, pywal) != 0){
+		return -1;
+	}
+	pywal->running = 1;
+	return 0;
+}
+
+/*
+ * func : open a dict with a write ahead log, the snapshot and the logs are
+ *        loaded and replayed
+ *
+ * args : path, file, the snapshot file, the logs are file.wal and
+ *      :             file.wal.old
+ *      : hashsize, hash table size of a new dict, when there is no snapshot
+ *      : threshold, log size in bytes starting a compaction
+ *      : flags, PYWAL_SYNC, PYWAL_NO_COMPACT
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_wal_t struct
+ */
+py_wal_t* pywal_open(const char* path, const char* file, const int hashsize,
+                     const size_t threshold, const int flags)
+{
+	py_wal_t*   pywal     = NULL;
+	wal_scan_t  scan;
+	char        log[600];
+	char        old[600];
+
+	pywal = (py_wal_t*)calloc(1, sizeof(py_wal_t));
+	if(!pywal){
+		goto failed;
+	}
+	pywal->fd        = -1;
+	pywal->flags     = flags;
+	pywal->threshold = threshold;
+	if(cmps_path(pywal->path, sizeof(pywal->path), path, file) < 0){
+		goto failed;
+	}
+	snprintf(log, sizeof(log), "%s.wal", pywal->path);
+	snprintf(old, sizeof(old), "%s.wal.old", pywal->path);
+
+	if(access(pywal->path, F_OK)==0){
+		pywal->pydict = pydict_load_fullpath(pywal->path);
+	}
+	else{
+		pywal->pydict = pydict_create(hashsize>0 ? hashsize : 1, 1024);
+	}
+	if(!pywal->pydict){
+		goto failed;
+	}
+
+	// an old log is left by a compaction which did not finish
+	if(wal_replay(pywal->pydict, old, 0, &scan) < 0){
+		goto failed;
+	}
+	if(wal_replay(pywal->pydict, log, 0, &scan) < 0){
+		goto failed;
+	}
+
+	// records are not appended to a log of an older version, it becomes
+	// the old log and a new log is started
+	if(scan.version>0 && scan.version<PYWAL_VERSION){
+		if(access(old, F_OK)==0){
+			if(pywal_merge(pywal->path, old, hashsize) < 0){
+				goto failed;
+			}
+			unlink(old);
+		}
+		if(rename(log, old) < 0){
+			goto failed;
+		}
+		wal_sync_dir(log);
+		scan.good_size = 0;
+	}
+	if(wal_open_log(pywal, scan.good_size) < 0){
+		goto failed;
+	}
+
+	if(access(old, F_OK)==0 && !(flags & PYWAL_NO_COMPACT)){
+		if(wal_compact(pywal) < 0){
+			goto failed;
+		}
+	}
+
+	return pywal;
+
+failed:
+	if(pywal){
+		if(pywal->fd>=0){
+			close(pywal->fd);
+		}
+		pydict_free(pywal->pydict);
+		free(pywal);
+	}
+	return NULL;
+}
+
+/*
+ * func : wait for a running compaction, close the log and free the dict
+ */
+void pywal_close(py_wal_t* pywal)
+{
+	if(!pywal){
+		return;
+	}
+	wal_join(pywal, 1);
+	if(pywal->fd>=0){
+		fdatasync(pywal->fd);
+		close(pywal->fd);
+		pywal->fd = -1;
+	}
+	pydict_free(pywal->pydict);
+	pywal->pydict = NULL;
+	free(pywal);
+}
+
+/*
+ * func : append a record to the log
+ */
+static int wal_write(py_wal_t* pywal, wal_rec_t* rec)
+{
+	rec->check = wal_check(rec, PYWAL_VERSION);
+	if(write(pywal->fd, rec, sizeof(wal_rec_t))!=sizeof(wal_rec_t) ||
+	   ((pywal->flags & PYWAL_SYNC) && fdatasync(pywal->fd)<0)){
+		// cut the record, a failed change is not replayed and the next
+		// one starts at a record end
+		if(ftruncate(pywal->fd, pywal->log_size)==0){
+			lseek(pywal->fd, pywal->log_size, SEEK_SET);
+		}
+		return -1;
+	}
+	pywal->log_size += sizeof(wal_rec_t);
+
+	if(pywal->log_size>=pywal->threshold && !(pywal->flags & PYWAL_NO_COMPACT)){
+		wal_compact(pywal); // the record is logged, a failed start is retried later
+	}
+	return 0;
+}
+
+/*
+ * func : log and add a value pair
+ *
+ * ret  : 1,  find a same key, value changed;
+ *      : 0,  find NO same key, new node added,
+ *      : -1, error, nothing is changed
+ *
+ * note : the change is applied first and undone if it can not be logged,
+ *        a record in the log is a change the caller was told succeeded
+ */
+int pywal_add(py_wal_t* pywal, const char* key, const int keylen, const int code, const int value)
+{
+	wal_rec_t     rec;
+	PNODE*        pnode   = NULL;
+	PNODE         old;
+	SIGN64        sign;
+	unsigned int  key_max = pywal->pydict->key_max;
+	int           ret     = 0;
+
+	rec.op     = PYWAL_OP_ADD;
+	py_sign64_double_int_hash(pywal->pydict->hash, key, keylen, &rec.sign1, &rec.sign2);
+	rec.code   = code;
+	rec.value  = value;
+	rec.keylen = keylen;
+
+	sign.sign = ((unsigned long)rec.sign1 << 32) | rec.sign2;
+	if((pnode = pydict_find_node(pywal->pydict, &sign)) != NULL){
+		old      = *pnode;
+		old.next = COMMON_NULL;
+	}
+	if((ret = wal_apply(pywal->pydict, &rec, 0)) < 0){
+		return -1;
+	}
+	if(wal_write(pywal, &rec) < 0){
+		// an overwrite of the old value never allocates
+		if(pnode){
+			pydict_add_node(pywal->pydict, &old);
+		}
+		else{
+			pydict_del_node(pywal->pydict, &sign);
+		}
+		pywal->pydict->key_max = key_max;
+		return -1;
+	}
+	return ret;
+}
+
+/*
+ * func : log and delete a key
+ *
+ * ret  : 0, NOT found; 1, founded.
+ *      : -1, error, nothing is changed
+ *
+ * note : see pywal_add
+ */
+int pywal_del(py_wal_t* pywal, const char* key, const int keylen)
+{
+	wal_rec_t     rec;
+	PNODE*        pnode   = NULL;
+	PNODE         old;
+	SIGN64        sign;
+	unsigned int  key_max = pywal->pydict->key_max;
+	int           ret     = 0;
+
+	py_sign64_double_int_hash(pywal->pydict->hash, key, keylen, &rec.sign1, &rec.sign2);
+	sign.sign = ((unsigned long)rec.sign1 << 32) | rec.sign2;
+	if((pnode = pydict_find_node(pywal->pydict, &sign)) == NULL){ // nothing to log
+		return 0;
+	}
+
+	old      = *pnode;
+	old.next = COMMON_NULL;
+
+	rec.op     = PYWAL_OP_DEL;
+	rec.code   = 0;
+	rec.value  = 0;
+	rec.keylen = 0;
+	if((ret = wal_apply(pywal->pydict, &rec, 0)) < 0){
+		return -1;
+	}
+	if(wal_write(pywal, &rec) < 0){
+		// the node is back from the free list
+		pydict_add_node(pywal->pydict, &old);
+		pywal->pydict->key_max = key_max;
+		return -1;
+	}
+	return ret;
+}
+
+/*
+ * func : find a key, same as pydict_find on pywal->pydict
+ */
+int pywal_find(py_wal_t* pywal, const char* key, const int keylen, int* code, int* value)
+{
+	return pydict_find(pywal->pydict, key, keylen, code, value);
+}
+
+/*
+ * func : fdatasync the log, records before it survive a crash
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+int pywal_sync(py_wal_t* pywal)
+{
+	return fdatasync(pywal->fd)<0 ? -1 : 0;
+}
+
+/*
+ * func : start a compaction now, whatever the log size
+ *
+ * args : pywal, pointer to py_wal_t
+ *      : wait, 1 to wait for the new snapshot
+ *
+ * ret  : 0, started, or done when wait is 1
+ *      : -1, error
+ */
+int pywal_checkpoint(py_wal_t* pywal, const int wait)
+{
+	wal_join(pywal, 1); // a running compaction merges an older log
+	if(wal_compact(pywal) < 0){
+		return -1;
+	}
+	if(wait){
+		wal_join(pywal, 1);
+		return pywal->failed ? -1 : 0;
+	}
+	return 0;
+}
@@ -0,0 +1,166 @@
+/********************************************************************************
+ * Describe : a dict with a write ahead log. every add and del is appended to
+ *          : "file.wal" as a 28 bytes record before the dict is changed, so
+ *          : persisting a few updates writes a few records instead of the
+ *          : whole dict. opening replays the log on top of the last snapshot
+ *          : "file".
+ *
+ *          : when the log passes a size threshold it is renamed to
+ *          : "file.wal.old" and a new log is started, a background thread
+ *          : merges the old log into a new snapshot: the snapshot is mapped
+ *          : and streamed to "file.tmp" with the logged changes applied, the
+ *          : temp file is renamed to "file" and the old log is removed. only
+ *          : the hash table of the new snapshot is kept in memory. an old log
+ *          : left by a crash is replayed on open and merged again, replaying
+ *          : a log twice gives the same dict.
+ *
+ *          : log layout, [wal_head_t][wal_rec_t]..., a record with a bad
+ *          : checksum or a short record ends the log, it is cut off on open.
+ *          : records are signed with the function of the dict, a log of 
+ *          : another function is not replayed. an add record keeps the key
+ *          : length for key_max, see py_seg.h, a log of an older version
+ *          : has none, it is replayed and then merged as an old log.
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ *******************************************************************************/
+#ifndef _PY_WAL_H
+#define _PY_WAL_H
+
+#include <pthread.h>
+#include <py_dict.h>
+
+// macros defined here
+//
+#define PYWAL_MAGIC      0x4c575950   // "PYWL"
+#define PYWAL_VERSION    3            // 2, records without the key length
+                                      // 1, an 8 bytes head, murmur signed
+
+#define PYWAL_SYNC       0x01         // fdatasync the log after every record
+#define PYWAL_NO_COMPACT 0x02         // never compact in the background, see pywal_checkpoint
+
+#define PYWAL_OP_ADD     1
+#define PYWAL_OP_DEL     2
+
+// data structure define here
+//
+typedef struct _wal_head{
+	unsigned int      magic;
+	unsigned int      version;
+	unsigned int      hash;         // signature function of the records
+	unsigned int      reserved;
+}wal_head_t;
+
+// a logged add or del
+typedef struct _wal_rec{
+	unsigned int      op;           // PYWAL_OP_ADD or PYWAL_OP_DEL
+	unsigned int      sign1;
+	unsigned int      sign2;
+	int               code;
+	int               value;
+	unsigned int      check;        // checksum of the other fields
+	int               keylen;       // bytes of the key of an add, -1 unknown,
+	                                // a version 2 record ends at check
+}wal_rec_t;
+
+typedef struct _py_wal{
+	py_dict_t*        pydict;       // the dict, find in it directly
+	char              path[512];    // full path of the snapshot
+	int               flags;        // PYWAL_SYNC, PYWAL_NO_COMPACT
+	size_t            threshold;    // log size starting a compaction
+	int               fd;           // the log
+	size_t            log_size;
+
+	pthread_t         thread;       // the compaction thread
+	int               running;      // thread started and not joined
+	int               done;         // thread finished, read atomically
+	int               failed;       // last compaction failed
+	unsigned int      hashsize;     // hash table size of a new snapshot, taken
+	                                // when the thread starts
+}py_wal_t;
+
+
+// functions defined here
+//
+
+/*
+ * func : open a dict with a write ahead log, the snapshot and the logs are
+ *        loaded and replayed
+ *
+ * args : path, file, the snapshot file, the logs are file.wal and
+ *      :             file.wal.old
+ *      : hashsize, hash table size of a new dict, when there is no snapshot
+ *      : threshold, log size in bytes starting a compaction
+ *      : flags, PYWAL_SYNC, PYWAL_NO_COMPACT
+ *
+ * ret  : NULL, error
+ *      : else, pointer to py_wal_t struct
+ */
+py_wal_t*  pywal_open(const char* path, const char* file, const int hashsize,
+                      const size_t threshold, const int flags);
+
+/*
+ * func : wait for a running compaction, close the log and free the dict
+ */
+void       pywal_close(py_wal_t* pywal);
+
+/*
+ * func : log and add a value pair
+ *
+ * ret  : 1,  find a same key, value changed;
+ *      : 0,  find NO same key, new node added,
+ *      : -1, error, nothing is changed
+ *
+ * note : the change is applied first and undone if it can not be logged,
+ *        a record in the log is a change the caller was told succeeded
+ */
+int        pywal_add(py_wal_t* pywal, const char* key, const int keylen, const int code, const int value);
+
+/*
+ * func : log and delete a key
+ *
+ * ret  : 0, NOT found; 1, founded.
+ *      : -1, error, nothing is changed
+ */
+int        pywal_del(py_wal_t* pywal, const char* key, const int keylen);
+
+/*
+ * func : find a key, same as pydict_find on pywal->pydict
+ */
+int        pywal_find(py_wal_t* pywal, const char* key, const int keylen, int* code, int* value);
+
+/*
+ * func : fdatasync the log, records before it survive a crash
+ *
+ * ret  : 0, succeed
+ *      : -1, error
+ */
+int        pywal_sync(py_wal_t* pywal);
+
+/*
+ * func : start a compaction now, whatever the log size
+ *
+ * args : pywal, pointer to py_wal_t
+ *      : wait, 1 to wait for the new snapshot
+ *
+ * ret  : 0, started, or done when wait is 1
+ *      : -1, error
+ */
+int        pywal_checkpoint(py_wal_t* pywal, const int wait);
+
+/*
+ * func : merge a log into a dict file, used by the compaction
+ *
+ * args : path, the dict file, may not exist
+ *      : log, the log file
+ *      : hashsize, hash table size when there is no dict file
+ *
+ * ret  : 0, succeed
+ *      : -1, error, the dict file is not changed
+ */
+int        pywal_merge(const char* path, const char* log, const int hashsize);
+
+#endif
@@ -0,0 +1,835 @@
+/***********************************************************************************
+ * Describe : dict benchmark, throughput and latency of add, find (hit and miss),
+ *          : iterate, parallel iterate, save, load, map, delete and the 
+ *          : parallel build, and the throughput of the signature functions
+ *          : on the keys. find_hit_call and find_hit_inline compare the 
+ *          : throughput of pydict_find and pydict_find_inline, untimed.
+ *          : sign_128 and find_hit_128 are the same for a py_dict128_t of the
+ *          : keys, 128 bit signatures and 32 bytes nodes. split_c and
+ *          : split_span split a "key\tcode\tvalue" line of every key.
+ *
+ *          : usage : bench_pdict [options]
+ *          :   -n num      keys of a synthetic dict, default 1000000
+ *          :   -l min[-max] key length, fixed or uniform in [min, max], default 8-32
+ *          :   -f file     keys from a text file, the first '\t' field of a line
+ *          :   -s hashsize hash table size, default the number of keys
+ *          :   -e engine   chain, swiss or split (chain engine, split layout),
+ *          :               default chain
+ *          :   -a alloc    libc or huge (2MB pages), allocator of the arrays,
+ *          :               default libc
+ *          :   -H hash     murmur, wyhash or roll, signature function of the dict,
+ *          :               default murmur
+ *          :   -t threads  threads of the parallel iterate and of the build
+ *          :               with -f, default all cores
+ *          :   -r seed     random seed, default 1
+ *          :   -o file     write the results to file
+ *          :   -F format   json or csv, default json
+ *
+ *          : latencies are taken per operation with clock_gettime, the timer
+ *          : cost is reported as timer_ns and is part of every latency.
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ **********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <py_dict.h>
+#include <py_dict_inline.h>
+#include <py_dict128.h>
+#include <py_build.h>
+#include <py_utils.h>
+
+#define HIST_SUB     16                 // sub buckets of a power of 2
+#define HIST_SIZE    (61*HIST_SUB)
+#define BENCH_MAX_OP 24
+#define BENCH_FILE   "dictbin_bench"
+
+// log linear latency histogram, about 6% resolution
+typedef struct _bench_hist{
+	unsigned long   count[HIST_SIZE];
+	unsigned long   total;
+	unsigned long   max;
+}bench_hist_t;
+
+typedef struct _bench_op{
+	const char*     name;
+	unsigned long   ops;
+	double          seconds;
+	int             timed;              // per operation latencies taken
+	bench_hist_t    hist;
+}bench_op_t;
+
+typedef struct _bench{
+	char**          keys;
+	int*            lens;
+	char**          misses;
+	int*            miss_lens;
+	unsigned int*   order;              // random order of the keys
+	unsigned int    key_num;
+	unsigned int    hashsize;
+	int             min_len;
+	int             max_len;
+	int             engine;
+	int             layout;
+	int             hash;
+	int             thread_num;
+	unsigned int    seed;               // random seed, as given
+	unsigned int    rand;               // random state
+	const char*     input;
+	const char*     output;
+	const char*     format;
+	double          timer_ns;
+	bench_op_t      ops[BENCH_MAX_OP];
+	int             op_num;
+}bench_t;
+
+static inline unsigned long now_ns()
+{
+	struct timespec   ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long)ts.tv_sec*1000000000UL + ts.tv_nsec;
+}
+
+static inline int hist_index(unsigned long ns)
+{
+	int   b = 0;
+
+	if(ns<HIST_SUB){
+		return (int)ns;
+	}
+	b = 63 - __builtin_clzl(ns);
+	return (b-3)*HIST_SUB + (int)((ns >> (b-4)) & (HIST_SUB-1));
+}
+
+// lowest latency of a histogram bucket
+static unsigned long hist_value(int idx)
+{
+	int   b = 0;
+
+	if(idx<HIST_SUB){
+		return idx;
+	}
+	b = idx/HIST_SUB + 3;
+	return (unsigned long)(HIST_SUB + idx%HIST_SUB) << (b-4);
+}
+
+static inline void hist_add(bench_hist_t* hist, unsigned long ns)
+{
+	hist->count[hist_index(ns)]++;
+	hist->total++;
+	if(ns>hist->max){
+		hist->max = ns;
+	}
+}
+
+static unsigned long hist_percentile(bench_hist_t* hist, double p)
+{
+	unsigned long   want = (unsigned long)(hist->total*p);
+	unsigned long   sum  = 0;
+	int             i    = 0;
+
+	for(i=0;i<HIST_SIZE;i++){
+		sum += hist->count[i];
+		if(sum>want){
+			return hist_value(i);
+		}
+	}
+	return hist->max;
+}
+
+static bench_op_t* bench_op(bench_t* bench, const char* name, int timed)
+{
+	bench_op_t*   op = &bench->ops[bench->op_num++];
+
+	memset(op, 0, sizeof(bench_op_t));
+	op->name  = name;
+	op->timed = timed;
+	return op;
+}
+
+static unsigned int bench_rand(unsigned int* seed)
+{
+	*seed = *seed*1103515245 + 12345;
+	return (*seed >> 8) & 0xffffff;
+}
+
+/*
+ * func : random keys, a miss key starts with a character no hit key has
+ */
+static char* make_key(bench_t* bench, int* len, int miss)
+{
+	static const char  chars[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	char*   key = NULL;
+	int     i   = 0;
+
+	*len = bench->min_len;
+	if(bench->max_len>bench->min_len){
+		*len += bench_rand(&bench->rand) % (bench->max_len-bench->min_len+1);
+	}
+	key = (char*)malloc(*len+1);
+	for(i=0;i<*len;i++){
+		key[i] = chars[bench_rand(&bench->rand) % (sizeof(chars)-1)];
+	}
+	if(miss){
+		key[0] = '~';
+	}
+	key[*len] = '\0';
+	return key;
+}
+
+static int load_keys(bench_t* bench)
+{
+	FILE*          fp   = NULL;
+	char*          tab  = NULL;
+	unsigned int   size = 1024;
+	int            len  = 0;
+	char           line[4096];
+
+	if((fp=fopen(bench->input, "r"))==NULL){
+		return -1;
+	}
+	bench->key_num = 0;
+	bench->keys = (char**)malloc(sizeof(char*)*size);
+	bench->lens = (int*)malloc(sizeof(int)*size);
+	while(fgets(line, sizeof(line), fp)){
+		len = strlen(line);
+		while(len>0 && (line[len-1]=='\n' || line[len-1]=='\r')){
+			line[--len] = '\0';
+		}
+		if((tab=strchr(line, '\t'))!=NULL){
+			*tab = '\0';
+			len  = tab-line;
+		}
+		if(len==0){
+			continue;
+		}
+		if(bench->key_num==size){
+			size *= 2;
+			bench->keys = (char**)realloc(bench->keys, sizeof(char*)*size);
+			bench->lens = (int*)realloc(bench->lens, sizeof(int)*size);
+		}
+		bench->keys[bench->key_num] = strdup(line);
+		bench->lens[bench->key_num] = len;
+		bench->key_num++;
+	}
+	fclose(fp);
+	return 0;
+}
+
+static int make_keys(bench_t* bench)
+{
+	unsigned int   i   = 0;
+	unsigned int   j   = 0;
+	unsigned int   tmp = 0;
+
+	if(bench->input){
+		if(load_keys(bench)<0){
+			return -1;
+		}
+	}
+	else{
+		bench->keys = (char**)malloc(sizeof(char*)*bench->key_num);
+		bench->lens = (int*)malloc(sizeof(int)*bench->key_num);
+		for(i=0;i<bench->key_num;i++){
+			bench->keys[i] = make_key(bench, &bench->lens[i], 0);
+		}
+	}
+
+	bench->misses    = (char**)malloc(sizeof(char*)*bench->key_num);
+	bench->miss_lens = (int*)malloc(sizeof(int)*bench->key_num);
+	bench->order     = (unsigned int*)malloc(sizeof(unsigned int)*bench->key_num);
+	for(i=0;i<bench->key_num;i++){
+		bench->misses[i] = make_key(bench, &bench->miss_lens[i], 1);
+		bench->order[i]  = i;
+	}
+	for(i=bench->key_num;i>1;i--){
+		j   = bench_rand(&bench->rand) % i;
+		tmp = bench->order[i-1];
+		bench->order[i-1] = bench->order[j];
+		bench->order[j]   = tmp;
+	}
+	return 0;
+}
+
+static void free_keys(bench_t* bench)
+{
+	unsigned int   i = 0;
+
+	for(i=0;i<bench->key_num;i++){
+		free(bench->keys[i]);
+		free(bench->misses[i]);
+	}
+	free(bench->keys);
+	free(bench->lens);
+	free(bench->misses);
+	free(bench->miss_lens);
+	free(bench->order);
+}
+
+/*
+ * func : look up every key once, in random order
+ */
+static void bench_find(bench_t* bench, py_dict_t* pydict, const char* name, int miss)
+{
+	bench_op_t*     op    = bench_op(bench, name, 1);
+	unsigned long   begin = 0;
+	unsigned long   t0    = 0;
+	unsigned long   t1    = 0;
+	unsigned int    found = 0;
+	unsigned int    i     = 0;
+	unsigned int    k     = 0;
+	int             code  = 0;
+	int             value = 0;
+
+	begin = now_ns();
+	t0    = begin;
+	for(i=0;i<bench->key_num;i++){
+		k = bench->order[i];
+		if(miss){
+			found += pydict_find(pydict, bench->misses[k], bench->miss_lens[k], &code, &value);
+		}
+		else{
+			found += pydict_find(pydict, bench->keys[k], bench->lens[k], &code, &value);
+		}
+		t1 = now_ns();
+		hist_add(&op->hist, t1-t0);
+		t0 = t1;
+	}
+	op->ops     = bench->key_num;
+	op->seconds = (t0-begin)/1e9;
+	if((miss && found>0) || (!miss && found<bench->key_num)){
+		fprintf(stderr, "%s : %u of %u keys found\n", name, found, bench->key_num);
+	}
+}
+
+/*
+ * func : throughput of finding the keys in order, no per operation timer
+ *
+ * args : inlined, 1 pydict_find_inline, 0 pydict_find
+ */
+static void bench_find_loop(bench_t* bench, py_dict_t* pydict, const char* name, int inlined)
+{
+	bench_op_t*     op    = bench_op(bench, name, 0);
+	unsigned long   begin = 0;
+	unsigned int    found = 0;
+	unsigned int    i     = 0;
+	int             code  = 0;
+	int             value = 0;
+
+	begin = now_ns();
+	if(inlined){
+		for(i=0;i<bench->key_num;i++){
+			found += pydict_find_inline(pydict, bench->keys[i], bench->lens[i], &code, &value);
+		}
+	}
+	else{
+		for(i=0;i<bench->key_num;i++){
+			found += pydict_find(pydict, bench->keys[i], bench->lens[i], &code, &value);
+		}
+	}
+	op->ops     = bench->key_num;
+	op->seconds = (now_ns()-begin)/1e9;
+	if(found<bench->key_num){
+		fprintf(stderr, "%s : %u of %u keys found\n", name, found, bench->key_num);
+	}
+}
+
+static py_dict_t* bench_add(bench_t* bench)
+{
+	py_dict_t*      pydict = NULL;
+	bench_op_t*     op     = NULL;
+	unsigned long   begin  = 0;
+	unsigned long   t0     = 0;
+	unsigned long   t1     = 0;
+	unsigned int    i      = 0;
+
+	if((pydict = pydict_create(bench->hashsize, bench->key_num+1)) == NULL){
+		return NULL;
+	}
+	if(pydict_set_engine(pydict, bench->engine) < 0 ||
+	   pydict_set_layout(pydict, bench->layout) < 0){
+		pydict_free(pydict);
+		return NULL;
+	}
+
+	op    = bench_op(bench, "add", 1);
+	begin = now_ns();
+	t0    = begin;
+	for(i=0;i<bench->key_num;i++){
+		pydict_add(pydict, bench->keys[i], bench->lens[i], i, i);
+		t1 = now_ns();
+		hist_add(&op->hist, t1-t0);
+		t0 = t1;
+	}
+	op->ops     = bench->key_num;
+	op->seconds = (t0-begin)/1e9;
+	return pydict;
+}
+
+static void bench_iterate(bench_t* bench, py_dict_t* pydict)
+{
+	bench_op_t*     op    = bench_op(bench, "iterate", 0);
+	PNODE*          node  = NULL;
+	unsigned long   begin = 0;
+	unsigned long   sum   = 0;
+	unsigned int    pos   = 0;
+
+	begin = now_ns();
+	for(node=pydict_first(pydict, &pos);node;node=pydict_next(pydict, (int*)&pos)){
+		sum += node->value;
+		op->ops++;
+	}
+	op->seconds = (now_ns()-begin)/1e9;
+	if(sum==1){ // keep the loop
+		printf(" ");
+	}
+}
+
+// reads the node, never stops
+static int bench_visit(PNODE* node, unsigned int pos, void* arg)
+{
+	return node->value == -2;
+}
+
+static void bench_iterate_parallel(bench_t* bench, py_dict_t* pydict)
+{
+	bench_op_t*     op    = bench_op(bench, "iterate_parallel", 0);
+	unsigned long   begin = 0;
+
+	begin = now_ns();
+	op->ops     = pydict_parallel_foreach(pydict, bench->thread_num, bench_visit, NULL);
+	op->seconds = (now_ns()-begin)/1e9;
+}
+
+/*
+ * func : sign every key with a signature function, compare with -l
+ */
+static void bench_sign(bench_t* bench, const char* name, int hash)
+{
+	bench_op_t*     op    = bench_op(bench, name, 0);
+	unsigned long   begin = 0;
+	unsigned long   sum   = 0;
+	unsigned long   sign  = 0;
+	unsigned int    i     = 0;
+
+	begin = now_ns();
+	for(i=0;i<bench->key_num;i++){
+		py_sign64_hash(hash, bench->keys[i], bench->lens[i], &sign);
+		sum += sign;
+	}
+	op->ops     = bench->key_num;
+	op->seconds = (now_ns()-begin)/1e9;
+	if(sum==1){ // keep the loop
+		printf(" ");
+	}
+}
+
+/*
+ * func : split a "key\tcode\tvalue" line of every key with split_c, or
+ *        with split_span on the same lines
+ */
+static void bench_split(bench_t* bench, const char* name, int span)
+{
+	bench_op_t*     op    = bench_op(bench, name, 0);
+	split_delim_t   sd;
+	split_span_t    spans[8];
+	char*           items[8];
+	char            line[1024];
+	unsigned long   begin = 0;
+	unsigned long   ns    = 0;
+	unsigned long   sum   = 0;
+	unsigned int    i     = 0;
+	int             len   = 0;
+
+	split_delim_init(&sd, "\t");
+	for(i=0;i<bench->key_num;i++){
+		len = snprintf(line, sizeof(line), "%.*s\t%u\t%u", bench->lens[i], bench->keys[i], i, i*10);
+		if(len >= (int)sizeof(line)){
+			len = sizeof(line)-1;
+		}
+		begin = now_ns();
+		if(span){
+			sum += split_span(line, len, &sd, spans, 8);
+		}
+		else{
+			sum += split_c(line, items, 8, "\t");
+		}
+		ns += now_ns()-begin;
+	}
+	op->ops     = bench->key_num;
+	op->seconds = ns/1e9;
+	if(sum==1){ // keep the loop
+		printf(" ");
+	}
+}
+
+/*
+ * func : 128 bit signatures of every key, then the throughput of finding 
+ *        them in order in a py_dict128_t, compare with find_hit_call
+ */
+static int bench_dict128(bench_t* bench)
+{
+	py_dict128_t*   pydict = NULL;
+	bench_op_t*     op     = NULL;
+	unsigned long   begin  = 0;
+	unsigned long   sum    = 0;
+	unsigned int    found  = 0;
+	unsigned int    i      = 0;
+	int             code   = 0;
+	int             value  = 0;
+	SIGN128         sign;
+
+	op    = bench_op(bench, "sign_128", 0);
+	begin = now_ns();
+	for(i=0;i<bench->key_num;i++){
+		py_sign128_hash(bench->keys[i], bench->lens[i], &sign);
+		sum += sign.sign1;
+	}
+	op->ops     = bench->key_num;
+	op->seconds = (now_ns()-begin)/1e9;
+	if(sum==1){ // keep the loop
+		printf(" ");
+	}
+
+	if((pydict = pydict128_create(bench->hashsize, bench->key_num)) == NULL){
+		return -1;
+	}
+	for(i=0;i<bench->key_num;i++){
+		if(pydict128_add(pydict, bench->keys[i], bench->lens[i], i, i) < 0){
+			pydict128_free(pydict);
+			return -1;
+		}
+	}
+
+	op    = bench_op(bench, "find_hit_128", 0);
+	begin = now_ns();
+	for(i=0;i<bench->key_num;i++){
+		found += pydict128_find(pydict, bench->keys[i], bench->lens[i], &code, &value);
+	}
+	op->ops     = bench->key_num;
+	op->seconds = (now_ns()-begin)/1e9;
+	if(found<bench->key_num){
+		fprintf(stderr, "find_hit_128 : %u of %u keys found\n", found, bench->key_num);
+	}
+	pydict128_free(pydict);
+
+	return 0;
+}
+
+static void bench_del(bench_t* bench, py_dict_t* pydict)
+{
+	bench_op_t*     op    = bench_op(bench, "del", 1);
+	unsigned long   begin = 0;
+	unsigned long   t0    = 0;
+	unsigned long   t1    = 0;
+	unsigned int    i     = 0;
+	unsigned int    k     = 0;
+
+	begin = now_ns();
+	t0    = begin;
+	for(i=0;i<bench->key_num;i++){
+		k = bench->order[i];
+		pydict_del(pydict, bench->keys[k], bench->lens[k]);
+		t1 = now_ns();
+		hist_add(&op->hist, t1-t0);
+		t0 = t1;
+	}
+	op->ops     = bench->key_num;
+	op->seconds = (t0-begin)/1e9;
+}
+
+/*
+ * func : time a single call, save, load, map or build
+ */
+static bench_op_t* bench_once(bench_t* bench, const char* name, unsigned long begin)
+{
+	bench_op_t*   op = bench_op(bench, name, 0);
+
+	op->ops     = 1;
+	op->seconds = (now_ns()-begin)/1e9;
+	return op;
+}
+
+static int bench_run(bench_t* bench)
+{
+	py_dict_t*      pydict = NULL;
+	py_dict_t*      loaded = NULL;
+	unsigned long   begin  = 0;
+	unsigned long   t0     = 0;
+	int             i      = 0;
+
+	// the cost of a timer call, part of every latency
+	t0 = now_ns();
+	for(i=0;i<100000;i++){
+		now_ns();
+	}
+	bench->timer_ns = (now_ns()-t0)/100000.0;
+
+	bench_sign(bench, "sign_murmur", PY_SIGN_MURMUR);
+	bench_sign(bench, "sign_wyhash", PY_SIGN_WYHASH);
+	bench_sign(bench, "sign_roll", PY_SIGN_ROLL);
+	bench_split(bench, "split_c", 0);
+	bench_split(bench, "split_span", 1);
+
+	if((pydict = bench_add(bench)) == NULL){
+		return -1;
+	}
+	bench_find(bench, pydict, "find_hit", 0);
+	bench_find(bench, pydict, "find_miss", 1);
+	bench_find_loop(bench, pydict, "find_hit_call", 0);
+	bench_find_loop(bench, pydict, "find_hit_inline", 1);
+	if(bench_dict128(bench) < 0){
+		goto failed;
+	}
+	bench_iterate(bench, pydict);
+	bench_iterate_parallel(bench, pydict);
+
+	begin = now_ns();
+	if(pydict_save(pydict, "./", BENCH_FILE) < 0){
+		goto failed;
+	}
+	bench_once(bench, "save", begin);
+
+	begin = now_ns();
+	if((loaded = pydict_load("./", BENCH_FILE)) == NULL){
+		goto failed;
+	}
+	bench_once(bench, "load", begin);
+	pydict_free(loaded);
+
+	begin = now_ns();
+	if((loaded = pydict_map("./", BENCH_FILE, PYDICT_MAP_POPULATE)) == NULL){
+		goto failed;
+	}
+	bench_once(bench, "map", begin);
+	pydict_set_layout(loaded, bench->layout);
+	bench_find(bench, loaded, "find_hit_map", 0);
+	pydict_free(loaded);
+
+	if(bench->input){
+		begin = now_ns();
+		if((loaded = pydict_build(bench->input, bench->hashsize, bench->thread_num, NULL)) == NULL){
+			goto failed;
+		}
+		bench_once(bench, "build", begin);
+		pydict_free(loaded);
+	}
+
+	bench_del(bench, pydict);
+	pydict_free(pydict);
+	unlink(BENCH_FILE);
+	return 0;
+
+failed:
+	pydict_free(pydict);
+	unlink(BENCH_FILE);
+	return -1;
+}
+
+static const char* hash_name(bench_t* bench)
+{
+	if(bench->hash==PY_SIGN_ROLL){
+		return "roll";
+	}
+	return bench->hash==PY_SIGN_WYHASH ? "wyhash" : "murmur";
+}
+
+static const char* engine_name(bench_t* bench)
+{
+	if(bench->engine==PYDICT_ENGINE_SWISS){
+		return "swiss";
+	}
+	return bench->layout==PYDICT_LAYOUT_SPLIT ? "split" : "chain";
+}
+
+static void print_json(bench_t* bench, FILE* fp)
+{
+	bench_op_t*   op    = NULL;
+	int           first = 1;
+	int           i     = 0;
+	int           j     = 0;
+
+	fprintf(fp, "{\n  \"config\" : {\"keys\" : %u, \"hashsize\" : %u, \"min_len\" : %d, "
+	        "\"max_len\" : %d, \"engine\" : \"%s\", \"hash\" : \"%s\", \"input\" : \"%s\", "
+	        "\"seed\" : %u, \"timer_ns\" : %.1f},\n  \"results\" : [\n",
+	        bench->key_num, bench->hashsize, bench->min_len, bench->max_len,
+	        engine_name(bench), hash_name(bench),
+	        bench->input ? bench->input : "", bench->seed, bench->timer_ns);
+	for(i=0;i<bench->op_num;i++){
+		op = &bench->ops[i];
+		fprintf(fp, "    {\"op\" : \"%s\", \"ops\" : %lu, \"seconds\" : %.6f, \"mops\" : %.3f",
+		        op->name, op->ops, op->seconds, op->seconds>0 ? op->ops/op->seconds/1e6 : 0);
+		if(op->timed){
+			fprintf(fp, ", \"p50_ns\" : %lu, \"p99_ns\" : %lu, \"p999_ns\" : %lu, \"max_ns\" : %lu, "
+			        "\"histogram\" : [", hist_percentile(&op->hist, 0.5),
+			        hist_percentile(&op->hist, 0.99), hist_percentile(&op->hist, 0.999),
+			        op->hist.max);
+			for(j=0,first=1;j<HIST_SIZE;j++){
+				if(op->hist.count[j]){
+					fprintf(fp, "%s[%lu, %lu]", first ? "" : ", ", hist_value(j), op->hist.count[j]);
+					first = 0;
+				}
+			}
+			fprintf(fp, "]");
+		}
+		fprintf(fp, "}%s\n", i+1<bench->op_num ? "," : "");
+	}
+	fprintf(fp, "  ]\n}\n");
+}
+
+static void print_csv(bench_t* bench, FILE* fp)
+{
+	bench_op_t*   op = NULL;
+	int           i  = 0;
+
+	fprintf(fp, "op,keys,engine,hash,ops,seconds,mops,p50_ns,p99_ns,p999_ns,max_ns\n");
+	for(i=0;i<bench->op_num;i++){
+		op = &bench->ops[i];
+		fprintf(fp, "%s,%u,%s,%s,%lu,%.6f,%.3f,%lu,%lu,%lu,%lu\n", op->name, bench->key_num,
+		        engine_name(bench), hash_name(bench),
+		        op->ops, op->seconds, op->seconds>0 ? op->ops/op->seconds/1e6 : 0,
+		        op->timed ? hist_percentile(&op->hist, 0.5) : 0,
+		        op->timed ? hist_percentile(&op->hist, 0.99) : 0,
+		        op->timed ? hist_percentile(&op->hist, 0.999) : 0,
+		        op->timed ? op->hist.max : 0);
+	}
+}
+
+static void print_table(bench_t* bench)
+{
+	bench_op_t*   op = NULL;
+	int           i  = 0;
+
+	printf("keys %u, hashsize %u, key length %d-%d, engine %s, hash %s, timer %.1fns\n",
+	       bench->key_num, bench->hashsize, bench->min_len, bench->max_len,
+	       engine_name(bench), hash_name(bench), bench->timer_ns);
+	printf("%-16s %10s %10s %8s %8s %8s %8s\n", "op", "ops", "ms", "Mops", "p50", "p99", "p99.9");
+	for(i=0;i<bench->op_num;i++){
+		op = &bench->ops[i];
+		printf("%-16s %10lu %10.3f %8.3f", op->name, op->ops, op->seconds*1e3,
+		       op->seconds>0 ? op->ops/op->seconds/1e6 : 0);
+		if(op->timed){
+			printf(" %8lu %8lu %8lu", hist_percentile(&op->hist, 0.5),
+			       hist_percentile(&op->hist, 0.99), hist_percentile(&op->hist, 0.999));
+		}
+		printf("\n");
+	}
+}
+
+static void usage(const char* prog)
+{
+	fprintf(stderr, "usage : %s [-n num] [-l min[-max]] [-f file] [-s hashsize] "
+	        "[-e chain|swiss|split] [-a libc|huge] [-H murmur|wyhash|roll] [-t threads] [-r seed] [-o file] [-F json|csv]\n", prog);
+}
+
+int main(int argc, char* argv[])
+{
+	bench_t*   bench = NULL;
+	FILE*      fp    = NULL;
+	char*      dash  = NULL;
+	int        opt   = 0;
+	int        ret   = 0;
+
+	bench = (bench_t*)calloc(1, sizeof(bench_t));
+	bench->key_num = 1000000;
+	bench->min_len = 8;
+	bench->max_len = 32;
+	bench->seed    = 1;
+	bench->format  = "json";
+
+	while((opt=getopt(argc, argv, "n:l:f:s:e:a:H:t:r:o:F:h"))!=-1){
+		switch(opt){
+		case 'n':
+			bench->key_num = (unsigned int)strtoul(optarg, NULL, 10);
+			break;
+		case 'l':
+			bench->min_len = atoi(optarg);
+			bench->max_len = bench->min_len;
+			if((dash=strchr(optarg, '-'))!=NULL){
+				bench->max_len = atoi(dash+1);
+			}
+			break;
+		case 'f':
+			bench->input = optarg;
+			break;
+		case 's':
+			bench->hashsize = (unsigned int)strtoul(optarg, NULL, 10);
+			break;
+		case 'e':
+			bench->engine = strcmp(optarg, "swiss")==0 ? PYDICT_ENGINE_SWISS : PYDICT_ENGINE_CHAIN;
+			bench->layout = strcmp(optarg, "split")==0 ? PYDICT_LAYOUT_SPLIT : PYDICT_LAYOUT_NODE;
+			break;
+		case 'a':
+			pyalloc_set(strcmp(optarg, "huge")==0 ? &pyalloc_huge : &pyalloc_libc);
+			break;
+		case 'H':
+			bench->hash = strcmp(optarg, "wyhash")==0 ? PY_SIGN_WYHASH : PY_SIGN_MURMUR;
+			if(strcmp(optarg, "roll")==0){
+				bench->hash = PY_SIGN_ROLL;
+			}
+			py_sign_set_default(bench->hash);
+			break;
+		case 't':
+			bench->thread_num = atoi(optarg);
+			break;
+		case 'r':
+			bench->seed = (unsigned int)strtoul(optarg, NULL, 10);
+			break;
+		case 'o':
+			bench->output = optarg;
+			break;
+		case 'F':
+			bench->format = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if(bench->min_len<=0 || bench->max_len<bench->min_len || bench->key_num==0){
+		usage(argv[0]);
+		return 1;
+	}
+
+	bench->rand = bench->seed;
+	if(make_keys(bench)<0 || bench->key_num==0){
+		fprintf(stderr, "no keys\n");
+		return 1;
+	}
+	if(bench->hashsize==0){
+		bench->hashsize = bench->key_num;
+	}
+
+	if(bench_run(bench)<0){
+		fprintf(stderr, "bench failed\n");
+		ret = 1;
+	}
+	print_table(bench);
+
+	if(bench->output){
+		if((fp=fopen(bench->output, "w"))==NULL){
+			fprintf(stderr, "can not write %s\n", bench->output);
+			ret = 1;
+		}
+		else{
+			if(strcmp(bench->format, "csv")==0){
+				print_csv(bench, fp);
+			}
+			else{
+				print_json(bench, fp);
+			}
+			fclose(fp);
+		}
+	}
+
+	free_keys(bench);
+	free(bench);
+	return ret;
+}
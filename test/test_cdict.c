@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <pthread.h>
+#include <py_dict.h>
+#include "test_util.h"
+#include <py_cdict.h>
+
+// 8 bytes keys, murmur_hash_64 is a bijection on them, no signature collision
+#define KEY_NUM     400000
+#define THREAD_NUM  4
+
+static py_cdict_t* pycdict = NULL;
+
+// each writer adds its own range of keys, and reads back what it added
+static void* writer_thread(void* arg)
+{
+	char   key[64];
+	long   id    = (long)arg;
+	int    len   = 0;
+	int    code  = 0;
+	int    value = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	for(i=id;i<KEY_NUM;i+=THREAD_NUM){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pycdict_add(pycdict, key, len, i, i*10);
+		assert(ret == 0);
+
+		len = snprintf(key, sizeof(key), "%08d", i/2);
+		if(pycdict_find(pycdict, key, len, &code, &value)){
+			assert(code == i/2 && value == (i/2)*10);
+		}
+	}
+
+	return NULL;
+}
+
+static void check_dict(py_dict_t* pydict, py_cdict_t* pycdict)
+{
+	char   key[64];
+	int    len   = 0;
+	int    code  = 0;
+	int    value = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict ? pydict_find(pydict, key, len, &code, &value) 
+			: pycdict_find(pycdict, key, len, &code, &value);
+		assert(ret == (i%5!=0));
+		if(ret){
+			assert(code == i && value == i*10);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	pthread_t      threads[THREAD_NUM];
+	py_dict_t*     pydict  = NULL;
+	py_cdict_t*    loaded  = NULL;
+	PNODE          node;
+	unsigned long  pos     = 0;
+	char   key[64];
+	int    len   = 0;
+	int    count = 0;
+	long   i     = 0;
+	int    ret   = 0;
+
+	pycdict = pycdict_create(8, 1000, 1000);
+	assert(pycdict);
+
+	for(i=0;i<THREAD_NUM;i++){
+		pthread_create(threads+i, NULL, writer_thread, (void*)i);
+	}
+	for(i=0;i<THREAD_NUM;i++){
+		pthread_join(threads[i], NULL);
+	}
+	assert(pycdict_size(pycdict) == KEY_NUM);
+
+	for(i=0;i<KEY_NUM;i+=5){
+		len = snprintf(key, sizeof(key), "%08ld", i);
+		ret = pycdict_del(pycdict, key, len);
+		assert(ret == 1);
+	}
+	check_dict(NULL, pycdict);
+
+	ret = pycdict_first(pycdict, &node, &pos);
+	while(ret){
+		count++;
+		ret = pycdict_next(pycdict, &node, &pos);
+	}
+	assert(count == KEY_NUM - KEY_NUM/5);
+
+	// regular dict file
+	ret = pycdict_save(pycdict, "./", "dictbin_cdict");
+	assert(ret == 0);
+	pydict = pydict_load("./", "dictbin_cdict");
+	assert(pydict);
+	assert(pydict->block_pos == KEY_NUM && pydict->key_max == 8);
+	check_dict(pydict, NULL);
+
+	// deleted nodes are dropped by load
+	loaded = pycdict_load("./", "dictbin_cdict", 4);
+	assert(loaded);
+	assert(pycdict_size(loaded) == KEY_NUM - KEY_NUM/5);
+	assert(loaded->shards[0].pydict->key_max == 8);
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08ld", i);
+		ret = pycdict_find(loaded, key, len, &count, &count);
+		assert(ret == (i%5!=0));
+	}
+
+	pycdict_free(loaded);
+	pycdict_free(pycdict);
+	pydict_free(pydict);
+
+	fprintf(stdout, "test_cdict ok\n");
+
+	return 0;
+}
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <py_dict.h>
+#include "test_util.h"
+#include <py_dict128.h>
+
+#define KEY_NUM 200000
+
+// keys [0, key_num) but i%3==0 are in the dict with code i, the others are not
+static void check(py_dict128_t* pydict, const int key_num)
+{
+	PNODE128*      pnode  = NULL;
+	const char*    keys[100];
+	int            lens[100];
+	int            codes[100];
+	int            values[100];
+	char           found[100];
+	char           buf[100][16];
+	unsigned int   pos    = 0;
+	int            code   = 0;
+	int            value  = 0;
+	int            num    = 0;
+	int            i      = 0;
+	int            j      = 0;
+	int            ret    = 0;
+
+	for(i=0;i<key_num*2;i+=100){
+		for(j=0;j<100;j++){
+			lens[j] = snprintf(buf[j], sizeof(buf[j]), "%08d", i+j);
+			keys[j] = buf[j];
+			ret = pydict128_find(pydict, keys[j], lens[j], &code, &value);
+			assert(ret == (i+j<key_num && (i+j)%3!=0));
+			if(ret){
+				assert(code == i+j && value == (i+j)*10);
+			}
+		}
+		ret = pydict128_find_batch(pydict, keys, lens, 100, codes, values, found);
+		for(j=0;j<100;j++){
+			assert(found[j] == (i+j<key_num && (i+j)%3!=0));
+			if(found[j]){
+				assert(codes[j] == i+j && values[j] == (i+j)*10);
+				num++;
+			}
+		}
+	}
+	assert(num == (int)pydict128_size(pydict));
+
+	// every live node once
+	num = 0;
+	for(pnode=pydict128_first(pydict, &pos);pnode;pnode=pydict128_next(pydict, &pos)){
+		assert(pnode == pydict128_node(pydict, pos) && pnode->code%3!=0);
+		num++;
+	}
+	assert(num == (int)pydict128_size(pydict));
+}
+
+int main()
+{
+	py_dict128_t*  pydict = NULL;
+	py_dict_t*     dict64 = NULL;
+	PNODE128*      pnode  = NULL;
+	SIGN128        sign;
+	SIGN128        other;
+	char           key[64];
+	int            len    = 0;
+	int            i      = 0;
+	int            ret    = 0;
+
+	assert(sizeof(PNODE128) == 32 && sizeof(pydict128_head_t) == 64);
+
+	// MurmurHash3_x64_128, one pass
+	py_sign128_hash("The quick brown fox jumps over the lazy dog", 43, &sign);
+	assert(sign.sign1 == 0xe34bbc7bbc071b6cUL && sign.sign2 == 0x7a433ca9c49a9347UL);
+	py_sign128_hash("", 0, &sign);
+	assert(sign.sign1 == 0 && sign.sign2 == 0);
+	py_sign128(key, 0, &other);
+	assert(other.sign1 == 0 && other.sign2 == 0);
+
+	// a small table grows
+	pydict = pydict128_create(10, 100);
+	assert(pydict && pydict->hashsize == PYDICT128_HASH_MIN);
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict128_add(pydict, key, len, i+1, i);
+		assert(ret == 0);
+	}
+	assert(pydict->hashsize >= KEY_NUM && ((unsigned long)pydict128_node(pydict, 1) & 31) == 0);
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict128_add(pydict, key, len, i, i*10);
+		assert(ret == 1);
+	}
+
+	// deleted nodes are reused
+	for(i=0;i<KEY_NUM;i+=3){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict128_del(pydict, key, len);
+		assert(ret == 1);
+		ret = pydict128_del(pydict, key, len);
+		assert(ret == 0);
+	}
+	for(i=KEY_NUM*3;i<KEY_NUM*3+1000;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict128_add(pydict, key, len, i, i);
+		assert(ret == 0);
+		ret = pydict128_del(pydict, key, len);
+		assert(ret == 1);
+	}
+	assert(pydict->block_pos == KEY_NUM);
+	check(pydict, KEY_NUM);
+
+	// two signatures with the same sign2 chain in one bucket
+	sign.sign1  = 1;
+	sign.sign2  = 7;
+	other.sign1 = 2;
+	other.sign2 = 7;
+	ret = pydict128_add_node(pydict, &sign, 1, 1);
+	assert(ret == 0);
+	ret = pydict128_add_node(pydict, &other, 2, 2);
+	assert(ret == 0);
+	pnode = pydict128_find_node(pydict, &sign);
+	assert(pnode && pnode->code == 1);
+	ret = pydict128_del_node(pydict, &other);
+	assert(ret == 1);
+	pnode = pydict128_find_node(pydict, &other);
+	assert(pnode == NULL);
+	ret = pydict128_del_node(pydict, &sign);
+	assert(ret == 1);
+
+	// the file keeps the free list, a mapped dict is read only
+	ret = pydict128_save(pydict, "./", "dictbin_128");
+	assert(ret == 0);
+	pydict128_free(pydict);
+
+	pydict = pydict128_load("./", "dictbin_128");
+	assert(pydict);
+	check(pydict, KEY_NUM);
+	len = snprintf(key, sizeof(key), "%08d", KEY_NUM*5);
+	ret = pydict128_add(pydict, key, len, 0, 0);
+	assert(ret == 0 && pydict->block_pos == KEY_NUM);
+	pydict128_free(pydict);
+
+	pydict = pydict128_map("./", "dictbin_128", PYDICT_MAP_POPULATE);
+	assert(pydict && ((unsigned long)pydict128_node(pydict, 0) & 31) == 0);
+	check(pydict, KEY_NUM);
+	ret = pydict128_add(pydict, key, len, 0, 0);
+	assert(ret == -1);
+	ret = pydict128_del(pydict, "00000001", 8);
+	assert(ret == -1);
+	pydict128_free(pydict);
+
+	// the file formats do not mix
+	dict64 = pydict_load("./", "dictbin_128");
+	assert(dict64 == NULL);
+	dict64 = pydict_map("./", "dictbin_128", 0);
+	assert(dict64 == NULL);
+	dict64 = pydict_create(100, 100);
+	assert(dict64);
+	ret = pydict_save(dict64, "./", "dictbin_128");
+	assert(ret == 0);
+	pydict_free(dict64);
+	pydict = pydict128_load("./", "dictbin_128");
+	assert(pydict == NULL);
+	pydict = pydict128_map("./", "dictbin_128", 0);
+	assert(pydict == NULL);
+	remove("./dictbin_128");
+
+	printf("test_pdict128 ok\n");
+	return 0;
+}
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <py_dict.h>
+#include "test_util.h"
+#include <py_build.h>
+#include <py_alloc.h>
+
+// 8 bytes keys, murmur_hash_64 is a bijection on them, no signature collision
+#define KEY_NUM 300000
+#define INPUT   "./dictbin_alloc.txt"
+
+// a counting allocator, sizes given back to free must match the allocations
+typedef struct _count{
+	long   live;        // bytes allocated and not freed
+	long   calls;
+}count_t;
+
+static void* count_alloc(size_t size, void* ctx)
+{
+	count_t*  count = (count_t*)ctx;
+	void*     ptr   = NULL;
+
+	count->live += size;
+	count->calls++;
+	if(posix_memalign(&ptr, 64, size>0 ? size : 1) != 0){
+		return NULL;
+	}
+	return ptr;
+}
+
+static void* count_realloc(void* ptr, size_t old_size, size_t size, void* ctx)
+{
+	count_t*  count = (count_t*)ctx;
+
+	count->live += (long)size-(long)old_size;
+	count->calls++;
+	return realloc(ptr, size);
+}
+
+static void count_free(void* ptr, size_t size, void* ctx)
+{
+	count_t*  count = (count_t*)ctx;
+
+	count->live -= size;
+	count->calls++;
+	free(ptr);
+}
+
+// growth, rehash, delete, compact, layouts and engines of a dict
+static py_dict_t* make_dict()
+{
+	py_dict_t*   pydict = NULL;
+	char         key[64];
+	int          len    = 0;
+	int          i      = 0;
+	int          ret    = 0;
+
+	pydict = pydict_create(1000, 1000);
+	assert(pydict);
+	ret = pydict_set_layout(pydict, PYDICT_LAYOUT_SPLIT);
+	assert(ret == 0);
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	for(i=0;i<KEY_NUM/2;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_del(pydict, key, len);
+		assert(ret == 1);
+	}
+	ret = pydict_compact(pydict);
+	assert(ret == KEY_NUM/2);
+	check_range(pydict, KEY_NUM/2, KEY_NUM, KEY_NUM);
+
+	ret = pydict_set_engine(pydict, PYDICT_ENGINE_SWISS);
+	assert(ret == 0);
+	ret = pydict_save(pydict, "./", "dictbin_alloc");
+	assert(ret == 0);
+	ret = pydict_set_engine(pydict, PYDICT_ENGINE_CHAIN);
+	assert(ret == 0);
+	check_range(pydict, KEY_NUM/2, KEY_NUM, KEY_NUM);
+
+	return pydict;
+}
+
+static void test_hook()
+{
+	count_t      count  = {0, 0};
+	py_alloc_t   alloc  = {count_alloc, count_realloc, count_free, &count};
+	py_dict_t*   pydict = NULL;
+	FILE*        fp     = NULL;
+	int          i      = 0;
+	int          ret    = 0;
+
+	pyalloc_set(&alloc);
+
+	pydict = make_dict();
+	pydict_free(pydict);
+	assert(count.calls > 0 && count.live == 0);
+
+	pydict = pydict_load("./", "dictbin_alloc");
+	assert(pydict);
+	check_range(pydict, KEY_NUM/2, KEY_NUM, KEY_NUM);
+	pydict_free(pydict);
+
+	pydict = pydict_map("./", "dictbin_alloc", 0);
+	assert(pydict);
+	ret = pydict_set_layout(pydict, PYDICT_LAYOUT_SPLIT);
+	assert(ret == 0);
+	check_range(pydict, KEY_NUM/2, KEY_NUM, KEY_NUM);
+	pydict_free(pydict);
+
+	fp = fopen(INPUT, "w");
+	assert(fp);
+	for(i=KEY_NUM/2;i<KEY_NUM;i++){
+		fprintf(fp, "%08d\t%d\t%d\n", i, i, i*10);
+	}
+	fclose(fp);
+	pydict = pydict_build(INPUT, 0, 2, NULL);
+	assert(pydict);
+	check_range(pydict, KEY_NUM/2, KEY_NUM, KEY_NUM);
+	pydict_free(pydict);
+	remove(INPUT);
+
+	assert(count.live == 0);
+	pyalloc_set(NULL);
+}
+
+static void test_huge()
+{
+	py_dict_t*   pydict = NULL;
+	char*        ptr    = NULL;
+	size_t       i      = 0;
+
+	// across the threshold and back, the content is kept
+	ptr = (char*)pyalloc_alloc(&pyalloc_huge, 1000);
+	assert(ptr);
+	memset(ptr, 1, 1000);
+	ptr = (char*)pyalloc_realloc(&pyalloc_huge, ptr, 1000, 3*PYALLOC_HUGE_PAGE);
+	assert(ptr && ((size_t)ptr & (PYALLOC_HUGE_PAGE-1)) == 0);
+	for(i=0;i<1000;i++){
+		assert(ptr[i] == 1);
+	}
+	memset(ptr, 2, 3*PYALLOC_HUGE_PAGE);
+	ptr = (char*)pyalloc_realloc(&pyalloc_huge, ptr, 3*PYALLOC_HUGE_PAGE, 9*PYALLOC_HUGE_PAGE);
+	assert(ptr && ((size_t)ptr & (PYALLOC_HUGE_PAGE-1)) == 0);
+	assert(ptr[0] == 2 && ptr[3*PYALLOC_HUGE_PAGE-1] == 2);
+	ptr = (char*)pyalloc_realloc(&pyalloc_huge, ptr, 9*PYALLOC_HUGE_PAGE, 100);
+	assert(ptr && ptr[99] == 2);
+	pyalloc_free(&pyalloc_huge, ptr, 100);
+
+	// node segments of a dict start at a huge page
+	pyalloc_set(&pyalloc_huge);
+	pydict = make_dict();
+	assert(((size_t)pydict->segs[0] & (PYALLOC_HUGE_PAGE-1)) == 0);
+	pydict_free(pydict);
+	pydict = pydict_load("./", "dictbin_alloc");
+	assert(pydict);
+	check_range(pydict, KEY_NUM/2, KEY_NUM, KEY_NUM);
+	pydict_free(pydict);
+	pyalloc_set(NULL);
+}
+
+int main()
+{
+	test_hook();
+	test_huge();
+	remove("./dictbin_alloc");
+
+	printf("test_pdict_alloc ok\n");
+	return 0;
+}
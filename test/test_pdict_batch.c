@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <sys/time.h>
+#include <py_dict.h>
+#include "test_util.h"
+
+#define KEY_NUM   1000000
+#define BATCH_NUM 256
+
+static char   keybuf[BATCH_NUM][16];
+static const char* keys[BATCH_NUM];
+static int    lens[BATCH_NUM];
+static int    codes[BATCH_NUM];
+static int    values[BATCH_NUM];
+static int    found[BATCH_NUM];
+
+static double now_ms()
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec*1000.0 + tv.tv_usec/1000.0;
+}
+
+// compare batch find with single find, half of the keys are misses
+static void check_batch(py_dict_t* pydict, const char* name)
+{
+	int    code  = 0;
+	int    value = 0;
+	int    num   = 0;
+	int    i     = 0;
+	int    j     = 0;
+	double t1    = 0;
+	double t2    = 0;
+	double t3    = 0;
+	int    ret   = 0;
+
+	srand(1);
+	t1 = now_ms();
+	for(i=0;i<KEY_NUM*2;i+=BATCH_NUM){
+		for(j=0;j<BATCH_NUM;j++){
+			lens[j] = snprintf(keybuf[j], sizeof(keybuf[j]), "%08d", rand()%(KEY_NUM*2));
+		}
+		num = pydict_find_batch(pydict, keys, lens, BATCH_NUM, codes, values, found);
+		for(j=0;j<BATCH_NUM;j++){
+			ret = pydict_find(pydict, keys[j], lens[j], &code, &value);
+			assert(ret == found[j]);
+			if(found[j]){
+				assert(code == codes[j] && value == values[j]);
+				num--;
+			}
+		}
+		assert(num == 0);
+	}
+
+	// timing, batch against single
+	srand(2);
+	t2 = now_ms();
+	for(i=0;i<KEY_NUM*2;i+=BATCH_NUM){
+		for(j=0;j<BATCH_NUM;j++){
+			lens[j] = snprintf(keybuf[j], sizeof(keybuf[j]), "%08d", rand()%(KEY_NUM*2));
+		}
+		pydict_find_batch(pydict, keys, lens, BATCH_NUM, codes, values, found);
+	}
+	t3 = now_ms();
+	for(i=0;i<KEY_NUM*2;i+=BATCH_NUM){
+		for(j=0;j<BATCH_NUM;j++){
+			lens[j] = snprintf(keybuf[j], sizeof(keybuf[j]), "%08d", rand()%(KEY_NUM*2));
+			found[j] = pydict_find(pydict, keys[j], lens[j], codes+j, values+j);
+		}
+	}
+	fprintf(stdout, "%s: batch %.1f ms, single %.1f ms (check %.1f ms)\n", 
+			name, t3-t2, now_ms()-t3, t2-t1);
+}
+
+int main(int argc, char* argv[])
+{
+	py_dict_t* pydict = NULL;
+	char   key[64];
+	int    len   = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	for(i=0;i<BATCH_NUM;i++){
+		keys[i] = keybuf[i];
+	}
+
+	pydict = pydict_create(KEY_NUM/4, KEY_NUM);
+	assert(pydict);
+	pydict_set_max_load(pydict, 0);
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	check_batch(pydict, "chain");
+
+	ret = pydict_set_engine(pydict, PYDICT_ENGINE_SWISS);
+	assert(ret == 0);
+	check_batch(pydict, "swiss");
+
+	// rehashing
+	ret = pydict_set_engine(pydict, PYDICT_ENGINE_CHAIN);
+	assert(ret == 0);
+	pydict_set_max_load(pydict, 1.0);
+	len = snprintf(key, sizeof(key), "%08d", KEY_NUM*3);
+	ret = pydict_add(pydict, key, len, 1, 1);
+	assert(ret == 0);
+	assert(pydict->oldtab);
+	check_batch(pydict, "rehash");
+
+	pydict_free(pydict);
+
+	fprintf(stdout, "test_pdict_batch ok\n");
+
+	return 0;
+}
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <py_dict.h>
+#include "test_util.h"
+
+// 8 bytes keys, murmur_hash_64 is a bijection on them, no signature collision
+#define KEY_NUM 100000
+
+// the blob of key i, 0 to 299 bytes
+static int make_blob(int i, int round, char* blob)
+{
+	int   len = (i*7+round)%300;
+	int   j   = 0;
+
+	for(j=0;j<len;j++){
+		blob[j] = (char)(i+j+round);
+	}
+	return len;
+}
+
+// keys [0, KEY_NUM) are in the dict with blobs of round, the others are not
+static void check(py_dict_t* pydict, int round)
+{
+	const char*    blob     = NULL;
+	unsigned int   blob_len = 0;
+	char           want[512];
+	char           key[64];
+	int            want_len = 0;
+	int            len      = 0;
+	int            code     = 0;
+	int            i        = 0;
+	int            ret      = 0;
+
+	for(i=0;i<KEY_NUM*2;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_find_blob(pydict, key, len, &code, &blob, &blob_len);
+		assert(ret == (i<KEY_NUM));
+		if(ret){
+			want_len = make_blob(i, round, want);
+			assert(code == i && blob_len == (unsigned int)want_len);
+			assert(memcmp(blob, want, want_len) == 0 && blob[want_len] == '\0');
+			assert(((blob-pydict->blob) & (PYDICT_BLOB_ALIGN-1)) == 0);
+		}
+	}
+}
+
+static void add_all(py_dict_t* pydict, int round, int expect)
+{
+	char   blob[512];
+	char   key[64];
+	int    blob_len = 0;
+	int    len      = 0;
+	int    i        = 0;
+	int    ret      = 0;
+
+	for(i=0;i<KEY_NUM;i++){
+		len      = snprintf(key, sizeof(key), "%08d", i);
+		blob_len = make_blob(i, round, blob);
+		ret = pydict_add_blob(pydict, key, len, i, blob, blob_len);
+		assert(ret == expect);
+	}
+}
+
+int main()
+{
+	py_dict_t*       pydict   = NULL;
+	PNODE*           pnode    = NULL;
+	const char*      blob     = NULL;
+	unsigned int     blob_len = 0;
+	unsigned int     pos      = 0;
+	pydict_stats_t   stats;
+	size_t           size     = 0;
+	int              code     = 0;
+	int              num      = 0;
+	int              ret      = 0;
+
+	pydict = pydict_create(KEY_NUM, 1000);
+	assert(pydict);
+	add_all(pydict, 0, 0);
+	check(pydict, 0);
+
+	// changed blobs take new records, old pointers are not used again
+	add_all(pydict, 1, 1);
+	check(pydict, 1);
+	pydict_stats(pydict, &stats);
+	assert(stats.blob_size == pydict->blob_size && stats.bytes > stats.blob_size);
+
+	// a plain value is not a blob
+	ret = pydict_add(pydict, "plain", 5, 1, -1);
+	assert(ret == 0);
+	ret = pydict_find_blob(pydict, "plain", 5, &code, &blob, &blob_len);
+	assert(ret == -1);
+	ret = pydict_del(pydict, "plain", 5);
+	assert(ret == 1);
+	ret = pydict_add_blob(pydict, "null", 4, 1, NULL, 10);
+	assert(ret == -1);
+	ret = pydict_add_blob(pydict, "null", 4, 1, NULL, 0);
+	assert(ret == 0);
+	ret = pydict_find_blob(pydict, "null", 4, &code, &blob, &blob_len);
+	assert(ret == 1 && blob_len == 0 && blob[0] == '\0');
+	ret = pydict_del(pydict, "null", 4);
+	assert(ret == 1);
+
+	// iterating, the layouts and engines keep the values
+	for(pnode=pydict_first(pydict, &pos);pnode;pnode=pydict_next(pydict, (int*)&pos)){
+		blob = pydict_blob(pydict, pnode, &blob_len);
+		assert(blob);
+		num++;
+	}
+	assert(num == KEY_NUM);
+	ret = pydict_compact(pydict);
+	assert(ret >= 0);
+	ret = pydict_set_engine(pydict, PYDICT_ENGINE_SWISS);
+	assert(ret == 0);
+	check(pydict, 1);
+
+	// one file, the arena is loaded or stays in the mapping
+	ret = pydict_save(pydict, "./", "dictbin_blob");
+	assert(ret == 0);
+	size = pydict->blob_size;
+	pydict_free(pydict);
+
+	pydict = pydict_load("./", "dictbin_blob");
+	assert(pydict && pydict->blob_size == size);
+	check(pydict, 1);
+	add_all(pydict, 2, 1);
+	check(pydict, 2);
+	pydict_free(pydict);
+
+	pydict = pydict_map("./", "dictbin_blob", 0);
+	assert(pydict && pydict->blob_size == size);
+	assert(pydict->blob > (char*)pydict->map_addr &&
+	       pydict->blob+size <= (char*)pydict->map_addr+pydict->map_size);
+	check(pydict, 1);
+	ret = pydict_add_blob(pydict, "mapped", 6, 1, "x", 1);
+	assert(ret == -1);
+	pydict_free(pydict);
+
+	// a dict without blobs has no section
+	pydict = pydict_create(100, 100);
+	assert(pydict);
+	ret = pydict_add(pydict, "plain", 5, 1, 2);
+	assert(ret == 0);
+	ret = pydict_save(pydict, "./", "dictbin_blob");
+	assert(ret == 0);
+	pydict_free(pydict);
+	pydict = pydict_map("./", "dictbin_blob", 0);
+	assert(pydict && pydict->blob == NULL && pydict->blob_size == 0);
+	pydict_free(pydict);
+	remove("./dictbin_blob");
+
+	printf("test_pdict_blob ok\n");
+	return 0;
+}
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <py_dict.h>
+#include "test_util.h"
+#include <py_build.h>
+
+// 8 bytes keys, murmur_hash_64 is a bijection on them, no signature collision
+#define KEY_NUM 100000
+#define INPUT   "./dictbin_build.txt"
+
+// every key once, every 7th key again later with a new code, some bad 
+// lines, a "\r\n" line and no '\n' after the last line
+static void make_input()
+{
+	FILE*  fp = NULL;
+	int    i  = 0;
+
+	fp = fopen(INPUT, "w");
+	assert(fp);
+	for(i=0;i<KEY_NUM;i++){
+		fprintf(fp, "%08d\t%d\t%d\n", i, i, i*10);
+		if(i%1000==0){
+			fprintf(fp, "bad line\n\n");
+		}
+	}
+	for(i=0;i<KEY_NUM;i+=7){
+		fprintf(fp, "%08d\t\t%d\t%d\r\n", i, -i, i*20);
+	}
+	fprintf(fp, "%08d\t%d\t%d", KEY_NUM, KEY_NUM, KEY_NUM*10);
+	fclose(fp);
+}
+
+static void check_dict(py_dict_t* pydict)
+{
+	char   key[64];
+	int    len   = 0;
+	int    code  = 0;
+	int    value = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	for(i=0;i<=KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_find(pydict, key, len, &code, &value);
+		assert(ret == 1);
+		if(i%7==0 && i<KEY_NUM){
+			assert(code == -i && value == i*20);
+		}
+		else{
+			assert(code == i && value == i*10);
+		}
+	}
+	len = snprintf(key, sizeof(key), "%08d", KEY_NUM+1);
+	ret = pydict_find(pydict, key, len, &code, &value);
+	assert(ret == 0);
+}
+
+static void test_threads(int thread_num, unsigned int hashsize)
+{
+	py_dict_t*     pydict = NULL;
+	build_stat_t   stat;
+	int            ret    = 0;
+
+	pydict = pydict_build(INPUT, hashsize, thread_num, &stat);
+	assert(pydict);
+	assert(stat.node_num == KEY_NUM+1);
+	assert(stat.bad_num == KEY_NUM/1000);
+	assert(stat.line_num == KEY_NUM+1 + (KEY_NUM+6)/7 + KEY_NUM/1000);
+	assert(pydict->block_pos == KEY_NUM+1);
+	if(hashsize){
+		assert(pydict->hashsize == hashsize);
+	}
+	check_dict(pydict);
+
+	// built dicts take updates like any other
+	ret = pydict_add(pydict, "00000001", 8, 5, 50);
+	assert(ret == 1);
+	ret = pydict_add(pydict, "new key", 7, 5, 50);
+	assert(ret == 0);
+	pydict_free(pydict);
+}
+
+int main()
+{
+	py_dict_t*     pydict = NULL;
+	build_stat_t   stat;
+	int            ret    = 0;
+
+	make_input();
+
+	test_threads(1, 0);
+	test_threads(3, 1000);
+	test_threads(8, 20011);
+	test_threads(0, 0);
+
+	ret = pydict_build_file(INPUT, 0, 4, "./", "dictbin_build", &stat);
+	assert(ret == 0);
+	pydict = pydict_load("./", "dictbin_build");
+	assert(pydict);
+	check_dict(pydict);
+	pydict_free(pydict);
+
+	pydict = pydict_build("./no_such_file", 0, 4, &stat);
+	assert(pydict == NULL);
+
+	printf("test_pdict_build ok\n");
+	return 0;
+}
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <py_dict.h>
+#include "test_util.h"
+
+// 8 bytes keys, murmur_hash_64 is a bijection on them, no signature collision
+#define KEY_NUM 200000
+
+static void test_engine(int engine, float max_load)
+{
+	py_dict_t*   pydict = NULL;
+	PNODE*       pnode  = NULL;
+	unsigned int pos    = 0;
+	char   key[64];
+	int    len   = 0;
+	int    count = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	pydict = pydict_create(KEY_NUM/8, 1000);
+	assert(pydict);
+	pydict_set_max_load(pydict, max_load);
+	ret = pydict_set_engine(pydict, engine);
+	assert(ret == 0);
+
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+
+	// delete the first half, twice
+	for(i=0;i<KEY_NUM/2;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_del(pydict, key, len);
+		assert(ret == 1);
+		ret = pydict_del(pydict, key, len);
+		assert(ret == 0);
+	}
+	assert(pydict->free_num == KEY_NUM/2);
+	check_range(pydict, KEY_NUM/2, KEY_NUM, KEY_NUM*2);
+
+	// deleted nodes are reused
+	for(i=KEY_NUM;i<KEY_NUM+KEY_NUM/2;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	assert(pydict->block_pos == KEY_NUM && pydict->free_num == 0);
+	check_range(pydict, KEY_NUM/2, KEY_NUM+KEY_NUM/2, KEY_NUM*2);
+
+	// compact after deleting the middle
+	for(i=KEY_NUM/2;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_del(pydict, key, len);
+		assert(ret == 1);
+	}
+	for(pnode=pydict_first(pydict, &pos);pnode;pnode=pydict_next(pydict, (int*)&pos)){
+		count++;
+	}
+	assert(count == KEY_NUM/2);
+
+	ret = pydict_compact(pydict);
+	assert(ret == KEY_NUM/2);
+	assert(pydict->block_pos == KEY_NUM/2 && pydict->free_head == COMMON_NULL);
+	check_range(pydict, KEY_NUM, KEY_NUM+KEY_NUM/2, KEY_NUM*2);
+
+	// a saved dict keeps its free nodes out of the chains
+	len = snprintf(key, sizeof(key), "%08d", KEY_NUM);
+	ret = pydict_del(pydict, key, len);
+	assert(ret == 1);
+	ret = pydict_save(pydict, "./", "dictbin_del");
+	assert(ret == 0);
+	pydict_free(pydict);
+
+	pydict = pydict_load("./", "dictbin_del");
+	assert(pydict && pydict->free_num == 1);
+	check_range(pydict, KEY_NUM+1, KEY_NUM+KEY_NUM/2, KEY_NUM*2);
+
+	// and reuses them after a load
+	pos = pydict->block_pos;
+	len = snprintf(key, sizeof(key), "%08d", KEY_NUM*2);
+	ret = pydict_add(pydict, key, len, 1, 10);
+	assert(ret == 0 && pydict->block_pos == pos && pydict->free_num == 0);
+	check_range(pydict, KEY_NUM+1, KEY_NUM+KEY_NUM/2, KEY_NUM*2);
+	ret = pydict_del(pydict, key, len);
+	assert(ret == 1);
+	ret = pydict_compact(pydict);
+	assert(ret == 1);
+	check_range(pydict, KEY_NUM+1, KEY_NUM+KEY_NUM/2, KEY_NUM*2);
+
+	pydict_free(pydict);
+}
+
+int main(int argc, char* argv[])
+{
+	test_engine(PYDICT_ENGINE_CHAIN, 0);
+	test_engine(PYDICT_ENGINE_CHAIN, 1.0);   // deletes while rehashing
+	test_engine(PYDICT_ENGINE_SWISS, 0);
+
+	fprintf(stdout, "test_pdict_del ok\n");
+
+	return 0;
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <py_dict.h>
+#include "test_util.h"
+#include <py_frozen.h>
+
+// 8 bytes keys, murmur_hash_64 is a bijection on them, no signature collision
+#define KEY_NUM 300000
+
+static void check_frozen(py_frozen_t* pyfrozen)
+{
+	char   key[64];
+	int    len   = 0;
+	int    code  = 0;
+	int    value = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	assert(pyfrozen->head.key_num == KEY_NUM-KEY_NUM/10);
+	for(i=0;i<KEY_NUM*2;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pyfrozen_find(pyfrozen, key, len, &code, &value);
+		if(i>=KEY_NUM || i%10==0){ // never added or deleted
+			assert(ret == 0);
+		}
+		else{
+			assert(ret == 1);
+			assert(code == i && value == i*10);
+		}
+	}
+}
+
+int main()
+{
+	py_dict_t*     pydict   = NULL;
+	py_frozen_t*   pyfrozen = NULL;
+	char   key[64];
+	int    len   = 0;
+	int    code  = 0;
+	int    value = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	pydict = pydict_create(KEY_NUM, KEY_NUM);
+	assert(pydict);
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	for(i=0;i<KEY_NUM;i+=10){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_del(pydict, key, len);
+		assert(ret == 1);
+	}
+
+	pyfrozen = pyfrozen_freeze(pydict);
+	assert(pyfrozen);
+	check_frozen(pyfrozen);
+	ret = pyfrozen_save(pyfrozen, "./", "dictbin_frozen");
+	assert(ret == 0);
+	printf("frozen : %u keys, %u slots, %u buckets, %.2f bytes a key\n",
+	       pyfrozen->head.key_num, pyfrozen->head.slot_num, pyfrozen->head.bucket_num,
+	       (double)pyfrozen->data_size/pyfrozen->head.key_num);
+	pyfrozen_free(pyfrozen);
+
+	pyfrozen = pyfrozen_load("./", "dictbin_frozen");
+	assert(pyfrozen);
+	check_frozen(pyfrozen);
+	pyfrozen_free(pyfrozen);
+
+	pyfrozen = pyfrozen_map("./", "dictbin_frozen", PYDICT_MAP_WILLNEED);
+	assert(pyfrozen);
+	check_frozen(pyfrozen);
+	pyfrozen_free(pyfrozen);
+
+	// a dict file is not a frozen file
+	ret = pydict_save(pydict, "./", "dictbin_frozen_dict");
+	assert(ret == 0);
+	pyfrozen = pyfrozen_load("./", "dictbin_frozen_dict");
+	assert(pyfrozen == NULL);
+	pyfrozen = pyfrozen_map("./", "dictbin_frozen_dict", 0);
+	assert(pyfrozen == NULL);
+
+	// an empty dict freezes to an empty frozen dict
+	pydict_reset(pydict);
+	pyfrozen = pyfrozen_freeze(pydict);
+	assert(pyfrozen);
+	assert(pyfrozen->head.key_num == 0);
+	ret = pyfrozen_find(pyfrozen, "00000001", 8, &code, &value);
+	assert(ret == 0);
+	pyfrozen_free(pyfrozen);
+	pydict_free(pydict);
+
+	printf("test_pdict_frozen ok\n");
+	return 0;
+}
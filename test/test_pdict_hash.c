@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <py_dict.h>
+#include "test_util.h"
+#include <py_build.h>
+#include <py_cdict.h>
+#include <py_frozen.h>
+#include <py_wal.h>
+
+#define KEY_NUM 50000
+#define INPUT   "./dictbin_hash.txt"
+
+// keys [0, KEY_NUM) are in the dict with code i, the others are not
+static void check_dict(py_dict_t* pydict)
+{
+	char   key[64];
+	int    len   = 0;
+	int    code  = 0;
+	int    value = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	for(i=0;i<KEY_NUM*2;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_find(pydict, key, len, &code, &value);
+		assert(ret == (i<KEY_NUM));
+		if(ret){
+			assert(code == i && value == i*10);
+		}
+	}
+}
+
+static py_dict_t* make_dict()
+{
+	py_dict_t*   pydict = NULL;
+	char         key[64];
+	int          len    = 0;
+	int          i      = 0;
+	int          ret    = 0;
+
+	pydict = pydict_create(KEY_NUM, 1000);
+	assert(pydict);
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	return pydict;
+}
+
+static void test_sign()
+{
+	unsigned long   sign  = 0;
+	unsigned long   prev  = 0;
+	unsigned int    sign1 = 0;
+	unsigned int    sign2 = 0;
+	char            buf[256];
+	int             i     = 0;
+
+	// wyhash final 4, seed 0
+	py_sign64_hash(PY_SIGN_WYHASH, "", 0, &sign);
+	assert(sign == 0x93228a4de0eec5a2ul);
+
+	// murmur is py_sign64
+	py_sign64_hash(PY_SIGN_MURMUR, "hello", 5, &sign);
+	py_sign64("hello", 5, &prev);
+	assert(sign == prev);
+
+	// every length path, the split is the same signature
+	memset(buf, 'x', sizeof(buf));
+	for(i=1;i<(int)sizeof(buf);i++){
+		py_sign64_hash(PY_SIGN_WYHASH, buf, i, &sign);
+		assert(sign != prev);
+		prev = sign;
+		py_sign64_double_int_hash(PY_SIGN_WYHASH, buf, i, &sign1, &sign2);
+		assert(sign1 == (unsigned int)(sign>>32) && sign2 == (unsigned int)sign);
+	}
+}
+
+static void test_dict()
+{
+	py_dict_t*   pydict = NULL;
+	FILE*        fp     = NULL;
+	long         size   = 0;
+	int          ret    = 0;
+
+	ret = py_sign_set_default(PY_SIGN_NUM);
+	assert(ret == -1);
+	ret = py_sign_set_default(PY_SIGN_WYHASH);
+	assert(ret == 0);
+
+	// the function is kept in the file
+	pydict = make_dict();
+	assert(pydict->hash == PY_SIGN_WYHASH);
+	check_dict(pydict);
+	ret = pydict_set_hash(pydict, PY_SIGN_MURMUR);
+	assert(ret == -1);
+	ret = pydict_save(pydict, "./", "dictbin_hash");
+	assert(ret == 0);
+	pydict_free(pydict);
+
+	py_sign_set_default(PY_SIGN_MURMUR);
+	pydict = pydict_load("./", "dictbin_hash");
+	assert(pydict && pydict->hash == PY_SIGN_WYHASH);
+	check_dict(pydict);
+	pydict_free(pydict);
+	pydict = pydict_map("./", "dictbin_hash", 0);
+	assert(pydict && pydict->hash == PY_SIGN_WYHASH);
+	check_dict(pydict);
+	pydict_free(pydict);
+
+	// a file without the footer is murmur
+	pydict = make_dict();
+	assert(pydict->hash == PY_SIGN_MURMUR);
+	ret = pydict_save(pydict, "./", "dictbin_hash");
+	assert(ret == 0);
+	pydict_free(pydict);
+	fp = fopen("./dictbin_hash", "r+");
+	assert(fp);
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fclose(fp);
+	ret = truncate("./dictbin_hash", size-sizeof(pydict_footer_t));
+	assert(ret == 0);
+	py_sign_set_default(PY_SIGN_WYHASH);
+	pydict = pydict_load("./", "dictbin_hash");
+	assert(pydict && pydict->hash == PY_SIGN_MURMUR);
+	check_dict(pydict);
+	pydict_free(pydict);
+
+	// an empty dict may switch
+	pydict = pydict_create(KEY_NUM, 1000);
+	assert(pydict && pydict->hash == PY_SIGN_WYHASH);
+	ret = pydict_set_hash(pydict, PY_SIGN_MURMUR);
+	assert(ret == 0);
+	pydict_free(pydict);
+
+	py_sign_set_default(PY_SIGN_MURMUR);
+	remove("./dictbin_hash");
+}
+
+static void test_others()
+{
+	py_dict_t*     pydict  = NULL;
+	py_cdict_t*    pycdict = NULL;
+	py_frozen_t*   frozen  = NULL;
+	py_wal_t*      pywal   = NULL;
+	FILE*          fp      = NULL;
+	char           key[64];
+	int            len     = 0;
+	int            code    = 0;
+	int            value   = 0;
+	int            i       = 0;
+	int            ret     = 0;
+
+	py_sign_set_default(PY_SIGN_WYHASH);
+
+	// builder
+	fp = fopen(INPUT, "w");
+	assert(fp);
+	for(i=0;i<KEY_NUM;i++){
+		fprintf(fp, "%08d\t%d\t%d\n", i, i, i*10);
+	}
+	fclose(fp);
+	pydict = pydict_build(INPUT, 0, 2, NULL);
+	assert(pydict && pydict->hash == PY_SIGN_WYHASH);
+	check_dict(pydict);
+	remove(INPUT);
+
+	// frozen, saved and found under the other default
+	frozen = pyfrozen_freeze(pydict);
+	assert(frozen);
+	ret = pyfrozen_save(frozen, "./", "dictbin_hash_frozen");
+	assert(ret == 0);
+	pyfrozen_free(frozen);
+	pydict_free(pydict);
+	py_sign_set_default(PY_SIGN_MURMUR);
+	frozen = pyfrozen_load("./", "dictbin_hash_frozen");
+	assert(frozen);
+	for(i=0;i<KEY_NUM*2;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pyfrozen_find(frozen, key, len, &code, &value);
+		assert(ret == (i<KEY_NUM));
+	}
+	pyfrozen_free(frozen);
+	remove("./dictbin_hash_frozen");
+	py_sign_set_default(PY_SIGN_WYHASH);
+
+	// sharded dict
+	pycdict = pycdict_create(4, KEY_NUM, 1000);
+	assert(pycdict);
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pycdict_add(pycdict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	ret = pycdict_save(pycdict, "./", "dictbin_hash_cdict");
+	assert(ret == 0);
+	pycdict_free(pycdict);
+	py_sign_set_default(PY_SIGN_MURMUR);
+	pycdict = pycdict_load("./", "dictbin_hash_cdict", 4);
+	assert(pycdict && pycdict->hash == PY_SIGN_WYHASH);
+	for(i=0;i<KEY_NUM*2;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pycdict_find(pycdict, key, len, &code, &value);
+		assert(ret == (i<KEY_NUM));
+	}
+	pycdict_free(pycdict);
+	remove("./dictbin_hash_cdict");
+	py_sign_set_default(PY_SIGN_WYHASH);
+
+	// log replayed, merged and reopened under the other default
+	unlink("./dictbin_hash_wal");
+	unlink("./dictbin_hash_wal.wal");
+	pywal = pywal_open("./", "dictbin_hash_wal", KEY_NUM, 1UL<<30, PYWAL_NO_COMPACT);
+	assert(pywal && pywal->pydict->hash == PY_SIGN_WYHASH);
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pywal_add(pywal, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	pywal_close(pywal);
+	py_sign_set_default(PY_SIGN_MURMUR);
+	pywal = pywal_open("./", "dictbin_hash_wal", KEY_NUM, 1UL<<30, PYWAL_NO_COMPACT);
+	assert(pywal && pywal->pydict->hash == PY_SIGN_WYHASH);
+	check_dict(pywal->pydict);
+	ret = pywal_checkpoint(pywal, 1);
+	assert(ret == 0);
+	pywal_close(pywal);
+	pydict = pydict_load("./", "dictbin_hash_wal");
+	assert(pydict && pydict->hash == PY_SIGN_WYHASH);
+	check_dict(pydict);
+	pydict_free(pydict);
+	unlink("./dictbin_hash_wal");
+	unlink("./dictbin_hash_wal.wal");
+	unlink("./dictbin_hash_wal.wal.old");
+}
+
+int main()
+{
+	test_sign();
+	test_dict();
+	test_others();
+
+	printf("test_pdict_hash ok\n");
+	return 0;
+}
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <py_dict.h>
+#include "test_util.h"
+#include <py_dict_inline.h>
+
+// 8 bytes keys, murmur_hash_64 is a bijection on them, no signature collision
+#define KEY_NUM 100000
+
+// every length around the short key paths, both functions
+static void test_sign()
+{
+	unsigned long   sign   = 0;
+	unsigned long   inl    = 0;
+	unsigned int    seed   = 1;
+	char            buf[64];
+	int             hash   = 0;
+	int             len    = 0;
+	int             off    = 0;
+	int             i      = 0;
+
+	for(i=0;i<1000;i++){
+		for(len=0;len<(int)sizeof(buf);len++){
+			seed   = seed*1103515245+12345;
+			buf[len] = (char)(seed>>16);
+		}
+		for(hash=0;hash<PY_SIGN_NUM;hash++){
+			for(len=0;len<=PY_SIGN_SHORT*2;len++){
+				off = i%8; // unaligned keys too
+				inl = py_sign64_inline(hash, buf+off, len);
+				py_sign64_hash(hash, buf+off, len, &sign);
+				assert(inl == sign);
+			}
+		}
+	}
+
+	// the short path is the generic murmur, not just py_sign64_hash
+	for(len=0;len<=PY_SIGN_SHORT;len++){
+		py_sign64(buf, len, &sign);
+		inl = py_murmur64_short(buf, len);
+		assert(inl == sign);
+	}
+}
+
+// keys [0, KEY_NUM) are in the dict with code i, the others are not
+static void check_find(py_dict_t* pydict)
+{
+	PNODE*   pnode = NULL;
+	char     key[64];
+	int      len   = 0;
+	int      code  = 0;
+	int      value = 0;
+	int      i     = 0;
+	int      ret   = 0;
+
+	for(i=0;i<KEY_NUM*2;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_find_inline(pydict, key, len, &code, &value);
+		assert(ret == (i<KEY_NUM));
+		if(ret){
+			assert(code == i && value == i*10);
+		}
+		pnode = pydict_find_node_inline(pydict, key, len);
+		assert(pnode == pydict_find_node_str(pydict, key, len));
+
+		// 2 to 16 bytes words
+		len = i%15+2;
+		pnode = pydict_find_node_inline(pydict, key, len);
+		assert(pnode == pydict_find_node_str(pydict, key, len));
+	}
+}
+
+int main()
+{
+	py_dict_t*   pydict = NULL;
+	char         key[64];
+	int          len    = 0;
+	int          hash   = 0;
+	int          i      = 0;
+	int          ret    = 0;
+
+	test_sign();
+
+	for(hash=0;hash<PY_SIGN_NUM;hash++){
+		py_sign_set_default(hash);
+
+		// rehashing while adding
+		pydict = pydict_create(1000, 1000);
+		assert(pydict);
+		pydict_set_max_load(pydict, 1.0);
+		for(i=0;i<KEY_NUM;i++){
+			len = snprintf(key, sizeof(key), "%08d", i);
+			ret = pydict_add(pydict, key, len, i, i*10);
+			assert(ret == 0);
+		}
+		check_find(pydict);
+		pydict_rehash_finish(pydict);
+		check_find(pydict);
+
+		// the other engines and layouts go to pydict_find_node
+		ret = pydict_set_layout(pydict, PYDICT_LAYOUT_SPLIT);
+		assert(ret == 0);
+		check_find(pydict);
+		ret = pydict_set_layout(pydict, PYDICT_LAYOUT_NODE);
+		assert(ret == 0);
+		ret = pydict_set_engine(pydict, PYDICT_ENGINE_SWISS);
+		assert(ret == 0);
+		check_find(pydict);
+		ret = pydict_set_engine(pydict, PYDICT_ENGINE_CHAIN);
+		assert(ret == 0);
+		ret = pydict_counters_enable(pydict, 1);
+		assert(ret == 0);
+		check_find(pydict);
+		pydict_free(pydict);
+	}
+	py_sign_set_default(PY_SIGN_MURMUR);
+
+	printf("test_pdict_inline ok\n");
+	return 0;
+}
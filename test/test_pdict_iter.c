@@ -0,0 +1,226 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <py_dict.h>
+#include "test_util.h"
+
+// 8 bytes keys, murmur_hash_64 is a bijection on them, no signature collision
+#define KEY_NUM 600000
+
+// every key is seen once, counted by code
+typedef struct _seen{
+	unsigned char*  seen;
+	int             stop_at;    // >=0, stop at the node of this code
+}seen_t;
+
+static int visit(PNODE* node, unsigned int pos, void* arg)
+{
+	seen_t*  seen = (seen_t*)arg;
+
+	assert(node->code >= 0 && node->code < KEY_NUM);
+	assert(node->value == node->code*10);
+	__atomic_fetch_add(seen->seen+node->code, 1, __ATOMIC_RELAXED);
+
+	return node->code == seen->stop_at;
+}
+
+// keys i%3!=0 are in the dict
+static int live_key(int i)
+{
+	return i%3!=0;
+}
+
+static void check_seen(seen_t* seen)
+{
+	int   i = 0;
+
+	for(i=0;i<KEY_NUM;i++){
+		assert(seen->seen[i] == live_key(i));
+	}
+	memset(seen->seen, 0, KEY_NUM);
+}
+
+static void check_iter(py_dict_t* pydict, int live_num)
+{
+	seen_t         seen;
+	PNODE*         node = NULL;
+	unsigned int   pos  = 0;
+	unsigned int   last = 0;
+	unsigned int   step = 0;
+	unsigned int   i    = 0;
+	int            num  = 0;
+	int            ret  = 0;
+
+	seen.seen    = (unsigned char*)calloc(KEY_NUM, 1);
+	seen.stop_at = -1;
+	assert(seen.seen);
+
+	// first and next, in position order
+	for(node=pydict_first(pydict, &pos);node;node=pydict_next(pydict, (int*)&pos)){
+		assert(num==0 || pos>last);
+		last = pos;
+		visit(node, pos, &seen);
+		num++;
+	}
+	assert(num == live_num);
+	check_seen(&seen);
+
+	// disjoint ranges of any size cover the dict
+	for(step=1;step<=pydict->block_pos+1;step=step*7+5){
+		num = 0;
+		for(i=0;i<pydict->block_pos;i+=step){
+			num += pydict_iter_range(pydict, i, i+step, visit, &seen);
+		}
+		assert(num == live_num);
+		check_seen(&seen);
+	}
+
+	ret = pydict_parallel_foreach(pydict, 4, visit, &seen);
+	assert(ret == live_num);
+	check_seen(&seen);
+	ret = pydict_parallel_foreach(pydict, 0, visit, &seen);
+	assert(ret == live_num);
+	check_seen(&seen);
+
+	// func stops the iteration
+	seen.stop_at = KEY_NUM-1;
+	ret = pydict_iter_range(pydict, 0, pydict->block_pos, visit, &seen);
+	assert(ret>0 && ret<=live_num);
+	memset(seen.seen, 0, KEY_NUM);
+	ret = pydict_parallel_foreach(pydict, 4, visit, &seen);
+	assert(ret>0 && ret<=live_num);
+
+	free(seen.seen);
+}
+
+static int count_node(PNODE* node, unsigned int pos, void* arg)
+{
+	__atomic_fetch_add((int*)arg, 1, __ATOMIC_RELAXED);
+	return 0;
+}
+
+// nodes of first and next, a range and parallel foreach, all the same
+static int count_iter(py_dict_t* pydict)
+{
+	PNODE*         node  = NULL;
+	unsigned int   pos   = 0;
+	int            num   = 0;
+	int            count = 0;
+	int            ret   = 0;
+
+	for(node=pydict_first(pydict, &pos);node;node=pydict_next(pydict, (int*)&pos)){
+		num++;
+	}
+	ret = pydict_iter_range(pydict, 0, pydict->block_pos, count_node, &count);
+	assert(ret == num && count == num);
+	count = 0;
+	ret   = pydict_parallel_foreach(pydict, 2, count_node, &count);
+	assert(ret == num && count == num);
+	return num;
+}
+
+// a node of a file with code -1 is found again after an add, and iterated
+static void test_revive()
+{
+	py_dict_t*   pydict = NULL;
+	int          code   = 0;
+	int          value  = 0;
+	int          ret    = 0;
+
+	pydict = pydict_create(16, 16);
+	assert(pydict);
+	ret = pydict_add(pydict, "a", 1, -1, 0);
+	assert(ret == 0);
+	ret = pydict_add(pydict, "b", 1, 2, 20);
+	assert(ret == 0);
+	ret = pydict_save(pydict, "./", "dictbin_iter");
+	assert(ret == 0);
+	pydict_free(pydict);
+
+	pydict = pydict_load("./", "dictbin_iter");
+	assert(pydict);
+	ret = count_iter(pydict);
+	assert(ret == 1);
+	ret = pydict_add(pydict, "a", 1, 3, 30);
+	assert(ret == 1);
+	ret = pydict_find(pydict, "a", 1, &code, &value);
+	assert(ret == 1 && code == 3);
+	ret = count_iter(pydict);
+	assert(ret == 2);
+	ret = pydict_add(pydict, "a", 1, -1, 0);
+	assert(ret == 1);
+	ret = count_iter(pydict);
+	assert(ret == 1);
+	pydict_free(pydict);
+	remove("./dictbin_iter");
+}
+
+int main()
+{
+	py_dict_t*   pydict = NULL;
+	char         key[64];
+	int          len    = 0;
+	int          i      = 0;
+	int          ret    = 0;
+
+	pydict = pydict_create(KEY_NUM, 1000);
+	assert(pydict);
+	ret = pydict_iter_range(pydict, 0, 100, visit, NULL);
+	assert(ret == 0);
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	for(i=0;i<KEY_NUM;i+=3){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_del(pydict, key, len);
+		assert(ret == 1);
+	}
+	check_iter(pydict, KEY_NUM-KEY_NUM/3);
+
+	// freed nodes are reused, the bitmap follows
+	for(i=0;i<KEY_NUM;i+=3){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	for(i=0;i<KEY_NUM;i+=3){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_del(pydict, key, len);
+		assert(ret == 1);
+	}
+	check_iter(pydict, KEY_NUM-KEY_NUM/3);
+
+	// loaded, mapped without a bitmap, and compacted
+	ret = pydict_save(pydict, "./", "dictbin_iter");
+	assert(ret == 0);
+	pydict_free(pydict);
+	pydict = pydict_load("./", "dictbin_iter");
+	assert(pydict && pydict->live);
+	check_iter(pydict, KEY_NUM-KEY_NUM/3);
+	ret = pydict_compact(pydict);
+	assert(ret == KEY_NUM/3);
+	check_iter(pydict, KEY_NUM-KEY_NUM/3);
+	pydict_free(pydict);
+
+	pydict = pydict_map("./", "dictbin_iter", 0);
+	assert(pydict && pydict->live == NULL);
+	check_iter(pydict, KEY_NUM-KEY_NUM/3);
+	pydict_free(pydict);
+
+	// nothing is left after a reset
+	pydict = pydict_load("./", "dictbin_iter");
+	assert(pydict);
+	pydict_reset(pydict);
+	ret = pydict_parallel_foreach(pydict, 4, visit, NULL);
+	assert(ret == 0);
+	pydict_free(pydict);
+	remove("./dictbin_iter");
+
+	test_revive();
+
+	printf("test_pdict_iter ok\n");
+	return 0;
+}
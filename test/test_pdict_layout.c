@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <py_dict.h>
+#include "test_util.h"
+
+// 8 bytes keys, murmur_hash_64 is a bijection on them, no signature collision
+#define KEY_NUM 200000
+
+// keys [begin, end) are in the dict with code i, others are not, by
+// pydict_find and by the batch find
+static void check_range_batch(py_dict_t* pydict, int begin, int end)
+{
+	const char*   keys[16];
+	int           lens[16];
+	char          bufs[16][16];
+	int           codes[16];
+	int           values[16];
+	int           found[16];
+	int           i     = 0;
+	int           j     = 0;
+
+	check_range(pydict, begin, end, KEY_NUM*2);
+
+	// the batch find walks the keys array too
+	for(i=0;i<KEY_NUM*2;i+=16){
+		for(j=0;j<16;j++){
+			lens[j] = snprintf(bufs[j], sizeof(bufs[j]), "%08d", i+j);
+			keys[j] = bufs[j];
+		}
+		pydict_find_batch(pydict, keys, lens, 16, codes, values, found);
+		for(j=0;j<16;j++){
+			assert(found[j] == (i+j>=begin && i+j<end));
+			if(found[j]){
+				assert(codes[j] == i+j && values[j] == (i+j)*10);
+			}
+		}
+	}
+}
+
+// every key and next of the split layout matches its node
+static void check_keys(py_dict_t* pydict)
+{
+	PKEY*          key  = NULL;
+	PNODE*         node = NULL;
+	unsigned int   i    = 0;
+
+	assert(pydict->layout == PYDICT_LAYOUT_SPLIT && pydict->keys);
+	for(i=0;i<pydict->block_pos;i++){
+		key  = pydict->keys[i>>PYDICT_SEG_SHIFT] + (i&PYDICT_SEG_MASK);
+		node = pydict_node(pydict, i);
+		assert(key->sign1 == node->sign1);
+		assert(key->sign2 == node->sign2);
+		assert(key->next  == node->next);
+	}
+}
+
+int main()
+{
+	py_dict_t*   pydict = NULL;
+	py_dict_t*   mapped = NULL;
+	char         key[64];
+	int          len    = 0;
+	int          i      = 0;
+	int          ret    = 0;
+
+	// small table, chains are long and the table grows while adding
+	pydict = pydict_create(1000, 1000);
+	assert(pydict);
+	ret = pydict_set_layout(pydict, PYDICT_LAYOUT_SPLIT);
+	assert(ret == 0);
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	check_range_batch(pydict, 0, KEY_NUM);
+	pydict_rehash_finish(pydict);
+	check_keys(pydict);
+
+	// deleted nodes are unlinked from the keys and reused
+	for(i=0;i<KEY_NUM/2;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_del(pydict, key, len);
+		assert(ret == 1);
+	}
+	check_range_batch(pydict, KEY_NUM/2, KEY_NUM);
+	for(i=KEY_NUM;i<KEY_NUM+KEY_NUM/4;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	check_keys(pydict);
+	check_range_batch(pydict, KEY_NUM/2, KEY_NUM+KEY_NUM/4);
+
+	ret = pydict_compact(pydict);
+	assert(ret == KEY_NUM/4);
+	check_keys(pydict);
+	check_range_batch(pydict, KEY_NUM/2, KEY_NUM+KEY_NUM/4);
+
+	// the file is the same as the node layout, a mapped dict may be split
+	ret = pydict_save(pydict, "./", "dictbin_layout");
+	assert(ret == 0);
+	mapped = pydict_map("./", "dictbin_layout", 0);
+	assert(mapped);
+	ret = pydict_set_layout(mapped, PYDICT_LAYOUT_SPLIT);
+	assert(ret == 0);
+	check_range_batch(mapped, KEY_NUM/2, KEY_NUM+KEY_NUM/4);
+	pydict_free(mapped);
+
+	// back to the node layout, and no split layout for the swiss engine
+	ret = pydict_set_layout(pydict, PYDICT_LAYOUT_NODE);
+	assert(ret == 0 && pydict->keys == NULL);
+	check_range_batch(pydict, KEY_NUM/2, KEY_NUM+KEY_NUM/4);
+	ret = pydict_set_layout(pydict, PYDICT_LAYOUT_SPLIT);
+	assert(ret == 0);
+	ret = pydict_set_engine(pydict, PYDICT_ENGINE_SWISS);
+	assert(ret == 0 && pydict->keys == NULL);
+	ret = pydict_set_layout(pydict, PYDICT_LAYOUT_SPLIT);
+	assert(ret == -1);
+	pydict_free(pydict);
+
+	printf("test_pdict_layout ok\n");
+	return 0;
+}
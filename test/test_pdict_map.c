@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <py_dict.h>
+#include "test_util.h"
+
+int main(int argc, char* argv[])
+{
+	py_dict_t* pydict = NULL;
+	py_dict_t* mapped = NULL;
+	char   key[64];
+	int    len   = 0;
+	int    code  = 0;
+	int    value = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	pydict = pydict_create(1000, 555);
+	assert(pydict);
+
+	for(i=0;i<10000;i++){
+		len = snprintf(key, sizeof(key), "key_%d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	ret = pydict_save(pydict, "./", "dictbin_map");
+	assert(ret == 0);
+
+	mapped = pydict_map("./", "dictbin_map", PYDICT_MAP_POPULATE|PYDICT_MAP_WILLNEED);
+	assert(mapped);
+	assert(mapped->hashsize == pydict->hashsize);
+	assert(mapped->block_pos == pydict->block_pos);
+
+	for(i=0;i<10000;i++){
+		len = snprintf(key, sizeof(key), "key_%d", i);
+		ret = pydict_find(mapped, key, len, &code, &value);
+		assert(ret == 1);
+		assert(code == i && value == i*10);
+	}
+	ret = pydict_find(mapped, "nokey", 5, &code, &value);
+	assert(ret == 0);
+
+	// mapped dict is read only
+	ret = pydict_add(mapped, "nokey", 5, 1, 1);
+	assert(ret == -1);
+	ret = pydict_del(mapped, "key_1", 5);
+	assert(ret == -1);
+
+	pydict_unmap(mapped);
+	pydict_free(pydict);
+
+	fprintf(stdout, "test_pdict_map ok\n");
+
+	return 0;
+}
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <py_dict.h>
+#include "test_util.h"
+
+// 8 bytes keys, murmur_hash_64 is a bijection on them, no signature collision
+#define KEY_NUM 1000000
+
+int main(int argc, char* argv[])
+{
+	py_dict_t* pydict = NULL;
+	py_dict_t* loaded = NULL;
+	char   key[64];
+	int    len   = 0;
+	int    code  = 0;
+	int    value = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	pydict = pydict_create(100, 555);
+	assert(pydict);
+
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+
+		// keys added before and during the rehash must be found
+		len = snprintf(key, sizeof(key), "%08d", i/2);
+		ret = pydict_find(pydict, key, len, &code, &value);
+		assert(ret == 1);
+		assert(code == i/2 && value == (i/2)*10);
+	}
+	assert(pydict->hashsize >= KEY_NUM/2);
+
+	for(i=0;i<KEY_NUM;i+=7){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, -2, i);
+		assert(ret == 1);
+	}
+	assert(pydict->block_pos == KEY_NUM);
+
+	// fixed size table
+	pydict_set_max_load(pydict, 0);
+	pydict_rehash_finish(pydict);
+	assert(pydict->oldtab == NULL);
+
+	ret = pydict_save(pydict, "./", "dictbin_rehash");
+	assert(ret == 0);
+	loaded = pydict_load("./", "dictbin_rehash");
+	assert(loaded);
+	assert(loaded->hashsize == pydict->hashsize);
+
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_find(loaded, key, len, &code, &value);
+		assert(ret == 1);
+		if(i%7 == 0){
+			assert(code == -2 && value == i);
+		}
+		else{
+			assert(code == i && value == i*10);
+		}
+	}
+	ret = pydict_find(loaded, "nokey", 5, &code, &value);
+	assert(ret == 0);
+
+	pydict_free(loaded);
+	pydict_free(pydict);
+
+	fprintf(stdout, "test_pdict_rehash ok\n");
+
+	return 0;
+}
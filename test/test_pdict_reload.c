@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <py_dict.h>
+#include "test_util.h"
+#include <py_reload.h>
+
+#define KEY_NUM     10000
+#define READER_NUM  4
+#define VERSION_NUM 20
+
+static py_reload_t* reload  = NULL;
+static int          stop    = 0;
+
+// write a dict of a version to a temp file and rename it
+static void write_dict(int version)
+{
+	py_dict_t* pydict = NULL;
+	char   key[64];
+	int    len   = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	pydict = pydict_create(KEY_NUM, KEY_NUM);
+	assert(pydict);
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		pydict_add(pydict, key, len, version, i);
+	}
+	ret = pydict_save(pydict, "./", "dictbin_reload.tmp");
+	assert(ret == 0);
+	ret = rename("./dictbin_reload.tmp", "./dictbin_reload");
+	assert(ret == 0);
+	pydict_free(pydict);
+}
+
+// versions seen by a reader never go back, all keys of a version are there
+static void* reader_thread(void* arg)
+{
+	py_dict_t* pydict  = NULL;
+	char   key[64];
+	int    reader  = 0;
+	int    len     = 0;
+	int    code    = 0;
+	int    value   = 0;
+	int    last    = 0;
+	int    i       = 0;
+	int    ret     = 0;
+
+	reader = pyreload_reader(reload);
+	assert(reader >= 0);
+
+	while(!__atomic_load_n(&stop, __ATOMIC_RELAXED)){
+		pydict = pyreload_enter(reload, reader);
+		for(i=0;i<KEY_NUM;i+=97){
+			len = snprintf(key, sizeof(key), "%08d", i);
+			ret = pydict_find(pydict, key, len, &code, &value);
+			assert(ret == 1 && value == i);
+			assert(code >= last);
+			last = code;
+		}
+		pyreload_leave(reload, reader);
+
+		len = snprintf(key, sizeof(key), "%08d", last);
+		ret = pyreload_find(reload, reader, key, len, &code, &value);
+		assert(ret == 1 && code >= last);
+	}
+
+	return NULL;
+}
+
+int main(int argc, char* argv[])
+{
+	pthread_t  threads[READER_NUM];
+	int    version = 0;
+	int    i       = 0;
+	int    ret     = 0;
+
+	write_dict(0);
+	reload = pyreload_create("./", "dictbin_reload", 0, READER_NUM, 0);
+	assert(reload);
+
+	for(i=0;i<READER_NUM;i++){
+		pthread_create(threads+i, NULL, reader_thread, NULL);
+	}
+
+	// reload by hand, then by the watching thread
+	for(version=1;version<VERSION_NUM;version++){
+		write_dict(version);
+		ret = pyreload_check(reload);
+		assert(ret == 1);
+	}
+	ret = pyreload_check(reload);
+	assert(ret == 0);
+
+	__atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+	for(i=0;i<READER_NUM;i++){
+		pthread_join(threads[i], NULL);
+	}
+	assert(reload->version == VERSION_NUM);
+	pyreload_free(reload);
+
+	reload = pyreload_create("./", "dictbin_reload", 1, READER_NUM, PYRELOAD_MAP);
+	assert(reload);
+	stop = 0;
+	for(i=0;i<READER_NUM;i++){
+		pthread_create(threads+i, NULL, reader_thread, NULL);
+	}
+	sleep(1);
+	write_dict(VERSION_NUM);
+	for(i=0;i<50 && __atomic_load_n(&reload->version, __ATOMIC_ACQUIRE)==1;i++){
+		usleep(100000);
+	}
+	assert(reload->version == 2);
+
+	__atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+	for(i=0;i<READER_NUM;i++){
+		pthread_join(threads[i], NULL);
+	}
+	pyreload_free(reload);
+
+	fprintf(stdout, "test_pdict_reload ok\n");
+
+	return 0;
+}
@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <py_dict.h>
+#include "test_util.h"
+#include <py_sign_inline.h>
+#include <py_seg.h>
+#include <py_wal.h>
+
+#define TOKEN_NUM 4096
+#define WAL_DICT  "./dictbin_seg_wal"
+
+// GBK hanzi
+#define ZHONG "\xd6\xd0"
+#define GUO   "\xb9\xfa"
+#define REN   "\xc8\xcb"
+#define MIN   "\xc3\xf1"
+#define GONG  "\xb9\xb2"
+#define HE    "\xba\xcd"
+
+static const char* words[] = {
+	ZHONG GUO, ZHONG GUO REN, GUO REN, REN MIN, GONG HE, GONG HE GUO, "ab", "abc", NULL
+};
+
+// tokens are the given byte lengths, words or not
+static void expect(pyseg_token_t* tokens, int num, const char* want[], int want_num)
+{
+	int   offset = 0;
+	int   i      = 0;
+
+	assert(num == want_num);
+	for(i=0;i<num;i++){
+		assert(tokens[i].len == (int)strlen(want[i]) && tokens[i].offset == offset);
+		offset += tokens[i].len;
+	}
+}
+
+// the longest word of text at pos, by full signatures of every candidate
+static int naive_longest(py_dict_t* pydict, const unsigned char* text, int len, int pos, int* is_word)
+{
+	int   best  = 0;
+	int   n     = 0;
+	int   c     = 0;
+	int   code  = 0;
+	int   value = 0;
+
+	*is_word = 0;
+	c    = (pos+1<len && text[pos]>=0x81 && text[pos]<=0xFE && text[pos+1]>=0x40 && 
+	        text[pos+1]<=0xFE && text[pos+1]!=0x7F) ? 2 : 1;
+	best = c;
+	for(n=c;pos+n<=len && n<=(int)pydict->key_max;){
+		if(pydict_find(pydict, (const char*)text+pos, n, &code, &value)){
+			best     = n;
+			*is_word = 1;
+		}
+		if(pos+n==len){
+			break;
+		}
+		n += (pos+n+1<len && text[pos+n]>=0x81 && text[pos+n]<=0xFE && text[pos+n+1]>=0x40 && 
+		      text[pos+n+1]<=0xFE && text[pos+n+1]!=0x7F) ? 2 : 1;
+	}
+	return best;
+}
+
+// a word token is one of all the words
+static int in_all(pyseg_token_t* all, int all_num, pyseg_token_t* token)
+{
+	int i = 0;
+
+	for(i=0;i<all_num;i++){
+		if(all[i].offset==token->offset && all[i].len==token->len){
+			return all[i].node==token->node;
+		}
+	}
+	return 0;
+}
+
+// random texts of the dict characters, forward against the naive walk,
+// word tokens of both matches against all the words
+static void test_random(py_dict_t* pydict)
+{
+	static pyseg_token_t tokens[TOKEN_NUM];
+	static pyseg_token_t all[TOKEN_NUM];
+	unsigned char        text[1024];
+	const char*          chars[] = {ZHONG, GUO, REN, MIN, GONG, HE, "a", "b", "c", "\xa1\xa3"};
+	unsigned int         seed    = 7;
+	int                  len     = 0;
+	int                  num     = 0;
+	int                  all_num = 0;
+	int                  is_word = 0;
+	int                  round   = 0;
+	int                  pos     = 0;
+	int                  i       = 0;
+
+	for(round=0;round<200;round++){
+		for(len=0;len<(int)sizeof(text)-2;){
+			seed = seed*1103515245+12345;
+			i    = (seed>>16)%10;
+			memcpy(text+len, chars[i], strlen(chars[i]));
+			len += strlen(chars[i]);
+			if((seed>>8)%50==0){
+				break;
+			}
+		}
+		all_num = pyseg_all(pydict, (const char*)text, len, all, TOKEN_NUM);
+		assert(all_num >= 0);
+
+		num = pyseg_forward(pydict, (const char*)text, len, tokens, TOKEN_NUM);
+		assert(num > 0);
+		for(i=0,pos=0;i<num;i++){
+			assert(tokens[i].offset == pos);
+			assert(tokens[i].len == naive_longest(pydict, text, len, pos, &is_word));
+			assert((tokens[i].node != NULL) == is_word);
+			assert(tokens[i].node == NULL || in_all(all, all_num, tokens+i));
+			pos += tokens[i].len;
+		}
+		assert(pos == len);
+
+		num = pyseg_backward(pydict, (const char*)text, len, tokens, TOKEN_NUM);
+		assert(num > 0);
+		for(i=0,pos=0;i<num;i++){
+			assert(tokens[i].offset == pos && tokens[i].len > 0);
+			assert(tokens[i].node == NULL || in_all(all, all_num, tokens+i));
+			pos += tokens[i].len;
+		}
+		assert(pos == len);
+	}
+}
+
+static py_dict_t* make_dict(int hash)
+{
+	py_dict_t*   pydict = NULL;
+	int          ret    = 0;
+	int          i      = 0;
+
+	pydict = pydict_create(100, 100);
+	assert(pydict);
+	ret = pydict_set_hash(pydict, hash);
+	assert(ret == 0);
+	for(i=0;words[i];i++){
+		ret = pydict_add(pydict, words[i], strlen(words[i]), i, 0);
+		assert(ret == 0);
+	}
+	assert(pydict->key_max == 6);
+	return pydict;
+}
+
+static void test_dict(py_dict_t* pydict)
+{
+	pyseg_token_t  tokens[64];
+	const char*    text        = ZHONG GUO REN MIN GONG HE GUO "abcd";
+	const char*    forward[]   = {ZHONG GUO REN, MIN, GONG HE GUO, "abc", "d"};
+	const char*    backward[]  = {ZHONG GUO, REN MIN, GONG HE GUO, "abc", "d"};
+	const char*    all[]       = {ZHONG GUO, ZHONG GUO REN, GUO REN, REN MIN, GONG HE, GONG HE GUO, "ab", "abc"};
+	int            num         = 0;
+	int            i           = 0;
+
+	num = pyseg_forward(pydict, text, strlen(text), tokens, 64);
+	expect(tokens, num, forward, 5);
+	assert(tokens[1].node == NULL && tokens[2].node->code == 5);
+	num = pyseg_backward(pydict, text, strlen(text), tokens, 64);
+	expect(tokens, num, backward, 5);
+	assert(tokens[1].node->code == 3 && tokens[4].node == NULL);
+	num = pyseg_all(pydict, text, strlen(text), tokens, 64);
+	assert(num == 8);
+	for(i=0;i<num;i++){
+		assert(tokens[i].len == (int)strlen(all[i]) && memcmp(text+tokens[i].offset, all[i], tokens[i].len) == 0);
+	}
+
+	// full token arrays
+	num = pyseg_forward(pydict, text, strlen(text), tokens, 4);
+	assert(num == -1);
+	num = pyseg_backward(pydict, text, strlen(text), tokens, 4);
+	assert(num == -1);
+	num = pyseg_all(pydict, text, strlen(text), tokens, 7);
+	assert(num == -1);
+	num = pyseg_forward(pydict, text, 0, tokens, 64);
+	assert(num == 0);
+
+	test_random(pydict);
+}
+
+// keys added through a log count in key_max, replayed and merged too
+static void test_wal()
+{
+	pyseg_token_t  tokens[8];
+	py_dict_t*     pydict = NULL;
+	py_wal_t*      pywal  = NULL;
+	unsigned long  sign   = 0;
+	PNODE          node;
+	int            num    = 0;
+	int            ret    = 0;
+
+	unlink(WAL_DICT ".wal");
+	unlink(WAL_DICT ".wal.old");
+	pydict = pydict_create(100, 100);
+	assert(pydict);
+	ret = pydict_add(pydict, "ab", 2, 1, 0);
+	assert(ret == 0);
+	ret = pydict_save(pydict, "./", "dictbin_seg_wal");
+	assert(ret == 0);
+	pydict_free(pydict);
+
+	pywal = pywal_open("./", "dictbin_seg_wal", 100, 1UL<<30, PYWAL_NO_COMPACT);
+	assert(pywal && pywal->pydict->key_max == 2);
+	ret = pywal_add(pywal, "abcd", 4, 2, 0);
+	assert(ret == 0 && pywal->pydict->key_max == 4);
+	num = pyseg_forward(pywal->pydict, "abcd", 4, tokens, 8);
+	assert(num == 1 && tokens[0].node && tokens[0].node->code == 2);
+	pywal_close(pywal);
+
+	pywal = pywal_open("./", "dictbin_seg_wal", 100, 1UL<<30, PYWAL_NO_COMPACT);
+	assert(pywal && pywal->pydict->key_max == 4);
+	ret = pywal_checkpoint(pywal, 1);
+	assert(ret == 0);
+	pywal_close(pywal);
+	pydict = pydict_load("./", "dictbin_seg_wal");
+	assert(pydict && pydict->key_max == 4);
+	num = pyseg_forward(pydict, "abcd", 4, tokens, 8);
+	assert(num == 1 && tokens[0].node->code == 2);
+
+	// a key added by its signature has no length, key_max stays unknown
+	sign       = py_sign64_inline(pydict->hash, "abcdef", 6);
+	node.sign1 = (unsigned int)(sign>>32);
+	node.sign2 = (unsigned int)sign;
+	node.code  = 3;
+	node.value = 0;
+	ret = pydict_add_node(pydict, &node);
+	assert(ret == 0 && pydict->key_max == 0);
+	ret = pydict_add(pydict, "a", 1, 4, 0);
+	assert(ret == 0 && pydict->key_max == 0);
+	num = pyseg_forward(pydict, "abcdef", 6, tokens, 8);
+	assert(num == 1 && tokens[0].node->code == 3);
+	pydict_free(pydict);
+
+	remove(WAL_DICT);
+	remove(WAL_DICT ".wal");
+}
+
+int main()
+{
+	py_dict_t*      pydict = NULL;
+	char            buf[64];
+	unsigned long   sign   = 0;
+	unsigned long   h      = 0;
+	unsigned long   pw     = 1;
+	int             len    = 0;
+	int             i      = 0;
+	int             ret    = 0;
+
+	// a rolled state is the signature of the whole key, both ways
+	for(i=0;i<(int)sizeof(buf);i++){
+		buf[i] = (char)(i*131+7);
+	}
+	for(len=1;len<=(int)sizeof(buf);len++){
+		h = py_roll_step(h, buf[len-1]);
+		py_sign64_hash(PY_SIGN_ROLL, buf, len, &sign);
+		assert(sign == py_roll_final(h, len) && sign == py_sign64_inline(PY_SIGN_ROLL, buf, len));
+	}
+	h = 0;
+	for(i=sizeof(buf)-1;i>=0;i--){
+		h  = py_roll_prepend(h, pw, buf[i]);
+		pw = py_roll_pow(pw);
+	}
+	assert(py_roll_final(h, sizeof(buf)) == sign);
+
+	pydict = make_dict(PY_SIGN_ROLL);
+	test_dict(pydict);
+
+	// the longest key and the function are kept in the file
+	ret = pydict_save(pydict, "./", "dictbin_seg");
+	assert(ret == 0);
+	pydict_free(pydict);
+	pydict = pydict_load("./", "dictbin_seg");
+	assert(pydict && pydict->key_max == 6 && pydict->hash == PY_SIGN_ROLL);
+	test_dict(pydict);
+	pydict_free(pydict);
+	pydict = pydict_map("./", "dictbin_seg", 0);
+	assert(pydict && pydict->key_max == 6);
+	test_dict(pydict);
+	pydict_free(pydict);
+	remove("./dictbin_seg");
+
+	// other functions sign every candidate
+	pydict = make_dict(PY_SIGN_MURMUR);
+	test_dict(pydict);
+	ret = pydict_add_blob(pydict, "abcdefghij", 10, 9, "x", 1);
+	assert(ret == 0 && pydict->key_max == 10);
+	ret = pydict_save(pydict, "./", "dictbin_seg");
+	assert(ret == 0);
+	pydict_free(pydict);
+	pydict = pydict_map("./", "dictbin_seg", 0);
+	assert(pydict && pydict->key_max == 10 && pydict->blob_size > 0);
+	pydict_free(pydict);
+	remove("./dictbin_seg");
+
+	test_wal();
+
+	printf("test_pdict_seg ok\n");
+	return 0;
+}
@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <py_dict.h>
+#include "test_util.h"
+
+// 8 bytes keys, murmur_hash_64 is a bijection on them, no signature collision
+// the nodes fill two segments and half of the third one
+#define KEY_NUM (PYDICT_SEG_SIZE*2+PYDICT_SEG_SIZE/2)
+#define PIN_NUM 16
+
+int main()
+{
+	py_dict_t*   pydict = NULL;
+	py_dict_t*   loaded = NULL;
+	PNODE*       pins[PIN_NUM];
+	PNODE*       pnode  = NULL;
+	unsigned int pos    = 0;
+	char         key[64];
+	int          len    = 0;
+	int          i      = 0;
+	int          ret    = 0;
+
+	// nodes found before the dict grows stay where they are
+	pydict = pydict_create(1000, 1000);
+	assert(pydict);
+	for(i=0;i<PIN_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+		pins[i] = pydict_find_node_str(pydict, key, len);
+		assert(pins[i]);
+	}
+	for(i=PIN_NUM;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	assert(pydict->seg_num == 3 && pydict->block_pos == KEY_NUM);
+	for(i=0;i<PIN_NUM;i++){
+		len   = snprintf(key, sizeof(key), "%08d", i);
+		pnode = pydict_find_node_str(pydict, key, len);
+		assert(pnode == pins[i] && pnode->code == i);
+	}
+	check_range(pydict, 0, KEY_NUM, KEY_NUM+1000);
+
+	// files are the same, nodes are written and read a segment at a time
+	ret = pydict_save(pydict, "./", "dictbin_segs");
+	assert(ret == 0);
+	loaded = pydict_load("./", "dictbin_segs");
+	assert(loaded && loaded->seg_num == 3);
+	check_range(loaded, 0, KEY_NUM, KEY_NUM+1000);
+	pydict_free(loaded);
+	loaded = pydict_map("./", "dictbin_segs", 0);
+	assert(loaded && loaded->seg_num == 3);
+	check_range(loaded, 0, KEY_NUM, KEY_NUM+1000);
+	ret = pydict_set_layout(loaded, PYDICT_LAYOUT_SPLIT);
+	assert(ret == 0);
+	check_range(loaded, 0, KEY_NUM, KEY_NUM+1000);
+	pydict_free(loaded);
+
+	// compact moves the nodes to the front and gives back empty segments
+	for(i=0;i<PYDICT_SEG_SIZE*2;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_del(pydict, key, len);
+		assert(ret == 1);
+	}
+	ret = pydict_set_layout(pydict, PYDICT_LAYOUT_SPLIT);
+	assert(ret == 0);
+	ret = pydict_compact(pydict);
+	assert(ret == PYDICT_SEG_SIZE*2);
+	assert(pydict->seg_num == 1 && pydict->block_size == PYDICT_SEG_SIZE);
+	check_range(pydict, PYDICT_SEG_SIZE*2, KEY_NUM, KEY_NUM+1000);
+
+	// and the dict grows again
+	for(i=0;i<PYDICT_SEG_SIZE*2;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	assert(pydict->seg_num == 3);
+	check_range(pydict, 0, KEY_NUM, KEY_NUM+1000);
+	pydict_free(pydict);
+	remove("./dictbin_segs");
+
+	// a small dict takes no segment until its first add, an empty one is
+	// saved, loaded and iterated
+	pydict = pydict_create(100, 555);
+	assert(pydict && pydict->seg_num == 0 && pydict->block_size == 0);
+	ret = pydict_save(pydict, "./", "dictbin_segs");
+	assert(ret == 0);
+	loaded = pydict_load("./", "dictbin_segs");
+	assert(loaded && loaded->block_pos == 0 && pydict_first(loaded, &pos) == NULL);
+	pydict_free(loaded);
+	ret = pydict_add(pydict, "abc", 3, 1, 1);
+	assert(ret == 0 && pydict->seg_num == 1);
+	pydict_free(pydict);
+	remove("./dictbin_segs");
+
+	printf("test_pdict_segs ok\n");
+	return 0;
+}
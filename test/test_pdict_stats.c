@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <pthread.h>
+#include <py_dict.h>
+#include "test_util.h"
+
+// 8 bytes keys, murmur_hash_64 is a bijection on them, no signature collision
+#define KEY_NUM     30000
+#define HASH_SIZE   10007
+#define DEL_NUM     1000
+#define THREAD_NUM  4
+#define THREAD_FIND 20000
+
+static py_dict_t* g_dict = NULL;
+
+static void check_stats(py_dict_t* pydict, unsigned int node_num, unsigned int deleted_num)
+{
+	pydict_stats_t   stats;
+	unsigned int     used  = 0;
+	unsigned int     nodes = 0;
+	int              ret   = 0;
+	int              i     = 0;
+
+	ret = pydict_stats(pydict, &stats);
+	assert(ret == 0);
+	assert(stats.node_num == node_num);
+	assert(stats.deleted_num == deleted_num);
+	assert(stats.free_num == deleted_num);
+	assert(stats.block_pos == node_num+deleted_num);
+	assert(stats.slack == stats.block_size-stats.block_pos);
+	assert(stats.max_len < PYDICT_STATS_LEN_MAX);
+	assert(stats.avg_len >= 1.0);
+	assert(stats.bytes >= (size_t)stats.block_size*sizeof(PNODE));
+	for(i=0;i<PYDICT_STATS_LEN_MAX;i++){
+		used  += stats.len_hist[i];
+		nodes += stats.len_hist[i]*i;
+	}
+	if(stats.engine==PYDICT_ENGINE_SWISS){
+		assert(used == node_num);       // keys by groups probed
+		assert(stats.used == node_num); // full slots
+	}
+	else{
+		assert(stats.hashsize == HASH_SIZE);
+		assert(used == stats.used);     // buckets by chain length
+		assert(nodes == node_num);
+		assert(stats.load == (double)node_num/HASH_SIZE);
+	}
+}
+
+static void* find_thread(void* arg)
+{
+	char   key[64];
+	int    len   = 0;
+	int    code  = 0;
+	int    value = 0;
+	int    i     = 0;
+
+	for(i=0;i<THREAD_FIND;i++){
+		len = snprintf(key, sizeof(key), "%08d", i%KEY_NUM);
+		pydict_find(g_dict, key, len, &code, &value);
+	}
+	return NULL;
+}
+
+static void test_engine(int engine)
+{
+	py_dict_t*       pydict = NULL;
+	pydict_stats_t   stats;
+	pthread_t        threads[THREAD_NUM];
+	const char*      keys[16];
+	int              lens[16];
+	int              codes[16];
+	int              values[16];
+	char             bufs[16][16];
+	char             key[64];
+	int              len   = 0;
+	int              code  = 0;
+	int              value = 0;
+	int              i     = 0;
+	int              ret   = 0;
+
+	pydict = pydict_create(HASH_SIZE, 1000);
+	assert(pydict);
+	pydict_set_max_load(pydict, 0);
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i);
+		assert(ret == 0);
+	}
+	ret = pydict_set_engine(pydict, engine);
+	assert(ret == 0);
+	check_stats(pydict, KEY_NUM, 0);
+
+	for(i=0;i<DEL_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_del(pydict, key, len);
+		assert(ret == 1);
+	}
+	check_stats(pydict, KEY_NUM-DEL_NUM, DEL_NUM);
+
+	// no counting until enabled
+	ret = pydict_find(pydict, "00005000", 8, &code, &value);
+	assert(ret == 1);
+	pydict_stats(pydict, &stats);
+	assert(stats.finds == 0);
+
+	ret = pydict_counters_enable(pydict, THREAD_NUM+1);
+	assert(ret == 0);
+	for(i=0;i<KEY_NUM;i++){ // DEL_NUM deleted keys miss
+		len = snprintf(key, sizeof(key), "%08d", i);
+		pydict_find(pydict, key, len, &code, &value);
+	}
+	for(i=0;i<16;i++){ // the batch finds count too, 8 of them hit
+		snprintf(bufs[i], sizeof(bufs[i]), "%08d", i%2 ? KEY_NUM+i : KEY_NUM-1-i);
+		keys[i] = bufs[i];
+		lens[i] = 8;
+	}
+	ret = pydict_find_batch(pydict, keys, lens, 16, codes, values, NULL);
+	assert(ret == 8);
+
+	pydict_stats(pydict, &stats);
+	assert(stats.finds == KEY_NUM+16);
+	assert(stats.hits == KEY_NUM-DEL_NUM+8);
+	assert(stats.misses == DEL_NUM+8);
+	assert(stats.probes >= stats.hits);
+
+	// each thread has its own slot, nothing is lost
+	g_dict = pydict;
+	ret = pydict_counters_enable(pydict, THREAD_NUM+1);
+	assert(ret == 0);
+	for(i=0;i<THREAD_NUM;i++){
+		ret = pthread_create(&threads[i], NULL, find_thread, NULL);
+		assert(ret == 0);
+	}
+	for(i=0;i<THREAD_NUM;i++){
+		pthread_join(threads[i], NULL);
+	}
+	pydict_stats(pydict, &stats);
+	assert(stats.finds == THREAD_NUM*THREAD_FIND);
+
+	ret = pydict_counters_enable(pydict, 0);
+	assert(ret == 0);
+	assert(pydict->counters == NULL);
+	pydict_find(pydict, "00005000", 8, &code, &value);
+	pydict_stats(pydict, &stats);
+	assert(stats.finds == 0);
+
+	pydict_free(pydict);
+}
+
+int main()
+{
+	py_dict_t*       pydict = NULL;
+	pydict_stats_t   stats;
+	int              ret    = 0;
+
+	test_engine(PYDICT_ENGINE_CHAIN);
+	test_engine(PYDICT_ENGINE_SWISS);
+
+	// a mapped dict reports the mapping
+	pydict = pydict_create(HASH_SIZE, 1000);
+	assert(pydict);
+	ret = pydict_add(pydict, "00000001", 8, 1, 1);
+	assert(ret == 0);
+	ret = pydict_save(pydict, "./", "dictbin_stats");
+	assert(ret == 0);
+	pydict_free(pydict);
+
+	pydict = pydict_map("./", "dictbin_stats", 0);
+	assert(pydict);
+	ret = pydict_counters_enable(pydict, 1);
+	assert(ret == 0);
+	pydict_stats(pydict, &stats);
+	assert(stats.mapped == 1);
+	assert(stats.node_num == 1 && stats.used == 1);
+	assert(stats.bytes >= pydict->map_size);
+	pydict_free(pydict);
+
+	printf("test_pdict_stats ok\n");
+	return 0;
+}
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <py_dict.h>
+#include "test_util.h"
+
+// 8 bytes keys, murmur_hash_64 is a bijection on them, no signature collision
+#define KEY_NUM 1000000
+
+static void check_dict(py_dict_t* pydict)
+{
+	char   key[64];
+	int    len   = 0;
+	int    code  = 0;
+	int    value = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_find(pydict, key, len, &code, &value);
+		assert(ret == 1);
+		if(i%3 == 0){
+			assert(code == -2 && value == i);
+		}
+		else{
+			assert(code == i && value == i*10);
+		}
+	}
+	for(i=KEY_NUM;i<KEY_NUM*2;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_find(pydict, key, len, &code, &value);
+		assert(ret == 0);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	py_dict_t* pydict = NULL;
+	py_dict_t* loaded = NULL;
+	char   key[64];
+	int    len   = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	pydict = pydict_create(100, 555);
+	assert(pydict);
+	ret = pydict_set_engine(pydict, PYDICT_ENGINE_SWISS);
+	assert(ret == 0);
+
+	for(i=0;i<KEY_NUM;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, i, i*10);
+		assert(ret == 0);
+	}
+	for(i=0;i<KEY_NUM;i+=3){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_add(pydict, key, len, -2, i);
+		assert(ret == 1);
+	}
+	check_dict(pydict);
+
+	// saved in chain layout
+	ret = pydict_save(pydict, "./", "dictbin_swiss");
+	assert(ret == 0);
+	loaded = pydict_load("./", "dictbin_swiss");
+	assert(loaded);
+	assert(loaded->engine == PYDICT_ENGINE_CHAIN);
+	check_dict(loaded);
+
+	ret = pydict_set_engine(loaded, PYDICT_ENGINE_SWISS);
+	assert(ret == 0);
+	check_dict(loaded);
+	ret = pydict_set_engine(pydict, PYDICT_ENGINE_CHAIN);
+	assert(ret == 0);
+	check_dict(pydict);
+
+	pydict_free(loaded);
+	pydict_free(pydict);
+
+	fprintf(stdout, "test_pdict_swiss ok\n");
+
+	return 0;
+}
@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <utility>
+#include <py_dict.hpp>
+#include "test_util.h"
+
+// 8 bytes keys, no murmur signature collision, 32 bits signatures collide
+// from about 64K keys, those dicts take fewer keys
+#define KEY_NUM 200000
+#define KEY_NUM_32 10000
+
+// a value larger than 8 bytes, in the values array
+struct offset_t{
+	unsigned long   offset;
+	unsigned int    length;
+	short           type;
+	char            flag;
+};
+
+// nodes are packed by the layout
+static_assert(sizeof(pydict::dict<int>::node_t) == sizeof(PNODE)-4, "sign1, sign2, next, value");
+static_assert(sizeof(pydict::dict<int, 32>::node_t) == 12, "sign, next, value");
+static_assert(sizeof(pydict::dict<short, 32>::node_t) == 12, "sign, next, value, end padding");
+static_assert(sizeof(pydict::dict<unsigned long>::node_t) == 24, "value first, end padding");
+static_assert(sizeof(pydict::dict<unsigned long, 32>::node_t) == 16, "value first, no padding");
+static_assert(sizeof(pydict::dict<offset_t>::node_t) == 12, "split, signatures and next");
+static_assert(!std::is_copy_constructible<pydict::dict<int> >::value, "move-only");
+static_assert(std::is_move_constructible<pydict::dict<int> >::value, "move-only");
+
+template<typename Value> static Value make_value(int i);
+
+template<> int make_value<int>(int i)
+{
+	return i*10;
+}
+
+template<> unsigned long make_value<unsigned long>(int i)
+{
+	return (unsigned long)i<<33;
+}
+
+template<> offset_t make_value<offset_t>(int i)
+{
+	offset_t value;
+
+	memset(&value, 0, sizeof(value));
+	value.offset = (unsigned long)i<<33;
+	value.length = i;
+	value.type   = (short)i;
+	value.flag   = (char)i;
+	return value;
+}
+
+// keys [0, key_num) but i%3==0 are in the dict, the others are not
+template<typename Dict, typename Value> static void check(const Dict& pydict, const int key_num)
+{
+	const Value*   value = NULL;
+	Value          want;
+	char           key[64];
+	int            len   = 0;
+	int            num   = 0;
+	int            i     = 0;
+
+	for(i=0;i<key_num*2;i++){
+		len   = snprintf(key, sizeof(key), "%08d", i);
+		value = pydict.find(key, len);
+		assert((value!=NULL) == (i<key_num && i%3!=0));
+		if(value){
+			want = make_value<Value>(i);
+			assert(memcmp(value, &want, sizeof(Value)) == 0);
+		}
+	}
+	assert(pydict.size() == (unsigned int)(key_num-(key_num+2)/3));
+
+	// every live node once, in position order
+	for(typename Dict::const_iterator it=pydict.begin();it!=pydict.end();++it){
+		num++;
+	}
+	assert(num == (int)pydict.size());
+}
+
+template<typename Value, int SignBits> static void test_dict()
+{
+	typedef pydict::dict<Value, SignBits> dict_t;
+
+	dict_t         pydict(1000);
+	dict_t         other;
+	Value*         value = NULL;
+	char           key[64];
+	int            len   = 0;
+	int            i     = 0;
+	int            ret   = 0;
+	int            num   = SignBits==32 ? KEY_NUM_32 : KEY_NUM;
+
+	for(i=0;i<num;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict.add(key, len, make_value<Value>(i+1));
+		assert(ret == 0);
+	}
+	for(i=0;i<num;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict.add(key, len, make_value<Value>(i));
+		assert(ret == 1);
+	}
+	assert(pydict.hashsize() >= (unsigned int)num);
+
+	// deleted nodes are reused
+	for(i=0;i<num;i+=3){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict.del(key, len);
+		assert(ret == 1);
+		ret = pydict.del(key, len);
+		assert(ret == 0);
+	}
+	for(i=num*3;i<num*3+1000;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict.add(key, len, make_value<Value>(i));
+		assert(ret == 0);
+		ret = pydict.del(key, len);
+		assert(ret == 1);
+	}
+	check<dict_t, Value>(pydict, num);
+
+	// iterators give the values and signatures
+	for(typename dict_t::iterator it=pydict.begin();it!=pydict.end();++it){
+		assert(pydict.find_sign(it.sign()) == &*it);
+	}
+
+	// values stay where they are when the dict moves
+	len   = snprintf(key, sizeof(key), "%08d", 1);
+	value = pydict.find(key, len);
+	other = std::move(pydict);
+	assert(pydict.size() == 0 && pydict.begin() == pydict.end());
+	assert(other.find(key, len) == value);
+	dict_t moved(std::move(other));
+	assert(moved.find(key, len) == value);
+	check<dict_t, Value>(moved, num);
+
+	// files of the same instantiation only
+	ret = moved.save("./", "dictbin_tpl");
+	assert(ret == 0);
+	ret = other.load("./", "dictbin_tpl");
+	assert(ret == 0);
+	check<dict_t, Value>(other, num);
+	pydict::dict<char, SignBits> wrong;
+	ret = wrong.load("./", "dictbin_tpl");
+	assert(ret == -1);
+
+	moved.clear();
+	assert(moved.size() == 0 && moved.begin() == moved.end());
+	len   = snprintf(key, sizeof(key), "%08d", 1);
+	assert(moved.find(key, len) == NULL);
+	remove("./dictbin_tpl");
+}
+
+int main()
+{
+	pydict::dict<int>   pydict;
+	int                 ret = 0;
+
+	test_dict<int, 64>();
+	test_dict<int, 32>();
+	test_dict<unsigned long, 64>();
+	test_dict<offset_t, 64>();
+	test_dict<offset_t, 32>();
+
+	// the signature function is kept in the file
+	ret = py_sign_set_default(PY_SIGN_WYHASH);
+	assert(ret == 0);
+	test_dict<int, 64>();
+	ret = pydict.set_hash(PY_SIGN_WYHASH);
+	assert(ret == 0);
+	ret = pydict.add("abc", 3, 1);
+	assert(ret == 0 && pydict.hash() == PY_SIGN_WYHASH);
+	ret = pydict.set_hash(PY_SIGN_MURMUR);
+	assert(ret == -1);
+	ret = pydict.save("./", "dictbin_tpl");
+	assert(ret == 0);
+	py_sign_set_default(PY_SIGN_MURMUR);
+	pydict::dict<int> loaded;
+	ret = loaded.load("./", "dictbin_tpl");
+	assert(ret == 0 && loaded.hash() == PY_SIGN_WYHASH && *loaded.find("abc", 3) == 1);
+	remove("./dictbin_tpl");
+
+	printf("test_pdict_tpl ok\n");
+	return 0;
+}
@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <py_dict.h>
+#include "test_util.h"
+#include <py_build.h>
+#include <py_trie.h>
+
+#define KEY_NUM   20000
+#define KEY_LEN   12
+#define INPUT     "./dictbin_trie.txt"
+
+// short keys of a few GBK characters and ASCII bytes, many keys are
+// prefixes of others
+static const char* chars[] = {"\xd6\xd0", "\xb9\xfa", "\xc8\xcb", "\xd6\xd1", "a", "b", "\xff"};
+
+static char*  keys[KEY_NUM];
+static int    lens[KEY_NUM];
+static int    codes[KEY_NUM];
+static int    values[KEY_NUM];
+static char   last[KEY_NUM];        // 1, no equal key after it
+
+static int make_key(char* key)
+{
+	int    n   = 1 + rand()%5;
+	int    len = 0;
+	int    i   = 0;
+
+	for(i=0;i<n;i++){
+		strcpy(key+len, chars[rand()%7]);
+		len += strlen(key+len);
+	}
+	key[len] = '\0';
+	return len;
+}
+
+// the last of equal keys, -1 if none
+static int naive_find(const char* key, int len)
+{
+	int    i = 0;
+
+	for(i=KEY_NUM-1;i>=0;i--){
+		if(lens[i]==len && memcmp(keys[i], key, len)==0){
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void make_keys()
+{
+	char   key[KEY_LEN+1];
+	int    i = 0;
+
+	srand(7);
+	for(i=0;i<KEY_NUM;i++){
+		lens[i]   = make_key(key);
+		keys[i]   = strdup(key);
+		codes[i]  = i;
+		values[i] = i*10;
+	}
+	for(i=0;i<KEY_NUM;i++){
+		last[i] = naive_find(keys[i], lens[i]) == i;
+	}
+}
+
+
+static void check_trie(py_trie_t* pytrie)
+{
+	pytrie_match_t   matches[8];
+	pytrie_match_t   match;
+	char             str[KEY_LEN*2+1];
+	int              code  = 0;
+	int              value = 0;
+	int              len   = 0;
+	int              num   = 0;
+	int              idx   = 0;
+	int              i     = 0;
+	int              j     = 0;
+	int              ret   = 0;
+
+	// every key, the payload of its last line
+	for(i=0;i<KEY_NUM;i++){
+		idx = naive_find(keys[i], lens[i]);
+		ret = pytrie_find(pytrie, keys[i], lens[i], &code, &value);
+		assert(ret == 1 && code == idx && value == idx*10);
+	}
+	ret = pytrie_find(pytrie, "", 0, &code, &value);
+	assert(ret == 0);
+	ret = pytrie_find(pytrie, "\xd6", 1, &code, &value);
+	assert(ret == 0);
+
+	// prefixes of random strings, every prefix length is checked
+	for(i=0;i<500;i++){
+		len = make_key(str);
+		len += make_key(str+len);
+		num = pytrie_prefix(pytrie, str, len, matches, 8);
+		ret = pytrie_longest(pytrie, str, len, &match);
+		idx = 0;
+		for(j=0;j<=len;j++){
+			if(naive_find(str, j) < 0){
+				continue;
+			}
+			assert(idx < num && matches[idx].len == j);
+			assert(matches[idx].code == naive_find(str, j));
+			idx++;
+		}
+		assert(idx == num);
+		assert(ret == (num>0));
+		if(ret){
+			assert(match.len == matches[num-1].len && match.code == matches[num-1].code);
+		}
+	}
+
+	// a full matches array keeps the shortest keys
+	for(j=0,idx=0;j<=10;j++){
+		idx += naive_find("aaaaaaaaaa", j) >= 0;
+	}
+	num = pytrie_prefix(pytrie, "aaaaaaaaaa", 10, matches, 2);
+	assert(idx > 2 && num == idx && matches[0].len == 1 && matches[1].len == 2);
+}
+
+typedef struct _predict_arg{
+	char    last[KEY_LEN+1];
+	int     last_len;
+	int     num;
+	int     stop;
+}predict_arg_t;
+
+static int predict_func(const char* key, int len, int code, int value, void* arg)
+{
+	predict_arg_t*  pa  = (predict_arg_t*)arg;
+	int             cmp = 0;
+	int             min = len < pa->last_len ? len : pa->last_len;
+
+	assert(key[len] == '\0');
+	assert(last[code] && lens[code] == len && memcmp(keys[code], key, len) == 0 && value == code*10);
+
+	// byte order, strictly increasing
+	if(pa->num > 0){
+		cmp = memcmp(pa->last, key, min);
+		assert(cmp < 0 || (cmp == 0 && pa->last_len < len));
+	}
+	memcpy(pa->last, key, len);
+	pa->last_len = len;
+	pa->num++;
+
+	return pa->stop && pa->num == pa->stop;
+}
+
+static void check_predict(py_trie_t* pytrie, const char* prefix, const int len)
+{
+	predict_arg_t   pa;
+	int             want = 0;
+	int             i    = 0;
+	int             ret  = 0;
+
+	for(i=KEY_NUM-1;i>=0;i--){
+		if(lens[i]>=len && memcmp(keys[i], prefix, len)==0 && last[i]){
+			want++;
+		}
+	}
+	memset(&pa, 0, sizeof(pa));
+	ret = pytrie_predict(pytrie, prefix, len, predict_func, &pa);
+	assert(ret == want && pa.num == want);
+
+	// the search stops early
+	if(want > 3){
+		memset(&pa, 0, sizeof(pa));
+		pa.stop = 3;
+		ret = pytrie_predict(pytrie, prefix, len, predict_func, &pa);
+		assert(ret == 3 && pa.num == 3);
+	}
+	ret = pytrie_predict(pytrie, prefix, len, NULL, NULL);
+	assert(ret == want);
+}
+
+static void check_all(py_trie_t* pytrie)
+{
+	check_trie(pytrie);
+	check_predict(pytrie, "", 0);
+	check_predict(pytrie, "a", 1);
+	check_predict(pytrie, "\xd6\xd0\xb9\xfa", 4);
+	check_predict(pytrie, "\xd6", 1);
+	check_predict(pytrie, "zzz", 3);
+}
+
+// the trie and the dict of the same file hold the same payloads
+static void test_build()
+{
+	build_stat_t   stat;
+	build_stat_t   dict_stat;
+	py_trie_t*     pytrie = NULL;
+	py_dict_t*     pydict = NULL;
+	FILE*          fp     = NULL;
+	int            code   = 0;
+	int            value  = 0;
+	int            dcode  = 0;
+	int            dvalue = 0;
+	int            i      = 0;
+	int            ret    = 0;
+
+	fp = fopen(INPUT, "w");
+	assert(fp);
+	for(i=0;i<KEY_NUM;i++){
+		fprintf(fp, "%s\t%d\t%d\n", keys[i], codes[i], values[i]);
+	}
+	fprintf(fp, "bad line\n\r\n");
+	fclose(fp);
+
+	pytrie = pytrie_build(INPUT, &stat);
+	assert(pytrie && stat.line_num == KEY_NUM+1 && stat.bad_num == 1);
+	pydict = pydict_build(INPUT, 0, 2, &dict_stat);
+	assert(pydict && stat.node_num == dict_stat.node_num);
+	for(i=0;i<KEY_NUM;i++){
+		ret = pytrie_find(pytrie, keys[i], lens[i], &code, &value);
+		assert(ret == 1);
+		ret = pydict_find(pydict, keys[i], lens[i], &dcode, &dvalue);
+		assert(ret == 1 && code == dcode && value == dvalue);
+	}
+	check_all(pytrie);
+
+	pydict_free(pydict);
+	pytrie_free(pytrie);
+	remove(INPUT);
+}
+
+int main()
+{
+	py_trie_t*     pytrie = NULL;
+	py_trie_t*     other  = NULL;
+	py_dict_t*     pydict = NULL;
+	const char*    one[]  = {"", "ab", "ab"};
+	int            olen[] = {0, 2, 2};
+	int            ocode[]= {1, 2, 3};
+	int            code   = 0;
+	int            value  = 0;
+	int            ret    = 0;
+	int            i      = 0;
+
+	make_keys();
+
+	pytrie = pytrie_create((const char**)keys, lens, codes, values, KEY_NUM);
+	assert(pytrie);
+	check_all(pytrie);
+
+	// saved, loaded and mapped
+	ret = pytrie_save(pytrie, "./", "dictbin_trie");
+	assert(ret == 0);
+	other = pytrie_load("./", "dictbin_trie");
+	assert(other && other->head.unit_num == pytrie->head.unit_num);
+	check_all(other);
+	pytrie_free(other);
+	other = pytrie_map("./", "dictbin_trie", PYDICT_MAP_POPULATE);
+	assert(other && (char*)other->units > (char*)other->map_addr);
+	assert((char*)(other->payloads+other->head.key_num) <= (char*)other->map_addr+other->map_size);
+	check_all(other);
+	pytrie_free(other);
+	pytrie_free(pytrie);
+
+	// a dict file is not a trie
+	pydict = pydict_create(16, 16);
+	assert(pydict);
+	ret = pydict_add(pydict, "ab", 2, 1, 1);
+	assert(ret == 0);
+	ret = pydict_save(pydict, "./", "dictbin_trie");
+	assert(ret == 0);
+	pydict_free(pydict);
+	other = pytrie_load("./", "dictbin_trie");
+	assert(other == NULL);
+	other = pytrie_map("./", "dictbin_trie", 0);
+	assert(other == NULL);
+	remove("./dictbin_trie");
+
+	// the empty key, a duplicate and an empty trie
+	pytrie = pytrie_create(one, olen, ocode, ocode, 3);
+	assert(pytrie && pytrie->head.key_num == 2);
+	ret = pytrie_find(pytrie, "", 0, &code, &value);
+	assert(ret == 1 && code == 1);
+	ret = pytrie_find(pytrie, "ab", 2, &code, &value);
+	assert(ret == 1 && code == 3);
+	ret = pytrie_predict(pytrie, "", 0, NULL, NULL);
+	assert(ret == 2);
+	pytrie_free(pytrie);
+	pytrie = pytrie_create(one, olen, ocode, ocode, 0);
+	assert(pytrie);
+	ret = pytrie_find(pytrie, "", 0, &code, &value);
+	assert(ret == 0);
+	ret = pytrie_prefix(pytrie, "ab", 2, NULL, 0);
+	assert(ret == 0);
+	ret = pytrie_predict(pytrie, "", 0, NULL, NULL);
+	assert(ret == 0);
+	pytrie_free(pytrie);
+
+	test_build();
+
+	for(i=0;i<KEY_NUM;i++){
+		free(keys[i]);
+	}
+	printf("test_pdict_trie ok\n");
+	return 0;
+}
@@ -0,0 +1,299 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <py_dict.h>
+#include "test_util.h"
+#include <py_wal.h>
+
+// 8 bytes keys, murmur_hash_64 is a bijection on them, no signature collision
+#define KEY_NUM 20000
+
+#define DICT_FILE "./dictbin_wal"
+#define LOG_FILE  "./dictbin_wal.wal"
+#define OLD_FILE  "./dictbin_wal.wal.old"
+
+static void clean()
+{
+	unlink(DICT_FILE);
+	unlink(LOG_FILE);
+	unlink(OLD_FILE);
+}
+
+static long file_size(const char* file)
+{
+	struct stat   st;
+
+	if(stat(file, &st)<0){
+		return -1;
+	}
+	return st.st_size;
+}
+
+// keys [0, KEY_NUM*2): i%3==0 are deleted, others have value i*10+round
+static void update(py_wal_t* pywal, int round)
+{
+	char   key[64];
+	int    len = 0;
+	int    i   = 0;
+	int    ret = 0;
+
+	for(i=0;i<KEY_NUM*2;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pywal_add(pywal, key, len, i, i*10+round);
+		assert(ret == 0 || ret == 1);
+	}
+	for(i=0;i<KEY_NUM*2;i+=3){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pywal_del(pywal, key, len);
+		assert(ret == 1);
+	}
+}
+
+static void check(py_dict_t* pydict, int round)
+{
+	char   key[64];
+	int    len   = 0;
+	int    code  = 0;
+	int    value = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	for(i=0;i<KEY_NUM*3;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_find(pydict, key, len, &code, &value);
+		assert(ret == (i<KEY_NUM*2 && i%3!=0));
+		if(ret){
+			assert(code == i && value == i*10+round);
+		}
+	}
+}
+
+static void test_replay()
+{
+	py_wal_t*   pywal  = NULL;
+	FILE*       fp     = NULL;
+	long        size   = 0;
+	char        key[64];
+	int         len    = 0;
+	int         ret    = 0;
+
+	clean();
+	pywal = pywal_open("./", "dictbin_wal", KEY_NUM, 1UL<<30, 0);
+	assert(pywal);
+	update(pywal, 0);
+	check(pywal->pydict, 0);
+
+	// deleting a missing key logs nothing
+	size = file_size(LOG_FILE);
+	len  = snprintf(key, sizeof(key), "%08d", 0);
+	ret  = pywal_del(pywal, key, len);
+	assert(ret == 0);
+	pywal_close(pywal);
+	assert(file_size(LOG_FILE) == size);
+	assert(access(DICT_FILE, F_OK) < 0);
+
+	// a torn record at the tail is cut off
+	fp = fopen(LOG_FILE, "ab");
+	assert(fp);
+	fwrite("torn record", 11, 1, fp);
+	fclose(fp);
+
+	pywal = pywal_open("./", "dictbin_wal", KEY_NUM, 1UL<<30, 0);
+	assert(pywal);
+	assert(file_size(LOG_FILE) == size);
+	check(pywal->pydict, 0);
+	pywal_close(pywal);
+}
+
+static void test_checkpoint()
+{
+	py_wal_t*   pywal  = NULL;
+	py_dict_t*  pydict = NULL;
+	int         ret    = 0;
+
+	// the log of test_replay is merged into a new snapshot
+	pywal = pywal_open("./", "dictbin_wal", KEY_NUM, 1UL<<30, PYWAL_NO_COMPACT);
+	assert(pywal);
+	ret = pywal_checkpoint(pywal, 1);
+	assert(ret == 0);
+	assert(access(OLD_FILE, F_OK) < 0);
+	assert(file_size(LOG_FILE) == sizeof(wal_head_t));
+
+	pydict = pydict_load("./", "dictbin_wal");
+	assert(pydict);
+	check(pydict, 0);
+	pydict_free(pydict);
+
+	// changes after the checkpoint are merged on top of the snapshot
+	update(pywal, 1);
+	ret = pywal_checkpoint(pywal, 1);
+	assert(ret == 0);
+	pywal_close(pywal);
+
+	pydict = pydict_map("./", "dictbin_wal", 0);
+	assert(pydict);
+	check(pydict, 1);
+	pydict_free(pydict);
+
+	pywal = pywal_open("./", "dictbin_wal", KEY_NUM, 1UL<<30, 0);
+	assert(pywal);
+	check(pywal->pydict, 1);
+	pywal_close(pywal);
+}
+
+static void test_crash()
+{
+	py_wal_t*   pywal  = NULL;
+	py_dict_t*  pydict = NULL;
+	int         ret    = 0;
+
+	// a compaction stopped after the log was renamed
+	pywal = pywal_open("./", "dictbin_wal", KEY_NUM, 1UL<<30, PYWAL_NO_COMPACT);
+	assert(pywal);
+	update(pywal, 2);
+	pywal_close(pywal);
+	ret = rename(LOG_FILE, OLD_FILE);
+	assert(ret == 0);
+
+	// the old log is replayed and merged again
+	pywal = pywal_open("./", "dictbin_wal", KEY_NUM, 1UL<<30, 0);
+	assert(pywal);
+	check(pywal->pydict, 2);
+	pywal_close(pywal);
+	assert(access(OLD_FILE, F_OK) < 0);
+
+	pydict = pydict_load("./", "dictbin_wal");
+	assert(pydict);
+	check(pydict, 2);
+	pydict_free(pydict);
+}
+
+static void test_compact()
+{
+	py_wal_t*   pywal  = NULL;
+	py_dict_t*  pydict = NULL;
+	int         round  = 0;
+
+	// small threshold, logs are rotated and merged while updating
+	clean();
+	pywal = pywal_open("./", "dictbin_wal", 1000, 64*1024, 0);
+	assert(pywal);
+	for(round=0;round<4;round++){
+		update(pywal, round);
+		check(pywal->pydict, round);
+	}
+	pywal_close(pywal);
+	assert(access(DICT_FILE, F_OK) == 0);
+
+	pywal = pywal_open("./", "dictbin_wal", 1000, 64*1024, 0);
+	assert(pywal);
+	check(pywal->pydict, 3);
+	pywal_close(pywal);
+
+	pydict = pydict_load("./", "dictbin_wal");
+	assert(pydict);
+	assert(pydict->hashsize > 1000);
+	pydict_free(pydict);
+}
+
+// a change that can not be logged is undone and never replayed
+static void test_failed_write()
+{
+	py_wal_t*   pywal = NULL;
+	int         fd    = -1;
+	int         code  = 0;
+	int         value = 0;
+	int         ret   = 0;
+
+	clean();
+	pywal = pywal_open("./", "dictbin_wal", 1000, 1UL<<30, PYWAL_NO_COMPACT);
+	assert(pywal);
+	ret = pywal_add(pywal, "abc", 3, 1, 10);
+	assert(ret == 0);
+
+	// writes to a read only descriptor fail
+	fd = pywal->fd;
+	pywal->fd = open(LOG_FILE, O_RDONLY);
+	assert(pywal->fd >= 0);
+	ret = pywal_add(pywal, "abc", 3, 2, 20);
+	assert(ret == -1);
+	ret = pywal_add(pywal, "abd", 3, 3, 30);
+	assert(ret == -1);
+	ret = pywal_del(pywal, "abc", 3);
+	assert(ret == -1);
+	ret = pywal_find(pywal, "abc", 3, &code, &value);
+	assert(ret == 1 && code == 1 && value == 10);
+	ret = pywal_find(pywal, "abd", 3, &code, &value);
+	assert(ret == 0);
+	close(pywal->fd);
+	pywal->fd = fd;
+	pywal_close(pywal);
+
+	pywal = pywal_open("./", "dictbin_wal", 1000, 1UL<<30, PYWAL_NO_COMPACT);
+	assert(pywal);
+	ret = pywal_find(pywal, "abc", 3, &code, &value);
+	assert(ret == 1 && code == 1 && value == 10);
+	ret = pywal_find(pywal, "abd", 3, &code, &value);
+	assert(ret == 0);
+	pywal_close(pywal);
+}
+
+// the blob arena of the snapshot is kept by a merge
+static void test_blob()
+{
+	py_wal_t*      pywal    = NULL;
+	py_dict_t*     pydict   = NULL;
+	const char*    blob     = NULL;
+	unsigned int   blob_len = 0;
+	int            code     = 0;
+	int            value    = 0;
+	int            ret      = 0;
+
+	clean();
+	pydict = pydict_create(16, 16);
+	assert(pydict);
+	ret = pydict_add_blob(pydict, "k", 1, 7, "hello", 5);
+	assert(ret == 0);
+	ret = pydict_save(pydict, "./", "dictbin_wal");
+	assert(ret == 0);
+	pydict_free(pydict);
+
+	pywal = pywal_open("./", "dictbin_wal", 16, 1UL<<30, PYWAL_NO_COMPACT);
+	assert(pywal);
+	ret = pywal_add(pywal, "x", 1, 1, 10);
+	assert(ret == 0);
+	ret = pywal_checkpoint(pywal, 1);
+	assert(ret == 0);
+	pywal_close(pywal);
+
+	pydict = pydict_load("./", "dictbin_wal");
+	assert(pydict && pydict->blob_size > 0);
+	ret = pydict_find_blob(pydict, "k", 1, &code, &blob, &blob_len);
+	assert(ret == 1 && code == 7 && blob_len == 5 && memcmp(blob, "hello", 5) == 0);
+	ret = pydict_find(pydict, "x", 1, &code, &value);
+	assert(ret == 1 && code == 1 && value == 10);
+	pydict_free(pydict);
+
+	pydict = pydict_map("./", "dictbin_wal", 0);
+	assert(pydict);
+	ret = pydict_find_blob(pydict, "k", 1, &code, &blob, &blob_len);
+	assert(ret == 1 && blob_len == 5 && memcmp(blob, "hello", 5) == 0);
+	pydict_free(pydict);
+}
+
+int main()
+{
+	test_replay();
+	test_checkpoint();
+	test_crash();
+	test_compact();
+	test_failed_write();
+	test_blob();
+	clean();
+
+	printf("test_pdict_wal ok\n");
+	return 0;
+}
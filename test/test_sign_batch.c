@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <sys/time.h>
+#include <py_sign.h>
+#include "test_util.h"
+
+#define KEY_NUM  100000
+#define MAX_LEN  64
+
+static double now_ms()
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec*1000.0 + tv.tv_usec/1000.0;
+}
+
+int main(int argc, char* argv[])
+{
+	char*          buff   = NULL;
+	const char**   strs   = NULL;
+	int*           lens   = NULL;
+	unsigned long* signs  = NULL;
+	unsigned int*  sign1  = NULL;
+	unsigned int*  sign2  = NULL;
+	unsigned long  sign   = 0;
+	unsigned int   s1     = 0;
+	unsigned int   s2     = 0;
+	int            pos    = 0;
+	int            i      = 0;
+	int            j      = 0;
+	double         t1     = 0;
+	double         t2     = 0;
+
+	buff  = (char*)malloc(KEY_NUM*(MAX_LEN+1));
+	strs  = (const char**)malloc(sizeof(char*)*KEY_NUM);
+	lens  = (int*)malloc(sizeof(int)*KEY_NUM);
+	signs = (unsigned long*)malloc(sizeof(unsigned long)*KEY_NUM);
+	sign1 = (unsigned int*)malloc(sizeof(unsigned int)*KEY_NUM);
+	sign2 = (unsigned int*)malloc(sizeof(unsigned int)*KEY_NUM);
+	assert(buff && strs && lens && signs && sign1 && sign2);
+
+	// random bytes, random lengths, unaligned strings
+	srand(1);
+	for(i=0;i<KEY_NUM;i++){
+		lens[i] = i < MAX_LEN ? i : rand()%(i%5==0 ? MAX_LEN : 17);
+		strs[i] = buff+pos;
+		for(j=0;j<lens[i];j++){
+			buff[pos++] = (char)rand();
+		}
+	}
+
+	for(i=0;i<KEY_NUM;i+=KEY_NUM/7){ // odd batch sizes
+		py_sign64_batch(strs, lens, i, signs);
+		for(j=0;j<i;j++){
+			py_sign64(strs[j], lens[j], &sign);
+			assert(signs[j] == sign);
+		}
+	}
+	py_sign64_double_int_batch(strs, lens, KEY_NUM, sign1, sign2);
+	for(i=0;i<KEY_NUM;i++){
+		py_sign64_double_int(strs[i], lens[i], &s1, &s2);
+		assert(sign1[i] == s1 && sign2[i] == s2);
+	}
+
+	t1 = now_ms();
+	for(j=0;j<20;j++){
+		py_sign64_batch(strs, lens, KEY_NUM, signs);
+	}
+	t2 = now_ms();
+	for(j=0;j<20;j++){
+		for(i=0;i<KEY_NUM;i++){
+			py_sign64(strs[i], lens[i], signs+i);
+		}
+	}
+	fprintf(stdout, "batch %.1f ms, single %.1f ms\n", t2-t1, now_ms()-t2);
+
+	free(buff);
+	free(strs);
+	free(lens);
+	free(signs);
+	free(sign1);
+	free(sign2);
+
+	fprintf(stdout, "test_sign_batch ok\n");
+
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <py_utils.h>
+#include "test_util.h"
+
+#define STR_MAX   300
+#define ITEM_MAX  (STR_MAX+2)
+
+// bytes of the strings, delimiters of the sets below and others
+static const char alphabet[] = " \t\n,;abcXYZ\xa1\xb0\xff";
+
+static const char* delims[] = {
+	" ",
+	" \t",
+	"\t\n ,;",
+	" \t\t ",                 // duplicates
+	"\xa1\xff",               // high bytes
+	" \t\n,;abcX",            // more than SPLIT_VEC_MAX, the table
+	"#",                      // not in the strings
+};
+
+static int make_str(char* str)
+{
+	int    len = rand() % STR_MAX;
+	int    i   = 0;
+
+	// runs of a byte cross the 64 bytes blocks
+	for(i=0;i<len;i++){
+		str[i] = (i>0 && rand()%3==0) ? str[i-1] : alphabet[rand()%(sizeof(alphabet)-1)];
+	}
+	str[len] = '\0';
+	return len;
+}
+
+static void check(const char* str, const int len, const split_delim_t* sd, const char* delim,
+                  const int size)
+{
+	split_span_t   spans[ITEM_MAX];
+	char*          items[ITEM_MAX];
+	char           copy[STR_MAX+1];
+	char           strbuf[STR_MAX*2+2];
+	int            want = 0;
+	int            num  = 0;
+	int            i    = 0;
+
+	memcpy(copy, str, len+1);
+	want = split_c(copy, items, size, delim);
+	num  = split_span(str, len, sd, spans, size);
+	assert(num == want);
+	for(i=0;i<num;i++){
+		assert(items[i] == copy+spans[i].offset);
+		assert((int)strlen(items[i]) == spans[i].len);
+	}
+
+	want = split_all(str, strbuf, sizeof(strbuf), items, size, delim);
+	num  = split_all_span(str, len, sd, spans, size);
+	assert(num == want);
+	for(i=0;i<num;i++){
+		assert((int)strlen(items[i]) == spans[i].len);
+		assert(memcmp(items[i], str+spans[i].offset, spans[i].len) == 0);
+	}
+}
+
+int main()
+{
+	split_delim_t  sd;
+	split_delim_t  forced;
+	char           str[STR_MAX+1];
+	int            len  = 0;
+	int            size = 0;
+	int            d    = 0;
+	int            i    = 0;
+	int            simd = 0;
+
+	srand(1);
+	for(d=0;d<(int)(sizeof(delims)/sizeof(delims[0]));d++){
+		split_delim_init(&sd, delims[d]);
+		assert(sd.table[(unsigned char)delims[d][0]] == 1 && sd.table['#'] == (d==6));
+		for(i=0;i<20000;i++){
+			len  = make_str(str);
+			size = i%2 ? ITEM_MAX : 1+rand()%(len/2+3);
+
+			// every path the cpu has gives the same spans
+			for(simd=0;simd<=sd.simd;simd++){
+				forced      = sd;
+				forced.simd = simd;
+				check(str, len, &forced, delims[d], size);
+			}
+		}
+	}
+	split_delim_init(&sd, " \t\t ");
+	assert(sd.num == 2);
+	split_delim_init(&sd, " \t\n,;abcX");
+	assert(sd.num == 9 && sd.simd == 0);
+
+	// only delimiters, the empty string
+	split_delim_init(&sd, " ");
+	check("   ", 3, &sd, " ", 1);
+	check("   ", 3, &sd, " ", 2);
+	check("", 0, &sd, " ", 1);
+	check("a  ", 3, &sd, " ", 2);
+	check("a ", 2, &sd, " ", 2);
+
+	printf("test_split ok\n");
+	return 0;
+}
@@ -0,0 +1,43 @@
+/********************************************************************************
+ * Describe : checks shared by the dict tests
+ *
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ *
+ * Create   : 2008-10-15
+ *
+ * Modify   : 2008-10-15
+ *******************************************************************************/
+#ifndef _TEST_UTIL_H
+#define _TEST_UTIL_H
+
+// the checks are the tests, a release (-DNDEBUG) build keeps them
+#undef NDEBUG
+#include <stdio.h>
+#include <assert.h>
+#include <py_dict.h>
+
+/*
+ * func : check the "%08d" keys [0, key_num), keys [begin, end) are in the
+ *        dict with code i and value i*10, the others are not
+ */
+static inline void check_range(py_dict_t* pydict, const int begin, const int end,
+                               const int key_num)
+{
+	char   key[64];
+	int    len   = 0;
+	int    code  = 0;
+	int    value = 0;
+	int    i     = 0;
+	int    ret   = 0;
+
+	for(i=0;i<key_num;i++){
+		len = snprintf(key, sizeof(key), "%08d", i);
+		ret = pydict_find(pydict, key, len, &code, &value);
+		assert(ret == (i>=begin && i<end));
+		if(ret){
+			assert(code == i && value == i*10);
+		}
+	}
+}
+
+#endif
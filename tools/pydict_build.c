@@ -0,0 +1,90 @@
+/***********************************************************************************
+ * Describe : build a dict file from a "key\tcode\tvalue" text file on all cores
+ *
+ *          : usage : pydict_build [-t thread_num] [-s hashsize] [-T trie_file] input path file
+ * 
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ * 
+ * Create   : 2008-10-15
+ * 
+ * Modify   : 2008-10-15
+ **********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <py_dict.h>
+#include <py_trie.h>
+#include <py_build.h>
+
+static void usage(const char* prog)
+{
+	fprintf(stderr, "usage : %s [-t thread_num] [-s hashsize] [-T trie_file] input path file\n", prog);
+	fprintf(stderr, "        -t thread_num, default the number of cores\n");
+	fprintf(stderr, "        -s hashsize, default the number of lines\n");
+	fprintf(stderr, "        -T trie_file, also save a trie of the keys in path\n");
+}
+
+int main(int argc, char* argv[])
+{
+	build_stat_t     stat;
+	build_stat_t     trie_stat;
+	py_trie_t*       pytrie     = NULL;
+	const char*      trie_file  = NULL;
+	struct timeval   begin;
+	struct timeval   end;
+	unsigned int     hashsize   = 0;
+	int              thread_num = 0;
+	int              opt        = 0;
+	int              ret        = 0;
+
+	while((opt=getopt(argc, argv, "t:s:T:h"))!=-1){
+		switch(opt){
+		case 't':
+			thread_num = atoi(optarg);
+			break;
+		case 's':
+			hashsize = (unsigned int)strtoul(optarg, NULL, 10);
+			break;
+		case 'T':
+			trie_file = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if(argc-optind!=3){
+		usage(argv[0]);
+		return 1;
+	}
+
+	gettimeofday(&begin, NULL);
+	ret = pydict_build_file(argv[optind], hashsize, thread_num, argv[optind+1], argv[optind+2], &stat);
+	gettimeofday(&end, NULL);
+	if(ret<0){
+		fprintf(stderr, "build %s failed\n", argv[optind]);
+		return 1;
+	}
+
+	printf("lines : %u, bad lines : %u, nodes : %u, time : %.3fs\n",
+	       stat.line_num, stat.bad_num, stat.node_num,
+	       (end.tv_sec-begin.tv_sec) + (end.tv_usec-begin.tv_usec)/1e6);
+
+	if(trie_file){
+		gettimeofday(&begin, NULL);
+		pytrie = pytrie_build(argv[optind], &trie_stat);
+		ret    = pytrie ? pytrie_save(pytrie, argv[optind+1], trie_file) : -1;
+		gettimeofday(&end, NULL);
+		if(ret<0){
+			fprintf(stderr, "build trie of %s failed\n", argv[optind]);
+			pytrie_free(pytrie);
+			return 1;
+		}
+		printf("trie keys : %u, units : %u, time : %.3fs\n",
+		       pytrie->head.key_num, pytrie->head.unit_num,
+		       (end.tv_sec-begin.tv_sec) + (end.tv_usec-begin.tv_usec)/1e6);
+		pytrie_free(pytrie);
+	}
+	return 0;
+}
@@ -0,0 +1,118 @@
+/***********************************************************************************
+ * Describe : print the health metrics of a dict file, see pydict_stats
+ *
+ *          : usage : pydict_inspect [-l] [-e chain|swiss] path file
+ *          :   -l  load the file instead of mapping it
+ *          :   -e  rebuild the table with an engine first, implies -l
+ * 
+ * Author   : Paul Yang, zhenahoji@gmail.com
+ * 
+ * Create   : 2008-10-15
+ * 
+ * Modify   : 2008-10-15
+ **********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <py_dict.h>
+
+static void usage(const char* prog)
+{
+	fprintf(stderr, "usage : %s [-l] [-e chain|swiss] path file\n", prog);
+}
+
+static void print_stats(pydict_stats_t* stats)
+{
+	int   i = 0;
+
+	printf("engine        : %s%s%s\n", stats->engine==PYDICT_ENGINE_SWISS ? "swiss" : "chain",
+	       stats->mapped ? ", mapped" : "", stats->rehashing ? ", rehashing" : "");
+	printf("hash          : %s\n", stats->hash==PY_SIGN_ROLL ? "roll" :
+	       stats->hash==PY_SIGN_WYHASH ? "wyhash" : "murmur");
+	printf("%-13s : %u\n", stats->engine==PYDICT_ENGINE_SWISS ? "slots" : "hashsize", stats->hashsize);
+	printf("used          : %u (%.1f%%)\n", stats->used,
+	       stats->hashsize ? 100.0*stats->used/stats->hashsize : 0);
+	printf("nodes         : %u\n", stats->node_num);
+	printf("deleted nodes : %u\n", stats->deleted_num);
+	printf("free nodes    : %u\n", stats->free_num);
+	printf("block         : %u of %u, slack %u\n", stats->block_pos, stats->block_size, stats->slack);
+	if(stats->key_max>0){
+		printf("longest key   : %u bytes\n", stats->key_max);
+	}
+	if(stats->blob_size>0){
+		printf("blobs         : %lu bytes\n", (unsigned long)stats->blob_size);
+	}
+	printf("load          : %.3f\n", stats->load);
+	printf("avg walk      : %.3f\n", stats->avg_len);
+	printf("max %-9s : %u\n", stats->engine==PYDICT_ENGINE_SWISS ? "probe" : "chain", stats->max_len);
+	printf("bytes         : %lu (%.1f a node)\n", (unsigned long)stats->bytes,
+	       stats->node_num ? (double)stats->bytes/stats->node_num : 0);
+
+	printf("%s :\n", stats->engine==PYDICT_ENGINE_SWISS ? "keys by groups probed" : "buckets by chain length");
+	for(i=0;i<=PYDICT_STATS_LEN_MAX;i++){
+		if(stats->len_hist[i]){
+			printf("  %s%-3d : %u\n", i==PYDICT_STATS_LEN_MAX ? ">=" : "  ", i, stats->len_hist[i]);
+		}
+	}
+
+	if(stats->engine!=PYDICT_ENGINE_SWISS && stats->hashsize>0){
+		if(stats->load>2.0 || (stats->load<0.25 && stats->node_num>0)){
+			printf("hint          : a hashsize near %u, the node number, fits better\n", 
+			       stats->node_num);
+		}
+		if(stats->load<=1.0 && stats->max_len>=PYDICT_STATS_LEN_MAX){
+			printf("hint          : long chains at a low load, check the key signatures\n");
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	py_dict_t*       pydict = NULL;
+	pydict_stats_t   stats;
+	int              load   = 0;
+	int              engine = -1;
+	int              opt    = 0;
+
+	while((opt=getopt(argc, argv, "le:h"))!=-1){
+		switch(opt){
+		case 'l':
+			load = 1;
+			break;
+		case 'e':
+			load   = 1;
+			engine = strcmp(optarg, "swiss")==0 ? PYDICT_ENGINE_SWISS : PYDICT_ENGINE_CHAIN;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if(argc-optind!=2){
+		usage(argv[0]);
+		return 1;
+	}
+
+	if(load){
+		pydict = pydict_load(argv[optind], argv[optind+1]);
+	}
+	else{
+		pydict = pydict_map(argv[optind], argv[optind+1], 0);
+	}
+	if(!pydict){
+		fprintf(stderr, "can not open %s/%s\n", argv[optind], argv[optind+1]);
+		return 1;
+	}
+	if(engine>=0 && pydict_set_engine(pydict, engine)<0){
+		fprintf(stderr, "can not set engine\n");
+		pydict_free(pydict);
+		return 1;
+	}
+
+	pydict_stats(pydict, &stats);
+	print_stats(&stats);
+
+	pydict_free(pydict);
+	return 0;
+}